@@ -2,10 +2,14 @@
 
 -- Create the main table to store key-value pairs.
 -- 'key' is a unique identifier (primary key), and 'value' holds the associated data.
+-- 'value' is BYTEA so binary blobs (and empty values) round-trip unchanged; the server
+-- reads and writes it with binary-format libpq parameters.
+-- Existing databases created with a TEXT column can be migrated with:
+--   ALTER TABLE kv_store ALTER COLUMN value TYPE BYTEA USING convert_to(value, 'UTF8');
 -- 'created_at' and 'updated_at' keep track of when the record was inserted or modified.
 CREATE TABLE IF NOT EXISTS kv_store (
     key VARCHAR(255) PRIMARY KEY,        -- Unique key for each entry (string up to 255 chars)
-    value TEXT NOT NULL,                 -- Value corresponding to the key, cannot be NULL
+    value BYTEA NOT NULL,                -- Value corresponding to the key (raw bytes), cannot be NULL
     created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,  -- Auto-set creation timestamp
     updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP   -- Auto-set modification timestamp
 );
@@ -5,6 +5,11 @@ HOST="localhost"
 PORT="8080"
 DURATIONS=300      # test duration in seconds
 KEY_SPACE_SIZE=10000
+TARGET_RPS=0       # Total requests/sec, sent on a Poisson schedule (open loop); 0 = closed loop
+CONNECTIONS=0      # Simulated clients, spread over the threads; 0 = one per thread
+KEYS="uniform"     # Key distribution: uniform, zipfian[:theta], scrambled[:theta], hotspot[:ops:keys], latest, sequential
+VALUE_SIZE=""      # Value sizes in bytes (N, uniform:MIN:MAX, pareto:MIN:ALPHA[:MAX], file:PATH); empty = short strings
+SCENARIO=""        # Scenario file (e.g. scenarios/peak_hour.scenario); results in $OUTPUT_DIR/scenario_*
 
 LOADS=("GET_POPULAR" "GET_ALL" "PUT_ALL" "MIXED")
 THREAD_COUNTS=(5 10 15 20 25 30 35 40 45 50 55 60 65 70 75 80 85 90 95 100)
@@ -12,8 +17,27 @@ THREAD_COUNTS=(5 10 15 20 25 30 35 40 45 50 55 60 65 70 75 80 85 90 95 100)
 OUTPUT_DIR="./load_test_results"
 mkdir -p $OUTPUT_DIR
 
+# Scenario: run its phases once instead of the sweep below
+if [ -n "$SCENARIO" ]; then
+  taskset -c 1,2,3,5,6,7 ./build/load_generator $HOST $PORT --scenario "$SCENARIO" --results "$OUTPUT_DIR/scenario" | tee "$OUTPUT_DIR/scenario_raw.log"
+  echo "Scenario complete. Phase summary saved to $OUTPUT_DIR/scenario_phases.csv"
+  exit 0
+fi
+
 # CSV Header
-echo "Workload,Threads,Duration,TotalRequests,SuccessfulRequests,FailedRequests,SuccessRate,AvgThroughput,AvgResponseTime" > $OUTPUT_DIR/summary.csv
+echo "Workload,Threads,Duration,TotalRequests,SuccessfulRequests,FailedRequests,SuccessRate,AvgThroughput,AvgResponseTime,MaxResponseTime" > $OUTPUT_DIR/summary.csv
+
+# Open loop: the threads share TARGET_RPS and keep up to 64 requests in flight each
+EXTRA_ARGS=""
+if [ "$TARGET_RPS" != "0" ]; then
+  EXTRA_ARGS="$KEY_SPACE_SIZE http 64 $TARGET_RPS poisson"
+fi
+if [ -n "$VALUE_SIZE" ]; then
+  EXTRA_ARGS="$EXTRA_ARGS --value-size $VALUE_SIZE"
+fi
+if [ "$CONNECTIONS" != "0" ]; then
+  EXTRA_ARGS="$EXTRA_ARGS --connections $CONNECTIONS"
+fi
 
 for workload in "${LOADS[@]}"; do
   echo "Starting tests for workload: $workload"
@@ -22,9 +46,10 @@ for workload in "${LOADS[@]}"; do
     echo "Running load generator: workload=$workload, threads=$threads"
 
     # Run load generator and capture entire output
-    output=$(taskset -c 1,2,3,5,6,7 ./build/load_generator $HOST $PORT $workload $threads $DURATIONS)
+    output=$(taskset -c 1,2,3,5,6,7 ./build/load_generator $HOST $PORT $workload $threads $DURATIONS $EXTRA_ARGS --keys "$KEYS" --results "$OUTPUT_DIR/${workload}_${threads}")
 
-    # Optional: Save full raw output to file per run
+    # Optional: Save full raw output to file per run (percentiles and time
+    # series are also in ${workload}_${threads}.json and the CSVs beside it)
     echo "$output" > "$OUTPUT_DIR/${workload}_${threads}_raw.log"
 
     # Parse fields from output using grep and awk
@@ -34,9 +59,10 @@ for workload in "${LOADS[@]}"; do
     success_rate=$(echo "$output" | grep "Success Rate:" | awk '{print $3}' | tr -d '%')
     avg_throughput=$(echo "$output" | grep "Average Throughput:" | awk '{print $3}')
     avg_resp_time=$(echo "$output" | grep "Average Response Time:" | awk '{print $4}')
+    max_resp_time=$(echo "$output" | grep "Max Response Time:" | awk '{print $4}')
 
     # Save summary line to CSV
-    echo "$workload,$threads,$DURATIONS,$total_requests,$successful_requests,$failed_requests,$success_rate,$avg_throughput,$avg_resp_time" >> $OUTPUT_DIR/summary.csv
+    echo "$workload,$threads,$DURATIONS,$total_requests,$successful_requests,$failed_requests,$success_rate,$avg_throughput,$avg_resp_time,$max_resp_time" >> $OUTPUT_DIR/summary.csv
 
     echo "Completed: $workload $threads threads; Throughput = $avg_throughput req/sec; Avg Latency = $avg_resp_time ms"
   done
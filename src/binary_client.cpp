@@ -0,0 +1,132 @@
+#include "binary_client.hpp" // BinaryClient class definition
+#include <cerrno>            // For EINTR
+#include <cstring>           // For memset
+#include <netinet/in.h>      // For sockaddr_in
+#include <netinet/tcp.h>     // For TCP_NODELAY
+#include <arpa/inet.h>       // For inet_pton, htons
+#include <sys/socket.h>      // For socket, connect, send, recv
+#include <unistd.h>          // For close
+
+BinaryClient::~BinaryClient()
+{
+    close();
+}
+
+bool BinaryClient::connect(const std::string &host, int port)
+{
+    close();
+
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host == "localhost" ? "127.0.0.1" : host.c_str(), &server_addr.sin_addr) != 1)
+        return false;
+
+    sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0)
+        return false;
+    if (::connect(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
+    {
+        close();
+        return false;
+    }
+
+    // Requests are small and latency-sensitive: don't let Nagle hold them back.
+    int nodelay = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    return true;
+}
+
+void BinaryClient::close()
+{
+    if (sock >= 0)
+        ::close(sock);
+    sock = -1;
+    output.clear();
+    input.clear();
+    input_offset = 0;
+}
+
+uint64_t BinaryClient::sendGet(std::string_view key)
+{
+    return queue(binproto::Opcode::Get, key, {});
+}
+
+uint64_t BinaryClient::sendPut(std::string_view key, std::string_view value)
+{
+    return queue(binproto::Opcode::Put, key, value);
+}
+
+uint64_t BinaryClient::sendDelete(std::string_view key)
+{
+    return queue(binproto::Opcode::Delete, key, {});
+}
+
+uint64_t BinaryClient::sendPing()
+{
+    return queue(binproto::Opcode::Ping, {}, {});
+}
+
+uint64_t BinaryClient::queue(binproto::Opcode opcode, std::string_view key, std::string_view value)
+{
+    uint64_t id = next_id++;
+    binproto::appendRequest(output, opcode, id, key, value);
+    return id;
+}
+
+bool BinaryClient::flush()
+{
+    size_t sent = 0;
+    while (sent < output.size())
+    {
+        ssize_t n = send(sock, output.data() + sent, output.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    output.clear();
+    return true;
+}
+
+bool BinaryClient::receive(Response &response)
+{
+    while (true)
+    {
+        binproto::Response parsed;
+        size_t consumed = 0;
+        std::string_view pending(input.data() + input_offset, input.size() - input_offset);
+        binproto::ParseStatus status = binproto::parseResponse(pending, parsed, consumed);
+        if (status == binproto::ParseStatus::Error)
+            return false;
+        if (status == binproto::ParseStatus::Ok)
+        {
+            response.id = parsed.id;
+            response.status = parsed.status;
+            response.value.assign(parsed.value);
+            input_offset += consumed;
+            if (input_offset == input.size())
+            {
+                input.clear();
+                input_offset = 0;
+            }
+            return true;
+        }
+
+        // Compact before reading so the buffer doesn't grow without bound.
+        if (input_offset > 0)
+        {
+            input.erase(0, input_offset);
+            input_offset = 0;
+        }
+        char buffer[16 * 1024];
+        ssize_t n = recv(sock, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        input.append(buffer, n);
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "binary_protocol.hpp"
+
+/**
+ * @brief Client for the server's binary protocol.
+ *
+ * Requests are queued with sendGet()/sendPut()/sendDelete()/sendPing(),
+ * which return the request ID, and written to the socket by flush(), so a
+ * caller can keep many requests in flight on one connection. receive()
+ * returns responses as they arrive, in whatever order the server completes
+ * them; the caller matches them to its requests by ID.
+ *
+ * Not thread-safe: use one client per thread.
+ */
+class BinaryClient
+{
+public:
+    struct Response
+    {
+        uint64_t id = 0;
+        binproto::Status status = binproto::Status::Ok;
+        std::string value; // Get: the value
+    };
+
+    BinaryClient() = default;
+    ~BinaryClient();
+    BinaryClient(const BinaryClient &) = delete;
+    BinaryClient &operator=(const BinaryClient &) = delete;
+
+    /**
+     * @brief Connects to the server (IPv4 address or "localhost").
+     * @return false if the connection failed.
+     */
+    bool connect(const std::string &host, int port);
+
+    /**
+     * @brief Closes the connection; queued and outstanding requests are dropped.
+     */
+    void close();
+
+    bool isConnected() const { return sock >= 0; }
+
+    // Queue a request; returns its ID.
+    uint64_t sendGet(std::string_view key);
+    uint64_t sendPut(std::string_view key, std::string_view value);
+    uint64_t sendDelete(std::string_view key);
+    uint64_t sendPing();
+
+    /**
+     * @brief Writes all queued requests to the socket.
+     * @return false if the connection failed.
+     */
+    bool flush();
+
+    /**
+     * @brief Blocks until the next response arrives.
+     * @return false if the connection failed or the server sent garbage.
+     */
+    bool receive(Response &response);
+
+private:
+    uint64_t queue(binproto::Opcode opcode, std::string_view key, std::string_view value);
+
+    int sock = -1;
+    uint64_t next_id = 1;
+    std::string output;  // Encoded requests not yet flushed
+    std::string input;   // Received bytes not yet parsed
+    size_t input_offset = 0;
+};
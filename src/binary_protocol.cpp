@@ -0,0 +1,94 @@
+#include "binary_protocol.hpp" // Declarations of the binary framing
+
+namespace binproto
+{
+    namespace
+    {
+        // Little-endian integer encoding, independent of the host byte order.
+        template <typename T>
+        T load(const char *p)
+        {
+            T value = 0;
+            for (size_t i = 0; i < sizeof(T); ++i)
+                value |= static_cast<T>(static_cast<unsigned char>(p[i])) << (8 * i);
+            return value;
+        }
+
+        template <typename T>
+        void store(char *p, T value)
+        {
+            for (size_t i = 0; i < sizeof(T); ++i)
+                p[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+        }
+
+        // Header shared by both directions: magic, code, 16-bit field, value length, ID.
+        void encodeHeader(char *header, uint8_t magic, uint8_t code, uint16_t field, uint32_t value_length,
+                          uint64_t id)
+        {
+            header[0] = static_cast<char>(magic);
+            header[1] = static_cast<char>(code);
+            store<uint16_t>(header + 2, field);
+            store<uint32_t>(header + 4, value_length);
+            store<uint64_t>(header + 8, id);
+        }
+    }
+
+    ParseStatus parseRequest(std::string_view input, Request &request, size_t &consumed)
+    {
+        if (input.size() < kHeaderSize)
+            return input.empty() || static_cast<uint8_t>(input[0]) == kRequestMagic ? ParseStatus::Incomplete
+                                                                                    : ParseStatus::Error;
+        if (static_cast<uint8_t>(input[0]) != kRequestMagic)
+            return ParseStatus::Error;
+
+        size_t key_length = load<uint16_t>(input.data() + 2);
+        size_t value_length = load<uint32_t>(input.data() + 4);
+        if (value_length > kMaxValueLength)
+            return ParseStatus::Error;
+        if (input.size() < kHeaderSize + key_length + value_length)
+            return ParseStatus::Incomplete;
+
+        request.opcode = static_cast<Opcode>(input[1]);
+        request.id = load<uint64_t>(input.data() + 8);
+        request.key = input.substr(kHeaderSize, key_length);
+        request.value = input.substr(kHeaderSize + key_length, value_length);
+        consumed = kHeaderSize + key_length + value_length;
+        return ParseStatus::Ok;
+    }
+
+    ParseStatus parseResponse(std::string_view input, Response &response, size_t &consumed)
+    {
+        if (input.size() < kHeaderSize)
+            return input.empty() || static_cast<uint8_t>(input[0]) == kResponseMagic ? ParseStatus::Incomplete
+                                                                                     : ParseStatus::Error;
+        if (static_cast<uint8_t>(input[0]) != kResponseMagic)
+            return ParseStatus::Error;
+
+        size_t value_length = load<uint32_t>(input.data() + 4);
+        if (value_length > kMaxValueLength)
+            return ParseStatus::Error;
+        if (input.size() < kHeaderSize + value_length)
+            return ParseStatus::Incomplete;
+
+        response.status = static_cast<Status>(input[1]);
+        response.id = load<uint64_t>(input.data() + 8);
+        response.value = input.substr(kHeaderSize, value_length);
+        consumed = kHeaderSize + value_length;
+        return ParseStatus::Ok;
+    }
+
+    void appendRequest(std::string &out, Opcode opcode, uint64_t id, std::string_view key, std::string_view value)
+    {
+        char header[kHeaderSize];
+        encodeHeader(header, kRequestMagic, static_cast<uint8_t>(opcode), static_cast<uint16_t>(key.size()),
+                     static_cast<uint32_t>(value.size()), id);
+        out.append(header, kHeaderSize).append(key).append(value);
+    }
+
+    void appendResponse(std::pmr::string &out, Status status, uint64_t id, std::string_view value)
+    {
+        char header[kHeaderSize];
+        encodeHeader(header, kResponseMagic, static_cast<uint8_t>(status), 0, static_cast<uint32_t>(value.size()), id);
+        out.append(header, kHeaderSize).append(value);
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Framing of the compact binary protocol, shared by the server and
+ *        BinaryClient.
+ *
+ * Every message is a 16-byte header followed by its payload; all integers
+ * are little-endian.
+ *
+ *   Request:  magic(1)=0xB1 opcode(1) key_length(2) value_length(4) request_id(8) key value
+ *   Response: magic(1)=0xB2 status(1) reserved(2)  value_length(4) request_id(8) value
+ *
+ * The request ID is chosen by the client and echoed in the response. Many
+ * requests may be outstanding on one connection and the server answers
+ * them in any order (a cache hit is answered before an earlier database
+ * miss), so clients match responses to requests by ID. Requests for the same
+ * key are still executed in the order they were sent.
+ */
+namespace binproto
+{
+    enum class Opcode : uint8_t
+    {
+        Get = 1,
+        Put = 2,
+        Delete = 3,
+        Ping = 4
+    };
+
+    enum class Status : uint8_t
+    {
+        Ok = 0,
+        NotFound = 1,    // Get/Delete of a missing key
+        BadRequest = 2,  // Unknown opcode or empty key
+        ServerError = 3  // Storage failure
+    };
+
+    constexpr uint8_t kRequestMagic = 0xB1;
+    constexpr uint8_t kResponseMagic = 0xB2;
+    constexpr size_t kHeaderSize = 16;
+    constexpr size_t kMaxKeyLength = UINT16_MAX;
+    constexpr size_t kMaxValueLength = 16 * 1024 * 1024;
+
+    struct Request
+    {
+        Opcode opcode = Opcode::Ping;
+        uint64_t id = 0;
+        std::string_view key;
+        std::string_view value; // Put only
+    };
+
+    struct Response
+    {
+        Status status = Status::Ok;
+        uint64_t id = 0;
+        std::string_view value; // Get only
+    };
+
+    enum class ParseStatus
+    {
+        Ok,         // A complete message; 'consumed' bytes belong to it
+        Incomplete, // Wait for more input
+        Error       // Bad magic or oversized message: the stream can't be framed
+    };
+
+    /**
+     * @brief Parses one request from the start of 'input' (server side).
+     *
+     * Fields of 'request' are views into 'input'. Opcodes are not checked
+     * here, so an unknown one can still be answered with BadRequest.
+     */
+    ParseStatus parseRequest(std::string_view input, Request &request, size_t &consumed);
+
+    /**
+     * @brief Parses one response from the start of 'input' (client side).
+     */
+    ParseStatus parseResponse(std::string_view input, Response &response, size_t &consumed);
+
+    /**
+     * @brief Appends an encoded request to 'out' (client side).
+     */
+    void appendRequest(std::string &out, Opcode opcode, uint64_t id, std::string_view key,
+                       std::string_view value = {});
+
+    /**
+     * @brief Appends an encoded response to 'out' (server side).
+     */
+    void appendResponse(std::pmr::string &out, Status status, uint64_t id, std::string_view value = {});
+}
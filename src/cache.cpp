@@ -1,7 +1,124 @@
 #include "cache.hpp"     // Include the corresponding header file for LRUCache class definition
-#include <unordered_map> // For O(1) average time complexity key lookup
-#include <list>          // For O(1) time complexity item insertion/deletion at both ends, and efficient splicing
-#include <mutex>         // For thread safety
+#include "slab_allocator.hpp" // For inline, slab-allocated entry blocks
+#include "compression.hpp"    // For transparent compression of large values
+#include "large_value.hpp"    // For memfd-backed storage of very large values
+#include <atomic>        // For lock-free publication of entries and epoch counters
+#include <cstdint>       // For fixed-width epoch counters
+#include <cstring>       // For memcpy/memcmp on inline key and value bytes
+#include <functional>    // For std::hash
+#include <memory>        // For the bucket array
+#include <mutex>         // For serializing writers (put/del/evict)
+#include <new>           // For placement new into slab chunks
+#include <fcntl.h>       // For F_DUPFD_CLOEXEC
+#include <sys/resource.h> // For RLIMIT_NOFILE, which bounds memfd-backed entries
+#include <unistd.h>      // For close() of memfd-backed values
+#include <utility>       // For std::pair
+#include <vector>        // For the clock ring, free slots and retire list
+
+// =======================
+// Epoch-Based Reclamation
+// =======================
+//
+// Readers never lock. Instead, before touching the index a reader publishes the
+// current global epoch in its own slot, and clears it (0 = quiescent) when done.
+// A writer that unlinks an entry cannot free it immediately because a reader may
+// still be standing on it; it "retires" the entry tagged with the global epoch.
+// The global epoch can only advance once every active reader has observed it, so
+// after two advances no reader can hold a pointer to an entry retired earlier.
+//
+// The domain is process-wide and shared by all cache instances; each thread
+// claims one slot the first time it reads and releases it when the thread exits.
+
+namespace
+{
+    // Maximum number of threads that can read concurrently without falling back
+    // to the writer mutex. Comfortably above any realistic worker pool size.
+    constexpr size_t kMaxReaderSlots = 256;
+
+    // Number of retired entries to accumulate before trying to reclaim memory.
+    constexpr size_t kReclaimBatch = 64;
+
+    // One slot per reading thread, padded to a cache line so readers on
+    // different cores never write to the same line.
+    struct alignas(64) ReaderSlot
+    {
+        std::atomic<uint64_t> epoch{0}; // Epoch the reader entered in, 0 when quiescent
+        std::atomic<bool> claimed{false};
+    };
+
+    ReaderSlot g_reader_slots[kMaxReaderSlots];
+    std::atomic<uint64_t> g_global_epoch{1};
+
+    // Owns a reader slot for the lifetime of the calling thread.
+    struct SlotHandle
+    {
+        ReaderSlot *slot = nullptr;
+
+        SlotHandle()
+        {
+            for (auto &candidate : g_reader_slots)
+            {
+                bool expected = false;
+                if (candidate.claimed.compare_exchange_strong(expected, true))
+                {
+                    slot = &candidate;
+                    break;
+                }
+            }
+        }
+
+        ~SlotHandle()
+        {
+            if (slot)
+            {
+                slot->epoch.store(0, std::memory_order_release);
+                slot->claimed.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    // Returns this thread's reader slot, or nullptr if all slots are taken.
+    ReaderSlot *localReaderSlot()
+    {
+        thread_local SlotHandle handle;
+        return handle.slot;
+    }
+
+    // RAII guard marking the calling thread as inside a read-side critical section.
+    class EpochGuard
+    {
+    public:
+        explicit EpochGuard(ReaderSlot *slot) : slot(slot)
+        {
+            slot->epoch.store(g_global_epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+            // The announcement must be visible before we load any index pointer,
+            // otherwise a writer could miss us and free what we are about to read.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+
+        ~EpochGuard()
+        {
+            slot->epoch.store(0, std::memory_order_release);
+        }
+
+    private:
+        ReaderSlot *slot;
+    };
+
+    // Advances the global epoch if every active reader has caught up with it.
+    void tryAdvanceEpoch()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint64_t current = g_global_epoch.load(std::memory_order_seq_cst);
+        for (auto &slot : g_reader_slots)
+        {
+            uint64_t seen = slot.epoch.load(std::memory_order_seq_cst);
+            if (seen != 0 && seen != current)
+                return; // A reader is still in an older epoch
+        }
+        g_global_epoch.compare_exchange_strong(current, current + 1);
+    }
+}
 
 // --- PIMPL Implementation Struct Definition ---
 
@@ -10,27 +127,400 @@
 
 struct LRUCache::Impl
 {
+    // A single cached item, stored as one slab chunk: this header followed by
+    // the key bytes and then the value bytes. Key and value are immutable once
+    // the entry is published; an update publishes a replacement entry instead.
+    struct Entry
+    {
+        size_t hash;
+
+        // Next entry in the same hash bucket (readers follow it without locks).
+        std::atomic<Entry *> next{nullptr};
+
+        // CLOCK access bit, set by readers with relaxed stores.
+        std::atomic<bool> referenced{true};
+
+        // Position of this entry in the clock ring (writer-only).
+        size_t clock_slot = 0;
+
+        size_t key_len;
+        size_t value_len; // Stored bytes (compressed size if 'compressed')
+
+        // Compression metadata: when set, the value bytes are raw deflate data
+        // of a 'raw_len'-byte value whose CRC-32 is 'value_crc'.
+        bool compressed = false;
+        uint32_t value_crc = 0;
+        size_t raw_len = 0;
+
+        // When >= 0 the value is not stored inline but in this sealed memfd
+        // (value_len is then 0 and raw_len is the file size). Owned by the entry.
+        int fd = -1;
+
+        Entry(size_t h, size_t klen, size_t vlen) : hash(h), key_len(klen), value_len(vlen), raw_len(vlen) {}
+
+        std::string_view stored() const { return std::string_view(valueData(), value_len); }
+
+        // Writes the original value into 'out' ('raw_len' bytes), inflating if
+        // needed. Returns false if the memfd can't be read or the data is corrupt.
+        bool copyValue(char *out) const
+        {
+            if (fd >= 0)
+                return large_value::read(fd, out, raw_len);
+            if (compressed)
+                return compression::inflateValue(stored(), out, raw_len);
+            std::memcpy(out, valueData(), value_len);
+            return true;
+        }
+
+        const char *keyData() const { return reinterpret_cast<const char *>(this + 1); }
+        const char *valueData() const { return keyData() + key_len; }
+
+        bool keyEquals(std::string_view k) const
+        {
+            return k.size() == key_len && std::memcmp(keyData(), k.data(), key_len) == 0;
+        }
+
+        // Total size of the block holding this entry.
+        size_t blockSize() const { return sizeof(Entry) + key_len + value_len; }
+
+        // Allocates one slab block and lays out header, key and value inline.
+        static Entry *create(std::string_view k, std::string_view v, size_t h)
+        {
+            void *block = SlabAllocator::instance().allocate(sizeof(Entry) + k.size() + v.size());
+            Entry *e = new (block) Entry(h, k.size(), v.size());
+            char *data = reinterpret_cast<char *>(e + 1);
+            std::memcpy(data, k.data(), k.size());
+            std::memcpy(data + k.size(), v.data(), v.size());
+            return e;
+        }
+
+        static void destroy(Entry *e)
+        {
+            size_t size = e->blockSize();
+            if (e->fd >= 0)
+                close(e->fd);
+            e->~Entry();
+            SlabAllocator::instance().deallocate(e, size);
+        }
+    };
+
     // Stores the maximum number of key-value pairs the cache can hold.
     size_t capacity;
 
-    // A Doubly Linked List to maintain the usage order.
-    // The front of the list (begin()) is the Most Recently Used (MRU) item.
-    // The back of the list (end()) is the Least Recently Used (LRU) item.
-    // Each node stores a pair of <key, {value,version no.}>.
+    // Values of at least this many bytes are stored compressed (0 = never).
+    size_t compress_threshold;
+
+    // Values of at least this many bytes are stored in memfds (0 = never).
+    size_t file_threshold;
+
+    // Fixed-size hash index (power of two buckets, never resized because the
+    // capacity is fixed). Each bucket is a singly linked chain of entries.
+    size_t bucket_mask;
+    std::unique_ptr<std::atomic<Entry *>[]> buckets;
+
+    // The clock ring holds every live entry; the hand sweeps it on eviction,
+    // clearing access bits and evicting the first entry whose bit is already clear.
+    std::vector<Entry *> clock;
+    std::vector<size_t> free_slots;
+    size_t clock_hand = 0;
+    size_t count = 0;
+
+    // Bytes of live entry blocks (header + key + value), for memory statistics.
+    size_t entry_bytes = 0;
 
-    std::list<std::pair<std::string, std::string>> item_list;
+    // Live values held in memfds and their total size. Each holds a descriptor,
+    // so at most max_file_entries are kept; past that, values go to the slab heap.
+    size_t file_entries = 0;
+    size_t file_bytes = 0;
+    size_t max_file_entries;
 
-    // A Hash Map (unordered_map) to provide O(1) average time complexity lookup by key.
-    // The value associated with the key is an iterator pointing to the item's location
-    // in the 'item_list' linked list. This allows for O(1) updates to the list order.
-    std::unordered_map<std::string, decltype(item_list.begin())> item_map;
+    // Entries unlinked from the index, waiting for readers to drain, tagged with
+    // the epoch in which they were retired.
+    std::vector<std::pair<uint64_t, Entry *>> retired;
 
-    // A Mutex to protect the shared data ('item_list' and 'item_map') from simultaneous
-    // access by multiple threads, ensuring the cache is thread-safe.
+    // A Mutex serializing writers (put, del and eviction). Readers never take it
+    // unless the process has run out of reader slots.
     std::mutex mtx;
 
+    std::hash<std::string_view> hasher;
+
     // Constructor for the implementation struct.
-    Impl(size_t cap) : capacity(cap) {}
+    Impl(size_t cap, size_t threshold, size_t file_threshold)
+        : capacity(cap), compress_threshold(threshold), file_threshold(file_threshold),
+          clock(cap, nullptr), max_file_entries(fileEntryLimit())
+    {
+        size_t bucket_count = 16;
+        while (bucket_count < cap * 2)
+            bucket_count <<= 1;
+        bucket_mask = bucket_count - 1;
+        buckets.reset(new std::atomic<Entry *>[bucket_count]);
+        for (size_t i = 0; i < bucket_count; ++i)
+            buckets[i].store(nullptr, std::memory_order_relaxed);
+
+        free_slots.reserve(cap);
+        for (size_t i = cap; i > 0; --i)
+            free_slots.push_back(i - 1);
+    }
+
+    ~Impl()
+    {
+        for (size_t i = 0; i <= bucket_mask; ++i)
+        {
+            Entry *e = buckets[i].load(std::memory_order_relaxed);
+            while (e)
+            {
+                Entry *next = e->next.load(std::memory_order_relaxed);
+                Entry::destroy(e);
+                e = next;
+            }
+        }
+        for (auto &r : retired)
+            Entry::destroy(r.second);
+    }
+
+    // Lock-free lookup. Must be called inside an EpochGuard (or with mtx held).
+    Entry *find(std::string_view key, size_t h) const
+    {
+        Entry *e = buckets[h & bucket_mask].load(std::memory_order_acquire);
+        while (e)
+        {
+            if (e->hash == h && e->keyEquals(key))
+                return e;
+            e = e->next.load(std::memory_order_acquire);
+        }
+        return nullptr;
+    }
+
+    // Cached memfds may use a quarter of the descriptor limit, leaving the rest
+    // for connections and for the private copies handed out by getStored().
+    static size_t fileEntryLimit()
+    {
+        rlimit limit{};
+        if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur == RLIM_INFINITY)
+            return 1024;
+        return limit.rlim_cur / 4;
+    }
+
+    // Builds an entry, recording compression metadata when 'stored' is deflated
+    // or taking ownership of 'fd' when the value lives in a memfd.
+    static Entry *createEntry(std::string_view key, std::string_view stored, size_t h,
+                              bool compressed, uint32_t crc, size_t raw_len, int fd)
+    {
+        Entry *e = Entry::create(key, fd >= 0 ? std::string_view() : stored, h);
+        e->compressed = compressed;
+        e->value_crc = crc;
+        e->raw_len = raw_len;
+        e->fd = fd;
+        return e;
+    }
+
+    // Copies the entry's value into 'value' (a std::string or std::pmr::string),
+    // leaving it untouched if that fails. Inflating or reading a memfd can
+    // fail, so those go through a temporary (using the same allocator)
+    // swapped in on success; a plain copy can't, and reuses the capacity.
+    template <typename String>
+    static bool copyValueInto(const Entry *e, String &value)
+    {
+        if (!e->compressed && e->fd < 0)
+        {
+            value.assign(e->valueData(), e->value_len);
+            return true;
+        }
+        String copy(e->raw_len, '\0', value.get_allocator());
+        if (!e->copyValue(&copy[0]))
+            return false;
+        value.swap(copy);
+        return true;
+    }
+
+    // Memory accounting for an entry entering (live) or leaving the index. Writer-only.
+    void account(const Entry *e, bool live)
+    {
+        size_t files = e->fd >= 0 ? 1 : 0;
+        size_t file_size = e->fd >= 0 ? e->raw_len : 0;
+        if (live)
+        {
+            entry_bytes += e->blockSize();
+            file_entries += files;
+            file_bytes += file_size;
+        }
+        else
+        {
+            entry_bytes -= e->blockSize();
+            file_entries -= files;
+            file_bytes -= file_size;
+        }
+    }
+
+    // Lock-free read path shared by the get() overloads: looks the key up
+    // inside an epoch guard, records the access and hands the entry to 'copy'
+    // while it is still protected. Returns false if the key is absent.
+    template <typename CopyFn>
+    bool read(std::string_view key, CopyFn &&copy)
+    {
+        size_t h = hasher(key);
+
+        ReaderSlot *slot = localReaderSlot();
+        if (!slot)
+        {
+            // Every reader slot is in use: fall back to reading under the writer lock.
+            std::lock_guard<std::mutex> lock(mtx);
+            Entry *e = find(key, h);
+            if (!e)
+                return false;
+            e->referenced.store(true, std::memory_order_relaxed);
+            copy(e);
+            return true;
+        }
+
+        // 1. Enter a read-side critical section: entries we see cannot be freed
+        //    until we leave it, even if a writer unlinks them meanwhile.
+        EpochGuard guard(slot);
+
+        // 2. Walk the bucket chain without taking any lock.
+        Entry *e = find(key, h);
+        if (!e)
+            return false;
+
+        // 3. Record the access for the CLOCK evictor. Only write when the bit is
+        //    clear so hot entries don't bounce their cache line between cores.
+        if (!e->referenced.load(std::memory_order_relaxed))
+            e->referenced.store(true, std::memory_order_relaxed);
+
+        // 4. Copy the value out while the entry is still protected.
+        copy(e);
+        return true;
+    }
+
+    // Returns the link (bucket head or predecessor's 'next') that points to the
+    // entry for 'key', or nullptr if absent. Writer-only (mtx held).
+    std::atomic<Entry *> *findLink(std::string_view key, size_t h)
+    {
+        std::atomic<Entry *> *link = &buckets[h & bucket_mask];
+        Entry *e = link->load(std::memory_order_relaxed);
+        while (e)
+        {
+            if (e->hash == h && e->keyEquals(key))
+                return link;
+            link = &e->next;
+            e = link->load(std::memory_order_relaxed);
+        }
+        return nullptr;
+    }
+
+    // Hands an unlinked entry to the reclamation scheme and frees whatever is safe.
+    void retire(Entry *e)
+    {
+        retired.emplace_back(g_global_epoch.load(std::memory_order_acquire), e);
+        // Memfd-backed values are large enough to be worth reclaiming right away
+        // instead of letting a batch of them pile up.
+        if (retired.size() < kReclaimBatch && e->fd < 0)
+            return;
+
+        tryAdvanceEpoch();
+        uint64_t now = g_global_epoch.load(std::memory_order_acquire);
+        size_t freed = 0;
+        // Retired entries are appended in non-decreasing epoch order.
+        while (freed < retired.size() && retired[freed].first + 2 <= now)
+        {
+            Entry::destroy(retired[freed].second);
+            ++freed;
+        }
+        retired.erase(retired.begin(), retired.begin() + freed);
+    }
+
+    // Removes an entry from its bucket chain and the clock ring. Writer-only.
+    void unlink(Entry *victim)
+    {
+        std::atomic<Entry *> *link = &buckets[victim->hash & bucket_mask];
+        while (link->load(std::memory_order_relaxed) != victim)
+            link = &link->load(std::memory_order_relaxed)->next;
+        link->store(victim->next.load(std::memory_order_relaxed), std::memory_order_release);
+
+        clock[victim->clock_slot] = nullptr;
+        free_slots.push_back(victim->clock_slot);
+        --count;
+        account(victim, false);
+        retire(victim);
+    }
+
+    // Publishes an entry for 'key' (insert or replace), evicting if the cache is
+    // full. 'stored' is the value as stored; 'fd' >= 0 means it lives in that memfd.
+    // Returns false, closing 'fd' and dropping any old entry for 'key', if that
+    // would exceed max_file_entries.
+    bool insert(std::string_view key, std::string_view stored, bool compressed, uint32_t crc,
+                size_t raw_len, int fd)
+    {
+        // Lock the mutex: only one writer at a time modifies the index.
+        std::lock_guard<std::mutex> lock(mtx);
+
+        size_t h = hasher(key);
+
+        // 1. Check if the key already exists (Update case).
+        std::atomic<Entry *> *link = findLink(key, h);
+        bool replaces_file = link && link->load(std::memory_order_relaxed)->fd >= 0;
+        if (fd >= 0 && !replaces_file && file_entries >= max_file_entries)
+        {
+            close(fd);
+            if (link)
+                unlink(link->load(std::memory_order_relaxed));
+            return false;
+        }
+        if (link)
+        {
+            // Key found: publish a replacement entry in place of the old one, so
+            // concurrent readers see either the old or the new value, never a torn one.
+            Entry *old = link->load(std::memory_order_relaxed);
+            Entry *fresh = createEntry(key, stored, h, compressed, crc, raw_len, fd);
+            fresh->next.store(old->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            fresh->clock_slot = old->clock_slot;
+            clock[fresh->clock_slot] = fresh;
+            link->store(fresh, std::memory_order_release);
+
+            account(fresh, true);
+            account(old, false);
+            retire(old);
+            return true; // Operation complete.
+        }
+
+        // 2. Key not found (New insertion case): make room if the cache is full.
+        if (count >= capacity)
+            evictOne();
+
+        // 3. Insert the new item at the head of its bucket chain.
+        Entry *fresh = createEntry(key, stored, h, compressed, crc, raw_len, fd);
+        std::atomic<Entry *> &head = buckets[h & bucket_mask];
+        fresh->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        fresh->clock_slot = free_slots.back();
+        free_slots.pop_back();
+        clock[fresh->clock_slot] = fresh;
+        ++count;
+        account(fresh, true);
+
+        // Publishing the head pointer makes the fully built entry visible to readers.
+        head.store(fresh, std::memory_order_release);
+        return true;
+    }
+
+    // Runs the CLOCK hand until one entry has been evicted. Writer-only, count > 0.
+    void evictOne()
+    {
+        while (true)
+        {
+            Entry *e = clock[clock_hand];
+            clock_hand = (clock_hand + 1) % capacity;
+            if (!e)
+                continue;
+            if (e->referenced.load(std::memory_order_relaxed))
+            {
+                // Second chance: clear the bit and move on.
+                e->referenced.store(false, std::memory_order_relaxed);
+                continue;
+            }
+            unlink(e);
+            return;
+        }
+    }
 };
 
 // --- LRUCache Public Methods Implementation ---
@@ -38,11 +528,13 @@ struct LRUCache::Impl
 /**
  * @brief Constructor for LRUCache. Allocates the implementation struct.
  * @param capacity The maximum size of the cache.
+ * @param compress_threshold Minimum value size stored compressed (0 disables compression).
+ * @param file_threshold Minimum value size stored in a memfd (0 disables it).
  */
-LRUCache::LRUCache(size_t capacity)
+LRUCache::LRUCache(size_t capacity, size_t compress_threshold, size_t file_threshold)
 {
     // Create and initialize the private implementation pointer.
-    cache_impl = new Impl(capacity);
+    cache_impl = new Impl(capacity, compress_threshold, file_threshold);
 }
 
 /**
@@ -55,30 +547,68 @@ LRUCache::~LRUCache()
 }
 
 /**
- * @brief Retrieves the value associated with a key, and marks the item as MRU.
+ * @brief Retrieves the value associated with a key, and marks the item as recently used.
  * @param key The key to look up.
- * @return The value if found, or an empty string if not found.
+ * @param value Output string, assigned only if true is returned.
+ * @return true if found. Values may be empty or contain NUL bytes, so the
+ *         result can't be signalled through the value itself. An entry that
+ *         can't be read back (corrupt compressed data) is reported as absent.
  */
-std::string LRUCache::get(const std::string &key)
+bool LRUCache::get(std::string_view key, std::string& value)
 {
-    // Lock the mutex: ensures exclusive access to the cache data for this operation.
-    std::lock_guard<std::mutex> lock(cache_impl->mtx);
+    bool copied = false;
+    return cache_impl->read(key, [&](const Impl::Entry *e) {
+        copied = Impl::copyValueInto(e, value);
+    }) && copied;
+}
+
+/**
+ * @brief Retrieves the value for a key into a caller-provided (arena) string.
+ * @param key The key to look up.
+ * @param value Output string, assigned only if true is returned.
+ * @return true if found and read back intact.
+ */
+bool LRUCache::get(std::string_view key, std::pmr::string &value)
+{
+    bool copied = false;
+    return cache_impl->read(key, [&](const Impl::Entry *e) {
+        copied = Impl::copyValueInto(e, value);
+    }) && copied;
+}
 
-    // 1. Check if the key exists in the map.
-    auto it = cache_impl->item_map.find(key);
-    // If the key is not found, return an empty string immediately.
-    if (it == cache_impl->item_map.end())
-        return {"", 0};
-
-    // 2. The item was found: it's now the Most Recently Used (MRU).
-    // Use std::list::splice to move the list node pointed to by 'it->second'
-    // from its current position to the front of the list (cache_impl->item_list.begin()).
-    // This is an O(1) operation as it only rearranges pointers.
-    cache_impl->item_list.splice(cache_impl->item_list.begin(), cache_impl->item_list, it->second);
-
-    // 3. The value is the 'second' element of the list node (it->second is the list iterator,
-    // which points to a std::pair<key, value>, so ->second is the value part).
-    return it->second->second;
+/**
+ * @brief Retrieves the value for a key exactly as stored (possibly compressed).
+ * @param key The key to look up.
+ * @param bytes Output string receiving the stored bytes.
+ * @param meta Output describing how to interpret 'bytes'.
+ * @return true if found.
+ */
+bool LRUCache::getStored(std::string_view key, std::pmr::string &bytes, StoredValue &meta)
+{
+    bool copied = false;
+    return cache_impl->read(key, [&](const Impl::Entry *e) {
+        // A memfd-backed value is handed out as a private descriptor: the entry
+        // (and its own descriptor) may be reclaimed while the caller still sends.
+        // Without one (e.g. EMFILE) there is nothing to send: report a miss,
+        // leaving the outputs untouched, so the caller reloads the value
+        // instead of answering with an empty body.
+        int fd = e->fd >= 0 ? fcntl(e->fd, F_DUPFD_CLOEXEC, 0) : -1;
+        if (e->fd >= 0 && fd < 0)
+            return;
+        bytes.assign(e->valueData(), e->value_len);
+        meta = {e->compressed, e->value_crc, e->raw_len, fd};
+        copied = true;
+    }) && copied;
+}
+
+/**
+ * @brief Checks whether a key is cached, marking it as recently used.
+ * @param key The key to look up.
+ * @return true if found.
+ */
+bool LRUCache::contains(std::string_view key)
+{
+    return cache_impl->read(key, [](const Impl::Entry *) {});
 }
 
 /**
@@ -86,67 +616,73 @@ std::string LRUCache::get(const std::string &key)
  * @param key The key to insert/update.
  * @param value The value to associate with the key.
  */
-void LRUCache::put(const std::string &key, const std::string &value)
+void LRUCache::put(std::string_view key, std::string_view value)
 {
-    // Lock the mutex: ensures exclusive access to the cache data.
-    std::lock_guard<std::mutex> lock(cache_impl->mtx);
+    if (cache_impl->capacity == 0)
+        return; // Caching disabled
 
-    // 1. Check if the key already exists (Update case).
-    auto it = cache_impl->item_map.find(key);
-    if (it != cache_impl->item_map.end())
+    // Very large values go to a memfd; they are served with sendfile() and
+    // not compressed. Like compression, this happens before taking the lock.
+    // If the cache already holds its share of memfds, store the value inline.
+    if (cache_impl->file_threshold > 0 && value.size() >= cache_impl->file_threshold)
     {
-        // Key found: Update the value in the list node.
-        
-            it->second->second = value;
-
-            // Mark as MRU: Move the node to the front of the list (O(1)).
-            cache_impl->item_list.splice(cache_impl->item_list.begin(), cache_impl->item_list, it->second);
-        
-
-        return; // Operation complete.
+        int fd = large_value::store(value);
+        if (fd >= 0 && cache_impl->insert(key, {}, false, 0, value.size(), fd))
+            return;
     }
 
-    // 2. Key not found (New insertion case): Check for capacity overflow.
-    if (cache_impl->item_list.size() >= cache_impl->capacity)
-    {
-        // A. Capacity exceeded: Find the Least Recently Used (LRU) item.
-        // The LRU item is always the last element in the list.
-        auto last = cache_impl->item_list.back();
+    // Compress large values before taking the lock so writers don't serialize
+    // on deflate. The scratch buffer is reused by this thread across calls.
+    thread_local std::string deflated;
+    uint32_t crc = 0;
+    bool compressed = cache_impl->compress_threshold > 0 &&
+                      value.size() >= cache_impl->compress_threshold &&
+                      compression::deflateValue(value, deflated, crc);
+    std::string_view stored = compressed ? std::string_view(deflated) : value;
 
-        // B. Remove the LRU item from the map.
-        cache_impl->item_map.erase(last.first);
+    cache_impl->insert(key, stored, compressed, crc, value.size(), -1);
+}
 
-        // C. Remove the LRU item from the list.
-        cache_impl->item_list.pop_back();
+/**
+ * @brief Inserts or updates a key whose value lives in a sealed memfd.
+ * @param key The key to insert/update.
+ * @param fd Sealed memfd holding the value; owned by the cache from now on.
+ * @param size Size of the value.
+ */
+void LRUCache::putFile(std::string_view key, int fd, size_t size)
+{
+    if (cache_impl->capacity == 0)
+    {
+        close(fd); // Caching disabled
+        return;
     }
-
-    // 3. Insert the new item.
-    // A. Add the new pair to the front of the list (MRU position).
-    cache_impl->item_list.emplace_front(key, value);
-
-    // B. Store the key and the iterator to the new list node in the map.
-    // cache_impl->item_list.begin() now points to the newly inserted node.
-    cache_impl->item_map[key] = cache_impl->item_list.begin();
+    cache_impl->insert(key, {}, false, 0, size, fd);
 }
 
 /**
  * @brief Removes a key-value pair from the cache.
  * @param key The key to delete.
  */
-void LRUCache::del(const std::string &key)
+void LRUCache::del(std::string_view key)
 {
-    // Lock the mutex: ensures exclusive access to the cache data.
+    // Lock the mutex: ensures exclusive access among writers.
     std::lock_guard<std::mutex> lock(cache_impl->mtx);
 
-    // 1. Find the key in the map.
-    auto it = cache_impl->item_map.find(key);
+    // 1. Find the key in the index.
+    std::atomic<Impl::Entry *> *link = cache_impl->findLink(key, cache_impl->hasher(key));
     // If not found, nothing to do, return.
-    if (it == cache_impl->item_map.end())
+    if (!link)
         return;
 
-    // 2. Remove the item from the list using the stored iterator (it->second).
-    cache_impl->item_list.erase(it->second);
+    // 2. Unlink it and let epoch-based reclamation free it once readers drain.
+    cache_impl->unlink(link->load(std::memory_order_relaxed));
+}
 
-    // 3. Remove the entry from the map.
-    cache_impl->item_map.erase(it);
-}
\ No newline at end of file
+/**
+ * @brief Reports the number of live entries and the bytes they occupy.
+ */
+LRUCache::Stats LRUCache::stats()
+{
+    std::lock_guard<std::mutex> lock(cache_impl->mtx);
+    return {cache_impl->count, cache_impl->entry_bytes, cache_impl->file_entries, cache_impl->file_bytes};
+}
@@ -1,10 +1,25 @@
 #pragma once // Ensures this header file is included only once during compilation.
 #include <string> // Includes the standard string class, used for keys and values.
+#include <cstdint>         // For the CRC-32 in StoredValue
+#include <string_view>     // Keys are passed as views so callers need not own a std::string.
+#include <memory_resource> // For copying values into caller-provided (arena) strings.
 
 /**
  * @brief Represents a thread-safe, fixed-size Least Recently Used (LRU) cache.
  * * An LRU cache stores key-value pairs and, when full, removes the item
  * that hasn't been accessed for the longest time to make space for new items.
+ *
+ * * Recency is approximated with the CLOCK (second-chance) algorithm so that
+ * reads never take a lock: get() walks an RCU-style hash index under an
+ * epoch guard and only sets a relaxed per-entry access bit. Writers (put/del
+ * and the evictor) serialize on a mutex, publish new entries with atomic
+ * pointer swaps and hand unlinked entries to epoch-based reclamation, which
+ * frees them once no reader can still be looking at them.
+ *
+ * * Each entry (bookkeeping, key and value) lives in a single block obtained
+ * from the process-wide SlabAllocator. Values above a configurable size are
+ * stored deflate-compressed and inflated transparently by get(). Very large
+ * values are kept outside the slab heap in sealed memfds (see large_value.hpp).
  */
 
 class LRUCache
@@ -12,54 +27,135 @@ class LRUCache
 private:
     /* data */
     // --- PIMPL Idiom Start ---
-    
+
     // Forward declaration of the private implementation structure.
-    // This hides all internal data members (like the map and list)
+    // This hides all internal data members (like the hash index and clock ring)
     // from users of the header file, reducing compilation dependencies.
     struct Impl;
-    
+
     // Pointer to the actual implementation structure.
     // This is the "pointer to implementation" part of the PIMPL idiom.
     Impl* cache_impl;
 
     // --- PIMPL Idiom End ---
 
-    
+
 
 public:
+    /**
+     * @brief Occupancy snapshot, used by the /stats endpoint.
+     */
+    struct Stats
+    {
+        size_t entries;     // Live key-value pairs
+        size_t entry_bytes; // Bytes of their slab blocks (header + key + value)
+        size_t file_entries; // Entries whose value lives in a memfd
+        size_t file_bytes;   // Total size of those values
+    };
+
+    /**
+     * @brief Describes the bytes returned by getStored().
+     */
+    struct StoredValue
+    {
+        bool compressed;   // Bytes are raw deflate data (see compression.hpp)
+        uint32_t crc32;    // CRC-32 of the original value (valid if compressed)
+        size_t raw_size;   // Size of the original value
+        int fd;            // -1, or a private descriptor of the memfd holding the
+                           // value ('bytes' is then empty); the caller must close() it
+    };
+
     /**
      * @brief Constructor for the LRUCache.
      * @param capacity The maximum number of items the cache can hold.
+     * @param compress_threshold Values of at least this many bytes are stored
+     *        deflate-compressed (0 disables compression).
+     * @param file_threshold Values of at least this many bytes are stored in a
+     *        memfd instead of the slab heap, uncompressed (0 disables it). At
+     *        most a quarter of RLIMIT_NOFILE memfds are kept at a time.
      */
-    LRUCache(size_t capacity);
-    
+    LRUCache(size_t capacity, size_t compress_threshold = 0, size_t file_threshold = 0);
+
     /**
      * @brief Destructor for the LRUCache.
      * * It is responsible for cleaning up the memory allocated for the 'impl' object.
+     * No other thread may be inside get()/put()/del() while the cache is destroyed.
      */
     ~LRUCache();
-    
+
     /**
      * @brief Retrieves the value associated with the given key.
-     * * If found, the item is moved to the Most Recently Used (MRU) position.
+     * * Lock-free: if found, the item's access bit is set so the evictor
+     * gives it a second chance instead of moving it in a list.
+     * * @param key The key to look up.
+     * @param value Output string; left untouched unless true is returned.
+     * @return true if the key was found (an empty value is a valid hit).
+     *         false also if the entry's compressed data or memfd can't be
+     *         read back, so callers fall back to the database.
+     */
+    bool get(std::string_view key, std::string& value);
+
+    /**
+     * @brief Copies the value for 'key' into 'value' using its allocator.
+     * * With an arena-backed string this performs no general-purpose heap allocation.
      * * @param key The key to look up.
-     * @return The value associated with the key, or an empty string if the key is not found.
+     * @param value Output string; left untouched unless true is returned.
+     * @return true if the key was found and read back, as get() above.
      */
-    std::string get(const std::string& key);
-    
+    bool get(std::string_view key, std::pmr::string& value);
+
+    /**
+     * @brief Copies the value for 'key' as stored, without decompressing it.
+     * * Lets the server send cached deflate data to gzip-capable clients as-is,
+     * and memfd-backed values with sendfile() (see StoredValue::fd).
+     * * @param key The key to look up.
+     * @param bytes Output string receiving the stored bytes.
+     * @param meta Output describing whether 'bytes' is compressed.
+     * @return true if the key was found, and for a memfd-backed value, a
+     *         private descriptor could be created (a miss otherwise). Both
+     *         outputs are left untouched on a miss.
+     */
+    bool getStored(std::string_view key, std::pmr::string& bytes, StoredValue& meta);
+
+    /**
+     * @brief Returns true if 'key' is cached, without copying its value.
+     * * Lock-free like get(), and likewise marks the item as recently used:
+     * it is meant for callers about to read the value.
+     * * @param key The key to look up.
+     */
+    bool contains(std::string_view key);
+
     /**
      * @brief Inserts or updates a key-value pair in the cache.
-     * * If the key already exists, its value is updated and it becomes MRU.
-     * If the key is new and the cache is full, the Least Recently Used (LRU) item is evicted.
+     * * If the key already exists, its entry is replaced with a new one.
+     * If the key is new and the cache is full, the CLOCK hand evicts the
+     * first entry whose access bit is clear (an approximation of LRU).
      * * @param key The unique key for the item.
      * @param value The data to be stored.
      */
-    void put(const std::string& key, const std::string& value);
-    
+    void put(std::string_view key, std::string_view value);
+
+    /**
+     * @brief Inserts or updates a key whose value is already in a sealed memfd.
+     * * Used for values that were streamed in and never held in memory. The
+     * cache takes ownership of 'fd' (it is closed even if caching is disabled,
+     * or if the cache already holds its limit of memfds, a quarter of
+     * RLIMIT_NOFILE; any older value for the key is then dropped).
+     * * @param key The unique key for the item.
+     * @param fd Sealed memfd holding the value (see large_value.hpp).
+     * @param size Size of the value in bytes.
+     */
+    void putFile(std::string_view key, int fd, size_t size);
+
     /**
      * @brief Explicitly removes a key-value pair from the cache.
      * * @param key The key of the item to delete.
      */
-    void del(const std::string& key);
-    
-};
\ No newline at end of file
+    void del(std::string_view key);
+
+    /**
+     * @brief Returns the current number of entries and their memory footprint.
+     */
+    Stats stats();
+
+};
@@ -0,0 +1,254 @@
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "cache.hpp"
+#include "key_distribution.hpp"
+#include "latency_histogram.hpp"
+
+/**
+ * @brief Microbenchmarks of the cache on its own, without HTTP or PostgreSQL.
+ *
+ * Measures get(), put() and del() throughput and latency for LRUCache and,
+ * as a reference, LockedListCache (the textbook LRU: one mutex, a list and
+ * a hash map), across thread counts, key distributions, hit ratios and
+ * value sizes. Each benchmark runs on 1 to 8 threads sharing one cache,
+ * with three arguments:
+ *
+ *  - zipf: 0 for uniform keys, 1 for Zipfian (theta 0.99, hot keys scattered);
+ *  - keyspace, as a multiple of the capacity: 1 fits in the cache, 10
+ *    hits about 10% of uniform reads;
+ *  - value: the value size in bytes.
+ *
+ * Throughput is items_per_second; the mean latency is the time per
+ * iteration. One operation in 64 is also timed on its own, into the
+ * p50_ns and p99_ns counters (averaged over the threads). Results are
+ * exported with Google Benchmark's flags, e.g.
+ *   cache_benchmark --benchmark_out=cache.json --benchmark_out_format=json
+ */
+
+namespace
+{
+    constexpr size_t kCapacity = 10000;
+    constexpr uint32_t kSampleGap = 64; // Operations between timed ones, on average
+    constexpr size_t kDeleteBatch = 1024; // Keys deleted before they are put back, untimed
+
+    /**
+     * @brief The textbook LRU cache: every operation, reads included, takes
+     *        one mutex and moves the entry to the front of a list.
+     */
+    class LockedListCache
+    {
+    public:
+        explicit LockedListCache(size_t capacity) : capacity(capacity) {}
+
+        bool get(std::string_view key, std::string &value)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = index.find(std::string(key));
+            if (it == index.end())
+                return false;
+            entries.splice(entries.begin(), entries, it->second);
+            value = it->second->second;
+            return true;
+        }
+
+        void put(std::string_view key, std::string_view value)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::string owned(key);
+            auto it = index.find(owned);
+            if (it != index.end())
+            {
+                it->second->second.assign(value);
+                entries.splice(entries.begin(), entries, it->second);
+                return;
+            }
+            if (entries.size() >= capacity && !entries.empty())
+            {
+                index.erase(entries.back().first);
+                entries.pop_back();
+            }
+            entries.emplace_front(owned, std::string(value));
+            index.emplace(std::move(owned), entries.begin());
+        }
+
+        void del(std::string_view key)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = index.find(std::string(key));
+            if (it == index.end())
+                return;
+            entries.erase(it->second);
+            index.erase(it);
+        }
+
+    private:
+        using Entry = std::pair<std::string, std::string>;
+        size_t capacity;
+        std::mutex mutex;
+        std::list<Entry> entries; // Most recently used first
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    };
+
+    // What every thread of one benchmark run shares: set up by thread 0
+    // before the timed loop (Google Benchmark starts the threads' loops together).
+    template <class Cache>
+    struct Setup
+    {
+        std::unique_ptr<Cache> cache;
+        std::unique_ptr<KeyDistribution> keys;
+        std::vector<std::string> key_names;
+        std::string value;
+    };
+
+    template <class Cache>
+    Setup<Cache> g_setup;
+
+    // Creates the cache and fills it with the whole key space (the cache
+    // keeps what fits).
+    template <class Cache>
+    void setUp(const benchmark::State &state)
+    {
+        Setup<Cache> &setup = g_setup<Cache>;
+        uint64_t key_count = kCapacity * state.range(1);
+        std::string error;
+        setup.keys = KeyDistribution::parse(state.range(0) ? "scrambled:0.99" : "uniform", key_count, error);
+        setup.key_names.clear();
+        for (uint64_t i = 0; i < key_count; i++)
+            setup.key_names.push_back("key_" + std::to_string(i));
+        setup.value.assign(state.range(2), 'v');
+        setup.cache = std::make_unique<Cache>(kCapacity);
+        for (const std::string &key : setup.key_names)
+            setup.cache->put(key, setup.value);
+    }
+
+    template <class Cache>
+    void tearDown()
+    {
+        g_setup<Cache>.cache.reset();
+        g_setup<Cache>.key_names.clear();
+    }
+
+    // Sets the per-thread latency counters from the sampled operations.
+    void reportLatency(benchmark::State &state, const LatencyHistogram &sampled)
+    {
+        state.counters["p50_ns"] = benchmark::Counter(sampled.valueAtPercentile(50), benchmark::Counter::kAvgThreads);
+        state.counters["p99_ns"] = benchmark::Counter(sampled.valueAtPercentile(99), benchmark::Counter::kAvgThreads);
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    // Runs 'operation' on a key drawn from the distribution per iteration,
+    // timing one in 64 on its own. The gaps between timed operations are
+    // random, so they don't line up with work the cache does periodically.
+    // The setup is only read inside the loop: before it, thread 0 may still
+    // be setting it up.
+    template <class Cache, class Operation>
+    void runOperations(benchmark::State &state, const Setup<Cache> &setup, LatencyHistogram &sampled,
+                       Operation operation)
+    {
+        std::mt19937 gen(state.thread_index() + 1);
+        uint32_t until_sample = 0;
+        for (auto _ : state)
+        {
+            const std::string &key = setup.key_names[setup.keys->next(gen)];
+            if (until_sample-- == 0)
+            {
+                until_sample = gen() % (2 * kSampleGap);
+                auto start = std::chrono::steady_clock::now();
+                operation(key);
+                sampled.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count());
+            }
+            else
+                operation(key);
+        }
+    }
+}
+
+template <class Cache>
+void BM_Get(benchmark::State &state)
+{
+    if (state.thread_index() == 0)
+        setUp<Cache>(state);
+    Setup<Cache> &setup = g_setup<Cache>;
+    LatencyHistogram sampled;
+    std::string value;
+    uint64_t hits = 0;
+    runOperations(state, setup, sampled, [&](const std::string &key) {
+        hits += setup.cache->get(key, value);
+        benchmark::DoNotOptimize(value);
+    });
+    reportLatency(state, sampled);
+    state.counters["hit_ratio"] =
+        benchmark::Counter(state.iterations() ? static_cast<double>(hits) / state.iterations() : 0,
+                           benchmark::Counter::kAvgThreads);
+    if (state.thread_index() == 0)
+        tearDown<Cache>();
+}
+
+template <class Cache>
+void BM_Put(benchmark::State &state)
+{
+    if (state.thread_index() == 0)
+        setUp<Cache>(state);
+    Setup<Cache> &setup = g_setup<Cache>;
+    LatencyHistogram sampled;
+    runOperations(state, setup, sampled,
+                  [&](const std::string &key) { setup.cache->put(key, setup.value); });
+    reportLatency(state, sampled);
+    state.SetBytesProcessed(state.iterations() * setup.value.size());
+    if (state.thread_index() == 0)
+        tearDown<Cache>();
+}
+
+// Deletes keys that are (mostly) present: every 1024 deletes, the timer
+// stops while the thread puts its deleted keys back.
+template <class Cache>
+void BM_Del(benchmark::State &state)
+{
+    if (state.thread_index() == 0)
+        setUp<Cache>(state);
+    Setup<Cache> &setup = g_setup<Cache>;
+    LatencyHistogram sampled;
+    std::vector<const std::string *> deleted;
+    deleted.reserve(kDeleteBatch);
+    runOperations(state, setup, sampled, [&](const std::string &key) {
+        setup.cache->del(key);
+        deleted.push_back(&key);
+        if (deleted.size() == kDeleteBatch)
+        {
+            state.PauseTiming();
+            for (const std::string *name : deleted)
+                setup.cache->put(*name, setup.value);
+            deleted.clear();
+            state.ResumeTiming();
+        }
+    });
+    reportLatency(state, sampled);
+    if (state.thread_index() == 0)
+        tearDown<Cache>();
+}
+
+// Distribution x key space (multiple of the capacity) x value size, on 1 to 8 threads
+#define CACHE_BENCHMARK(name, Cache)                                                                       \
+    BENCHMARK_TEMPLATE(name, Cache)                                                                        \
+        ->ArgNames({"zipf", "keyspace", "value"})                                                          \
+        ->ArgsProduct({{0, 1}, {1, 10}, {64, 4096}})                                                       \
+        ->ThreadRange(1, 8)                                                                                \
+        ->UseRealTime()
+
+CACHE_BENCHMARK(BM_Get, LRUCache);
+CACHE_BENCHMARK(BM_Get, LockedListCache);
+CACHE_BENCHMARK(BM_Put, LRUCache);
+CACHE_BENCHMARK(BM_Put, LockedListCache);
+CACHE_BENCHMARK(BM_Del, LRUCache);
+CACHE_BENCHMARK(BM_Del, LockedListCache);
+
+BENCHMARK_MAIN();
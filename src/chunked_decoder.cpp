@@ -0,0 +1,89 @@
+#include "chunked_decoder.hpp" // ChunkedDecoder class definition
+#include <algorithm>            // For std::min
+
+ChunkedDecoder::Status ChunkedDecoder::next(std::string_view input, size_t &consumed, std::string_view &data)
+{
+    consumed = 0;
+    while (true)
+    {
+        std::string_view rest = input.substr(consumed);
+        switch (state)
+        {
+        case State::Size:
+        case State::Trailer:
+        {
+            // The limit holds however the line is split across calls: a
+            // partial line may end with the '\r' of its CRLF.
+            size_t eol = rest.find("\r\n");
+            if (eol == std::string_view::npos)
+                return rest.size() > kMaxLineLength + 1 ? Status::Error : Status::NeedMore;
+            if (eol > kMaxLineLength)
+                return Status::Error;
+            std::string_view line = rest.substr(0, eol);
+            consumed += eol + 2;
+
+            if (state == State::Trailer)
+            {
+                // Trailer fields are ignored; an empty line ends the body.
+                if (line.empty())
+                {
+                    state = State::Done;
+                    return Status::Done;
+                }
+                continue;
+            }
+
+            // Hex chunk size, optionally followed by ";extension" (ignored).
+            uint64_t size = 0;
+            size_t digits = 0;
+            for (char c : line)
+            {
+                int v;
+                if (c >= '0' && c <= '9')
+                    v = c - '0';
+                else if (c >= 'a' && c <= 'f')
+                    v = c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F')
+                    v = c - 'A' + 10;
+                else
+                    break;
+                if (size >> 60)
+                    return Status::Error; // Would overflow
+                size = size * 16 + v;
+                ++digits;
+            }
+            if (digits == 0 || (digits < line.size() && line[digits] != ';' && line[digits] != ' ' && line[digits] != '\t'))
+                return Status::Error;
+
+            remaining = size;
+            state = size == 0 ? State::Trailer : State::Data;
+            continue;
+        }
+
+        case State::Data:
+        {
+            if (rest.empty())
+                return Status::NeedMore;
+            size_t n = static_cast<size_t>(std::min<uint64_t>(remaining, rest.size()));
+            data = rest.substr(0, n);
+            consumed += n;
+            remaining -= n;
+            if (remaining == 0)
+                state = State::DataEnd;
+            return Status::Data;
+        }
+
+        case State::DataEnd:
+            if (rest.size() < 2)
+                return Status::NeedMore;
+            if (rest[0] != '\r' || rest[1] != '\n')
+                return Status::Error;
+            consumed += 2;
+            state = State::Size;
+            continue;
+
+        case State::Done:
+            return Status::Done;
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief Incremental decoder for HTTP/1.1 "Transfer-Encoding: chunked" bodies.
+ *
+ * The decoder keeps only a few bytes of state, never buffers payload, and can
+ * be fed input in arbitrarily small pieces, so a body of any size is decoded
+ * in memory bounded by the caller's receive buffer. Payload is returned as
+ * views into the caller's input.
+ *
+ * Usage: call next() with the unconsumed input; drop 'consumed' bytes from
+ * the front of it; on Data, process 'data'; on NeedMore, read more input
+ * (keeping the unconsumed tail) and call again; stop on Done or Error.
+ */
+class ChunkedDecoder
+{
+public:
+    enum class Status
+    {
+        NeedMore, // All complete input was consumed; more is needed to make progress
+        Data,     // 'data' holds the next piece of payload
+        Done,     // The terminating chunk and trailers have been consumed
+        Error     // Malformed encoding
+    };
+
+    // Longest chunk-size or trailer line accepted (extensions included).
+    static constexpr size_t kMaxLineLength = 1024;
+
+    /**
+     * @brief Decodes from the start of 'input'.
+     * @param input Unconsumed bytes received so far.
+     * @param consumed Receives the number of bytes of 'input' used up.
+     * @param data On Data, the payload (a view into 'input').
+     */
+    Status next(std::string_view input, size_t &consumed, std::string_view &data);
+
+private:
+    enum class State
+    {
+        Size,    // Expecting "<hex size>[;ext]\r\n"
+        Data,    // Inside a chunk's payload
+        DataEnd, // Expecting the "\r\n" after a chunk's payload
+        Trailer, // After the last chunk: trailer lines up to an empty line
+        Done
+    };
+
+    State state = State::Size;
+    uint64_t remaining = 0; // Payload bytes left in the current chunk
+};
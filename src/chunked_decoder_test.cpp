@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include "chunked_decoder.hpp"
+
+/**
+ * @brief Tests of ChunkedDecoder on well-formed and malformed bodies, fed
+ *        whole and in pieces of every size from 1 byte up.
+ *
+ * The decoder must give the same result wherever the reads split the body:
+ * inside a chunk size, between the '\r' and '\n' of a CRLF, or inside a
+ * trailer. Run by ctest; exits non-zero if any check fails.
+ */
+
+namespace
+{
+    int failures = 0;
+
+#define CHECK(condition)                                                        \
+    do                                                                          \
+    {                                                                           \
+        if (!(condition))                                                       \
+        {                                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                         \
+        }                                                                       \
+    } while (0)
+
+    using Status = ChunkedDecoder::Status;
+
+    struct Result
+    {
+        Status status;
+        std::string body;
+        size_t left = 0; // Bytes after the body that were not consumed
+    };
+
+    // Decodes 'encoded' received 'piece' bytes at a time, keeping the
+    // unconsumed tail like handleStreamingPut() does, until Done or Error.
+    Result decode(std::string_view encoded, size_t piece)
+    {
+        ChunkedDecoder decoder;
+        Result result{Status::NeedMore, {}};
+        std::string buffer;
+        size_t received = 0;
+        while (true)
+        {
+            size_t consumed = 0;
+            std::string_view data;
+            Status status = decoder.next(buffer, consumed, data);
+            if (status == Status::Data)
+                result.body.append(data);
+            buffer.erase(0, consumed);
+            if (status == Status::Done || status == Status::Error)
+            {
+                result.status = status;
+                result.left = buffer.size() + encoded.size() - received;
+                return result;
+            }
+            if (status == Status::NeedMore)
+            {
+                if (received == encoded.size())
+                    return result; // Input ended before the body did
+                size_t length = std::min(piece, encoded.size() - received);
+                buffer.append(encoded.substr(received, length));
+                received += length;
+            }
+        }
+    }
+
+    // Checks that every split of 'encoded' gives 'status' (and, when Done,
+    // 'body' with 'left' bytes after it).
+    void checkDecode(std::string_view encoded, Status status, std::string_view body = {}, size_t left = 0)
+    {
+        for (size_t piece = 1; piece <= encoded.size(); piece++)
+        {
+            Result result = decode(encoded, piece);
+            CHECK(result.status == status);
+            if (result.status != status)
+            {
+                std::fprintf(stderr, "  in %zu-byte pieces\n", piece);
+                return;
+            }
+            if (status == Status::Done)
+            {
+                CHECK(result.body == body);
+                CHECK(result.left == left);
+            }
+        }
+    }
+
+    void testWellFormed()
+    {
+        checkDecode("0\r\n\r\n", Status::Done, "");
+        checkDecode("5\r\nhello\r\n6\r\n world\r\n0\r\n\r\n", Status::Done, "hello world");
+        checkDecode("A\r\n0123456789\r\n0\r\n\r\n", Status::Done, "0123456789");
+        checkDecode("00000a\r\n0123456789\r\n0\r\n\r\n", Status::Done, "0123456789");
+        checkDecode("5;name=value\r\nhello\r\n0 ; last\r\n\r\n", Status::Done, "hello");
+        checkDecode("5\r\nhello\r\n0\r\nX-Checksum: 1234\r\nX-Other: a\r\n\r\n", Status::Done, "hello");
+
+        // A pipelined request after the body is left for the next parse.
+        checkDecode("3\r\nabc\r\n0\r\n\r\nGET / HTTP/1.1\r\n\r\n", Status::Done, "abc", 18);
+    }
+
+    // A body cut short asks for more rather than failing.
+    void testIncomplete()
+    {
+        for (std::string_view encoded : {"5\r\nhel", "5\r\nhello\r", "5\r\nhello\r\n0\r\n", "5\r\nhello\r\n0\r\nX-A: b\r\n"})
+        {
+            CHECK(decode(encoded, 1).status == Status::NeedMore);
+            CHECK(decode(encoded, encoded.size()).status == Status::NeedMore);
+        }
+    }
+
+    void testMalformedSizes()
+    {
+        checkDecode("\r\nhello\r\n0\r\n\r\n", Status::Error);       // No digits
+        checkDecode("g\r\nhello\r\n0\r\n\r\n", Status::Error);      // Not hex
+        checkDecode("5x\r\nhello\r\n0\r\n\r\n", Status::Error);     // Junk after the digits
+        checkDecode(" 5\r\nhello\r\n0\r\n\r\n", Status::Error);     // Leading space
+        checkDecode("-5\r\nhello\r\n0\r\n\r\n", Status::Error);     // Negative
+        checkDecode("0x5\r\nhello\r\n0\r\n\r\n", Status::Error);    // C-style prefix
+
+        // Leading zeros don't count towards the 16 hex digits that fit in 64
+        // bits; a 17th significant digit overflows.
+        checkDecode("0000000000000000005\r\nhello\r\n0\r\n\r\n", Status::Done, "hello");
+        checkDecode("10000000000000000\r\n", Status::Error);
+        checkDecode("fffffffffffffffff\r\n", Status::Error);
+    }
+
+    void testMalformedFraming()
+    {
+        checkDecode("5\r\nhelloX\r\n0\r\n\r\n", Status::Error);   // Chunk longer than its size
+        checkDecode("5\r\nhello\n0\r\n\r\n", Status::Error);      // Bare LF after the payload
+        checkDecode("5\r\nhello\r\r\n0\r\n\r\n", Status::Error);  // Stray CR
+    }
+
+    // Lines up to kMaxLineLength are accepted and longer ones rejected,
+    // whether or not their CRLF arrived in the same read.
+    void testLineLength()
+    {
+        size_t limit = ChunkedDecoder::kMaxLineLength;
+        std::string longest = "5;" + std::string(limit - 2, 'e');
+        std::string too_long = longest + "e";
+        checkDecode(longest + "\r\nhello\r\n0\r\n\r\n", Status::Done, "hello");
+        checkDecode(too_long + "\r\nhello\r\n0\r\n\r\n", Status::Error);
+
+        std::string trailer = "X-T: " + std::string(limit - 5, 't');
+        checkDecode("0\r\n" + trailer + "\r\n\r\n", Status::Done, "");
+        checkDecode("0\r\n" + trailer + "t\r\n\r\n", Status::Error);
+
+        // A line that never ends is rejected once it passes the limit,
+        // without waiting for the rest.
+        std::string endless(limit + 2, '0');
+        CHECK(decode(endless, 1).status == Status::Error);
+        CHECK(decode(endless, endless.size()).status == Status::Error);
+    }
+}
+
+int main()
+{
+    testWellFormed();
+    testIncomplete();
+    testMalformedSizes();
+    testMalformedFraming();
+    testLineLength();
+
+    if (failures > 0)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("chunked_decoder_test: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,239 @@
+#include "compression.hpp" // Declarations of the compression helpers
+#include <atomic>          // For global statistics counters
+#include <cctype>          // For std::tolower
+#include <ctime>           // For per-thread CPU time
+#include <zlib.h>          // deflate/inflate/crc32
+
+namespace compression
+{
+    namespace
+    {
+        std::atomic<uint64_t> g_values_compressed{0};
+        std::atomic<uint64_t> g_raw_bytes{0};
+        std::atomic<uint64_t> g_compressed_bytes{0};
+        std::atomic<uint64_t> g_compress_ns{0};
+        std::atomic<uint64_t> g_decompress_ns{0};
+        std::atomic<uint64_t> g_gzip_passthrough{0};
+        std::atomic<uint64_t> g_gzip_compressed{0};
+
+        // CPU time consumed by the calling thread, in nanoseconds.
+        uint64_t threadCpuNs()
+        {
+            timespec ts;
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+            return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+        }
+
+        // A zlib stream owned by one thread and reused across calls via *Reset().
+        struct ThreadStream
+        {
+            z_stream zs{};
+            bool deflating;
+            bool ready = false;
+
+            ThreadStream(bool deflating, int window_bits) : deflating(deflating)
+            {
+                if (deflating)
+                    ready = deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+                else
+                    ready = inflateInit2(&zs, window_bits) == Z_OK;
+            }
+
+            ~ThreadStream()
+            {
+                if (!ready)
+                    return;
+                if (deflating)
+                    deflateEnd(&zs);
+                else
+                    inflateEnd(&zs);
+            }
+        };
+
+        // Raw deflate (no zlib/gzip wrapper) for cached values.
+        ThreadStream &rawDeflater()
+        {
+            thread_local ThreadStream stream(true, -MAX_WBITS);
+            deflateReset(&stream.zs);
+            return stream;
+        }
+
+        ThreadStream &rawInflater()
+        {
+            thread_local ThreadStream stream(false, -MAX_WBITS);
+            inflateReset(&stream.zs);
+            return stream;
+        }
+
+        // deflate with a gzip wrapper (window bits + 16) for whole responses.
+        ThreadStream &gzipDeflater()
+        {
+            thread_local ThreadStream stream(true, MAX_WBITS + 16);
+            deflateReset(&stream.zs);
+            return stream;
+        }
+
+        void appendLE32(std::pmr::string &out, uint32_t v)
+        {
+            for (int i = 0; i < 4; ++i)
+                out.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+        }
+
+        // Appends 'data' as one or more deflate stored blocks. The caller must be
+        // at a byte boundary; only the last block gets the BFINAL bit if 'final'.
+        void appendStoredBlocks(std::pmr::string &out, std::string_view data, bool final)
+        {
+            do
+            {
+                size_t len = data.size() < 65535 ? data.size() : 65535;
+                bool last = len == data.size();
+                out.push_back(static_cast<char>(final && last ? 1 : 0)); // BFINAL + BTYPE=00, padded
+                out.push_back(static_cast<char>(len & 0xff));
+                out.push_back(static_cast<char>(len >> 8));
+                out.push_back(static_cast<char>(~len & 0xff));
+                out.push_back(static_cast<char>((~len >> 8) & 0xff));
+                out.append(data.substr(0, len));
+                data.remove_prefix(len);
+            } while (!data.empty());
+        }
+
+        uint32_t crcOf(std::string_view data)
+        {
+            return static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef *>(data.data()), static_cast<uInt>(data.size())));
+        }
+    }
+
+    bool deflateValue(std::string_view in, std::string &out, uint32_t &crc)
+    {
+        uint64_t start = threadCpuNs();
+        ThreadStream &stream = rawDeflater();
+        if (!stream.ready || in.size() < 16)
+            return false;
+
+        // Never keep a result that doesn't save at least 1/8 of the size.
+        out.resize(in.size() - in.size() / 8);
+        stream.zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in.data()));
+        stream.zs.avail_in = static_cast<uInt>(in.size());
+        stream.zs.next_out = reinterpret_cast<Bytef *>(&out[0]);
+        stream.zs.avail_out = static_cast<uInt>(out.size());
+
+        // Z_SYNC_FLUSH (not Z_FINISH) leaves the stream byte-aligned and non-final,
+        // so it can later be spliced into a larger gzip member.
+        int rc = deflate(&stream.zs, Z_SYNC_FLUSH);
+        bool ok = rc == Z_OK && stream.zs.avail_in == 0 && stream.zs.avail_out > 0;
+        if (ok)
+        {
+            out.resize(out.size() - stream.zs.avail_out);
+            crc = crcOf(in);
+            g_values_compressed.fetch_add(1, std::memory_order_relaxed);
+            g_raw_bytes.fetch_add(in.size(), std::memory_order_relaxed);
+            g_compressed_bytes.fetch_add(out.size(), std::memory_order_relaxed);
+        }
+        g_compress_ns.fetch_add(threadCpuNs() - start, std::memory_order_relaxed);
+        return ok;
+    }
+
+    bool inflateValue(std::string_view in, char *out, size_t raw_size)
+    {
+        uint64_t start = threadCpuNs();
+        ThreadStream &stream = rawInflater();
+        if (!stream.ready)
+            return false;
+
+        stream.zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in.data()));
+        stream.zs.avail_in = static_cast<uInt>(in.size());
+        stream.zs.next_out = reinterpret_cast<Bytef *>(out);
+        stream.zs.avail_out = static_cast<uInt>(raw_size);
+
+        int rc = inflate(&stream.zs, Z_SYNC_FLUSH);
+        bool ok = (rc == Z_OK || rc == Z_BUF_ERROR || rc == Z_STREAM_END) && stream.zs.avail_out == 0;
+        g_decompress_ns.fetch_add(threadCpuNs() - start, std::memory_order_relaxed);
+        return ok;
+    }
+
+    void appendGzipSpliced(std::pmr::string &out, std::string_view prefix,
+                           std::string_view deflated, uint32_t value_crc, size_t value_size,
+                           std::string_view suffix)
+    {
+        // gzip header: magic, CM=deflate, no flags, no mtime, XFL=0, OS=unix
+        static const char kHeader[10] = {'\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, 3};
+        out.append(kHeader, sizeof(kHeader));
+
+        appendStoredBlocks(out, prefix, false);
+        out.append(deflated);
+        appendStoredBlocks(out, suffix, true);
+
+        // The trailer covers the whole uncompressed body; combine the part CRCs
+        // instead of touching the value bytes again.
+        uLong crc = crc32_combine(crcOf(prefix), value_crc, static_cast<z_off_t>(value_size));
+        crc = crc32_combine(crc, crcOf(suffix), static_cast<z_off_t>(suffix.size()));
+        appendLE32(out, static_cast<uint32_t>(crc));
+        appendLE32(out, static_cast<uint32_t>(prefix.size() + value_size + suffix.size()));
+
+        g_gzip_passthrough.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void appendGzip(std::pmr::string &out, std::string_view in)
+    {
+        uint64_t start = threadCpuNs();
+        ThreadStream &stream = gzipDeflater();
+
+        size_t offset = out.size();
+        out.resize(offset + deflateBound(&stream.zs, static_cast<uLong>(in.size())));
+        stream.zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in.data()));
+        stream.zs.avail_in = static_cast<uInt>(in.size());
+        stream.zs.next_out = reinterpret_cast<Bytef *>(&out[offset]);
+        stream.zs.avail_out = static_cast<uInt>(out.size() - offset);
+        deflate(&stream.zs, Z_FINISH);
+        out.resize(out.size() - stream.zs.avail_out);
+
+        g_gzip_compressed.fetch_add(1, std::memory_order_relaxed);
+        g_compress_ns.fetch_add(threadCpuNs() - start, std::memory_order_relaxed);
+    }
+
+    bool acceptsGzip(std::string_view accept_encoding)
+    {
+        // Look for a "gzip" (or "*") token that is not disabled with q=0.
+        size_t pos = 0;
+        while (pos < accept_encoding.size())
+        {
+            size_t comma = accept_encoding.find(',', pos);
+            std::string_view item = accept_encoding.substr(pos, comma == std::string_view::npos ? std::string_view::npos : comma - pos);
+            while (!item.empty() && item.front() == ' ')
+                item.remove_prefix(1);
+
+            std::string_view coding = item.substr(0, item.find(';'));
+            while (!coding.empty() && coding.back() == ' ')
+                coding.remove_suffix(1);
+
+            bool is_gzip = coding.size() == 4 &&
+                           std::tolower(coding[0]) == 'g' && std::tolower(coding[1]) == 'z' &&
+                           std::tolower(coding[2]) == 'i' && std::tolower(coding[3]) == 'p';
+            if (is_gzip || coding == "*")
+            {
+                size_t q = item.find("q=");
+                if (q == std::string_view::npos)
+                    return true;
+                std::string_view qvalue = item.substr(q + 2);
+                // "q=0", "q=0.0", "q=0.00" ... mean "not acceptable"
+                return qvalue.find_first_not_of("0.") != std::string_view::npos && !qvalue.empty();
+            }
+
+            if (comma == std::string_view::npos)
+                break;
+            pos = comma + 1;
+        }
+        return false;
+    }
+
+    Stats stats()
+    {
+        return {g_values_compressed.load(std::memory_order_relaxed),
+                g_raw_bytes.load(std::memory_order_relaxed),
+                g_compressed_bytes.load(std::memory_order_relaxed),
+                g_compress_ns.load(std::memory_order_relaxed),
+                g_decompress_ns.load(std::memory_order_relaxed),
+                g_gzip_passthrough.load(std::memory_order_relaxed),
+                g_gzip_compressed.load(std::memory_order_relaxed)};
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief zlib helpers for transparent value compression.
+ *
+ * Large cache values are stored as raw deflate data that ends on a byte
+ * boundary (Z_SYNC_FLUSH) and is never marked final. That lets the server
+ * answer a gzip-accepting client by splicing the cached bytes between a stored
+ * block carrying the JSON prefix and a final stored block carrying the suffix,
+ * so a compressed value is compressed once and never recompressed per request.
+ *
+ * Deflate/inflate streams are kept per thread and reset between uses, so the
+ * hot paths do not allocate zlib state.
+ */
+namespace compression
+{
+    /**
+     * @brief Snapshot of compression activity, reported by /stats.
+     */
+    struct Stats
+    {
+        uint64_t values_compressed;    // Cache values stored compressed
+        uint64_t raw_bytes;            // Their size before compression
+        uint64_t compressed_bytes;     // ...and after
+        uint64_t compress_ns;          // CPU time spent compressing (values and responses)
+        uint64_t decompress_ns;        // CPU time spent inflating for non-gzip clients
+        uint64_t gzip_passthrough;     // Responses served from cached deflate bytes
+        uint64_t gzip_compressed;      // Responses gzipped on the fly
+    };
+
+    /**
+     * @brief Compresses 'in' to raw, sync-flushed deflate data.
+     * @param out Receives the compressed bytes.
+     * @param crc Receives the CRC-32 of 'in' (needed for the gzip trailer).
+     * @return false if compression did not save at least 1/8 of the size.
+     */
+    bool deflateValue(std::string_view in, std::string &out, uint32_t &crc);
+
+    /**
+     * @brief Inflates data produced by deflateValue().
+     * @param out Buffer of exactly 'raw_size' bytes receiving the original value.
+     * @param raw_size Size of the original value.
+     * @return false if the data is corrupt.
+     */
+    bool inflateValue(std::string_view in, char *out, size_t raw_size);
+
+    /**
+     * @brief Appends a complete gzip member equal to prefix + value + suffix,
+     * reusing the value's cached deflate bytes as-is.
+     */
+    void appendGzipSpliced(std::pmr::string &out, std::string_view prefix,
+                           std::string_view deflated, uint32_t value_crc, size_t value_size,
+                           std::string_view suffix);
+
+    /**
+     * @brief Gzips 'in' in one shot and appends the result to 'out'.
+     */
+    void appendGzip(std::pmr::string &out, std::string_view in);
+
+    /**
+     * @brief Returns true if an Accept-Encoding header value allows gzip.
+     */
+    bool acceptsGzip(std::string_view accept_encoding);
+
+    /**
+     * @brief Returns the accumulated statistics.
+     */
+    Stats stats();
+}
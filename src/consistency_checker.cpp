@@ -0,0 +1,297 @@
+#include "consistency_checker.hpp" // ConsistencyChecker class definition
+#include <algorithm>               // For std::partition_point, std::max, std::min
+#include <charconv>                // For std::from_chars
+#include <cstdio>                  // For snprintf
+#include <functional>              // For std::hash
+#include <random>                  // For std::random_device
+
+namespace
+{
+    constexpr size_t kShards = 64;
+    constexpr size_t kMaxHistory = 1024; // Writes kept per key
+    constexpr size_t kScanLimit = 256;   // Writes one check looks at
+    constexpr size_t kMaxExamples = 10;  // Anomalies described per report
+}
+
+uint64_t ConsistencyChecker::Report::totalAnomalies() const
+{
+    uint64_t total = 0;
+    for (uint64_t count : anomalies)
+        total += count;
+    return total;
+}
+
+ConsistencyChecker::ConsistencyChecker(Clock::time_point start) : run_start(start)
+{
+    std::random_device random;
+    char id[16];
+    snprintf(id, sizeof(id), "v%08x", random());
+    run_id = id;
+    for (size_t i = 0; i < kShards; i++)
+        shards.push_back(std::make_unique<Shard>());
+}
+
+ConsistencyChecker::Shard &ConsistencyChecker::shardOf(const std::string &key)
+{
+    return *shards[std::hash<std::string>()(key) % shards.size()];
+}
+
+uint64_t ConsistencyChecker::beginWrite(const std::string &key, bool is_delete)
+{
+    Shard &shard = shardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    KeyHistory &history = shard.keys[key];
+    if (history.writes.size() == kMaxHistory)
+    {
+        history.trimmed_end = std::max(history.trimmed_end, history.writes.front().end);
+        history.writes.pop_front();
+        history.first_version++;
+    }
+    // Taken under the lock, so the writes of a key start in version order
+    history.writes.push_back({Clock::now(), Clock::time_point::max(), is_delete});
+    return history.first_version + history.writes.size() - 1;
+}
+
+void ConsistencyChecker::endWrite(const std::string &key, uint64_t version, bool acknowledged,
+                                  Clock::time_point end)
+{
+    if (!acknowledged)
+        return; // Stays unknown
+    writes_acknowledged.fetch_add(1, std::memory_order_relaxed);
+
+    Shard &shard = shardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.keys.find(key);
+    if (it == shard.keys.end())
+        return;
+    KeyHistory &history = it->second;
+    history.first_end = std::min(history.first_end, end);
+    if (version >= history.first_version && version - history.first_version < history.writes.size())
+        history.writes[version - history.first_version].end = end;
+}
+
+std::string ConsistencyChecker::tag(const std::string &key, uint64_t version) const
+{
+    return run_id + "." + std::to_string(version) + "." + key;
+}
+
+size_t ConsistencyChecker::findOverwrite(const KeyHistory &history, size_t from, Clock::time_point after,
+                                         Clock::time_point before)
+{
+    const std::deque<Write> &writes = history.writes;
+    if (from >= writes.size())
+        return kNone;
+    // Writes are in order of start: skip those that started too early
+    size_t i = std::partition_point(writes.begin() + from, writes.end(),
+                                    [after](const Write &write) { return write.start <= after; }) -
+               writes.begin();
+    size_t scanned = 0;
+    for (; i < writes.size() && writes[i].start < before; i++)
+    {
+        if (writes[i].end < before)
+            return i;
+        if (++scanned == kScanLimit)
+            return kUnresolved;
+    }
+    return kNone;
+}
+
+bool ConsistencyChecker::checkRead(const std::string &key, Clock::time_point start, Clock::time_point end,
+                                   bool found, std::string_view value)
+{
+    reads_checked.fetch_add(1, std::memory_order_relaxed);
+
+    // Parse "<run>.<version>.<key>", up to an optional '|'
+    bool ours = false;
+    uint64_t version = 0;
+    std::string_view tag_key;
+    if (found)
+    {
+        std::string_view body = value.substr(0, value.find('|'));
+        if (body.size() > run_id.size() && body.compare(0, run_id.size(), run_id) == 0 &&
+            body[run_id.size()] == '.')
+        {
+            const char *digits = body.data() + run_id.size() + 1;
+            auto [next, error] = std::from_chars(digits, body.data() + body.size(), version);
+            if (error == std::errc() && next < body.data() + body.size() && *next == '.')
+            {
+                ours = true;
+                tag_key = body.substr(next + 1 - body.data());
+            }
+        }
+    }
+
+    Shard &shard = shardOf(key);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    auto it = shard.keys.find(key);
+    const KeyHistory *history = it == shard.keys.end() ? nullptr : &it->second;
+
+    Anomaly anomaly;
+    std::string detail;
+    size_t overwrite = kNone;
+    if (ours && tag_key != key)
+    {
+        anomaly = Anomaly::ForeignValue;
+        detail = "returned version " + std::to_string(version) + " of " + std::string(tag_key);
+    }
+    else if (ours)
+    {
+        uint64_t next_version = history ? history->first_version + history->writes.size() : 1;
+        if (version >= next_version)
+        {
+            anomaly = Anomaly::FutureRead;
+            detail = "returned version " + std::to_string(version) + ", which was never written";
+        }
+        else if (version < history->first_version)
+        {
+            // Trimmed: stale for sure only if a kept write superseded every trimmed one
+            overwrite = findOverwrite(*history, 0, history->trimmed_end, start);
+            if (overwrite == kNone || overwrite == kUnresolved)
+            {
+                reads_unresolved.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            anomaly = Anomaly::StaleRead;
+            detail = "returned version " + std::to_string(version) + " (no longer in the history)";
+        }
+        else
+        {
+            size_t index = version - history->first_version;
+            const Write &write = history->writes[index];
+            if (write.start >= end)
+            {
+                anomaly = Anomaly::FutureRead;
+                detail = "returned version " + std::to_string(version) + ", sent at " + describeTime(write.start);
+            }
+            else
+            {
+                overwrite = findOverwrite(*history, index + 1, write.end, start);
+                if (overwrite == kNone)
+                    return true;
+                if (overwrite == kUnresolved)
+                {
+                    reads_unresolved.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+                anomaly = Anomaly::StaleRead;
+                detail = "returned version " + std::to_string(version) + ", acknowledged at " +
+                         describeTime(write.end);
+            }
+        }
+    }
+    else if (!history || history->first_end >= start)
+    {
+        return true; // Whatever was there before the run may still be
+    }
+    else if (found)
+    {
+        anomaly = Anomaly::ForeignValue;
+        detail = "returned a value this run did not write, after its first write was acknowledged at " +
+                 describeTime(history->first_end);
+    }
+    else
+    {
+        // Not found: look for a DELETE that may still be current, newest first
+        const std::deque<Write> &writes = history->writes;
+        size_t index = std::partition_point(writes.begin(), writes.end(),
+                                            [end](const Write &write) { return write.start < end; }) -
+                       writes.begin();
+        size_t scanned = 0;
+        bool unresolved = false;
+        while (index > 0 && !unresolved)
+        {
+            index--;
+            if (++scanned > kScanLimit)
+                unresolved = true;
+            else if (writes[index].is_delete)
+            {
+                size_t found_overwrite = findOverwrite(*history, index + 1, writes[index].end, start);
+                if (found_overwrite == kNone)
+                    return true;
+                unresolved = found_overwrite == kUnresolved;
+            }
+        }
+        if (!unresolved && history->first_version > 1)
+        {
+            // A trimmed DELETE is current unless a kept write superseded every trimmed one
+            size_t found_overwrite = findOverwrite(*history, 0, history->trimmed_end, start);
+            unresolved = found_overwrite == kNone || found_overwrite == kUnresolved;
+        }
+        if (unresolved)
+        {
+            reads_unresolved.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        anomaly = Anomaly::LostWrite;
+        detail = "returned \"not found\"";
+        // Name the newest write acknowledged before the read
+        for (size_t i = writes.size(); i > 0; i--)
+        {
+            if (writes[i - 1].end < start)
+            {
+                overwrite = i - 1;
+                break;
+            }
+        }
+    }
+
+    if (overwrite != kNone && overwrite != kUnresolved)
+    {
+        const Write &write = history->writes[overwrite];
+        detail += "; version " + std::to_string(history->first_version + overwrite) + " (" +
+                  (write.is_delete ? "DELETE" : "PUT") + ") was sent at " + describeTime(write.start) +
+                  " and acknowledged at " + describeTime(write.end);
+    }
+    lock.unlock();
+    recordAnomaly(anomaly, key, start, end, detail);
+    return false;
+}
+
+std::string ConsistencyChecker::describeTime(Clock::time_point time) const
+{
+    if (time == Clock::time_point::max())
+        return "(never)";
+    char text[32];
+    snprintf(text, sizeof(text), "%.6f s", std::chrono::duration<double>(time - run_start).count());
+    return text;
+}
+
+void ConsistencyChecker::recordAnomaly(Anomaly anomaly, const std::string &key, Clock::time_point start,
+                                       Clock::time_point end, const std::string &detail)
+{
+    std::lock_guard<std::mutex> lock(report_mutex);
+    report.anomalies[static_cast<int>(anomaly)]++;
+    if (report.examples.size() < kMaxExamples)
+    {
+        report.examples.push_back(std::string(anomalyName(anomaly)) + ": GET " + key + " (sent at " +
+                                  describeTime(start) + ", answered at " + describeTime(end) + ") " + detail);
+    }
+}
+
+ConsistencyChecker::Report ConsistencyChecker::takeReport()
+{
+    std::lock_guard<std::mutex> lock(report_mutex);
+    Report taken = std::move(report);
+    report = Report();
+    taken.reads_checked = reads_checked.exchange(0);
+    taken.reads_unresolved = reads_unresolved.exchange(0);
+    taken.writes_acknowledged = writes_acknowledged.exchange(0);
+    return taken;
+}
+
+const char *ConsistencyChecker::anomalyName(Anomaly anomaly)
+{
+    switch (anomaly)
+    {
+    case Anomaly::StaleRead:
+        return "stale read";
+    case Anomaly::FutureRead:
+        return "future read";
+    case Anomaly::LostWrite:
+        return "lost write";
+    case Anomaly::ForeignValue:
+        return "foreign value";
+    default:
+        return "unknown";
+    }
+}
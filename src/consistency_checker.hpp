@@ -0,0 +1,160 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Checks the values a load test reads against the history of what it wrote.
+ *
+ * Every PUT writes a value starting with a tag naming the run, the key and
+ * a version (a per-key sequence number), so any value read can be traced
+ * back to the write that produced it. Writes are registered just before
+ * they are sent and completed when acknowledged; reads are checked when
+ * their response arrives. A read is consistent if some linearizable
+ * execution explains it, judged from the client's view of each request
+ * (sent no earlier than its start, answered no later than its end):
+ *
+ *  - it must not return a write that started after the read ended;
+ *  - it must not return a write W if another write of the key started
+ *    after W was acknowledged and was itself acknowledged before the read
+ *    started (a stale read, e.g. a cache filled from the database just
+ *    before a concurrent PUT or DELETE, and never corrected);
+ *  - "not found" needs a DELETE that could still be current, or no write
+ *    acknowledged before the read (the key may not have existed);
+ *  - a value this run did not write (left by an earlier run) is only
+ *    possible until the run's first acknowledged write of the key.
+ *
+ * Writes that failed, or got no response, may or may not have taken
+ * effect: reads may return them, but they never make other values stale.
+ * Since the client's times only widen each request's interval, a reported
+ * anomaly is a real one; some anomalies (e.g. among pipelined requests on
+ * one connection) are too close to call and go unnoticed.
+ *
+ * Each key keeps its last 1024 writes, and a check looks at no more than
+ * 256 of them; a read that would need more (a hot key with hundreds of
+ * writes in flight at once) is counted as unresolved rather than judged.
+ * The load generator must be the only writer.
+ *
+ * Thread-safe: keys are spread over independently locked shards.
+ */
+class ConsistencyChecker
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Anomaly
+    {
+        StaleRead,    // Returned a write already overwritten when the read started
+        FutureRead,   // Returned a write sent after the read was answered
+        LostWrite,    // "Not found", though a PUT was acknowledged and no DELETE can explain it
+        ForeignValue, // A value of another key, or one this run never wrote
+        Count
+    };
+
+    struct Report
+    {
+        uint64_t reads_checked = 0;
+        uint64_t reads_unresolved = 0; // Too many writes to look at
+        uint64_t writes_acknowledged = 0;
+        uint64_t anomalies[static_cast<int>(Anomaly::Count)] = {};
+        std::vector<std::string> examples; // Descriptions of the first few anomalies
+
+        uint64_t totalAnomalies() const;
+    };
+
+    /**
+     * @param start Times in anomaly descriptions are relative to it.
+     */
+    explicit ConsistencyChecker(Clock::time_point start);
+
+    /**
+     * @brief Registers a PUT (or DELETE) of 'key' that is about to be sent.
+     * @return The write's version; a PUT's value starts with tag(key, version).
+     */
+    uint64_t beginWrite(const std::string &key, bool is_delete);
+
+    /**
+     * @brief Records the response to a write.
+     * @param acknowledged The server confirmed it; otherwise its effect is unknown.
+     */
+    void endWrite(const std::string &key, uint64_t version, bool acknowledged, Clock::time_point end);
+
+    /**
+     * @brief Tag a PUT's value starts with: "<run>.<version>.<key>". Values
+     *        may continue after it, following a '|'.
+     */
+    std::string tag(const std::string &key, uint64_t version) const;
+
+    /**
+     * @brief Checks a read of 'key' sent at 'start' and answered at 'end'.
+     * @param found false if the server answered that the key does not exist.
+     * @return false if the read is an anomaly (then it is recorded).
+     */
+    bool checkRead(const std::string &key, Clock::time_point start, Clock::time_point end, bool found,
+                   std::string_view value);
+
+    /**
+     * @brief Returns the counts since the last call, and starts counting afresh.
+     *        The write history is kept.
+     */
+    Report takeReport();
+
+    static const char *anomalyName(Anomaly anomaly);
+
+private:
+    struct Write
+    {
+        Clock::time_point start;
+        Clock::time_point end = Clock::time_point::max(); // Acknowledged at; max() while unknown
+        bool is_delete;
+    };
+
+    struct KeyHistory
+    {
+        std::deque<Write> writes;   // In order of version (and of start)
+        uint64_t first_version = 1; // Version of writes.front(); earlier ones were trimmed
+        Clock::time_point trimmed_end = Clock::time_point::min(); // Latest end of a trimmed write
+        Clock::time_point first_end = Clock::time_point::max();   // Earliest acknowledgement of any write
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string, KeyHistory> keys;
+    };
+
+    Shard &shardOf(const std::string &key);
+
+    // Results of findOverwrite() other than an index
+    static constexpr size_t kNone = SIZE_MAX;
+    static constexpr size_t kUnresolved = SIZE_MAX - 1;
+
+    // Index of a write, from 'from' on, that started after 'after' and was
+    // acknowledged before 'before'.
+    static size_t findOverwrite(const KeyHistory &history, size_t from, Clock::time_point after,
+                                Clock::time_point before);
+
+    void recordAnomaly(Anomaly anomaly, const std::string &key, Clock::time_point start, Clock::time_point end,
+                       const std::string &detail);
+
+    // Seconds since the start of the run, for descriptions
+    std::string describeTime(Clock::time_point time) const;
+
+    Clock::time_point run_start;
+    std::string run_id; // Random, so values of earlier runs are told apart
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    std::atomic<uint64_t> reads_checked{0};
+    std::atomic<uint64_t> reads_unresolved{0};
+    std::atomic<uint64_t> writes_acknowledged{0};
+    std::mutex report_mutex; // Guards 'report' (anomalies)
+    Report report;
+};
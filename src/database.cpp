@@ -1,7 +1,7 @@
 #include "database.hpp" // Includes the header file where the Database class and its member functions are declared.
 #include <iostream>     // For input-output operations (std::cout, std::cerr).
 #include <sstream>      // For building strings efficiently using std::ostringstream.
-#include <cstring>      // For C-style string operations if needed (not directly used here but good for compatibility).
+#include <algorithm>    // For std::min
 
 // ==========================================================================================
 // Constructor: Establishes a connection to the PostgreSQL database using given parameters.
@@ -69,6 +69,10 @@ bool Database::reconnect()
     // Re-establish a new connection using the same connection string.
     conn = PQconnectdb(connection_string.c_str());
 
+    // Temporary tables belong to the old session.
+    upload_table_ready = false;
+    stream_open = false;
+
     // Return true if the new connection status is OK, otherwise false.
     return PQstatus(conn) == CONNECTION_OK;
 }
@@ -86,53 +90,29 @@ void Database::checkConnection()
     }
 }
 
-// ==========================================================================================
-// Escape a string so that it can be safely used in SQL queries (prevents SQL injection).
-// ==========================================================================================
-std::string Database::escapeString(const std::string &str)
-{
-    // Allocate enough space for the escaped version of the string.
-    // Each character may become up to 2 characters in the escaped version, hence length*2 + 1.
-    char *escaped = new char[str.length() * 2 + 1];
-
-    // Use PostgreSQL's built-in escape function to sanitize the string.
-    // PQescapeStringConn() escapes special characters in 'str' for safe SQL usage.
-    // The last parameter is for error reporting, which we set to nullptr here.
-    PQescapeStringConn(conn, escaped, str.c_str(), str.length(), nullptr);
-
-    // Convert the escaped C-string to a std::string for ease of use in C++.
-    std::string result(escaped);
-
-    // Free the dynamically allocated memory.
-    delete[] escaped;
-
-    // Return the escaped string.
-    return result;
-}
-
 // ==========================================================================================
 // PUT operation: Create or update a key-value pair in the database (Upsert).
 // ==========================================================================================
-bool Database::put(const std::string &key, const std::string &value)
+bool Database::put(std::string_view key, std::string_view value)
 {
     checkConnection(); // Ensure the connection is valid before executing SQL.
     if (!conn)
         return false; // If connection is invalid, return false immediately.
 
-    // Escape the key and value to avoid SQL injection.
-    std::string escaped_key = escapeString(key);
-    std::string escaped_value = escapeString(value);
-
-    // Build an SQL query for "INSERT ... ON CONFLICT (key) DO UPDATE".
-    // This ensures if the key already exists, it updates its value instead of inserting a duplicate.
-    std::ostringstream query;
-    query << "INSERT INTO kv_store (key, value) VALUES ('"
-          << escaped_key << "', '" << escaped_value << "') "
-          << "ON CONFLICT (key) DO UPDATE SET value = EXCLUDED.value";
-
-    // Execute the SQL command using PQexec().
-    // PQexec() sends a command to the PostgreSQL server and waits for the result.
-    PGresult *res = PQexec(conn, query.str().c_str());
+    // Pass key and value as binary-format parameters instead of splicing them
+    // into the SQL text: no escaping, no SQL injection, and the value goes into
+    // the BYTEA column byte-for-byte (embedded NULs and empty values included).
+    // (An empty view may have a null data() pointer, which libpq would read as SQL NULL.)
+    const char *param_values[2] = {key.data() ? key.data() : "", value.data() ? value.data() : ""};
+    int param_lengths[2] = {static_cast<int>(key.size()), static_cast<int>(value.size())};
+    int param_formats[2] = {1, 1}; // 1 = binary
+
+    // "INSERT ... ON CONFLICT (key) DO UPDATE" ensures that if the key already
+    // exists, its value is updated instead of inserting a duplicate.
+    PGresult *res = PQexecParams(conn,
+                                 "INSERT INTO kv_store (key, value) VALUES ($1, $2) "
+                                 "ON CONFLICT (key) DO UPDATE SET value = EXCLUDED.value",
+                                 2, nullptr, param_values, param_lengths, param_formats, 0);
 
     // Check the execution result status.
     ExecStatusType status = PQresultStatus(res);
@@ -155,21 +135,20 @@ bool Database::put(const std::string &key, const std::string &value)
 // ==========================================================================================
 // GET operation: Retrieve the value for a given key from the database.
 // ==========================================================================================
-bool Database::get(const std::string &key, std::string &value)
+bool Database::get(std::string_view key, std::string &value)
 {
     checkConnection(); // Ensure connection is alive before executing.
     if (!conn)
         return false; // Return false if connection is invalid.
 
-    // Escape the key to ensure safe query execution.
-    std::string escaped_key = escapeString(key);
-
-    // Construct a SELECT SQL query to retrieve the value corresponding to the given key.
-    std::ostringstream query;
-    query << "SELECT value FROM kv_store WHERE key = '" << escaped_key << "'";
+    const char *param_values[1] = {key.data() ? key.data() : ""};
+    int param_lengths[1] = {static_cast<int>(key.size())};
+    int param_formats[1] = {1};
 
-    // Execute the SQL query and store the result.
-    PGresult *res = PQexec(conn, query.str().c_str());
+    // Request the result in binary format (last argument = 1) so the BYTEA value
+    // comes back as raw bytes rather than hex-escaped text.
+    PGresult *res = PQexecParams(conn, "SELECT value FROM kv_store WHERE key = $1",
+                                 1, nullptr, param_values, param_lengths, param_formats, 1);
 
     // Get the status of the executed query.
     ExecStatusType status = PQresultStatus(res);
@@ -179,8 +158,9 @@ bool Database::get(const std::string &key, std::string &value)
     // If the query succeeded and returned at least one row...
     if (status == PGRES_TUPLES_OK && PQntuples(res) > 0)
     {
-        // Extract the value from the first row and first column.
-        value = PQgetvalue(res, 0, 0);
+        // Extract the value from the first row and first column, using the
+        // explicit length since binary data may contain NUL bytes.
+        value.assign(PQgetvalue(res, 0, 0), PQgetlength(res, 0, 0));
         found = true; // Mark as found.
     }
 
@@ -194,29 +174,19 @@ bool Database::get(const std::string &key, std::string &value)
 // ==========================================================================================
 // DELETE operation: Remove a key-value pair from the database.
 // ==========================================================================================
-bool Database::del(const std::string &key)
+bool Database::del(std::string_view key, bool *existed)
 {
     checkConnection(); // Ensure connection is valid.
     if (!conn)
         return false; // If not connected, return false.
 
-    // Escape the key to prevent SQL injection.
-    std::string escaped_key = escapeString(key);
+    const char *param_values[1] = {key.data() ? key.data() : ""};
+    int param_lengths[1] = {static_cast<int>(key.size())};
+    int param_formats[1] = {1};
 
-    // Build the SQL query to delete the record matching the given key.
-    std::ostringstream query;
-    query << "DELETE FROM kv_store WHERE key = '" << escaped_key << "'";
-
-    //   const char* paramValues[1] = {key.c_str()};
-    //     int paramLengths[1] = {(int)key.length()};
-
-    //     int paramFormats[1] = {0};
-    // PGresult* res = PQexecParams(conn,
-    //     "DELETE FROM kv_store WHERE key = $1",
-    //     1, NULL, paramValues, paramLengths, paramFormats, 0);
-
-    // Execute the DELETE command.
-    PGresult *res = PQexec(conn, query.str().c_str());
+    // Execute the DELETE command with the key as a parameter.
+    PGresult *res = PQexecParams(conn, "DELETE FROM kv_store WHERE key = $1",
+                                 1, nullptr, param_values, param_lengths, param_formats, 0);
 
     // Get the result status.
     ExecStatusType status = PQresultStatus(res);
@@ -230,6 +200,12 @@ bool Database::del(const std::string &key)
         std::cerr << "DELETE failed: " << PQerrorMessage(conn) << std::endl;
     }
 
+    // PQcmdTuples() gives the number of deleted rows as text ("0" or "1").
+    if (existed)
+    {
+        *existed = success && std::string_view(PQcmdTuples(res)) != "0";
+    }
+
     // Clear the result to release memory.
     PQclear(res);
 
@@ -237,6 +213,136 @@ bool Database::del(const std::string &key)
     return success;
 }
 
+// ==========================================================================================
+// Utility function: Run a parameterless statement (BEGIN, COMMIT, DDL, ...).
+// ==========================================================================================
+bool Database::execCommand(const char *sql)
+{
+    PGresult *res = PQexec(conn, sql);
+    bool success = PQresultStatus(res) == PGRES_COMMAND_OK;
+    if (!success)
+    {
+        std::cerr << "Statement failed (" << sql << "): " << PQerrorMessage(conn) << std::endl;
+    }
+    PQclear(res);
+    return success;
+}
+
+// ==========================================================================================
+// Streaming PUT: COPY the value into a staging table in pieces, then upsert it.
+// ==========================================================================================
+//
+// COPY cannot upsert, so the row is copied into a temporary table (one per
+// session, emptied at commit) and moved into kv_store with INSERT ... SELECT
+// ... ON CONFLICT inside the same transaction. The value is sent in COPY text
+// format as BYTEA hex ("\x" followed by two hex digits per byte), which lets
+// it be encoded piece by piece without knowing its total length up front.
+bool Database::beginPutStream(std::string_view key)
+{
+    checkConnection(); // Ensure the connection is valid before executing SQL.
+    if (!conn || stream_open)
+        return false;
+
+    if (!upload_table_ready)
+    {
+        upload_table_ready = execCommand("CREATE TEMP TABLE IF NOT EXISTS kv_upload (key TEXT, value BYTEA) "
+                                         "ON COMMIT DELETE ROWS");
+        if (!upload_table_ready)
+            return false;
+    }
+
+    if (!execCommand("BEGIN"))
+        return false;
+
+    PGresult *res = PQexec(conn, "COPY kv_upload (key, value) FROM STDIN");
+    bool copying = PQresultStatus(res) == PGRES_COPY_IN;
+    PQclear(res);
+    if (!copying)
+    {
+        std::cerr << "COPY failed: " << PQerrorMessage(conn) << std::endl;
+        execCommand("ROLLBACK");
+        return false;
+    }
+    stream_open = true;
+
+    // First column: the key, with COPY text-format escapes.
+    std::string prefix;
+    prefix.reserve(key.size() + 8);
+    for (char c : key)
+    {
+        switch (c)
+        {
+        case '\\': prefix += "\\\\"; break;
+        case '\n': prefix += "\\n"; break;
+        case '\r': prefix += "\\r"; break;
+        case '\t': prefix += "\\t"; break;
+        default: prefix += c; break;
+        }
+    }
+    // Column separator, then the start of the BYTEA hex literal (backslash escaped for COPY).
+    prefix += "\t\\\\x";
+    return PQputCopyData(conn, prefix.data(), static_cast<int>(prefix.size())) == 1;
+}
+
+bool Database::writePutStream(std::string_view data)
+{
+    if (!stream_open)
+        return false;
+
+    // Hex-encode through a fixed buffer, so memory stays bounded by its size.
+    static const char kHex[] = "0123456789abcdef";
+    char hex[16 * 1024];
+    while (!data.empty())
+    {
+        size_t n = std::min(data.size(), sizeof(hex) / 2);
+        for (size_t i = 0; i < n; ++i)
+        {
+            unsigned char byte = static_cast<unsigned char>(data[i]);
+            hex[2 * i] = kHex[byte >> 4];
+            hex[2 * i + 1] = kHex[byte & 0x0f];
+        }
+        if (PQputCopyData(conn, hex, static_cast<int>(2 * n)) != 1)
+            return false;
+        data.remove_prefix(n);
+    }
+    return true;
+}
+
+bool Database::endPutStream(bool commit)
+{
+    if (!stream_open)
+        return false;
+    stream_open = false;
+
+    // Terminate the row and the COPY; a non-null error message aborts it.
+    bool copied = (!commit || PQputCopyData(conn, "\n", 1) == 1) &&
+                  PQputCopyEnd(conn, commit ? nullptr : "upload aborted") == 1;
+
+    // Collect the COPY's result(s) so the connection is ready for new commands.
+    while (PGresult *res = PQgetResult(conn))
+    {
+        if (PQresultStatus(res) != PGRES_COMMAND_OK)
+            copied = false;
+        PQclear(res);
+    }
+
+    if (!commit || !copied)
+    {
+        if (commit)
+            std::cerr << "COPY failed: " << PQerrorMessage(conn) << std::endl;
+        execCommand("ROLLBACK");
+        return false;
+    }
+
+    if (!execCommand("INSERT INTO kv_store (key, value) SELECT key, value FROM kv_upload "
+                     "ON CONFLICT (key) DO UPDATE SET value = EXCLUDED.value"))
+    {
+        execCommand("ROLLBACK");
+        return false;
+    }
+    return execCommand("COMMIT");
+}
+
 // ==========================================================================================
 // Utility function: Check if the database connection is currently alive.
 // ==========================================================================================
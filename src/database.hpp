@@ -1,13 +1,20 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <memory>
 #include <libpq-fe.h>
 
 /**
  * @brief Database connection manager for PostgreSQL
  * 
- * Provides thread-safe database operations for KV store
+ * Provides thread-safe database operations for KV store.
+ * Keys and values are sent as binary-format query parameters, so values are
+ * binary-safe (stored in a BYTEA column) and never need SQL escaping.
+ *
+ * Large values can also be uploaded as a stream (beginPutStream /
+ * writePutStream / endPutStream): the bytes are piped into the server with
+ * COPY as they arrive, so the client side never holds the whole value.
  */
 class Database {
 private:
@@ -19,8 +26,12 @@ private:
     bool reconnect();
     // Check if the connection is alive, and reconnect if necessary
     void checkConnection();
-    // Escape a string to be safely used in SQL queries
-    std::string escapeString(const std::string& str);
+    // Run a statement without parameters; true if it completed successfully
+    bool execCommand(const char* sql);
+    // Whether this session's temporary upload table has been created
+    bool upload_table_ready = false;
+    // Whether a COPY started by beginPutStream() is in progress
+    bool stream_open = false;
 
 public:
 // Constructor: Establishes a connection to the PostgreSQL database
@@ -33,10 +44,10 @@ public:
     /**
      * @brief Create or update a key-value pair in database
      * @param key The key to insert/update
-     * @param value The value to store
+     * @param value The value to store (arbitrary bytes, may be empty)
      * @return true if successful, false otherwise
      */
-    bool put(const std::string& key, const std::string& value);
+    bool put(std::string_view key, std::string_view value);
     
     /**
      * @brief Retrieve value for a given key from database
@@ -44,14 +55,40 @@ public:
      * @param value Output parameter for the retrieved value
      * @return true if key exists, false otherwise
      */
-    bool get(const std::string& key, std::string& value);
+    bool get(std::string_view key, std::string& value);
     
     /**
      * @brief Delete a key-value pair from database
      * @param key The key to delete
+     * @param existed Optional output: whether a row was actually deleted
      * @return true if successful, false otherwise
      */
-    bool del(const std::string& key);
+    bool del(std::string_view key, bool* existed = nullptr);
+
+    /**
+     * @brief Starts a streaming upsert of 'key' whose value arrives in pieces.
+     *
+     * Opens a transaction and a COPY into a session-local staging table; the
+     * value is then sent with writePutStream() and published by endPutStream().
+     * Only one stream can be open per connection, and no other operation may
+     * be issued on this Database until it is ended.
+     * @param key The key to insert/update
+     * @return true if the stream was opened
+     */
+    bool beginPutStream(std::string_view key);
+
+    /**
+     * @brief Appends the next piece of the value to the open stream.
+     * @return false if the connection failed (the stream must still be ended)
+     */
+    bool writePutStream(std::string_view data);
+
+    /**
+     * @brief Finishes the stream.
+     * @param commit true to upsert the streamed value into kv_store, false to discard it
+     * @return true if the value was committed
+     */
+    bool endPutStream(bool commit);
     
     /**
      * @brief Check if database connection is alive
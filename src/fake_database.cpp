@@ -0,0 +1,228 @@
+#include "fake_database.hpp" // Configuration of the fake backend
+#include "database.hpp"      // The Database class defined here instead of database.cpp
+#include <atomic>            // For the operation counters
+#include <chrono>            // For sleep durations
+#include <functional>        // For std::hash
+#include <mutex>             // For per-shard locks
+#include <random>            // For latency and failure draws
+#include <sstream>           // For parsing latency specifications
+#include <thread>            // For std::this_thread::sleep_for
+#include <unordered_map>     // For the shards' tables
+#include <vector>            // For the specification fields
+
+namespace
+{
+    constexpr size_t kShards = 64;
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::string> values;
+    };
+
+    Shard g_shards[kShards];
+
+    // Delay of one kind of operation, in microseconds
+    struct Latency
+    {
+        enum class Type
+        {
+            Fixed,
+            Uniform,
+            Exponential
+        };
+        Type type = Type::Fixed;
+        double a = 0; // Fixed: the delay; uniform: minimum; exponential: mean
+        double b = 0; // Uniform: maximum
+    };
+
+    // Set by configure() before the server starts; read without locking.
+    Latency g_read_latency;
+    Latency g_write_latency;
+    double g_failure_rate = 0;
+
+    std::atomic<uint64_t> g_reads{0};
+    std::atomic<uint64_t> g_writes{0};
+    std::atomic<uint64_t> g_deletes{0};
+    std::atomic<uint64_t> g_failures{0};
+
+    std::mt19937 &generator()
+    {
+        thread_local std::mt19937 gen(std::random_device{}());
+        return gen;
+    }
+
+    Shard &shardOf(std::string_view key)
+    {
+        return g_shards[std::hash<std::string_view>()(key) % kShards];
+    }
+
+    bool parseLatency(const std::string &spec, Latency &latency, std::string &error)
+    {
+        std::vector<std::string> fields;
+        std::istringstream in(spec);
+        std::string field;
+        while (std::getline(in, field, ':'))
+            fields.push_back(field);
+        if (fields.empty())
+        {
+            error = "empty latency";
+            return false;
+        }
+
+        std::vector<double> numbers;
+        for (size_t i = (fields.size() > 1 ? 1 : 0); i < fields.size(); i++)
+        {
+            std::istringstream number_in(fields[i]);
+            double number;
+            if (!(number_in >> number) || !number_in.eof() || number < 0)
+            {
+                error = "invalid latency: " + spec;
+                return false;
+            }
+            numbers.push_back(number);
+        }
+
+        if (fields.size() == 1 || (fields[0] == "fixed" && numbers.size() == 1))
+            latency = {Latency::Type::Fixed, numbers[0], 0};
+        else if (fields[0] == "uniform" && numbers.size() == 2 && numbers[0] <= numbers[1])
+            latency = {Latency::Type::Uniform, numbers[0], numbers[1]};
+        else if (fields[0] == "exponential" && numbers.size() == 1)
+            latency = {Latency::Type::Exponential, numbers[0], 0};
+        else
+        {
+            error = "invalid latency: " + spec + " (expected N, fixed:N, uniform:MIN:MAX or exponential:MEAN)";
+            return false;
+        }
+        return true;
+    }
+
+    // Sleeps for one draw of 'latency'; then true if the operation is to fail.
+    bool simulate(const Latency &latency)
+    {
+        double delay_us = latency.a;
+        if (latency.type == Latency::Type::Uniform)
+            delay_us = std::uniform_real_distribution<double>(latency.a, latency.b)(generator());
+        else if (latency.type == Latency::Type::Exponential && latency.a > 0)
+            delay_us = std::exponential_distribution<double>(1 / latency.a)(generator());
+        if (delay_us > 0)
+            std::this_thread::sleep_for(std::chrono::duration<double, std::micro>(delay_us));
+
+        if (g_failure_rate > 0 && std::uniform_real_distribution<double>(0, 1)(generator()) < g_failure_rate)
+        {
+            g_failures.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    // A streamed put in progress. Each worker thread has its own Database,
+    // and a stream is begun and ended by the same request.
+    thread_local std::string t_stream_key;
+    thread_local std::string t_stream_value;
+}
+
+namespace fake_database
+{
+    bool configure(const Config &config, std::string &error)
+    {
+        Latency read_latency, write_latency;
+        if (!parseLatency(config.read_latency, read_latency, error) ||
+            !parseLatency(config.write_latency, write_latency, error))
+            return false;
+        if (config.failure_rate < 0 || config.failure_rate > 1)
+        {
+            error = "the failure rate must be between 0 and 1";
+            return false;
+        }
+        g_read_latency = read_latency;
+        g_write_latency = write_latency;
+        g_failure_rate = config.failure_rate;
+        return true;
+    }
+
+    Stats stats()
+    {
+        Stats result{g_reads.load(), g_writes.load(), g_deletes.load(), g_failures.load(), 0};
+        for (Shard &shard : g_shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            result.keys += shard.values.size();
+        }
+        return result;
+    }
+}
+
+Database::Database(const std::string &, const std::string &, const std::string &, const std::string &,
+                   const std::string &)
+    : conn(nullptr)
+{
+}
+
+Database::~Database() {}
+
+bool Database::put(std::string_view key, std::string_view value)
+{
+    g_writes.fetch_add(1, std::memory_order_relaxed);
+    if (simulate(g_write_latency))
+        return false;
+    Shard &shard = shardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.values[std::string(key)].assign(value);
+    return true;
+}
+
+bool Database::get(std::string_view key, std::string &value)
+{
+    g_reads.fetch_add(1, std::memory_order_relaxed);
+    if (simulate(g_read_latency))
+        return false;
+    Shard &shard = shardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.values.find(std::string(key));
+    if (it == shard.values.end())
+        return false;
+    value = it->second;
+    return true;
+}
+
+bool Database::del(std::string_view key, bool *existed)
+{
+    g_deletes.fetch_add(1, std::memory_order_relaxed);
+    if (simulate(g_write_latency))
+        return false;
+    Shard &shard = shardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    size_t erased = shard.values.erase(std::string(key));
+    if (existed)
+        *existed = erased > 0;
+    return true;
+}
+
+bool Database::beginPutStream(std::string_view key)
+{
+    t_stream_key.assign(key);
+    t_stream_value.clear();
+    stream_open = true;
+    return true;
+}
+
+bool Database::writePutStream(std::string_view data)
+{
+    t_stream_value.append(data);
+    return true;
+}
+
+bool Database::endPutStream(bool commit)
+{
+    stream_open = false;
+    bool stored = commit && put(t_stream_key, t_stream_value);
+    t_stream_value.clear();
+    t_stream_value.shrink_to_fit();
+    return stored;
+}
+
+bool Database::isConnected()
+{
+    return true;
+}
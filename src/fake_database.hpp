@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief In-memory stand-in for the PostgreSQL backend, for benchmarks.
+ *
+ * fake_database.cpp defines the Database class of database.hpp without
+ * PostgreSQL: linked in place of database.cpp, it lets KVServer run with no
+ * external services. Every Database instance (one per worker thread) shares
+ * one sharded in-memory table, as the workers share one database.
+ *
+ * Operations can be slowed down and made to fail, to model the storage a
+ * benchmark should isolate the server from, or a slow one. Latencies are
+ * specified in microseconds:
+ *  - fixed:N, or just N: every operation takes N us (0, the default, is no delay);
+ *  - uniform:MIN:MAX: uniformly between MIN and MAX;
+ *  - exponential:MEAN: exponentially distributed around MEAN, with a long tail.
+ *
+ * The delay is a sleep of the calling worker, which blocks like a libpq
+ * call does. A failed put or del returns false; a failed get reports the
+ * key as missing, as Database::get does on errors.
+ */
+namespace fake_database
+{
+    struct Config
+    {
+        std::string read_latency = "0";  // get
+        std::string write_latency = "0"; // put, del and streamed puts
+        double failure_rate = 0;         // Fraction of operations that fail, 0 to 1
+    };
+
+    /**
+     * @brief Applies a configuration; operations already sleeping are unaffected.
+     * @return false, with 'error' set, if a latency specification is invalid.
+     */
+    bool configure(const Config &config, std::string &error);
+
+    /**
+     * @brief Counts of the operations performed since start.
+     */
+    struct Stats
+    {
+        uint64_t reads;
+        uint64_t writes;
+        uint64_t deletes;
+        uint64_t failures; // Injected failures, included in the counts above
+        uint64_t keys;     // Keys stored
+    };
+
+    Stats stats();
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief 64-bit FNV-1a hashing.
+ *
+ * Cheap and well spread for short inputs such as keys. The hot table and
+ * request traces store these hashes in their formats, and the load
+ * generator uses them to scatter key ranks, so all share this one
+ * definition: changing it changes those formats.
+ */
+namespace fnv
+{
+    constexpr uint64_t kOffsetBasis = 0xcbf29ce484222325ULL;
+    constexpr uint64_t kPrime = 0x100000001b3ULL;
+
+    /**
+     * @brief Hash of a byte string.
+     */
+    inline uint64_t hash(std::string_view bytes)
+    {
+        uint64_t hash = kOffsetBasis;
+        for (char c : bytes)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= kPrime;
+        }
+        return hash;
+    }
+
+    /**
+     * @brief Hash of the 8 bytes of 'value', least significant first.
+     */
+    inline uint64_t hash(uint64_t value)
+    {
+        uint64_t hash = kOffsetBasis;
+        for (int i = 0; i < 8; i++)
+        {
+            hash ^= value & 0xff;
+            hash *= kPrime;
+            value >>= 8;
+        }
+        return hash;
+    }
+}
@@ -0,0 +1,250 @@
+#include "hot_table.hpp" // Table layout and Publisher class definition
+#include <algorithm>      // For std::min
+#include <cstring>        // For memcpy, memcmp
+#include <fcntl.h>        // For O_* constants
+#include <sys/mman.h>     // For shm_open, mmap
+#include <sys/stat.h>     // For fchmod
+#include <unistd.h>       // For ftruncate, close
+
+namespace hottable
+{
+    namespace
+    {
+        // A reader gives up on a slot the server keeps rewriting and reports a
+        // miss; the caller then asks the server instead.
+        constexpr int kMaxReadAttempts = 64;
+    }
+
+    // ======================================================================
+    // Readers
+    // ======================================================================
+
+    bool lookup(const Slot *slots, size_t set_count, std::string_view key, std::string *value)
+    {
+        if (key.empty() || key.size() > kMaxKeyLength)
+            return false;
+
+        uint64_t hash = hashKey(key);
+        const Slot *set = slots + (hash & (set_count - 1)) * kWays;
+        for (size_t way = 0; way < kWays; ++way)
+        {
+            const Slot &slot = set[way];
+            for (int attempt = 0; attempt < kMaxReadAttempts; ++attempt)
+            {
+                uint32_t before = slot.sequence.load(std::memory_order_acquire);
+                if (before & 1)
+                    continue; // Being written
+
+                // The copy may be torn by a concurrent write; the sequence
+                // check below discards it then. Lengths are clamped so a torn
+                // length can't make the copy overrun the slot.
+                bool match = slot.hash.load(std::memory_order_relaxed) == hash &&
+                             slot.key_length.load(std::memory_order_relaxed) == key.size() &&
+                             memcmp(slot.key, key.data(), key.size()) == 0;
+                if (match && value)
+                {
+                    size_t length = std::min<size_t>(slot.value_length.load(std::memory_order_relaxed),
+                                                     kMaxValueLength);
+                    value->assign(slot.value, length);
+                }
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) != before)
+                    continue;
+                if (match)
+                    return true;
+                break; // A consistent read of another key: try the next way
+            }
+        }
+        return false;
+    }
+
+    // ======================================================================
+    // Publisher
+    // ======================================================================
+
+    Publisher::~Publisher()
+    {
+        if (!header)
+            return;
+        // Mapped readers see this and stop trusting the table.
+        header->active.store(0, std::memory_order_release);
+        munmap(segment, segment_size);
+        shm_unlink(name.c_str());
+    }
+
+    bool Publisher::create(const std::string &segment_name, size_t slot_count, mode_t mode)
+    {
+        size_t set_count = 1;
+        while (set_count * kWays < slot_count)
+            set_count *= 2;
+
+        // A segment left by a previous run would still be mapped by its old
+        // readers; a fresh one makes them notice (via 'active') and reopen.
+        shm_unlink(segment_name.c_str());
+        int fd = shm_open(segment_name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, mode);
+        if (fd < 0)
+            return false;
+        fchmod(fd, mode); // shm_open() applies the umask
+
+        size_t size = segmentSize(set_count);
+        void *memory = MAP_FAILED;
+        if (ftruncate(fd, size) == 0)
+            memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED)
+        {
+            shm_unlink(segment_name.c_str());
+            return false;
+        }
+
+        // The new segment is zero-filled: every slot is empty with sequence 0.
+        name = segment_name;
+        segment = memory;
+        segment_size = size;
+        header = static_cast<Header *>(memory);
+        slots = reinterpret_cast<Slot *>(static_cast<char *>(memory) + sizeof(Header));
+        set_mask = set_count - 1;
+        sets.reset(new SetState[set_count]);
+
+        header->magic = kMagic;
+        header->version = kVersion;
+        header->set_count = static_cast<uint32_t>(set_count);
+        header->active.store(1, std::memory_order_release);
+        return true;
+    }
+
+    bool Publisher::holds(std::string_view key) const
+    {
+        return lookup(slots, set_mask + 1, key, nullptr);
+    }
+
+    uint64_t Publisher::ticket(std::string_view key)
+    {
+        SetState &state = sets[hashKey(key) & set_mask];
+        std::lock_guard<std::mutex> lock(state.mtx);
+        return state.ticket;
+    }
+
+    bool Publisher::publish(std::string_view key, std::string_view value, uint64_t ticket)
+    {
+        if (!fits(key.size(), value.size()))
+            return false;
+
+        uint64_t hash = hashKey(key);
+        size_t set = hash & set_mask;
+        SetState &state = sets[set];
+        std::lock_guard<std::mutex> lock(state.mtx);
+        if (state.ticket != ticket)
+            return false; // A write to this set may have made 'value' stale
+
+        Slot *slot = findSlot(set, hash, key);
+        if (!slot)
+        {
+            // An empty way, else evict round-robin.
+            Slot *ways = slots + set * kWays;
+            for (size_t way = 0; way < kWays && !slot; ++way)
+            {
+                if (ways[way].key_length.load(std::memory_order_relaxed) == 0)
+                    slot = &ways[way];
+            }
+            if (!slot)
+                slot = &ways[state.next_victim++ % kWays];
+        }
+        writeSlot(*slot, hash, key, value);
+        published++;
+        return true;
+    }
+
+    void Publisher::update(std::string_view key, std::string_view value)
+    {
+        uint64_t hash = hashKey(key);
+        size_t set = hash & set_mask;
+        SetState &state = sets[set];
+        std::lock_guard<std::mutex> lock(state.mtx);
+        state.ticket++; // Even if the key isn't here: a publish in flight may carry the old value
+
+        Slot *slot = findSlot(set, hash, key);
+        if (!slot)
+            return;
+        if (fits(key.size(), value.size()))
+        {
+            writeSlot(*slot, hash, key, value);
+            updated++;
+        }
+        else
+        {
+            clearSlot(*slot);
+            invalidated++;
+        }
+    }
+
+    void Publisher::invalidate(std::string_view key)
+    {
+        uint64_t hash = hashKey(key);
+        size_t set = hash & set_mask;
+        SetState &state = sets[set];
+        std::lock_guard<std::mutex> lock(state.mtx);
+        state.ticket++;
+
+        Slot *slot = findSlot(set, hash, key);
+        if (!slot)
+            return;
+        clearSlot(*slot);
+        invalidated++;
+    }
+
+    Publisher::Stats Publisher::stats() const
+    {
+        Stats result;
+        result.published = published;
+        result.updated = updated;
+        result.invalidated = invalidated;
+        return result;
+    }
+
+    Slot *Publisher::findSlot(size_t set, uint64_t hash, std::string_view key) const
+    {
+        // Called with the set locked: no other thread writes these slots, so
+        // plain reads are consistent.
+        Slot *ways = slots + set * kWays;
+        for (size_t way = 0; way < kWays; ++way)
+        {
+            Slot &slot = ways[way];
+            if (slot.hash.load(std::memory_order_relaxed) == hash &&
+                slot.key_length.load(std::memory_order_relaxed) == key.size() &&
+                memcmp(slot.key, key.data(), key.size()) == 0)
+                return &slot;
+        }
+        return nullptr;
+    }
+
+    void Publisher::writeSlot(Slot &slot, uint64_t hash, std::string_view key, std::string_view value)
+    {
+        // Odd sequence first, so readers discard what they copy meanwhile.
+        uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.hash.store(hash, std::memory_order_relaxed);
+        slot.key_length.store(static_cast<uint32_t>(key.size()), std::memory_order_relaxed);
+        slot.value_length.store(static_cast<uint32_t>(value.size()), std::memory_order_relaxed);
+        memcpy(slot.key, key.data(), key.size());
+        memcpy(slot.value, value.data(), value.size());
+
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    void Publisher::clearSlot(Slot &slot)
+    {
+        uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.hash.store(0, std::memory_order_relaxed);
+        slot.key_length.store(0, std::memory_order_relaxed);
+        slot.value_length.store(0, std::memory_order_relaxed);
+
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+    }
+}
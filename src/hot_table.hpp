@@ -0,0 +1,195 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include "fnv_hash.hpp"
+
+/**
+ * @brief Shared-memory table of hot cache entries for co-located readers.
+ *
+ * The server publishes small, frequently read values into a POSIX shared
+ * memory segment; local processes map it read-only (see HotTableClient) and
+ * look keys up without a system call or a round-trip.
+ *
+ * Layout: a Header followed by 'set_count' sets of kWays slots. A key lives
+ * in one of the kWays slots of the set chosen by its hash. Every slot is
+ * guarded by a sequence lock: the server (the only writer) makes the
+ * sequence odd, changes the slot and makes it even again; a reader copies
+ * the slot and retries if the sequence was odd or changed meanwhile. Readers
+ * never write to the segment, so they cannot slow the server down or corrupt
+ * the table.
+ *
+ * A key missing from the table only means "ask the server": the table holds
+ * a subset of the cache. Writes and deletes update or remove a key's slot
+ * before the server acknowledges them, so a reader never sees a value older
+ * than the last acknowledged write.
+ */
+namespace hottable
+{
+    constexpr uint64_t kMagic = 0x4b56484f54544231; // "KVHOTTB1"
+    constexpr uint32_t kVersion = 1;
+
+    // Slots per set (associativity).
+    constexpr size_t kWays = 4;
+
+    // Largest key and value a slot holds; a slot is 1 KiB.
+    constexpr size_t kMaxKeyLength = 104;
+    constexpr size_t kMaxValueLength = 896;
+
+    struct alignas(64) Header
+    {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t set_count;           // Power of two
+        std::atomic<uint32_t> active; // Cleared when the server stops updating the table
+    };
+
+    struct alignas(64) Slot
+    {
+        std::atomic<uint32_t> sequence; // Odd while the server is changing the slot
+        std::atomic<uint32_t> key_length; // 0: empty
+        std::atomic<uint32_t> value_length;
+        uint32_t reserved;
+        std::atomic<uint64_t> hash;
+        char key[kMaxKeyLength];
+        char value[kMaxValueLength];
+    };
+
+    static_assert(sizeof(Slot) == 1024, "slot layout is part of the shared-memory format");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+                  "sequence locks in shared memory need lock-free atomics");
+
+    /**
+     * @brief Hash of a key (64-bit FNV-1a); part of the format, so both sides agree.
+     */
+    inline uint64_t hashKey(std::string_view key)
+    {
+        return fnv::hash(key);
+    }
+
+    /**
+     * @brief Size in bytes of a segment with 'set_count' sets.
+     */
+    inline size_t segmentSize(size_t set_count)
+    {
+        return sizeof(Header) + set_count * kWays * sizeof(Slot);
+    }
+
+    /**
+     * @brief Looks a key up in the table (the readers' side of the sequence lock).
+     *
+     * @param slots The slots following the header.
+     * @param set_count Number of sets (header->set_count).
+     * @param value If non-null, receives the value.
+     * @return true if the key was found; a slot that keeps changing under
+     *         the reader counts as a miss.
+     */
+    bool lookup(const Slot *slots, size_t set_count, std::string_view key, std::string *value);
+
+    /**
+     * @brief The server's side: creates the segment and is its only writer.
+     *
+     * Thread-safe; writers of the same set are serialized by a process-local
+     * mutex. Each set also has a ticket that every change of the set bumps,
+     * which lets a reader thread publish a value it read from the cache
+     * without racing a concurrent write (see publish()).
+     */
+    class Publisher
+    {
+    public:
+        struct Stats
+        {
+            uint64_t published = 0;   // Entries added
+            uint64_t updated = 0;     // Entries rewritten by a write
+            uint64_t invalidated = 0; // Entries removed by a write, delete or expiry
+        };
+
+        Publisher() = default;
+        Publisher(const Publisher &) = delete;
+        Publisher &operator=(const Publisher &) = delete;
+
+        /**
+         * @brief Marks the table inactive, unmaps and unlinks it.
+         */
+        ~Publisher();
+
+        /**
+         * @brief Creates (or replaces) the segment, e.g. name "/kv_hot".
+         * @param slot_count Number of slots, rounded up to a power-of-two number of sets.
+         * @param mode Permissions of the segment; readers need read access.
+         * @return false if the segment could not be created.
+         */
+        bool create(const std::string &name, size_t slot_count, mode_t mode);
+
+        /**
+         * @brief True if a key and value of these sizes fit in a slot.
+         */
+        static bool fits(size_t key_length, size_t value_length)
+        {
+            return key_length > 0 && key_length <= kMaxKeyLength && value_length <= kMaxValueLength;
+        }
+
+        /**
+         * @brief True if the key is in the table (lock-free; used on every cache hit).
+         */
+        bool holds(std::string_view key) const;
+
+        /**
+         * @brief Returns the current ticket of the key's set.
+         *
+         * Take it before reading the value to publish.
+         */
+        uint64_t ticket(std::string_view key);
+
+        /**
+         * @brief Adds a key, replacing another entry of its set if it is full.
+         * @param ticket The set's ticket taken before 'value' was read.
+         * @return false if the set changed since (the value may be stale) or
+         *         the entry doesn't fit.
+         */
+        bool publish(std::string_view key, std::string_view value, uint64_t ticket);
+
+        /**
+         * @brief Gives a key its new value, if the table holds the key.
+         *
+         * Called for every write, after the cache has been updated.
+         */
+        void update(std::string_view key, std::string_view value);
+
+        /**
+         * @brief Removes a key, if the table holds it.
+         */
+        void invalidate(std::string_view key);
+
+        Stats stats() const;
+
+    private:
+        struct SetState
+        {
+            std::mutex mtx;
+            uint64_t ticket = 0;
+            size_t next_victim = 0; // Round-robin replacement within the set
+        };
+
+        Slot *findSlot(size_t set, uint64_t hash, std::string_view key) const;
+        void writeSlot(Slot &slot, uint64_t hash, std::string_view key, std::string_view value);
+        void clearSlot(Slot &slot);
+
+        std::string name;
+        void *segment = nullptr;
+        size_t segment_size = 0;
+        Header *header = nullptr;
+        Slot *slots = nullptr;
+        size_t set_mask = 0;
+        std::unique_ptr<SetState[]> sets;
+        std::atomic<uint64_t> published{0};
+        std::atomic<uint64_t> updated{0};
+        std::atomic<uint64_t> invalidated{0};
+    };
+}
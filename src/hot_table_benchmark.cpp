@@ -0,0 +1,177 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "hot_table_client.hpp"
+
+/**
+ * @brief Compares reading a hot key from the shared-memory table with
+ *        reading it over HTTP.
+ *
+ * Stores a key through the raw-value endpoint, reads it twice so the server
+ * caches and then exports it, and times the same read both ways: as an HTTP
+ * GET over a fresh loopback connection, and as a HotTableClient lookup. The server must run with HOT_TABLE_NAME set.
+ */
+
+/**
+ * @brief Sends one HTTP request and returns the whole response ("" on failure).
+ */
+std::string httpRequest(const std::string &host, int port, const std::string &request)
+{
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0)
+        return "";
+
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(port);
+    inet_pton(AF_INET, host == "localhost" ? "127.0.0.1" : host.c_str(), &server_addr.sin_addr);
+    if (connect(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
+    {
+        close(sock);
+        return "";
+    }
+    int nodelay = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    std::string response;
+    if (send(sock, request.data(), request.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(request.size()))
+    {
+        // Requests ask the server to close the connection after the response.
+        char buffer[4096];
+        ssize_t n;
+        while ((n = recv(sock, buffer, sizeof(buffer), 0)) > 0)
+            response.append(buffer, n);
+    }
+    close(sock);
+    return response;
+}
+
+/**
+ * @brief Prints mean and percentiles of a set of latencies in nanoseconds.
+ */
+void report(const char *name, std::vector<double> &latencies)
+{
+    std::sort(latencies.begin(), latencies.end());
+    double sum = 0;
+    for (double latency : latencies)
+        sum += latency;
+    auto percentile = [&](double p) { return latencies[static_cast<size_t>(p * (latencies.size() - 1))]; };
+    std::cout << name << ": mean " << sum / latencies.size() << " ns, p50 " << percentile(0.50) << " ns, p99 "
+              << percentile(0.99) << " ns, max " << latencies.back() << " ns" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 4)
+    {
+        std::cout << "Usage: " << argv[0] << " <shm_name> <host> <port> [iterations] [value_size]" << std::endl;
+        std::cout << "Example: " << argv[0] << " /kv_hot 127.0.0.1 8080 10000 100" << std::endl;
+        return 1;
+    }
+
+    std::string shm_name = argv[1];
+    std::string host = argv[2];
+    int port = std::stoi(argv[3]);
+    int iterations = (argc > 4) ? std::stoi(argv[4]) : 10000;
+    size_t value_size = (argc > 5) ? std::stoul(argv[5]) : 100;
+    if (iterations < 1 || value_size > hottable::kMaxValueLength)
+    {
+        std::cerr << "iterations must be positive and value_size at most " << hottable::kMaxValueLength
+                  << std::endl;
+        return 1;
+    }
+
+    // Store the key, then read it twice: the first read may fill the cache
+    // from the database, the second is a cache hit and exports it.
+    const std::string key = "hot_table_benchmark_key";
+    const std::string value(value_size, 'v');
+    std::string put = "PUT /api/kv/" + key + " HTTP/1.1\r\nHost: " + host +
+                      "\r\nConnection: close\r\nContent-Length: " + std::to_string(value.size()) + "\r\n\r\n" + value;
+    std::string get = "GET /api/kv/" + key + " HTTP/1.1\r\nHost: " + host + "\r\nConnection: close\r\n\r\n";
+    if (httpRequest(host, port, put).find(" 200 ") == std::string::npos)
+    {
+        std::cerr << "Failed to store the benchmark key over HTTP" << std::endl;
+        return 1;
+    }
+    httpRequest(host, port, get);
+    httpRequest(host, port, get);
+
+    HotTableClient table;
+    std::string read_value;
+    if (!table.open(shm_name))
+    {
+        std::cerr << "Failed to open shared memory table " << shm_name << " (is HOT_TABLE_NAME set?)" << std::endl;
+        return 1;
+    }
+    if (!table.get(key, read_value) || read_value != value)
+    {
+        std::cerr << "Key was not exported to the shared memory table" << std::endl;
+        return 1;
+    }
+
+    std::cout << "=== Hot Table Benchmark ===" << std::endl;
+    std::cout << "Iterations: " << iterations << ", value size: " << value_size << " bytes" << std::endl;
+
+    // HTTP path: a GET on a new connection per request.
+    std::vector<double> http_latencies;
+    http_latencies.reserve(iterations);
+    int http_failures = 0;
+    for (int i = 0; i < iterations; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::string response = httpRequest(host, port, get);
+        auto end = std::chrono::steady_clock::now();
+        if (response.find(" 200 ") == std::string::npos)
+            http_failures++;
+        http_latencies.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+
+    // Shared-memory path. Lookups are timed in batches because a single one
+    // is close to the resolution of the clock.
+    constexpr int kBatch = 100;
+    std::vector<double> table_latencies;
+    table_latencies.reserve(iterations);
+    int table_misses = 0;
+    for (int i = 0; i < iterations; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int j = 0; j < kBatch; ++j)
+        {
+            if (!table.get(key, read_value))
+                table_misses++;
+        }
+        auto end = std::chrono::steady_clock::now();
+        table_latencies.push_back(std::chrono::duration<double, std::nano>(end - start).count() / kBatch);
+    }
+
+    report("HTTP GET    ", http_latencies);
+    report("Shared table", table_latencies);
+    std::cout << "HTTP failures: " << http_failures << ", shared table misses: " << table_misses << std::endl;
+
+    double http_mean = 0, table_mean = 0;
+    for (double latency : http_latencies)
+        http_mean += latency;
+    for (double latency : table_latencies)
+        table_mean += latency;
+    std::cout << "Speedup (mean): " << http_mean / table_mean << "x" << std::endl;
+
+    // A write must be visible in the table as soon as it is acknowledged.
+    const std::string new_value(value_size, 'w');
+    put = "PUT /api/kv/" + key + " HTTP/1.1\r\nHost: " + host +
+          "\r\nConnection: close\r\nContent-Length: " + std::to_string(new_value.size()) + "\r\n\r\n" + new_value;
+    httpRequest(host, port, put);
+    bool fresh = !table.get(key, read_value) || read_value == new_value;
+    httpRequest(host, port, "DELETE /api/kv/" + key + " HTTP/1.1\r\nHost: " + host + "\r\nConnection: close\r\n\r\n");
+    fresh = fresh && !table.get(key, read_value);
+    std::cout << "Write/delete visibility: " << (fresh ? "ok" : "STALE") << std::endl;
+    return fresh ? 0 : 1;
+}
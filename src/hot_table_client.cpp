@@ -0,0 +1,68 @@
+#include "hot_table_client.hpp" // HotTableClient class definition
+#include <fcntl.h>              // For O_RDONLY
+#include <sys/mman.h>           // For shm_open, mmap
+#include <sys/stat.h>           // For fstat
+#include <unistd.h>             // For close
+
+HotTableClient::~HotTableClient()
+{
+    close();
+}
+
+bool HotTableClient::open(const std::string &name)
+{
+    close();
+
+    int fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    void *memory = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(hottable::Header))
+        memory = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED)
+        return false;
+
+    // Check the format before trusting set_count to index the slots.
+    const auto *mapped = static_cast<const hottable::Header *>(memory);
+    size_t size = info.st_size;
+    if (mapped->magic != hottable::kMagic || mapped->version != hottable::kVersion || mapped->set_count == 0 ||
+        (mapped->set_count & (mapped->set_count - 1)) != 0 || hottable::segmentSize(mapped->set_count) > size ||
+        mapped->active.load(std::memory_order_acquire) == 0)
+    {
+        munmap(memory, size);
+        return false;
+    }
+
+    segment = memory;
+    segment_size = size;
+    header = mapped;
+    slots = reinterpret_cast<const hottable::Slot *>(static_cast<const char *>(memory) + sizeof(hottable::Header));
+    set_count = mapped->set_count;
+    return true;
+}
+
+void HotTableClient::close()
+{
+    if (segment)
+        munmap(const_cast<void *>(segment), segment_size);
+    segment = nullptr;
+    segment_size = 0;
+    header = nullptr;
+    slots = nullptr;
+    set_count = 0;
+}
+
+bool HotTableClient::isActive() const
+{
+    return header && header->active.load(std::memory_order_acquire) != 0;
+}
+
+bool HotTableClient::get(std::string_view key, std::string &value) const
+{
+    // An inactive table is no longer updated on writes: its contents may be stale.
+    if (!isActive())
+        return false;
+    return hottable::lookup(slots, set_count, key, &value);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "hot_table.hpp"
+
+/**
+ * @brief Reads the server's shared-memory hot table (see hot_table.hpp).
+ *
+ * For processes on the same host as the server (HOT_TABLE_NAME). get() is a
+ * few memory reads: no system call, no socket, no server involvement. A miss
+ * is not authoritative; the caller then asks the server over a socket, as it
+ * also must when the table is not open or the server has stopped.
+ *
+ * get() is safe to call from many threads at once.
+ */
+class HotTableClient
+{
+public:
+    HotTableClient() = default;
+    ~HotTableClient();
+    HotTableClient(const HotTableClient &) = delete;
+    HotTableClient &operator=(const HotTableClient &) = delete;
+
+    /**
+     * @brief Maps the segment read-only, e.g. name "/kv_hot".
+     * @return false if it doesn't exist, isn't a hot table or is inactive.
+     */
+    bool open(const std::string &name);
+
+    /**
+     * @brief Unmaps the segment.
+     */
+    void close();
+
+    /**
+     * @brief True while the table is mapped and the server still maintains it.
+     *
+     * After a server restart the old segment goes inactive: open() again.
+     */
+    bool isActive() const;
+
+    /**
+     * @brief Looks a key up in the table.
+     * @return true and the value if the key is there; false means "ask the server".
+     */
+    bool get(std::string_view key, std::string &value) const;
+
+private:
+    const void *segment = nullptr;
+    size_t segment_size = 0;
+    const hottable::Header *header = nullptr;
+    const hottable::Slot *slots = nullptr;
+    size_t set_count = 0;
+};
@@ -0,0 +1,395 @@
+#include "hpack.hpp" // Declarations of the HPACK decoder and encoder helpers
+
+namespace hpack
+{
+    namespace
+    {
+        struct StaticEntry
+        {
+            std::string_view name;
+            std::string_view value;
+        };
+
+        // The static table (RFC 7541, Appendix A); index 1 is the first entry.
+        constexpr StaticEntry kStaticTable[] = {
+            {":authority", ""},
+            {":method", "GET"},
+            {":method", "POST"},
+            {":path", "/"},
+            {":path", "/index.html"},
+            {":scheme", "http"},
+            {":scheme", "https"},
+            {":status", "200"},
+            {":status", "204"},
+            {":status", "206"},
+            {":status", "304"},
+            {":status", "400"},
+            {":status", "404"},
+            {":status", "500"},
+            {"accept-charset", ""},
+            {"accept-encoding", "gzip, deflate"},
+            {"accept-language", ""},
+            {"accept-ranges", ""},
+            {"accept", ""},
+            {"access-control-allow-origin", ""},
+            {"age", ""},
+            {"allow", ""},
+            {"authorization", ""},
+            {"cache-control", ""},
+            {"content-disposition", ""},
+            {"content-encoding", ""},
+            {"content-language", ""},
+            {"content-length", ""},
+            {"content-location", ""},
+            {"content-range", ""},
+            {"content-type", ""},
+            {"cookie", ""},
+            {"date", ""},
+            {"etag", ""},
+            {"expect", ""},
+            {"expires", ""},
+            {"from", ""},
+            {"host", ""},
+            {"if-match", ""},
+            {"if-modified-since", ""},
+            {"if-none-match", ""},
+            {"if-range", ""},
+            {"if-unmodified-since", ""},
+            {"last-modified", ""},
+            {"link", ""},
+            {"location", ""},
+            {"max-forwards", ""},
+            {"proxy-authenticate", ""},
+            {"proxy-authorization", ""},
+            {"range", ""},
+            {"referer", ""},
+            {"refresh", ""},
+            {"retry-after", ""},
+            {"server", ""},
+            {"set-cookie", ""},
+            {"strict-transport-security", ""},
+            {"transfer-encoding", ""},
+            {"user-agent", ""},
+            {"vary", ""},
+            {"via", ""},
+            {"www-authenticate", ""},
+        };
+        constexpr size_t kStaticTableSize = sizeof(kStaticTable) / sizeof(kStaticTable[0]);
+
+        // Huffman code of each octet (RFC 7541, Appendix B), right-aligned, and its length in bits.
+        constexpr uint32_t kHuffmanCodes[256] = {
+            0x1ff8, 0x7fffd8, 0xfffffe2, 0xfffffe3, 0xfffffe4, 0xfffffe5, 0xfffffe6, 0xfffffe7,
+            0xfffffe8, 0xffffea, 0x3ffffffc, 0xfffffe9, 0xfffffea, 0x3ffffffd, 0xfffffeb, 0xfffffec,
+            0xfffffed, 0xfffffee, 0xfffffef, 0xffffff0, 0xffffff1, 0xffffff2, 0x3ffffffe, 0xffffff3,
+            0xffffff4, 0xffffff5, 0xffffff6, 0xffffff7, 0xffffff8, 0xffffff9, 0xffffffa, 0xffffffb,
+            0x14, 0x3f8, 0x3f9, 0xffa, 0x1ff9, 0x15, 0xf8, 0x7fa,
+            0x3fa, 0x3fb, 0xf9, 0x7fb, 0xfa, 0x16, 0x17, 0x18,
+            0x0, 0x1, 0x2, 0x19, 0x1a, 0x1b, 0x1c, 0x1d,
+            0x1e, 0x1f, 0x5c, 0xfb, 0x7ffc, 0x20, 0xffb, 0x3fc,
+            0x1ffa, 0x21, 0x5d, 0x5e, 0x5f, 0x60, 0x61, 0x62,
+            0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a,
+            0x6b, 0x6c, 0x6d, 0x6e, 0x6f, 0x70, 0x71, 0x72,
+            0xfc, 0x73, 0xfd, 0x1ffb, 0x7fff0, 0x1ffc, 0x3ffc, 0x22,
+            0x7ffd, 0x3, 0x23, 0x4, 0x24, 0x5, 0x25, 0x26,
+            0x27, 0x6, 0x74, 0x75, 0x28, 0x29, 0x2a, 0x7,
+            0x2b, 0x76, 0x2c, 0x8, 0x9, 0x2d, 0x77, 0x78,
+            0x79, 0x7a, 0x7b, 0x7ffe, 0x7fc, 0x3ffd, 0x1ffd, 0xffffffc,
+            0xfffe6, 0x3fffd2, 0xfffe7, 0xfffe8, 0x3fffd3, 0x3fffd4, 0x3fffd5, 0x7fffd9,
+            0x3fffd6, 0x7fffda, 0x7fffdb, 0x7fffdc, 0x7fffdd, 0x7fffde, 0xffffeb, 0x7fffdf,
+            0xffffec, 0xffffed, 0x3fffd7, 0x7fffe0, 0xffffee, 0x7fffe1, 0x7fffe2, 0x7fffe3,
+            0x7fffe4, 0x1fffdc, 0x3fffd8, 0x7fffe5, 0x3fffd9, 0x7fffe6, 0x7fffe7, 0xffffef,
+            0x3fffda, 0x1fffdd, 0xfffe9, 0x3fffdb, 0x3fffdc, 0x7fffe8, 0x7fffe9, 0x1fffde,
+            0x7fffea, 0x3fffdd, 0x3fffde, 0xfffff0, 0x1fffdf, 0x3fffdf, 0x7fffeb, 0x7fffec,
+            0x1fffe0, 0x1fffe1, 0x3fffe0, 0x1fffe2, 0x7fffed, 0x3fffe1, 0x7fffee, 0x7fffef,
+            0xfffea, 0x3fffe2, 0x3fffe3, 0x3fffe4, 0x7ffff0, 0x3fffe5, 0x3fffe6, 0x7ffff1,
+            0x3ffffe0, 0x3ffffe1, 0xfffeb, 0x7fff1, 0x3fffe7, 0x7ffff2, 0x3fffe8, 0x1ffffec,
+            0x3ffffe2, 0x3ffffe3, 0x3ffffe4, 0x7ffffde, 0x7ffffdf, 0x3ffffe5, 0xfffff1, 0x1ffffed,
+            0x7fff2, 0x1fffe3, 0x3ffffe6, 0x7ffffe0, 0x7ffffe1, 0x3ffffe7, 0x7ffffe2, 0xfffff2,
+            0x1fffe4, 0x1fffe5, 0x3ffffe8, 0x3ffffe9, 0xffffffd, 0x7ffffe3, 0x7ffffe4, 0x7ffffe5,
+            0xfffec, 0xfffff3, 0xfffed, 0x1fffe6, 0x3fffe9, 0x1fffe7, 0x1fffe8, 0x7ffff3,
+            0x3fffea, 0x3fffeb, 0x1ffffee, 0x1ffffef, 0xfffff4, 0xfffff5, 0x3ffffea, 0x7ffff4,
+            0x3ffffeb, 0x7ffffe6, 0x3ffffec, 0x3ffffed, 0x7ffffe7, 0x7ffffe8, 0x7ffffe9, 0x7ffffea,
+            0x7ffffeb, 0xffffffe, 0x7ffffec, 0x7ffffed, 0x7ffffee, 0x7ffffef, 0x7fffff0, 0x3ffffee,
+        };
+        constexpr uint8_t kHuffmanLengths[256] = {
+            13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+            28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+            6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+            5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+            13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+            7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+            15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+            6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+            20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+            24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+            22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+            21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+            26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+            19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+            20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+            26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+        };
+
+        // Binary decoding tree of the Huffman code, built once on first use.
+        // symbol >= 0 marks a leaf; a child of -1 is a path no code takes.
+        struct HuffmanNode
+        {
+            int16_t child[2] = {-1, -1};
+            int16_t symbol = -1;
+        };
+
+        const std::vector<HuffmanNode> &huffmanTree()
+        {
+            static const std::vector<HuffmanNode> tree = []
+            {
+                std::vector<HuffmanNode> nodes(1);
+                for (int symbol = 0; symbol < 256; ++symbol)
+                {
+                    size_t node = 0;
+                    for (int bit = kHuffmanLengths[symbol] - 1; bit >= 0; --bit)
+                    {
+                        int b = (kHuffmanCodes[symbol] >> bit) & 1;
+                        if (nodes[node].child[b] < 0)
+                        {
+                            nodes[node].child[b] = static_cast<int16_t>(nodes.size());
+                            nodes.emplace_back();
+                        }
+                        node = nodes[node].child[b];
+                    }
+                    nodes[node].symbol = static_cast<int16_t>(symbol);
+                }
+                return nodes;
+            }();
+            return tree;
+        }
+
+        bool huffmanDecode(std::string_view input, std::string &out)
+        {
+            const std::vector<HuffmanNode> &tree = huffmanTree();
+            int node = 0;
+            int depth = 0;        // Bits consumed since the last complete symbol
+            bool all_ones = true; // Whether those bits were all 1s
+            for (char c : input)
+            {
+                for (int bit = 7; bit >= 0; --bit)
+                {
+                    int b = (static_cast<unsigned char>(c) >> bit) & 1;
+                    node = tree[node].child[b];
+                    if (node < 0)
+                        return false; // EOS or an invalid code
+                    depth++;
+                    all_ones = all_ones && b;
+                    if (tree[node].symbol >= 0)
+                    {
+                        if (out.size() >= Decoder::kMaxStringLength)
+                            return false;
+                        out.push_back(static_cast<char>(tree[node].symbol));
+                        node = 0;
+                        depth = 0;
+                        all_ones = true;
+                    }
+                }
+            }
+            // Padding must be a prefix of EOS (all 1s) and shorter than a byte.
+            return depth <= 7 && all_ones;
+        }
+
+        // Prefix-coded integer (RFC 7541, 5.1).
+        bool decodeInteger(std::string_view &in, int prefix_bits, uint64_t &value)
+        {
+            if (in.empty())
+                return false;
+            const uint64_t max_prefix = (uint64_t(1) << prefix_bits) - 1;
+            value = static_cast<unsigned char>(in[0]) & max_prefix;
+            in.remove_prefix(1);
+            if (value < max_prefix)
+                return true;
+            for (int shift = 0; shift <= 56; shift += 7)
+            {
+                if (in.empty())
+                    return false;
+                unsigned char b = static_cast<unsigned char>(in[0]);
+                in.remove_prefix(1);
+                value += static_cast<uint64_t>(b & 0x7f) << shift;
+                if (!(b & 0x80))
+                    return true;
+            }
+            return false; // Overlong
+        }
+
+        // String literal, optionally Huffman-coded (RFC 7541, 5.2).
+        bool decodeString(std::string_view &in, std::string &out)
+        {
+            if (in.empty())
+                return false;
+            bool huffman = static_cast<unsigned char>(in[0]) & 0x80;
+            uint64_t length = 0;
+            if (!decodeInteger(in, 7, length) || length > in.size() || length > Decoder::kMaxStringLength)
+                return false;
+            std::string_view raw = in.substr(0, length);
+            in.remove_prefix(length);
+            out.clear();
+            if (huffman)
+                return huffmanDecode(raw, out);
+            out.assign(raw);
+            return true;
+        }
+
+        void appendInteger(std::pmr::string &out, unsigned char first_bits, int prefix_bits, uint64_t value)
+        {
+            const uint64_t max_prefix = (uint64_t(1) << prefix_bits) - 1;
+            if (value < max_prefix)
+            {
+                out.push_back(static_cast<char>(first_bits | value));
+                return;
+            }
+            out.push_back(static_cast<char>(first_bits | max_prefix));
+            value -= max_prefix;
+            while (value >= 0x80)
+            {
+                out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        void appendString(std::pmr::string &out, std::string_view text)
+        {
+            appendInteger(out, 0x00, 7, text.size()); // H bit clear: raw octets
+            out.append(text);
+        }
+    }
+
+    bool Decoder::decode(std::string_view block, std::vector<Header> &headers)
+    {
+        size_t first_field = headers.size();
+        while (!block.empty())
+        {
+            unsigned char first = static_cast<unsigned char>(block[0]);
+            uint64_t index = 0;
+            std::string_view name, value;
+
+            if (first & 0x80)
+            {
+                // Indexed header field
+                if (!decodeInteger(block, 7, index) || !lookup(index, name, value))
+                    return false;
+                headers.push_back({std::string(name), std::string(value)});
+                continue;
+            }
+
+            if ((first & 0xe0) == 0x20)
+            {
+                // Dynamic table size update, bounded by our SETTINGS value and
+                // only allowed before the block's first field (RFC 7541, 4.2)
+                uint64_t size = 0;
+                if (headers.size() != first_field || !decodeInteger(block, 5, size) || size > kDefaultTableSize)
+                    return false;
+                max_table_size = size;
+                evict(max_table_size);
+                continue;
+            }
+
+            // Literal: with incremental indexing (01), without (0000) or never indexed (0001)
+            bool indexing = first & 0x40;
+            if (!decodeInteger(block, indexing ? 6 : 4, index))
+                return false;
+            Header header;
+            if (index == 0)
+            {
+                if (!decodeString(block, header.name))
+                    return false;
+            }
+            else
+            {
+                if (!lookup(index, name, value))
+                    return false;
+                header.name.assign(name);
+            }
+            if (!decodeString(block, header.value))
+                return false;
+
+            if (indexing)
+                insert(header.name, header.value);
+            headers.push_back(std::move(header));
+        }
+        return true;
+    }
+
+    bool Decoder::lookup(uint64_t index, std::string_view &name, std::string_view &value) const
+    {
+        if (index == 0)
+            return false;
+        if (index <= kStaticTableSize)
+        {
+            name = kStaticTable[index - 1].name;
+            value = kStaticTable[index - 1].value;
+            return true;
+        }
+        index -= kStaticTableSize + 1;
+        if (index >= table.size())
+            return false;
+        name = table[index].name;
+        value = table[index].value;
+        return true;
+    }
+
+    void Decoder::insert(std::string name, std::string value)
+    {
+        size_t size = name.size() + value.size() + 32;
+        if (size > max_table_size)
+        {
+            // Too large for the table: it empties it (RFC 7541, 4.4).
+            evict(0);
+            return;
+        }
+        evict(max_table_size - size);
+        table.push_front({std::move(name), std::move(value)});
+        table_size += size;
+    }
+
+    void Decoder::evict(size_t limit)
+    {
+        while (table_size > limit && !table.empty())
+        {
+            table_size -= table.back().name.size() + table.back().value.size() + 32;
+            table.pop_back();
+        }
+    }
+
+    void appendStatus(std::pmr::string &out, int status)
+    {
+        char digits[3] = {static_cast<char>('0' + status / 100 % 10), static_cast<char>('0' + status / 10 % 10),
+                          static_cast<char>('0' + status % 10)};
+        std::string_view text(digits, 3);
+
+        // Static table entries 8-14 are the common status codes.
+        for (size_t i = 7; i < 14; ++i)
+        {
+            if (kStaticTable[i].value == text)
+            {
+                appendInteger(out, 0x80, 7, i + 1);
+                return;
+            }
+        }
+        appendInteger(out, 0x00, 4, 8); // Literal without indexing, name ":status"
+        appendString(out, text);
+    }
+
+    void appendHeader(std::pmr::string &out, std::string_view name, std::string_view value)
+    {
+        // Reference the name in the static table when it is there.
+        for (size_t i = 0; i < kStaticTableSize; ++i)
+        {
+            if (kStaticTable[i].name == name)
+            {
+                appendInteger(out, 0x00, 4, i + 1);
+                appendString(out, value);
+                return;
+            }
+        }
+        out.push_back(0x00);
+        appendString(out, name);
+        appendString(out, value);
+    }
+}
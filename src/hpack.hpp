@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief HPACK header compression for HTTP/2 (RFC 7541).
+ *
+ * The Decoder is complete: indexed fields, literals with and without
+ * indexing, dynamic table size updates and Huffman-coded strings.
+ *
+ * The encoder side is deliberately stateless: response fields are sent as
+ * literals without indexing (using the static table for names and common
+ * status codes) and without Huffman coding. That is valid HPACK, needs no
+ * per-connection encoder state, and response header blocks here are small.
+ */
+namespace hpack
+{
+    struct Header
+    {
+        std::string name;
+        std::string value;
+    };
+
+    class Decoder
+    {
+    public:
+        // Dynamic table limit; 4096 is the HTTP/2 default (SETTINGS_HEADER_TABLE_SIZE).
+        static constexpr size_t kDefaultTableSize = 4096;
+
+        // Longest header name or value accepted, to bound memory per request.
+        static constexpr size_t kMaxStringLength = 64 * 1024;
+
+        /**
+         * @brief Decodes one complete header block into 'headers' (appended).
+         * @return false on a decoding error, which is a connection error
+         *         (COMPRESSION_ERROR) because the table state is then unknown.
+         */
+        bool decode(std::string_view block, std::vector<Header> &headers);
+
+    private:
+        bool lookup(uint64_t index, std::string_view &name, std::string_view &value) const;
+        void insert(std::string name, std::string value);
+        void evict(size_t limit);
+
+        std::deque<Header> table; // Dynamic table, newest entry first
+        size_t table_size = 0;    // Sum of name + value + 32 over the entries (RFC 7541, 4.1)
+        size_t max_table_size = kDefaultTableSize;
+    };
+
+    /**
+     * @brief Appends ":status" (indexed when it is in the static table).
+     */
+    void appendStatus(std::pmr::string &out, int status);
+
+    /**
+     * @brief Appends a header field as a literal without indexing.
+     * @param name Lower-case field name.
+     */
+    void appendHeader(std::pmr::string &out, std::string_view name, std::string_view value);
+}
@@ -0,0 +1,245 @@
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "hpack.hpp"
+
+/**
+ * @brief Tests of the HPACK decoder against the examples of RFC 7541,
+ *        Appendix C, and of dynamic table size updates and evictions.
+ *
+ * Each example is a sequence of header blocks decoded by one Decoder, so
+ * later blocks check the dynamic table the earlier ones left behind. Run
+ * by ctest; exits non-zero if any check fails.
+ */
+
+namespace
+{
+    int failures = 0;
+
+#define CHECK(condition)                                                        \
+    do                                                                          \
+    {                                                                           \
+        if (!(condition))                                                       \
+        {                                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                         \
+        }                                                                       \
+    } while (0)
+
+    // Hex digits, with spaces allowed, as the RFC prints the blocks
+    std::string fromHex(std::string_view hex)
+    {
+        std::string bytes;
+        int high = -1;
+        for (char c : hex)
+        {
+            int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+            if (digit < 0)
+                continue;
+            if (high < 0)
+                high = digit;
+            else
+            {
+                bytes.push_back(static_cast<char>(high << 4 | digit));
+                high = -1;
+            }
+        }
+        return bytes;
+    }
+
+    bool sameHeaders(const std::vector<hpack::Header> &actual, const std::vector<hpack::Header> &expected)
+    {
+        if (actual.size() != expected.size())
+            return false;
+        for (size_t i = 0; i < actual.size(); i++)
+        {
+            if (actual[i].name != expected[i].name || actual[i].value != expected[i].value)
+                return false;
+        }
+        return true;
+    }
+
+    // Decodes 'hex' as one header block and checks the fields it yields
+    void checkBlock(hpack::Decoder &decoder, std::string_view hex, const std::vector<hpack::Header> &expected)
+    {
+        std::vector<hpack::Header> headers;
+        CHECK(decoder.decode(fromHex(hex), headers));
+        CHECK(sameHeaders(headers, expected));
+    }
+
+    bool decodes(hpack::Decoder &decoder, std::string_view hex)
+    {
+        std::vector<hpack::Header> headers;
+        return decoder.decode(fromHex(hex), headers);
+    }
+
+    const std::vector<hpack::Header> kRequest1 = {
+        {":method", "GET"}, {":scheme", "http"}, {":path", "/"}, {":authority", "www.example.com"}};
+    const std::vector<hpack::Header> kRequest2 = {{":method", "GET"},
+                                                  {":scheme", "http"},
+                                                  {":path", "/"},
+                                                  {":authority", "www.example.com"},
+                                                  {"cache-control", "no-cache"}};
+    const std::vector<hpack::Header> kRequest3 = {{":method", "GET"},
+                                                  {":scheme", "https"},
+                                                  {":path", "/index.html"},
+                                                  {":authority", "www.example.com"},
+                                                  {"custom-key", "custom-value"}};
+
+    const std::vector<hpack::Header> kResponse1 = {{":status", "302"},
+                                                   {"cache-control", "private"},
+                                                   {"date", "Mon, 21 Oct 2013 20:13:21 GMT"},
+                                                   {"location", "https://www.example.com"}};
+    const std::vector<hpack::Header> kResponse2 = {{":status", "307"},
+                                                   {"cache-control", "private"},
+                                                   {"date", "Mon, 21 Oct 2013 20:13:21 GMT"},
+                                                   {"location", "https://www.example.com"}};
+    const std::vector<hpack::Header> kResponse3 = {
+        {":status", "200"},
+        {"cache-control", "private"},
+        {"date", "Mon, 21 Oct 2013 20:13:22 GMT"},
+        {"location", "https://www.example.com"},
+        {"content-encoding", "gzip"},
+        {"set-cookie", "foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1"}};
+
+    // The response examples assume a 256-byte table: a size update at the
+    // start of the first block sets it.
+    constexpr std::string_view kTableSize256 = "3fe101";
+
+    // C.2: one field of each representation
+    void testFieldRepresentations()
+    {
+        hpack::Decoder decoder;
+        checkBlock(decoder, "400a 6375 7374 6f6d 2d6b 6579 0d63 7573 746f 6d2d 6865 6164 6572",
+                   {{"custom-key", "custom-header"}});
+        checkBlock(decoder, "040c 2f73 616d 706c 652f 7061 7468", {{":path", "/sample/path"}});
+        checkBlock(decoder, "1008 7061 7373 776f 7264 0673 6563 7265 74", {{"password", "secret"}});
+        checkBlock(decoder, "82", {{":method", "GET"}});
+
+        // Only the first was indexed: it is entry 62, and nothing follows it.
+        checkBlock(decoder, "be", {{"custom-key", "custom-header"}});
+        CHECK(!decodes(decoder, "bf"));
+    }
+
+    // C.3: requests without Huffman coding
+    void testRequests()
+    {
+        hpack::Decoder decoder;
+        checkBlock(decoder, "8286 8441 0f77 7777 2e65 7861 6d70 6c65 2e63 6f6d", kRequest1);
+        checkBlock(decoder, "8286 84be 5808 6e6f 2d63 6163 6865", kRequest2);
+        checkBlock(decoder, "8287 85bf 400a 6375 7374 6f6d 2d6b 6579 0c63 7573 746f 6d2d 7661 6c75 65", kRequest3);
+    }
+
+    // C.4: the same requests, Huffman-coded
+    void testHuffmanRequests()
+    {
+        hpack::Decoder decoder;
+        checkBlock(decoder, "8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff", kRequest1);
+        checkBlock(decoder, "8286 84be 5886 a8eb 1064 9cbf", kRequest2);
+        checkBlock(decoder, "8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 a849 e95b b8e8 b4bf", kRequest3);
+    }
+
+    // C.5: responses without Huffman coding, which evict entries from the
+    // 256-byte table
+    void testResponses()
+    {
+        hpack::Decoder decoder;
+        checkBlock(decoder,
+                   std::string(kTableSize256) +
+                       "4803 3330 3258 0770 7269 7661 7465 611d 4d6f 6e2c 2032 3120 4f63 7420 3230 3133 2032 "
+                       "303a 3133 3a32 3120 474d 546e 1768 7474 7073 3a2f 2f77 7777 2e65 7861 6d70 6c65 2e63 "
+                       "6f6d",
+                   kResponse1);
+
+        // ":status: 302" (the oldest entry) is evicted to make room for "307".
+        checkBlock(decoder, "4803 3330 37c1 c0bf", kResponse2);
+        CHECK(!decodes(decoder, "c2")); // Entry 66: only four remain
+
+        checkBlock(decoder,
+                   "88c1 611d 4d6f 6e2c 2032 3120 4f63 7420 3230 3133 2032 303a 3133 3a32 3220 474d 54c0 "
+                   "5a04 677a 6970 7738 666f 6f3d 4153 444a 4b48 514b 425a 584f 5157 454f 5049 5541 5851 "
+                   "5745 4f49 553b 206d 6178 2d61 6765 3d33 3630 303b 2076 6572 7369 6f6e 3d31",
+                   kResponse3);
+
+        // Left in the table: set-cookie, content-encoding and the new date.
+        checkBlock(decoder, "bebfc0",
+                   {kResponse3[5], kResponse3[4], kResponse3[2]});
+        CHECK(!decodes(decoder, "c1"));
+    }
+
+    // C.6: the same responses, Huffman-coded
+    void testHuffmanResponses()
+    {
+        hpack::Decoder decoder;
+        checkBlock(decoder,
+                   std::string(kTableSize256) +
+                       "4882 6402 5885 aec3 771a 4b61 96d0 7abe 9410 54d4 44a8 2005 9504 0b81 66e0 82a6 2d1b "
+                       "ff6e 919d 29ad 1718 63c7 8f0b 97c8 e9ae 82ae 43d3",
+                   kResponse1);
+        checkBlock(decoder, "4883 640e ffc1 c0bf", kResponse2);
+        checkBlock(decoder,
+                   "88c1 6196 d07a be94 1054 d444 a820 0595 040b 8166 e084 a62d 1bff c05a 839b d9ab 77ad "
+                   "94e7 821d d7f2 e6c7 b335 dfdf cd5b 3960 d5af 2708 7f36 72c1 ab27 0fb5 291f 9587 3160 "
+                   "65c0 03ed 4ee5 b106 3d50 07",
+                   kResponse3);
+    }
+
+    // Dynamic table size updates: shrinking evicts, growing past the
+    // SETTINGS limit is an error, and so is an update after the first field.
+    void testTableSizeUpdates()
+    {
+        hpack::Decoder decoder;
+        checkBlock(decoder, "8286 8441 0f77 7777 2e65 7861 6d70 6c65 2e63 6f6d", kRequest1);
+        checkBlock(decoder, "be", {{":authority", "www.example.com"}});
+
+        // Down to 0 empties the table; back up to 4096 leaves it empty.
+        checkBlock(decoder, "20", {});
+        CHECK(!decodes(decoder, "be"));
+        checkBlock(decoder, "3fe11f", {});
+        CHECK(!decodes(decoder, "be"));
+
+        // An entry larger than the table empties it instead of being added.
+        checkBlock(decoder, "3f11 400a 6375 7374 6f6d 2d6b 6579 0d63 7573 746f 6d2d 6865 6164 6572",
+                   {{"custom-key", "custom-header"}});
+        CHECK(!decodes(decoder, "be"));
+
+        hpack::Decoder limited;
+        CHECK(!decodes(limited, "3fe21f")); // 4097: above SETTINGS_HEADER_TABLE_SIZE
+
+        hpack::Decoder late;
+        CHECK(!decodes(late, "82 20")); // Only allowed at the start of a block
+        hpack::Decoder twice;
+        checkBlock(twice, "20 3fe11f 82", {{":method", "GET"}}); // Two updates in a row are fine
+    }
+
+    // Malformed blocks are rejected rather than misread.
+    void testMalformed()
+    {
+        hpack::Decoder decoder;
+        CHECK(!decodes(decoder, "80"));                       // Index 0
+        CHECK(!decodes(decoder, "ff ffff ffff ffff ffff ff7f")); // Integer longer than 64 bits
+        CHECK(!decodes(decoder, "400a 6375 7374"));           // String runs past the block
+        CHECK(!decodes(decoder, "4084 ffff ffff 00"));        // Huffman-coded EOS
+        CHECK(!decodes(decoder, "4081 ff 00"));               // Padding longer than 7 bits
+    }
+}
+
+int main()
+{
+    testFieldRepresentations();
+    testRequests();
+    testHuffmanRequests();
+    testResponses();
+    testHuffmanResponses();
+    testTableSizeUpdates();
+    testMalformed();
+
+    if (failures > 0)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("hpack_test: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,317 @@
+#include "http1.hpp" // Declarations of the HTTP/1.1 helpers
+#include <algorithm>    // For std::equal
+#include <charconv>     // For std::from_chars, std::to_chars
+
+namespace http1
+{
+    namespace
+    {
+        // Compares received text case-insensitively with a lower-case literal.
+        // ASCII only, as header names and the tokens compared are: no locale.
+        bool equalsLower(std::string_view text, std::string_view lower)
+        {
+            return text.size() == lower.size() &&
+                   std::equal(text.begin(), text.end(), lower.begin(),
+                              [](char a, char b) { return (a >= 'A' && a <= 'Z' ? a + ('a' - 'A') : a) == b; });
+        }
+
+        std::string_view trim(std::string_view value)
+        {
+            while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+                value.remove_prefix(1);
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+                value.remove_suffix(1);
+            return value;
+        }
+
+        // Records 'line' in 'headers' if it is one of the fields they hold.
+        void scanField(std::string_view line, Headers &headers)
+        {
+            size_t colon = line.find(':');
+            if (colon == std::string_view::npos)
+                return;
+
+            // The names of interest have distinct lengths (but for two), so
+            // most fields are rejected by their length alone.
+            std::string_view name = line.substr(0, colon);
+            std::string_view *field = nullptr;
+            switch (name.size())
+            {
+            case 6:
+                field = equalsLower(name, "expect") ? &headers.expect : nullptr;
+                break;
+            case 7:
+                field = equalsLower(name, "upgrade") ? &headers.upgrade : nullptr;
+                break;
+            case 10:
+                field = equalsLower(name, "connection") ? &headers.connection : nullptr;
+                break;
+            case 14:
+                field = equalsLower(name, "content-length")   ? &headers.content_length
+                        : equalsLower(name, "http2-settings") ? &headers.http2_settings
+                                                              : nullptr;
+                break;
+            case 15:
+                field = equalsLower(name, "accept-encoding") ? &headers.accept_encoding : nullptr;
+                break;
+            case 17:
+                field = equalsLower(name, "transfer-encoding") ? &headers.transfer_encoding : nullptr;
+                break;
+            }
+
+            // A present field has a non-null view, even if its value is empty.
+            if (field && !field->data())
+                *field = trim(line.substr(colon + 1));
+        }
+    }
+
+    bool parseRequest(std::string_view input, Request &request)
+    {
+        // One pass over the lines: the request line, then the header fields
+        // up to the blank line, each looked at once.
+        request.headers = {};
+        size_t eol = input.find("\r\n");
+        if (eol == std::string_view::npos)
+            return false;
+        size_t pos = eol + 2;
+        while ((eol = input.find("\r\n", pos)) != pos)
+        {
+            if (eol == std::string_view::npos)
+                return false;
+            scanField(input.substr(pos, eol - pos), request.headers);
+            pos = eol + 2;
+        }
+        size_t header_end = pos - 2;
+
+        request.head = input.substr(0, header_end);
+        parseRequestLine(request.head, request.method, request.target);
+
+        std::string_view length = request.headers.content_length;
+        request.content_length = 0;
+        std::from_chars(length.data(), length.data() + length.size(), request.content_length);
+
+        // "chunked" must be the final transfer coding; it is the only one we accept.
+        std::string_view encoding = request.headers.transfer_encoding;
+        request.chunked = encoding.size() >= 7 && equalsLower(encoding.substr(encoding.size() - 7), "chunked");
+
+        request.body_offset = header_end + 4;
+        request.body = input.substr(request.body_offset, request.content_length);
+        return true;
+    }
+
+    void parseRequestLine(std::string_view head, std::string_view &method, std::string_view &target)
+    {
+        // Views of the buffer; nothing is copied.
+        std::string_view request_line = head.substr(0, head.find("\r\n"));
+        size_t method_end = request_line.find(' ');
+        method = request_line.substr(0, method_end);
+        target = {};
+        if (method_end != std::string_view::npos)
+        {
+            size_t target_end = request_line.find(' ', method_end + 1);
+            target = request_line.substr(method_end + 1, target_end == std::string_view::npos
+                                                             ? std::string_view::npos
+                                                             : target_end - method_end - 1);
+        }
+    }
+
+    void splitTarget(std::string_view target, std::string_view &path, std::string_view &query)
+    {
+        size_t query_pos = target.find('?');
+        path = target.substr(0, query_pos);
+        query = query_pos == std::string_view::npos ? std::string_view() : target.substr(query_pos + 1);
+    }
+
+    std::string_view findHeader(std::string_view headers, std::string_view name)
+    {
+        // Header names are case-insensitive; scan line by line (the first line is
+        // the request line and never matches because it has no "name:" prefix).
+        size_t pos = 0;
+        while (pos < headers.size())
+        {
+            size_t eol = headers.find("\r\n", pos);
+            std::string_view line = headers.substr(pos, eol == std::string_view::npos ? std::string_view::npos : eol - pos);
+            if (line.size() > name.size() && line[name.size()] == ':' && equalsLower(line.substr(0, name.size()), name))
+                return trim(line.substr(name.size() + 1));
+            if (eol == std::string_view::npos)
+                break;
+            pos = eol + 2;
+        }
+        return {};
+    }
+
+    bool expectsContinue(const Request &request)
+    {
+        return equalsLower(request.headers.expect, "100-continue");
+    }
+
+    bool keepsAlive(const Request &request)
+    {
+        // HTTP/1.0 connections close by default; keep-alive isn't offered to them.
+        std::string_view request_line = request.head.substr(0, request.head.find("\r\n"));
+        if (request_line.size() < 8 || request_line.substr(request_line.size() - 8) != "HTTP/1.1")
+            return false;
+
+        // Connection is a comma-separated list of options, e.g. "close" or "keep-alive, Upgrade".
+        std::string_view connection = request.headers.connection;
+        while (!connection.empty())
+        {
+            size_t comma = connection.find(',');
+            if (equalsLower(trim(connection.substr(0, comma)), "close"))
+                return false;
+            connection = comma == std::string_view::npos ? std::string_view() : connection.substr(comma + 1);
+        }
+        return true;
+    }
+
+    bool upgradesToHttp2(const Request &request)
+    {
+        // The upgrade request must carry the client's settings (RFC 7540, 3.2).
+        return equalsLower(request.headers.upgrade, "h2c") && !request.headers.http2_settings.empty();
+    }
+
+    std::string_view parseKeyFromQuery(std::string_view query)
+    {
+        size_t key_pos = query.find("key=");
+        if (key_pos == std::string_view::npos)
+        {
+            return {};
+        }
+
+        size_t start = key_pos + 4;
+        // Find the end of the key parameter (next '&' or end of string)
+        size_t end = query.find('&', start);
+
+        if (end == std::string_view::npos)
+        {
+            // If no '&' found, return substring from start to end of string
+            return query.substr(start);
+        }
+        // Return substring from start to the position of '&'
+        return query.substr(start, end - start);
+    }
+
+    void parseKeyValue(std::string_view body, std::string_view &key, std::string_view &value)
+    {
+        // Simplified JSON parsing for {"key":"...", "value":"..."}
+        // Find positions of "key" and "value" in the body string
+        size_t key_start = body.find("\"key\"");
+        size_t value_start = body.find("\"value\"");
+
+        // If either "key" or "value" is not found, return without modifying key/value
+        if (key_start == std::string_view::npos || value_start == std::string_view::npos)
+        {
+            return;
+        }
+
+        // Extract the value of the "key" field from a JSON-formatted HTTP request body.
+        //
+        // Example input body (from a POST request):
+        //     {"key":"username","value":"Manish"}
+        //
+        // After this block executes:
+        //     key = "username"
+
+        //    - Finds the colon ':' after the "key" field name, then the opening quote
+        //      of the field's value, and moves just past it.
+        size_t key_value_start = body.find(':', key_start) + 1;
+        key_value_start = body.find('"', key_value_start) + 1;
+
+        //    - Finds the next double quote '"' that marks the *end* of the key's value
+        //      and takes a view of the text in between (e.g., "username").
+        size_t key_value_end = body.find('"', key_value_start);
+        key = body.substr(key_value_start, key_value_end - key_value_start);
+
+        // Extract value substring
+        size_t value_value_start = body.find(':', value_start) + 1;
+        value_value_start = body.find('"', value_value_start) + 1;
+        size_t value_value_end = body.find('"', value_value_start);
+        value = body.substr(value_value_start, value_value_end - value_value_start);
+    }
+
+    std::pmr::string percentDecode(std::string_view text, std::pmr::memory_resource *arena)
+    {
+        auto hex = [](char c) -> int {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            return -1;
+        };
+
+        std::pmr::string decoded(arena);
+        decoded.reserve(text.size());
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            if (text[i] == '%' && i + 2 < text.size() && hex(text[i + 1]) >= 0 && hex(text[i + 2]) >= 0)
+            {
+                decoded.push_back(static_cast<char>(hex(text[i + 1]) * 16 + hex(text[i + 2])));
+                i += 2;
+            }
+            else
+            {
+                decoded.push_back(text[i]);
+            }
+        }
+        return decoded;
+    }
+
+    std::pmr::string buildKeyValueJson(std::string_view key, std::string_view value,
+                                       std::pmr::memory_resource *arena)
+    {
+        std::pmr::string json(arena);
+        json.reserve(key.size() + value.size() + 22);
+        json.append("{\"key\":\"").append(key).append("\",\"value\":\"").append(value).append("\"}");
+        return json;
+    }
+
+    const char *statusText(int status_code)
+    {
+        switch (status_code)
+        {
+        case 200:
+            return "OK";
+        case 400:
+            return "Bad Request";
+        case 404:
+            return "Not Found";
+        case 405:
+            return "Method Not Allowed";
+        case 411:
+            return "Length Required";
+        case 413:
+            return "Payload Too Large";
+        case 500:
+            return "Internal Server Error";
+        case 503:
+            return "Service Unavailable";
+        default:
+            return "Unknown";
+        }
+    }
+
+    void writeResponseHead(std::pmr::string &head, int status_code, size_t content_length,
+                           std::string_view extra_headers, std::string_view content_type)
+    {
+        // Format the numbers with to_chars (no locale, no heap) instead of a stream.
+        char status[16];
+        char length[24];
+        std::string_view status_str(status, std::to_chars(status, status + sizeof(status), status_code).ptr - status);
+        std::string_view length_str(length, std::to_chars(length, length + sizeof(length), content_length).ptr - length);
+
+        head.reserve(head.size() + 160);
+        head.append("HTTP/1.1 ").append(status_str).append(" ").append(statusText(status_code)).append("\r\n");
+        head.append("Content-Type: ").append(content_type).append("\r\n");
+        head.append(extra_headers);
+        head.append("Content-Length: ").append(length_str).append("\r\n");
+        head.append("\r\n");
+    }
+
+    void addCacheStatus(std::pmr::string &head, bool hit)
+    {
+        // Insert before the blank line that ends the head.
+        head.insert(head.size() - 2, hit ? "X-Cache: HIT\r\n" : "X-Cache: MISS\r\n");
+    }
+}
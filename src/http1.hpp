@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Parsing of HTTP/1.1 requests and formatting of responses.
+ *
+ * The stateless pieces of the server's HTTP/1.1 handling: splitting the
+ * request line and target, looking up headers, body framing, extracting
+ * keys and values, and formatting the status line and headers. Parsing is
+ * zero-copy (results are views into the request) and anything built is
+ * allocated from the caller's per-request arena.
+ *
+ * Reading requests from sockets and routing them stay in the server (see
+ * KVServer::handleClient()); keeping these functions apart lets
+ * http_benchmark measure the same sequence without sockets.
+ */
+namespace http1
+{
+    /**
+     * @brief The (trimmed) values of the header fields the server acts on,
+     *        found in one pass over the header block (see parseRequest()).
+     *
+     * Absent fields are empty. Any other field is skipped; if a field occurs
+     * more than once, the first occurrence counts, as with findHeader().
+     */
+    struct Headers
+    {
+        std::string_view content_length;
+        std::string_view transfer_encoding;
+        std::string_view expect;
+        std::string_view connection;
+        std::string_view upgrade;
+        std::string_view http2_settings;
+        std::string_view accept_encoding;
+    };
+
+    /**
+     * @brief A request at the start of a connection's input, as views into it.
+     */
+    struct Request
+    {
+        std::string_view head;      // Request line and headers, without the blank line
+        std::string_view method;
+        std::string_view target;    // e.g. "/api/kv?key=a"
+        Headers headers;
+        size_t content_length = 0;  // From Content-Length (0 if absent)
+        bool chunked = false;       // "Transfer-Encoding: chunked"
+        size_t body_offset = 0;     // Where the body starts: just after the blank line
+        std::string_view body;      // The Content-Length bytes received so far
+
+        // Bytes the whole request takes up in the input.
+        size_t size() const { return body_offset + content_length; }
+    };
+
+    /**
+     * @brief Parses the request line, headers and body framing of the request starting 'input'.
+     *
+     * The header block is scanned once, line by line, up to the blank line
+     * that ends it; the predicates below read the fields found then. The request may be incomplete: 'body' then holds
+     * fewer than 'content_length' bytes. Chunked bodies are left to
+     * ChunkedDecoder.
+     * @return false if the header block hasn't been received completely.
+     */
+    bool parseRequest(std::string_view input, Request &request);
+
+
+    /**
+     * @brief Splits the request line ("GET /api/kv?key=a HTTP/1.1") into method and target.
+     * @param head The request line and header block.
+     */
+    void parseRequestLine(std::string_view head, std::string_view &method, std::string_view &target);
+
+    /**
+     * @brief Splits a request target into path and query string.
+     *
+     * Example: "/api/kv?key=a" → path "/api/kv", query "key=a".
+     */
+    void splitTarget(std::string_view target, std::string_view &path, std::string_view &query);
+
+    /**
+     * @brief Returns the (trimmed) value of a header, or an empty view if absent.
+     *
+     * Scans the whole block on every call: for parsed HTTP/1.1 requests, read
+     * Request::headers instead. Used for HTTP/2 header lines.
+     * @param headers The header block, without the terminating blank line.
+     * @param name Lower-case header name, e.g. "content-length".
+     */
+    std::string_view findHeader(std::string_view headers, std::string_view name);
+
+    /**
+     * @brief Returns true if the client sent "Expect: 100-continue".
+     */
+    bool expectsContinue(const Request &request);
+
+    /**
+     * @brief Returns true if an HTTP/1.1 request lets the connection persist (no "Connection: close").
+     */
+    bool keepsAlive(const Request &request);
+
+    /**
+     * @brief Returns true if the client asks to switch to HTTP/2 ("Upgrade: h2c" with HTTP2-Settings).
+     */
+    bool upgradesToHttp2(const Request &request);
+
+    /**
+     * @brief Extracts the "key" parameter from an HTTP query string.
+     *
+     * Example:
+     *   Input:  "key=example"
+     *   Output: "example"
+     *
+     * @param query The HTTP query string.
+     * @return Extracted key, as a view into 'query'.
+     */
+    std::string_view parseKeyFromQuery(std::string_view query);
+
+    /**
+     * @brief Parses the key and value from a JSON request body (used in POST).
+     *
+     * The body contains data in the format:
+     *   {"key":"<key>","value":"<value>"}
+     *
+     * @param body The HTTP request body.
+     * @param key Reference to store the extracted key (a view into 'body').
+     * @param value Reference to store the extracted value (a view into 'body').
+     */
+    void parseKeyValue(std::string_view body, std::string_view &key, std::string_view &value);
+
+    /**
+     * @brief Decodes %XX escapes in a URL path segment (e.g. a key containing '/').
+     */
+    std::pmr::string percentDecode(std::string_view text, std::pmr::memory_resource *arena);
+
+    /**
+     * @brief Builds the {"key":"...","value":"..."} body returned by GET.
+     */
+    std::pmr::string buildKeyValueJson(std::string_view key, std::string_view value,
+                                       std::pmr::memory_resource *arena);
+
+    /**
+     * @brief Returns a human-readable status message for a given HTTP code.
+     *
+     * Example:
+     *  - 200 → "OK"
+     *  - 404 → "Not Found"
+     *  - 500 → "Internal Server Error"
+     */
+    const char *statusText(int status_code);
+
+    /**
+     * @brief Appends the status line and headers, up to and including the blank line, to 'head'.
+     *
+     * @param content_length Number of body bytes that will follow.
+     * @param extra_headers Additional "Name: value\r\n" lines (e.g. Content-Encoding).
+     * @param content_type The Content-Type header value.
+     */
+    void writeResponseHead(std::pmr::string &head, int status_code, size_t content_length,
+                           std::string_view extra_headers, std::string_view content_type);
+
+    /**
+     * @brief Adds "X-Cache: HIT" or "X-Cache: MISS" to a head written by writeResponseHead().
+     */
+    void addCacheStatus(std::pmr::string &head, bool hit);
+}
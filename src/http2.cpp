@@ -0,0 +1,587 @@
+#include "http2.hpp" // Session class definition
+#include <algorithm>  // For std::min
+#include <cctype>     // For std::tolower
+
+namespace http2
+{
+    namespace
+    {
+        // Frame types (RFC 7540, section 6).
+        constexpr uint8_t kData = 0x0;
+        constexpr uint8_t kHeaders = 0x1;
+        constexpr uint8_t kPriority = 0x2;
+        constexpr uint8_t kRstStream = 0x3;
+        constexpr uint8_t kSettings = 0x4;
+        constexpr uint8_t kPushPromise = 0x5;
+        constexpr uint8_t kPing = 0x6;
+        constexpr uint8_t kGoAway = 0x7;
+        constexpr uint8_t kWindowUpdate = 0x8;
+        constexpr uint8_t kContinuation = 0x9;
+
+        // Frame flags.
+        constexpr uint8_t kEndStream = 0x1;
+        constexpr uint8_t kAck = 0x1;
+        constexpr uint8_t kEndHeaders = 0x4;
+        constexpr uint8_t kPadded = 0x8;
+        constexpr uint8_t kPriorityFlag = 0x20;
+
+        // Error codes (RFC 7540, section 7).
+        constexpr uint32_t kProtocolError = 0x1;
+        constexpr uint32_t kFlowControlError = 0x3;
+        constexpr uint32_t kStreamClosed = 0x5;
+        constexpr uint32_t kFrameSizeError = 0x6;
+        constexpr uint32_t kRefusedStream = 0x7;
+        constexpr uint32_t kCompressionError = 0x9;
+
+        // Settings identifiers.
+        constexpr uint16_t kSettingsMaxConcurrentStreams = 0x3;
+        constexpr uint16_t kSettingsInitialWindowSize = 0x4;
+        constexpr uint16_t kSettingsMaxFrameSize = 0x5;
+
+        constexpr size_t kFrameHeaderSize = 9;
+        constexpr uint32_t kMaxFrameSize = 16384; // We never raise SETTINGS_MAX_FRAME_SIZE
+        constexpr int64_t kMaxWindow = 0x7fffffff;
+
+        uint32_t load32(const char *p)
+        {
+            return (static_cast<uint32_t>(static_cast<unsigned char>(p[0])) << 24) |
+                   (static_cast<uint32_t>(static_cast<unsigned char>(p[1])) << 16) |
+                   (static_cast<uint32_t>(static_cast<unsigned char>(p[2])) << 8) |
+                   static_cast<uint32_t>(static_cast<unsigned char>(p[3]));
+        }
+
+        void append32(std::pmr::string &out, uint32_t value)
+        {
+            out.push_back(static_cast<char>(value >> 24));
+            out.push_back(static_cast<char>(value >> 16));
+            out.push_back(static_cast<char>(value >> 8));
+            out.push_back(static_cast<char>(value));
+        }
+
+        void appendFrameHeader(std::pmr::string &out, size_t length, uint8_t type, uint8_t flags, uint32_t stream_id)
+        {
+            out.push_back(static_cast<char>(length >> 16));
+            out.push_back(static_cast<char>(length >> 8));
+            out.push_back(static_cast<char>(length));
+            out.push_back(static_cast<char>(type));
+            out.push_back(static_cast<char>(flags));
+            append32(out, stream_id & 0x7fffffff);
+        }
+
+        void appendWindowUpdate(std::pmr::string &out, uint32_t stream_id, uint32_t increment)
+        {
+            appendFrameHeader(out, 4, kWindowUpdate, 0, stream_id);
+            append32(out, increment);
+        }
+
+        // Strips the padding of a PADDED frame; false if the pad length is impossible.
+        bool removePadding(uint8_t flags, std::string_view &payload)
+        {
+            if (!(flags & kPadded))
+                return true;
+            if (payload.empty())
+                return false;
+            size_t pad = static_cast<unsigned char>(payload[0]);
+            if (pad >= payload.size())
+                return false;
+            payload = payload.substr(1, payload.size() - 1 - pad);
+            return true;
+        }
+
+        // HTTP2-Settings is base64url without padding (RFC 7540, section 3.2.1).
+        bool decodeBase64Url(std::string_view text, std::string &decoded)
+        {
+            uint32_t bits = 0;
+            int bit_count = 0;
+            for (char c : text)
+            {
+                int value;
+                if (c >= 'A' && c <= 'Z')
+                    value = c - 'A';
+                else if (c >= 'a' && c <= 'z')
+                    value = c - 'a' + 26;
+                else if (c >= '0' && c <= '9')
+                    value = c - '0' + 52;
+                else if (c == '-' || c == '+')
+                    value = 62;
+                else if (c == '_' || c == '/')
+                    value = 63;
+                else if (c == '=')
+                    break;
+                else
+                    return false;
+                bits = (bits << 6) | value;
+                bit_count += 6;
+                if (bit_count >= 8)
+                {
+                    bit_count -= 8;
+                    decoded.push_back(static_cast<char>((bits >> bit_count) & 0xff));
+                }
+            }
+            return true;
+        }
+
+        // Connection-specific fields have no meaning in HTTP/2 (RFC 7540, section 8.1.2.2).
+        bool isConnectionSpecific(std::string_view name)
+        {
+            return name == "connection" || name == "keep-alive" || name == "proxy-connection" ||
+                   name == "transfer-encoding" || name == "upgrade";
+        }
+    }
+
+    // ======================================================================
+    // Connection setup
+    // ======================================================================
+
+    bool Session::upgrade(std::string_view http2_settings)
+    {
+        std::string payload;
+        if (!decodeBase64Url(http2_settings, payload) || !applySettings(payload))
+            return false;
+
+        // The upgrading request becomes stream 1, already half-closed by the client.
+        Stream &stream = streams[1];
+        stream.request_done = true;
+        stream.send_window = peer_initial_window;
+        last_stream_id = 1;
+        return true;
+    }
+
+    void Session::start(std::pmr::string &out)
+    {
+        appendFrameHeader(out, 12, kSettings, 0, 0);
+        out.push_back(0);
+        out.push_back(static_cast<char>(kSettingsMaxConcurrentStreams));
+        append32(out, kMaxConcurrentStreams);
+        out.push_back(0);
+        out.push_back(static_cast<char>(kSettingsInitialWindowSize));
+        append32(out, kInitialWindowSize);
+
+        // The connection window can only be raised with WINDOW_UPDATE.
+        appendWindowUpdate(out, 0, kInitialWindowSize - 65535);
+    }
+
+    // ======================================================================
+    // Receiving frames
+    // ======================================================================
+
+    bool Session::receive(std::string_view input, size_t &consumed, std::vector<Request> &requests,
+                          std::pmr::string &out)
+    {
+        consumed = 0;
+        if (!preface_received)
+        {
+            size_t available = std::min(input.size(), kPreface.size());
+            if (input.substr(0, available) != kPreface.substr(0, available))
+                return connectionError(kProtocolError, out);
+            if (available < kPreface.size())
+                return true;
+            preface_received = true;
+            consumed = kPreface.size();
+        }
+
+        while (input.size() - consumed >= kFrameHeaderSize)
+        {
+            const char *header = input.data() + consumed;
+            size_t length = (static_cast<size_t>(static_cast<unsigned char>(header[0])) << 16) |
+                            (static_cast<size_t>(static_cast<unsigned char>(header[1])) << 8) |
+                            static_cast<size_t>(static_cast<unsigned char>(header[2]));
+            uint8_t type = static_cast<uint8_t>(header[3]);
+            uint8_t flags = static_cast<uint8_t>(header[4]);
+            uint32_t stream_id = load32(header + 5) & 0x7fffffff;
+
+            if (length > kMaxFrameSize)
+                return connectionError(kFrameSizeError, out);
+            if (input.size() - consumed < kFrameHeaderSize + length)
+                break;
+
+            std::string_view payload = input.substr(consumed + kFrameHeaderSize, length);
+            consumed += kFrameHeaderSize + length;
+            if (!handleFrame(type, flags, stream_id, payload, requests, out))
+                return false;
+        }
+        return true;
+    }
+
+    bool Session::handleFrame(uint8_t type, uint8_t flags, uint32_t stream_id, std::string_view payload,
+                              std::vector<Request> &requests, std::pmr::string &out)
+    {
+        // A header block must be continued without anything in between.
+        if (continuation_stream != 0 && (type != kContinuation || stream_id != continuation_stream))
+            return connectionError(kProtocolError, out);
+
+        switch (type)
+        {
+        case kData:
+        {
+            if (stream_id == 0)
+                return connectionError(kProtocolError, out);
+
+            // Flow control counts the whole payload, padding included; the body
+            // is buffered right away, so both windows are reopened by the same amount.
+            if (!payload.empty())
+                appendWindowUpdate(out, 0, static_cast<uint32_t>(payload.size()));
+            if (!removePadding(flags, payload))
+                return connectionError(kProtocolError, out);
+
+            auto it = streams.find(stream_id);
+            if (it == streams.end() || it->second.request_done)
+            {
+                if (stream_id > last_stream_id)
+                    return connectionError(kProtocolError, out); // DATA on an idle stream
+                resetStream(stream_id, kStreamClosed, out);
+                return true;
+            }
+
+            Stream &stream = it->second;
+            if (stream.request.body.size() + payload.size() > max_body_bytes)
+                stream.request.too_large = true;
+            if (!stream.request.too_large)
+                stream.request.body.append(payload);
+
+            if (flags & kEndStream)
+                completeRequest(stream_id, stream, requests);
+            else if (!payload.empty())
+                appendWindowUpdate(out, stream_id, static_cast<uint32_t>(payload.size()));
+            return true;
+        }
+
+        case kHeaders:
+        {
+            if (stream_id == 0 || stream_id % 2 == 0)
+                return connectionError(kProtocolError, out);
+            if (!removePadding(flags, payload))
+                return connectionError(kProtocolError, out);
+            if (flags & kPriorityFlag)
+            {
+                if (payload.size() < 5)
+                    return connectionError(kFrameSizeError, out);
+                payload.remove_prefix(5);
+            }
+
+            auto it = streams.find(stream_id);
+            if (it != streams.end())
+            {
+                // A second header block on an open stream is a trailer, which must end it.
+                if (it->second.request_done || !(flags & kEndStream))
+                    return connectionError(kProtocolError, out);
+                it->second.trailers = true;
+            }
+            else
+            {
+                if (stream_id <= last_stream_id)
+                    return connectionError(kStreamClosed, out);
+                last_stream_id = stream_id;
+                it = streams.emplace(stream_id, Stream()).first;
+                it->second.send_window = peer_initial_window;
+            }
+
+            Stream &stream = it->second;
+            stream.end_stream = (flags & kEndStream) != 0;
+            stream.header_block.assign(payload);
+            if (!(flags & kEndHeaders))
+            {
+                continuation_stream = stream_id;
+                return true;
+            }
+            return finishHeaders(stream_id, requests, out);
+        }
+
+        case kContinuation:
+        {
+            if (continuation_stream == 0)
+                return connectionError(kProtocolError, out);
+            Stream &stream = streams[stream_id];
+            if (stream.header_block.size() + payload.size() > hpack::Decoder::kMaxStringLength * 4)
+                return connectionError(kProtocolError, out);
+            stream.header_block.append(payload);
+            if (!(flags & kEndHeaders))
+                return true;
+            continuation_stream = 0;
+            return finishHeaders(stream_id, requests, out);
+        }
+
+        case kPriority:
+            if (stream_id == 0)
+                return connectionError(kProtocolError, out);
+            return true;
+
+        case kRstStream:
+            if (stream_id == 0 || stream_id > last_stream_id)
+                return connectionError(kProtocolError, out);
+            if (payload.size() != 4)
+                return connectionError(kFrameSizeError, out);
+            streams.erase(stream_id); // Queued data for it is skipped by flushData()
+            return true;
+
+        case kSettings:
+            if (stream_id != 0)
+                return connectionError(kProtocolError, out);
+            if (flags & kAck)
+                return payload.empty() ? true : connectionError(kFrameSizeError, out);
+            if (payload.size() % 6 != 0)
+                return connectionError(kFrameSizeError, out);
+            if (!applySettings(payload))
+                return connectionError(kFlowControlError, out);
+            appendFrameHeader(out, 0, kSettings, kAck, 0);
+            flushData(out); // A larger initial window may unblock streams
+            return true;
+
+        case kPushPromise:
+            return connectionError(kProtocolError, out); // Clients cannot push
+
+        case kPing:
+            if (stream_id != 0)
+                return connectionError(kProtocolError, out);
+            if (payload.size() != 8)
+                return connectionError(kFrameSizeError, out);
+            if (!(flags & kAck))
+            {
+                appendFrameHeader(out, 8, kPing, kAck, 0);
+                out.append(payload);
+            }
+            return true;
+
+        case kGoAway:
+            if (stream_id != 0)
+                return connectionError(kProtocolError, out);
+            goaway_received = true;
+            return true;
+
+        case kWindowUpdate:
+        {
+            if (payload.size() != 4)
+                return connectionError(kFrameSizeError, out);
+            uint32_t increment = load32(payload.data()) & 0x7fffffff;
+            if (stream_id == 0)
+            {
+                if (increment == 0)
+                    return connectionError(kProtocolError, out);
+                connection_send_window += increment;
+                if (connection_send_window > kMaxWindow)
+                    return connectionError(kFlowControlError, out);
+            }
+            else
+            {
+                auto it = streams.find(stream_id);
+                if (increment == 0)
+                    resetStream(stream_id, kProtocolError, out);
+                else if (it != streams.end())
+                {
+                    it->second.send_window += increment;
+                    if (it->second.send_window > kMaxWindow)
+                        resetStream(stream_id, kFlowControlError, out);
+                }
+            }
+            flushData(out);
+            return true;
+        }
+
+        default:
+            return true; // Unknown frame types must be ignored
+        }
+    }
+
+    bool Session::finishHeaders(uint32_t stream_id, std::vector<Request> &requests, std::pmr::string &out)
+    {
+        Stream &stream = streams[stream_id];
+        std::vector<hpack::Header> fields;
+        // Every block goes through the decoder, even one that is then refused,
+        // or the dynamic table would fall out of step with the client's.
+        if (!decoder.decode(stream.header_block, fields))
+            return connectionError(kCompressionError, out);
+        stream.header_block.clear();
+        stream.header_block.shrink_to_fit();
+
+        if (stream.trailers)
+        {
+            completeRequest(stream_id, stream, requests); // Trailer fields aren't used
+            return true;
+        }
+
+        if (streams.size() > kMaxConcurrentStreams)
+        {
+            resetStream(stream_id, kRefusedStream, out);
+            return true;
+        }
+
+        Request &request = stream.request;
+        for (const hpack::Header &field : fields)
+        {
+            if (field.name == ":method")
+                request.method = field.value;
+            else if (field.name == ":path")
+                request.target = field.value;
+            else if (!field.name.empty() && field.name[0] != ':')
+            {
+                request.headers += field.name;
+                request.headers += ": ";
+                request.headers += field.value;
+                request.headers += "\r\n";
+            }
+        }
+        if (request.method.empty() || request.target.empty())
+        {
+            resetStream(stream_id, kProtocolError, out);
+            return true;
+        }
+
+        if (stream.end_stream)
+            completeRequest(stream_id, stream, requests);
+        return true;
+    }
+
+    bool Session::applySettings(std::string_view payload)
+    {
+        for (size_t i = 0; i + 6 <= payload.size(); i += 6)
+        {
+            uint16_t id = static_cast<uint16_t>((static_cast<unsigned char>(payload[i]) << 8) |
+                                                static_cast<unsigned char>(payload[i + 1]));
+            uint32_t value = load32(payload.data() + i + 2);
+            if (id == kSettingsInitialWindowSize)
+            {
+                if (value > kMaxWindow)
+                    return false;
+                // The change applies to the windows of open streams too (RFC 7540, 6.9.2).
+                int64_t delta = static_cast<int64_t>(value) - peer_initial_window;
+                for (auto &entry : streams)
+                    entry.second.send_window += delta;
+                peer_initial_window = value;
+            }
+            else if (id == kSettingsMaxFrameSize)
+            {
+                if (value < 16384 || value > 16777215)
+                    return false;
+                peer_max_frame_size = value;
+            }
+        }
+        return true;
+    }
+
+    void Session::completeRequest(uint32_t stream_id, Stream &stream, std::vector<Request> &requests)
+    {
+        stream.request_done = true;
+        stream.request.stream_id = stream_id;
+        requests.push_back(std::move(stream.request));
+        stream.request = Request();
+    }
+
+    // ======================================================================
+    // Sending responses
+    // ======================================================================
+
+    void Session::respond(uint32_t stream_id, int status, std::string_view headers, std::string body,
+                          std::pmr::string &out)
+    {
+        auto it = streams.find(stream_id);
+        if (it == streams.end())
+            return; // Reset by the client in the meantime
+
+        std::pmr::string block(out.get_allocator());
+        hpack::appendStatus(block, status);
+        std::string name;
+        while (!headers.empty())
+        {
+            size_t line_end = headers.find("\r\n");
+            std::string_view line = headers.substr(0, line_end);
+            headers = line_end == std::string_view::npos ? std::string_view() : headers.substr(line_end + 2);
+
+            size_t colon = line.find(':');
+            if (colon == std::string_view::npos)
+                continue;
+            name.clear();
+            for (char c : line.substr(0, colon))
+                name.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+            if (isConnectionSpecific(name))
+                continue;
+            std::string_view value = line.substr(colon + 1);
+            while (!value.empty() && value.front() == ' ')
+                value.remove_prefix(1);
+            hpack::appendHeader(block, name, value);
+        }
+
+        // HEADERS, then CONTINUATION frames if the block exceeds the peer's frame size.
+        uint8_t end_stream = body.empty() ? kEndStream : 0;
+        size_t offset = 0;
+        do
+        {
+            size_t length = std::min<size_t>(block.size() - offset, peer_max_frame_size);
+            bool last = offset + length == block.size();
+            appendFrameHeader(out, length, offset == 0 ? kHeaders : kContinuation,
+                              (offset == 0 ? end_stream : 0) | (last ? kEndHeaders : 0), stream_id);
+            out.append(block, offset, length);
+            offset += length;
+        } while (offset < block.size());
+
+        if (body.empty())
+        {
+            streams.erase(it);
+            return;
+        }
+        it->second.pending = std::move(body);
+        it->second.pending_offset = 0;
+        it->second.responding = true;
+        send_queue.push_back(stream_id);
+        flushData(out);
+    }
+
+    void Session::flushData(std::pmr::string &out)
+    {
+        // One frame per stream per turn, so concurrent responses share the
+        // connection window fairly. 'blocked' counts consecutive streams that
+        // are waiting on their own window; once it covers the queue, stop.
+        size_t blocked = 0;
+        while (!send_queue.empty() && connection_send_window > 0 && blocked < send_queue.size())
+        {
+            uint32_t stream_id = send_queue.front();
+            send_queue.pop_front();
+            auto it = streams.find(stream_id);
+            if (it == streams.end() || !it->second.responding)
+                continue; // Reset by the client
+
+            Stream &stream = it->second;
+            size_t remaining = stream.pending.size() - stream.pending_offset;
+            int64_t window = std::min(stream.send_window, connection_send_window);
+            size_t length = window <= 0 ? 0 : std::min<size_t>({remaining, peer_max_frame_size,
+                                                                 static_cast<size_t>(window)});
+            if (length == 0)
+            {
+                send_queue.push_back(stream_id);
+                ++blocked;
+                continue;
+            }
+            blocked = 0;
+
+            bool last = length == remaining;
+            appendFrameHeader(out, length, kData, last ? kEndStream : 0, stream_id);
+            out.append(stream.pending, stream.pending_offset, length);
+            stream.pending_offset += length;
+            stream.send_window -= length;
+            connection_send_window -= length;
+
+            if (last)
+                streams.erase(it);
+            else
+                send_queue.push_back(stream_id);
+        }
+    }
+
+    // ======================================================================
+    // Errors
+    // ======================================================================
+
+    bool Session::connectionError(uint32_t error_code, std::pmr::string &out)
+    {
+        appendFrameHeader(out, 8, kGoAway, 0, 0);
+        append32(out, last_stream_id);
+        append32(out, error_code);
+        return false;
+    }
+
+    void Session::resetStream(uint32_t stream_id, uint32_t error_code, std::pmr::string &out)
+    {
+        appendFrameHeader(out, 4, kRstStream, 0, stream_id);
+        append32(out, error_code);
+        streams.erase(stream_id);
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "hpack.hpp"
+
+/**
+ * @brief Server side of a cleartext HTTP/2 (h2c) connection (RFC 7540).
+ *
+ * A Session turns the bytes received on a connection into complete requests
+ * and the responses given to it back into frames. It implements framing,
+ * stream states, HPACK (see hpack.hpp), SETTINGS, PING, GOAWAY and flow
+ * control in both directions. Response bodies of concurrent streams are
+ * interleaved frame by frame, so one large response doesn't hold the others
+ * back. Server push and priorities are not implemented (priorities are
+ * accepted and ignored).
+ *
+ * The session does no I/O: receive() and respond() append the bytes to send
+ * to the caller's output buffer.
+ */
+namespace http2
+{
+    // Client connection preface, which is also how prior-knowledge h2c is detected.
+    constexpr std::string_view kPreface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+    struct Request
+    {
+        uint32_t stream_id = 0;
+        std::string method;
+        std::string target;   // :path, e.g. "/api/kv?key=a"
+        std::string headers;  // Regular fields as HTTP/1.1-style "name: value\r\n" lines
+        std::string body;
+        bool too_large = false; // Body exceeded the limit and was discarded
+    };
+
+    class Session
+    {
+    public:
+        // Streams a client may have open at once (advertised in SETTINGS).
+        static constexpr uint32_t kMaxConcurrentStreams = 128;
+
+        // Per-stream receive window we advertise; request bodies are buffered,
+        // so the window is reopened as soon as DATA arrives.
+        static constexpr uint32_t kInitialWindowSize = 1024 * 1024;
+
+        explicit Session(size_t max_body_bytes) : max_body_bytes(max_body_bytes) {}
+
+        /**
+         * @brief Takes over a connection upgraded from HTTP/1.1 ("Upgrade: h2c").
+         *
+         * Applies the client's HTTP2-Settings header and opens stream 1 for the
+         * upgrading request, whose response is then given with respond(1, ...).
+         * @return false if the settings are malformed.
+         */
+        bool upgrade(std::string_view http2_settings);
+
+        /**
+         * @brief Appends the server's connection preface (its SETTINGS).
+         */
+        void start(std::pmr::string &out);
+
+        /**
+         * @brief Processes the complete frames at the start of 'input'.
+         * @param consumed Receives the number of bytes used.
+         * @param requests Receives the requests completed by these frames.
+         * @param out Receives acknowledgements, window updates, resets and any
+         *        response data that flow control had held back.
+         * @return false if the connection must be closed once 'out' is sent
+         *         (a connection error, which has been answered with GOAWAY).
+         */
+        bool receive(std::string_view input, size_t &consumed, std::vector<Request> &requests, std::pmr::string &out);
+
+        /**
+         * @brief Sends the response of a stream, as far as flow control allows.
+         * @param headers HTTP/1.1-style "Name: value\r\n" lines; names are
+         *        lower-cased and connection-specific fields dropped.
+         */
+        void respond(uint32_t stream_id, int status, std::string_view headers, std::string body, std::pmr::string &out);
+
+        /**
+         * @brief True once the client sent GOAWAY and every response went out.
+         */
+        bool finished() const { return goaway_received && send_queue.empty(); }
+
+    private:
+        struct Stream
+        {
+            bool request_done = false; // END_STREAM received
+            bool trailers = false;     // The header block being received is a trailer
+            bool end_stream = false;   // END_STREAM was set on the header block being received
+            std::string header_block;  // HEADERS + CONTINUATION fragments
+            Request request;
+            int64_t send_window = 0;
+            std::string pending;       // Response body bytes not sent yet
+            size_t pending_offset = 0;
+            bool responding = false;
+        };
+
+        bool handleFrame(uint8_t type, uint8_t flags, uint32_t stream_id, std::string_view payload,
+                         std::vector<Request> &requests, std::pmr::string &out);
+        bool finishHeaders(uint32_t stream_id, std::vector<Request> &requests, std::pmr::string &out);
+        bool applySettings(std::string_view payload);
+        void completeRequest(uint32_t stream_id, Stream &stream, std::vector<Request> &requests);
+        void flushData(std::pmr::string &out);
+        bool connectionError(uint32_t error_code, std::pmr::string &out);
+        void resetStream(uint32_t stream_id, uint32_t error_code, std::pmr::string &out);
+
+        size_t max_body_bytes;
+        hpack::Decoder decoder;
+        std::map<uint32_t, Stream> streams;
+        std::deque<uint32_t> send_queue;  // Streams with response data waiting, round-robin
+        bool preface_received = false;
+        bool goaway_received = false;
+        uint32_t last_stream_id = 0;      // Highest stream the client opened
+        uint32_t continuation_stream = 0; // Stream whose header block is incomplete, or 0
+        int64_t connection_send_window = 65535;
+        uint32_t peer_initial_window = 65535;
+        uint32_t peer_max_frame_size = 16384;
+    };
+}
@@ -0,0 +1,337 @@
+#include <cstdint>
+#include <cstdio>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "hpack.hpp"
+#include "http2.hpp"
+
+/**
+ * @brief Tests of http2::Session: header blocks split over CONTINUATION
+ *        frames, input arriving in arbitrary pieces, the connection errors
+ *        a broken header sequence must cause, and the frames of a response.
+ *
+ * The tests play the client: they build frames by hand, feed them to a
+ * Session the way serviceConnection() does (keeping what receive() did not
+ * consume for the next read), and parse the frames it answers with. Run by
+ * ctest; exits non-zero if any check fails.
+ */
+
+namespace
+{
+    int failures = 0;
+
+#define CHECK(condition)                                                        \
+    do                                                                          \
+    {                                                                           \
+        if (!(condition))                                                       \
+        {                                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                         \
+        }                                                                       \
+    } while (0)
+
+    constexpr uint8_t kData = 0x0;
+    constexpr uint8_t kHeaders = 0x1;
+    constexpr uint8_t kSettings = 0x4;
+    constexpr uint8_t kPing = 0x6;
+    constexpr uint8_t kGoAway = 0x7;
+    constexpr uint8_t kContinuation = 0x9;
+
+    constexpr uint8_t kEndStream = 0x1;
+    constexpr uint8_t kEndHeaders = 0x4;
+
+    constexpr uint32_t kProtocolError = 0x1;
+    constexpr uint32_t kCompressionError = 0x9;
+
+    constexpr size_t kMaxBody = 1024 * 1024;
+
+    struct Frame
+    {
+        uint8_t type;
+        uint8_t flags;
+        uint32_t stream_id;
+        std::string payload;
+    };
+
+    uint32_t load32(std::string_view bytes)
+    {
+        return (static_cast<uint32_t>(static_cast<unsigned char>(bytes[0])) << 24) |
+               (static_cast<uint32_t>(static_cast<unsigned char>(bytes[1])) << 16) |
+               (static_cast<uint32_t>(static_cast<unsigned char>(bytes[2])) << 8) |
+               static_cast<uint32_t>(static_cast<unsigned char>(bytes[3]));
+    }
+
+    std::string frame(uint8_t type, uint8_t flags, uint32_t stream_id, std::string_view payload)
+    {
+        std::string bytes;
+        bytes.push_back(static_cast<char>(payload.size() >> 16));
+        bytes.push_back(static_cast<char>(payload.size() >> 8));
+        bytes.push_back(static_cast<char>(payload.size()));
+        bytes.push_back(static_cast<char>(type));
+        bytes.push_back(static_cast<char>(flags));
+        for (int shift = 24; shift >= 0; shift -= 8)
+            bytes.push_back(static_cast<char>(stream_id >> shift));
+        bytes.append(payload);
+        return bytes;
+    }
+
+    std::vector<Frame> parseFrames(std::string_view bytes)
+    {
+        std::vector<Frame> frames;
+        while (bytes.size() >= 9)
+        {
+            size_t length = (static_cast<size_t>(static_cast<unsigned char>(bytes[0])) << 16) |
+                            (static_cast<size_t>(static_cast<unsigned char>(bytes[1])) << 8) |
+                            static_cast<size_t>(static_cast<unsigned char>(bytes[2]));
+            if (bytes.size() < 9 + length)
+                break;
+            frames.push_back({static_cast<uint8_t>(bytes[3]), static_cast<uint8_t>(bytes[4]),
+                              load32(bytes.substr(5)) & 0x7fffffff, std::string(bytes.substr(9, length))});
+            bytes.remove_prefix(9 + length);
+        }
+        return frames;
+    }
+
+    // The header block of a request, with literal fields only
+    std::string requestBlock(std::string_view method, std::string_view path,
+                             const std::vector<hpack::Header> &headers = {})
+    {
+        std::pmr::string block;
+        hpack::appendHeader(block, ":method", method);
+        hpack::appendHeader(block, ":scheme", "http");
+        hpack::appendHeader(block, ":path", path);
+        for (const hpack::Header &header : headers)
+            hpack::appendHeader(block, header.name, header.value);
+        return std::string(block);
+    }
+
+    /**
+     * @brief A Session and what it received and sent, fed like a connection.
+     */
+    struct Client
+    {
+        http2::Session session{kMaxBody};
+        std::string pending; // Received bytes receive() has not consumed yet
+        std::vector<http2::Request> requests;
+        std::pmr::string out;
+        bool open = true;
+
+        // Delivers 'bytes' in reads of at most 'piece' bytes.
+        void send(std::string_view bytes, size_t piece = SIZE_MAX)
+        {
+            while (!bytes.empty() && open)
+            {
+                size_t length = std::min(piece, bytes.size());
+                pending.append(bytes.substr(0, length));
+                bytes.remove_prefix(length);
+
+                size_t consumed = 0;
+                open = session.receive(pending, consumed, requests, out);
+                pending.erase(0, consumed);
+            }
+        }
+
+        void connect()
+        {
+            send(http2::kPreface);
+            send(frame(kSettings, 0, 0, ""));
+        }
+
+        // The GOAWAY error code sent, or -1 if there was none
+        int64_t goAwayError() const
+        {
+            for (const Frame &sent : parseFrames(out))
+            {
+                if (sent.type == kGoAway && sent.payload.size() >= 8)
+                    return load32(sent.payload.substr(4));
+            }
+            return -1;
+        }
+    };
+
+    // A request whose header block spans HEADERS and two CONTINUATION frames,
+    // split inside an HPACK string, is assembled into one request.
+    void testContinuation()
+    {
+        std::string block = requestBlock("GET", "/api/kv?key=split", {{"x-trace", "abc"}});
+        size_t first = block.size() / 3, second = block.size() * 2 / 3;
+        std::string frames = frame(kHeaders, kEndStream, 1, block.substr(0, first)) +
+                             frame(kContinuation, 0, 1, block.substr(first, second - first)) +
+                             frame(kContinuation, kEndHeaders, 1, block.substr(second));
+
+        // Whole, and then one byte per read: the result must not depend on
+        // where the reads split the frames.
+        for (size_t piece : {SIZE_MAX, size_t(1), size_t(7)})
+        {
+            Client client;
+            client.connect();
+            client.send(frames, piece);
+            CHECK(client.open);
+            CHECK(client.pending.empty());
+            CHECK(client.requests.size() == 1);
+            if (client.requests.size() != 1)
+                continue;
+            const http2::Request &request = client.requests[0];
+            CHECK(request.stream_id == 1);
+            CHECK(request.method == "GET");
+            CHECK(request.target == "/api/kv?key=split");
+            CHECK(request.headers == "x-trace: abc\r\n");
+            CHECK(request.body.empty());
+        }
+    }
+
+    // Nothing is returned until END_HEADERS, and a body sent after the
+    // CONTINUATION frames belongs to the same request.
+    void testContinuationWithBody()
+    {
+        std::string block = requestBlock("POST", "/api/kv", {{"content-type", "application/json"}});
+        Client client;
+        client.connect();
+        client.send(frame(kHeaders, 0, 1, block.substr(0, 5)));
+        client.send(frame(kContinuation, 0, 1, block.substr(5, 5)));
+        CHECK(client.requests.empty());
+        client.send(frame(kContinuation, kEndHeaders, 1, block.substr(10)));
+        CHECK(client.requests.empty()); // No END_STREAM yet
+        client.send(frame(kData, 0, 1, "{\"key\":\"a\","));
+        client.send(frame(kData, kEndStream, 1, "\"value\":\"b\"}"));
+
+        CHECK(client.open);
+        CHECK(client.requests.size() == 1);
+        if (client.requests.size() == 1)
+        {
+            CHECK(client.requests[0].method == "POST");
+            CHECK(client.requests[0].headers == "content-type: application/json\r\n");
+            CHECK(client.requests[0].body == "{\"key\":\"a\",\"value\":\"b\"}");
+        }
+    }
+
+    // A header block must be continued by CONTINUATION frames on its own
+    // stream, with nothing in between; anything else is a connection error.
+    void testBrokenContinuation()
+    {
+        std::string block = requestBlock("GET", "/api/kv?key=a");
+
+        Client interleaved;
+        interleaved.connect();
+        interleaved.send(frame(kHeaders, kEndStream, 1, block.substr(0, 4)));
+        interleaved.send(frame(kPing, 0, 0, std::string(8, '\0')));
+        CHECK(!interleaved.open);
+        CHECK(interleaved.goAwayError() == kProtocolError);
+        CHECK(interleaved.requests.empty());
+
+        Client other_stream;
+        other_stream.connect();
+        other_stream.send(frame(kHeaders, kEndStream, 1, block.substr(0, 4)));
+        other_stream.send(frame(kContinuation, kEndHeaders, 3, block.substr(4)));
+        CHECK(!other_stream.open);
+        CHECK(other_stream.goAwayError() == kProtocolError);
+
+        Client new_headers;
+        new_headers.connect();
+        new_headers.send(frame(kHeaders, kEndStream, 1, block.substr(0, 4)));
+        new_headers.send(frame(kHeaders, kEndStream | kEndHeaders, 3, block));
+        CHECK(!new_headers.open);
+        CHECK(new_headers.goAwayError() == kProtocolError);
+
+        Client orphan;
+        orphan.connect();
+        orphan.send(frame(kContinuation, kEndHeaders, 1, block));
+        CHECK(!orphan.open);
+        CHECK(orphan.goAwayError() == kProtocolError);
+
+        // After a complete block, another CONTINUATION has nothing to continue.
+        Client late;
+        late.connect();
+        late.send(frame(kHeaders, kEndStream, 1, block.substr(0, 4)));
+        late.send(frame(kContinuation, kEndHeaders, 1, block.substr(4)));
+        CHECK(late.requests.size() == 1);
+        late.send(frame(kContinuation, kEndHeaders, 1, block));
+        CHECK(!late.open);
+        CHECK(late.goAwayError() == kProtocolError);
+    }
+
+    // A block that doesn't decode once reassembled is a compression error.
+    void testCorruptBlock()
+    {
+        Client client;
+        client.connect();
+        client.send(frame(kHeaders, kEndStream, 1, "\x40\x0a" "cust"));
+        client.send(frame(kContinuation, kEndHeaders, 1, "om"));
+        CHECK(!client.open);
+        CHECK(client.goAwayError() == kCompressionError);
+    }
+
+    // A response whose header block exceeds the frame size goes out as
+    // HEADERS and CONTINUATION frames, followed by its body.
+    void testResponseContinuation()
+    {
+        Client client;
+        client.connect();
+        client.send(frame(kHeaders, kEndStream | kEndHeaders, 1, requestBlock("GET", "/api/kv?key=a")));
+        CHECK(client.requests.size() == 1);
+        client.out.clear();
+
+        std::string large(20000, 'x');
+        client.session.respond(1, 200, "Content-Type: application/json\r\nX-Large: " + large + "\r\n", "{}",
+                               client.out);
+
+        std::string block;
+        bool end_headers = false;
+        std::string body;
+        bool end_stream = false;
+        size_t header_frames = 0;
+        for (const Frame &sent : parseFrames(client.out))
+        {
+            CHECK(sent.stream_id == 1);
+            if (sent.type == kHeaders || sent.type == kContinuation)
+            {
+                CHECK(!end_headers);
+                CHECK((sent.type == kHeaders) == (header_frames == 0));
+                CHECK(sent.payload.size() <= 16384);
+                header_frames++;
+                block += sent.payload;
+                end_headers = sent.flags & kEndHeaders;
+            }
+            else if (sent.type == kData)
+            {
+                CHECK(end_headers);
+                body += sent.payload;
+                end_stream = sent.flags & kEndStream;
+            }
+        }
+        CHECK(header_frames == 2);
+        CHECK(end_headers);
+        CHECK(end_stream);
+        CHECK(body == "{}");
+
+        hpack::Decoder decoder;
+        std::vector<hpack::Header> fields;
+        CHECK(decoder.decode(block, fields));
+        CHECK(fields.size() == 3);
+        if (fields.size() == 3)
+        {
+            CHECK(fields[0].name == ":status" && fields[0].value == "200");
+            CHECK(fields[1].name == "content-type" && fields[1].value == "application/json");
+            CHECK(fields[2].name == "x-large" && fields[2].value == large);
+        }
+    }
+}
+
+int main()
+{
+    testContinuation();
+    testContinuationWithBody();
+    testBrokenContinuation();
+    testCorruptBlock();
+    testResponseContinuation();
+
+    if (failures > 0)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("http2_test: all checks passed\n");
+    return 0;
+}
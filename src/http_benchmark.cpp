@@ -0,0 +1,302 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include "http1.hpp"
+
+/**
+ * @brief Microbenchmarks of HTTP/1.1 request parsing and response building.
+ *
+ * Times, without sockets, the CPU work the server does for every request
+ * besides the cache lookup:
+ *
+ *  - BM_ParseRequest: request line, headers, framing, body and query key,
+ *    as handleClient() and routeRequest() do it. Its arguments are the
+ *    number of headers, the length of the query string and the body size (0
+ *    is a GET; otherwise a POST with a JSON body of about that size);
+ *  - BM_ParseKeyValue: extracting the key and value from a POST's JSON body
+ *    (parseKeyValue()), by value size;
+ *  - BM_BuildResponse: the JSON body, status line and headers of a GET hit,
+ *    by value size.
+ *
+ * Each runs on the http1 functions the server uses (Http1, on a per-request
+ * arena like a worker's) and, as a reference, on the string-copying and
+ * stream-based code of the first server version (Original). Besides the
+ * time per request, every case reports allocs_per_req and
+ * alloc_bytes_per_req: heap allocations counted by replacing the global
+ * operator new in this program. Allocations from the arena's own buffer
+ * don't count; a request outgrowing it does. Results are exported with
+ * Google Benchmark's flags, e.g.
+ *   http_benchmark --benchmark_out=http.json --benchmark_out_format=json
+ */
+
+namespace
+{
+    // Heap allocations made by this thread, counted by operator new below
+    thread_local uint64_t t_allocations = 0;
+    thread_local uint64_t t_allocated_bytes = 0;
+}
+
+// None of these are inlined: GCC would then see malloc() and free() paired
+// with operator new and delete, and warn.
+[[gnu::noinline]] void *operator new(std::size_t size)
+{
+    t_allocations++;
+    t_allocated_bytes += size;
+    if (void *memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+// Used by the arena's upstream resource (std::pmr::new_delete_resource())
+[[gnu::noinline]] void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    t_allocations++;
+    t_allocated_bytes += size;
+    size_t align = static_cast<size_t>(alignment);
+    if (void *memory = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align))
+        return memory;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+[[gnu::noinline]] void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+[[gnu::noinline]] void operator delete(void *memory, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+[[gnu::noinline]] void operator delete(void *memory, std::size_t, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace
+{
+    constexpr size_t kArenaSize = 64 * 1024;   // As KVServer::kArenaSize
+    constexpr std::string_view kKey = "user:12345";
+
+    // A request as a client would send it: common headers first, then
+    // custom ones up to 'header_count'.
+    std::string makeRequest(size_t header_count, size_t query_length, size_t body_size)
+    {
+        std::string query = "key=" + std::string(std::max<size_t>(query_length, 5) - 4, 'k');
+        std::string body;
+        if (body_size > 0)
+        {
+            body = "{\"key\":\"" + std::string(kKey) + "\",\"value\":\"";
+            body.append(body_size > body.size() + 2 ? body_size - body.size() - 2 : 1, 'v');
+            body.append("\"}");
+        }
+
+        const std::string common[] = {"Host: localhost:8080", "User-Agent: http_benchmark/1.0", "Accept: */*",
+                                      "Accept-Encoding: gzip, deflate", "Connection: keep-alive"};
+        std::string request = (body.empty() ? "GET" : "POST") + std::string(" /api/kv?") + query + " HTTP/1.1\r\n";
+        for (size_t i = 0; i < header_count; i++)
+        {
+            if (i < std::size(common))
+                request += common[i] + "\r\n";
+            else
+                request += "X-Request-Header-" + std::to_string(i) + ": value-" + std::to_string(i) + "\r\n";
+        }
+        if (!body.empty())
+            request += "Content-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) + "\r\n";
+        return request + "\r\n" + body;
+    }
+
+    std::string makeValue(size_t size)
+    {
+        return std::string(size, 'v');
+    }
+
+    /**
+     * @brief The server's parsing and formatting, with views into the
+     *        received request.
+     */
+    struct Http1
+    {
+        static size_t parseRequest(std::string_view input, std::pmr::memory_resource *)
+        {
+            // handleClient(): parsed in place from the connection's input
+            http1::Request request;
+            http1::parseRequest(input, request);
+            bool keep_alive = http1::keepsAlive(request);
+
+            // routeRequest() and the handlers
+            std::string_view path, query;
+            http1::splitTarget(request.target, path, query);
+            bool gzip = !request.headers.accept_encoding.empty();
+            std::string_view key = request.method == "GET" ? http1::parseKeyFromQuery(query) : std::string_view();
+            return path.size() + key.size() + request.body.size() + request.chunked + keep_alive + gzip;
+        }
+
+        static size_t parseKeyValue(std::string_view body, std::pmr::memory_resource *)
+        {
+            std::string_view key, value;
+            http1::parseKeyValue(body, key, value);
+            return key.size() + value.size();
+        }
+
+        static size_t buildResponse(std::string_view key, std::string_view value, std::pmr::memory_resource *arena)
+        {
+            // handleGetRequest() on a hit: buildHttpResponse() and withCacheStatus()
+            std::pmr::string body = http1::buildKeyValueJson(key, value, arena);
+            std::pmr::string head(arena);
+            http1::writeResponseHead(head, 200, body.size(), {}, "application/json");
+            http1::addCacheStatus(head, true);
+            return head.size() + body.size();
+        }
+    };
+
+    /**
+     * @brief The first server version's parsing and formatting: a string
+     *        copy of the request, a stream for the request line, copies of
+     *        every part, and streams for the response. It read no headers.
+     */
+    struct Original
+    {
+        static std::string parseKeyFromQuery(const std::string &query)
+        {
+            size_t key_pos = query.find("key=");
+            if (key_pos == std::string::npos)
+                return "";
+            size_t start = key_pos + 4;
+            size_t end = query.find('&', start);
+            return end == std::string::npos ? query.substr(start) : query.substr(start, end - start);
+        }
+
+        static size_t parseRequest(std::string_view input, std::pmr::memory_resource *)
+        {
+            std::string request(input);
+            std::istringstream iss(request);
+            std::string method, path, version;
+            iss >> method >> path >> version;
+
+            std::string query;
+            size_t query_pos = path.find('?');
+            if (query_pos != std::string::npos)
+            {
+                query = path.substr(query_pos + 1);
+                path = path.substr(0, query_pos);
+            }
+
+            std::string body;
+            size_t body_pos = request.find("\r\n\r\n");
+            if (body_pos != std::string::npos)
+                body = request.substr(body_pos + 4);
+
+            std::string key = method == "GET" ? parseKeyFromQuery(query) : std::string();
+            return path.size() + key.size() + body.size();
+        }
+
+        static size_t parseKeyValue(std::string_view input, std::pmr::memory_resource *)
+        {
+            std::string body(input); // The handlers took the body as a std::string
+            std::string key, value;
+            size_t key_start = body.find("\"key\"");
+            size_t value_start = body.find("\"value\"");
+            if (key_start == std::string::npos || value_start == std::string::npos)
+                return 0;
+            size_t key_value_start = body.find('"', body.find(':', key_start) + 1) + 1;
+            key = body.substr(key_value_start, body.find('"', key_value_start) - key_value_start);
+            size_t value_value_start = body.find('"', body.find(':', value_start) + 1) + 1;
+            value = body.substr(value_value_start, body.find('"', value_value_start) - value_value_start);
+            return key.size() + value.size();
+        }
+
+        static size_t buildResponse(std::string_view key, std::string_view value, std::pmr::memory_resource *)
+        {
+            std::ostringstream json;
+            json << "{\"key\":\"" << key << "\",\"value\":\"" << value << "\"}";
+            std::string body = json.str();
+
+            std::ostringstream response;
+            response << "HTTP/1.1 " << 200 << " " << http1::statusText(200) << "\r\n";
+            response << "Content-Type: application/json\r\n";
+            response << "Content-Length: " << body.length() << "\r\n";
+            response << "Connection: close\r\n";
+            response << "\r\n";
+            response << body;
+            return response.str().size();
+        }
+    };
+
+    // Runs 'operation' once per iteration on a fresh arena, as a worker
+    // does per request, and reports the allocations it made.
+    template <class Operation>
+    void runRequests(benchmark::State &state, Operation operation)
+    {
+        std::unique_ptr<char[]> arena_buffer(new char[kArenaSize]);
+        std::pmr::monotonic_buffer_resource arena(arena_buffer.get(), kArenaSize);
+
+        uint64_t allocations = t_allocations;
+        uint64_t allocated_bytes = t_allocated_bytes;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(operation(&arena));
+            arena.release();
+        }
+        state.counters["allocs_per_req"] =
+            benchmark::Counter(t_allocations - allocations, benchmark::Counter::kAvgIterations);
+        state.counters["alloc_bytes_per_req"] =
+            benchmark::Counter(t_allocated_bytes - allocated_bytes, benchmark::Counter::kAvgIterations);
+        state.SetItemsProcessed(state.iterations());
+    }
+}
+
+template <class Parser>
+void BM_ParseRequest(benchmark::State &state)
+{
+    std::string request = makeRequest(state.range(0), state.range(1), state.range(2));
+    runRequests(state, [&](std::pmr::memory_resource *arena) { return Parser::parseRequest(request, arena); });
+    state.SetBytesProcessed(state.iterations() * request.size());
+}
+
+template <class Parser>
+void BM_ParseKeyValue(benchmark::State &state)
+{
+    std::string body = "{\"key\":\"" + std::string(kKey) + "\",\"value\":\"" + makeValue(state.range(0)) + "\"}";
+    runRequests(state, [&](std::pmr::memory_resource *arena) { return Parser::parseKeyValue(body, arena); });
+    state.SetBytesProcessed(state.iterations() * body.size());
+}
+
+template <class Builder>
+void BM_BuildResponse(benchmark::State &state)
+{
+    std::string value = makeValue(state.range(0));
+    runRequests(state, [&](std::pmr::memory_resource *arena) { return Builder::buildResponse(kKey, value, arena); });
+    state.SetBytesProcessed(state.iterations() * value.size());
+}
+
+// Header count x query length x body size (0: GET, otherwise POST)
+#define PARSE_REQUEST_BENCHMARK(Parser)                                                                     \
+    BENCHMARK_TEMPLATE(BM_ParseRequest, Parser)                                                             \
+        ->ArgNames({"headers", "query", "body"})                                                            \
+        ->ArgsProduct({{2, 8, 32}, {16, 256}, {0, 1024, 65536}})
+
+// Value size
+#define VALUE_BENCHMARK(name, Implementation)                                                               \
+    BENCHMARK_TEMPLATE(name, Implementation)->ArgName("value")->Arg(16)->Arg(1024)->Arg(65536)
+
+PARSE_REQUEST_BENCHMARK(Http1);
+PARSE_REQUEST_BENCHMARK(Original);
+VALUE_BENCHMARK(BM_ParseKeyValue, Http1);
+VALUE_BENCHMARK(BM_ParseKeyValue, Original);
+VALUE_BENCHMARK(BM_BuildResponse, Http1);
+VALUE_BENCHMARK(BM_BuildResponse, Original);
+
+BENCHMARK_MAIN();
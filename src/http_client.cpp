@@ -0,0 +1,314 @@
+#include "http_client.hpp" // HttpClient class definition
+#include <algorithm>       // For std::equal
+#include <cctype>          // For std::tolower
+#include <cerrno>          // For EINTR, EAGAIN
+#include <charconv>        // For std::from_chars
+#include <cstring>         // For memset, memcpy
+#include <netinet/in.h>    // For sockaddr_in
+#include <netinet/tcp.h>   // For TCP_NODELAY
+#include <arpa/inet.h>     // For inet_pton, htons
+#include <sys/socket.h>    // For socket, connect, send, recv
+#include <sys/time.h>      // For timeval
+#include <sys/un.h>        // For sockaddr_un
+#include <unistd.h>        // For close
+
+namespace
+{
+    // Value of a header in a response head ("" if absent); 'name' is lower-case.
+    std::string_view findHeader(std::string_view head, std::string_view name)
+    {
+        size_t pos = head.find("\r\n");
+        while (pos != std::string_view::npos && pos + 2 < head.size())
+        {
+            pos += 2;
+            size_t eol = head.find("\r\n", pos);
+            std::string_view line = head.substr(pos, eol == std::string_view::npos ? std::string_view::npos : eol - pos);
+            if (line.size() > name.size() && line[name.size()] == ':' &&
+                std::equal(name.begin(), name.end(), line.begin(),
+                           [](char a, char b) { return a == std::tolower(static_cast<unsigned char>(b)); }))
+            {
+                std::string_view value = line.substr(name.size() + 1);
+                while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+                    value.remove_prefix(1);
+                while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+                    value.remove_suffix(1);
+                return value;
+            }
+            pos = eol;
+        }
+        return {};
+    }
+
+    // Bytes asked of each recv()
+    constexpr size_t kReadSize = 16 * 1024;
+
+    bool equalsIgnoreCase(std::string_view value, std::string_view lower)
+    {
+        return value.size() == lower.size() &&
+               std::equal(value.begin(), value.end(), lower.begin(),
+                          [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == b; });
+    }
+}
+
+HttpClient::~HttpClient()
+{
+    close();
+}
+
+bool HttpClient::connect(const std::string &host, int port, int timeout_ms)
+{
+    if (!open(host, port, false))
+        return false;
+
+    struct timeval timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    return true;
+}
+
+bool HttpClient::connectNonBlocking(const std::string &host, int port)
+{
+    return open(host, port, true);
+}
+
+bool HttpClient::finishConnect()
+{
+    connecting = false;
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool HttpClient::open(const std::string &host, int port, bool non_blocking)
+{
+    close();
+    int type = SOCK_STREAM | (non_blocking ? SOCK_NONBLOCK : 0);
+
+    if (host.compare(0, kUnixPrefix.size(), kUnixPrefix) == 0)
+    {
+        // Co-located server: skips the TCP/IP loopback stack entirely.
+        std::string path = host.substr(kUnixPrefix.size());
+        struct sockaddr_un server_addr;
+        memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(server_addr.sun_path))
+            return false;
+        memcpy(server_addr.sun_path, path.c_str(), path.size() + 1);
+
+        // A Unix domain socket connects at once or not at all (EAGAIN: backlog full).
+        sock = socket(AF_UNIX, type, 0);
+        if (sock < 0)
+            return false;
+        if (::connect(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
+        {
+            close();
+            return false;
+        }
+    }
+    else
+    {
+        struct sockaddr_in server_addr;
+        memset(&server_addr, 0, sizeof(server_addr));
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_port = htons(port);
+        if (inet_pton(AF_INET, host == "localhost" ? "127.0.0.1" : host.c_str(), &server_addr.sin_addr) != 1)
+            return false;
+
+        sock = socket(AF_INET, type, 0);
+        if (sock < 0)
+            return false;
+        if (::connect(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
+        {
+            if (!non_blocking || errno != EINPROGRESS)
+            {
+                close();
+                return false;
+            }
+            connecting = true;
+        }
+
+        // Requests are small and latency-sensitive: don't let Nagle hold them back.
+        int nodelay = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    }
+    return true;
+}
+
+void HttpClient::close()
+{
+    if (sock >= 0)
+        ::close(sock);
+    sock = -1;
+    connecting = false;
+    output.clear();
+    output_offset = 0;
+    input.clear();
+    input_offset = 0;
+    at_eof = false;
+}
+
+bool HttpClient::flush()
+{
+    while (output_offset < output.size())
+    {
+        ssize_t n = send(sock, output.data() + output_offset, output.size() - output_offset, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        output_offset += n;
+    }
+    output.clear();
+    output_offset = 0;
+    return true;
+}
+
+bool HttpClient::flushAvailable()
+{
+    while (output_offset < output.size())
+    {
+        ssize_t n = send(sock, output.data() + output_offset, output.size() - output_offset,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return true; // Socket buffer full: the rest goes out on EPOLLOUT
+        if (n <= 0)
+            return false;
+        output_offset += n;
+    }
+    output.clear();
+    output_offset = 0;
+    return true;
+}
+
+bool HttpClient::receive(Response &response)
+{
+    while (true)
+    {
+        ParseResult result = nextResponse(response);
+        if (result != ParseResult::Incomplete)
+            return result == ParseResult::Complete;
+        if (at_eof)
+            return false;
+        // At end of stream, parse once more: a body without a length is now complete.
+        if (fill(0) < 0)
+            return false;
+    }
+}
+
+bool HttpClient::readAvailable()
+{
+    while (true)
+    {
+        ssize_t n = fill(MSG_DONTWAIT);
+        if (n > 0)
+        {
+            // A short read emptied the socket: save the recv() that would say so.
+            if (static_cast<size_t>(n) < kReadSize)
+                return true;
+            continue;
+        }
+        if (n == 0)
+            return false;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+HttpClient::ParseResult HttpClient::nextResponse(Response &response)
+{
+    while (true)
+    {
+        size_t header_end = input.find("\r\n\r\n", input_offset);
+        if (header_end == std::string::npos)
+            return ParseResult::Incomplete;
+
+        std::string_view head(input.data() + input_offset, header_end - input_offset);
+        int status = 0;
+        if (head.size() < 12 || head.compare(0, 7, "HTTP/1.") != 0 ||
+            std::from_chars(head.data() + 9, head.data() + 12, status).ec != std::errc())
+            return ParseResult::Malformed;
+        size_t body_start = header_end + 4;
+
+        // Interim responses (100 Continue) precede the real one.
+        if (status >= 100 && status < 200)
+        {
+            input_offset = body_start;
+            continue;
+        }
+
+        bool close_after = false;
+        std::string_view connection = findHeader(head, "connection");
+        if (equalsIgnoreCase(connection, "close"))
+            close_after = true;
+        else if (head.compare(0, 8, "HTTP/1.0") == 0 && !equalsIgnoreCase(connection, "keep-alive"))
+            close_after = true;
+
+        size_t content_length = 0;
+        std::string_view length = findHeader(head, "content-length");
+        if (!length.empty())
+        {
+            if (std::from_chars(length.data(), length.data() + length.size(), content_length).ec != std::errc())
+                return ParseResult::Malformed;
+        }
+        else if (status != 204 && status != 304)
+        {
+            // No length: the body runs until the server closes the connection.
+            if (!at_eof)
+                return ParseResult::Incomplete;
+            content_length = input.size() - body_start;
+            close_after = true;
+        }
+
+        if (input.size() - body_start < content_length)
+            return ParseResult::Incomplete;
+
+        response.status = status;
+        response.body.assign(input, body_start, content_length);
+        response.close = close_after;
+        std::string_view cache = findHeader(head, "x-cache");
+        if (equalsIgnoreCase(cache, "hit"))
+            response.cache = CacheStatus::Hit;
+        else if (equalsIgnoreCase(cache, "miss"))
+            response.cache = CacheStatus::Miss;
+        else
+            response.cache = CacheStatus::Unknown;
+        input_offset = body_start + content_length;
+        if (input_offset == input.size())
+        {
+            input.clear();
+            input_offset = 0;
+        }
+        return ParseResult::Complete;
+    }
+}
+
+ssize_t HttpClient::fill(int flags)
+{
+    // Compact before reading so the buffer doesn't grow without bound.
+    if (input_offset > 0)
+    {
+        input.erase(0, input_offset);
+        input_offset = 0;
+    }
+
+    char buffer[kReadSize];
+    while (true)
+    {
+        ssize_t n = recv(sock, buffer, sizeof(buffer), flags);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n == 0)
+            at_eof = true;
+        if (n > 0)
+            input.append(buffer, n);
+        return n;
+    }
+}
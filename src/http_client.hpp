@@ -0,0 +1,152 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+
+/**
+ * @brief Keep-alive HTTP/1.1 client for load generation.
+ *
+ * Holds one persistent connection. Complete requests are queued with
+ * queue() and written by flush(), so a caller can pipeline several on the
+ * connection; receive() returns the responses in request order, framed by
+ * their Content-Length (or, without one, by the server closing the
+ * connection). Once a response says "Connection: close", or a call fails,
+ * the caller closes the client and reconnects.
+ *
+ * Event loops use the non-blocking calls instead: connectNonBlocking() and
+ * finishConnect() open the connection, flushAvailable() and readAvailable()
+ * move what the socket accepts or holds, and nextResponse() takes complete
+ * responses from the buffer.
+ *
+ * Not thread-safe: use one client per thread.
+ */
+class HttpClient
+{
+public:
+    // Host prefix selecting the server's Unix domain socket, e.g. "unix:/tmp/kv.sock".
+    static constexpr std::string_view kUnixPrefix = "unix:";
+
+    // Whether the server's cache answered a GET, from its X-Cache header.
+    enum class CacheStatus
+    {
+        Unknown, // No X-Cache header (not a cached request)
+        Hit,
+        Miss
+    };
+
+    struct Response
+    {
+        int status = 0;
+        std::string body;
+        bool close = false; // The server closes the connection after this response
+        CacheStatus cache = CacheStatus::Unknown;
+    };
+
+    HttpClient() = default;
+    ~HttpClient();
+    HttpClient(const HttpClient &) = delete;
+    HttpClient &operator=(const HttpClient &) = delete;
+
+    /**
+     * @brief Connects to the server: an IPv4 address, "localhost", or
+     *        "unix:<path>" (then 'port' is ignored).
+     * @param timeout_ms Send and receive timeout; a stalled server fails
+     *        the call instead of blocking the caller forever.
+     * @return false if the connection failed.
+     */
+    bool connect(const std::string &host, int port, int timeout_ms = 5000);
+
+    /**
+     * @brief Starts connecting without blocking, for event loops. Until
+     *        isConnecting() is false the socket is not usable: wait for it to
+     *        become writable, then call finishConnect().
+     * @return false if the connection failed at once.
+     */
+    bool connectNonBlocking(const std::string &host, int port);
+
+    /**
+     * @brief Completes a non-blocking connect once the socket is writable.
+     * @return false (and closes the client) if the connection failed.
+     */
+    bool finishConnect();
+
+    /**
+     * @brief Closes the connection; queued and outstanding requests are dropped.
+     */
+    void close();
+
+    // True from connect() on, and during a non-blocking connect.
+    bool isConnected() const { return sock >= 0; }
+
+    bool isConnecting() const { return connecting; }
+
+    // The socket, for registering with epoll.
+    int descriptor() const { return sock; }
+
+    /**
+     * @brief Queues a complete request (request line, headers and body).
+     */
+    void queue(std::string_view request) { output.append(request); }
+
+    /**
+     * @brief Writes all queued requests to the socket.
+     * @return false if the connection failed.
+     */
+    bool flush();
+
+    /**
+     * @brief Blocks until the next response has been received in full.
+     * @return false if the connection failed or the response was malformed.
+     */
+    bool receive(Response &response);
+
+    /**
+     * @brief Writes as much of the queued requests as the socket accepts, without blocking.
+     * @return false if the connection failed.
+     */
+    bool flushAvailable();
+
+    /**
+     * @brief True if queued requests are waiting for the socket to accept them.
+     */
+    bool hasOutput() const { return output_offset < output.size(); }
+
+    /**
+     * @brief Reads whatever has arrived, without blocking. Stops after a
+     *        short read, so a server close right behind the data may only be
+     *        seen on the next call (level-triggered epoll reports it again).
+     * @return false if the connection failed or the server closed it; the
+     *         responses received before that can still be taken.
+     */
+    bool readAvailable();
+
+    enum class ParseResult
+    {
+        Complete,
+        Incomplete,
+        Malformed
+    };
+
+    /**
+     * @brief Takes the next response from the received bytes, if it is complete.
+     */
+    ParseResult nextResponse(Response &response);
+
+private:
+    // Creates the socket and connects it; with 'non_blocking', a TCP
+    // connection may still be in progress on return ('connecting').
+    bool open(const std::string &host, int port, bool non_blocking);
+
+    // Reads more input: > 0 bytes read, 0 at end of stream (sets 'at_eof'),
+    // < 0 on error, timeout or (with MSG_DONTWAIT) no input.
+    ssize_t fill(int flags);
+
+    int sock = -1;
+    bool connecting = false; // Non-blocking connect in progress
+    std::string output; // Queued requests not yet flushed
+    size_t output_offset = 0;
+    std::string input;  // Received bytes not yet parsed
+    size_t input_offset = 0;
+    bool at_eof = false; // The server closed the connection
+};
@@ -0,0 +1,192 @@
+#include "key_distribution.hpp" // KeyDistribution class definition
+#include "fnv_hash.hpp"         // fnv::hash
+#include <algorithm>            // For std::min, std::max
+#include <cmath>                // For std::pow
+#include <sstream>              // For std::istringstream, std::ostringstream
+#include <vector>               // For the specification fields
+
+namespace
+{
+    // Keys up to this are summed term by term into the Zipfian constant.
+    constexpr uint64_t kExactZetaTerms = 1000000;
+
+    // Sum of 1 / i^theta for i = 1 .. n. Beyond kExactZetaTerms the terms are
+    // smooth enough for the integral of x^-theta (midpoint rule) to match the
+    // sum to well within the precision that matters here.
+    double zeta(uint64_t n, double theta)
+    {
+        uint64_t exact = std::min(n, kExactZetaTerms);
+        double sum = 0;
+        for (uint64_t i = 1; i <= exact; i++)
+            sum += 1.0 / std::pow(static_cast<double>(i), theta);
+        if (n > exact)
+        {
+            double from = exact + 0.5, to = n + 0.5;
+            sum += (std::pow(to, 1 - theta) - std::pow(from, 1 - theta)) / (1 - theta);
+        }
+        return sum;
+    }
+
+    bool parseFraction(const std::string &field, double &value)
+    {
+        std::istringstream in(field);
+        return (in >> value) && in.eof();
+    }
+}
+
+std::unique_ptr<KeyDistribution> KeyDistribution::parse(const std::string &spec, uint64_t key_count,
+                                                        std::string &error)
+{
+    std::vector<std::string> fields;
+    std::istringstream in(spec);
+    std::string field;
+    while (std::getline(in, field, ':'))
+        fields.push_back(field);
+    if (fields.empty())
+    {
+        error = "empty key distribution";
+        return nullptr;
+    }
+    if (key_count == 0)
+    {
+        error = "the key space is empty";
+        return nullptr;
+    }
+
+    const std::string &name = fields[0];
+    double theta = 0.99, hot_ops = 0.9, hot_keys = 0.1;
+    Type type;
+    size_t max_fields = 1;
+    if (name == "uniform")
+        type = Type::Uniform;
+    else if (name == "zipfian" || name == "scrambled" || name == "latest")
+    {
+        type = name == "zipfian" ? Type::Zipfian : (name == "scrambled" ? Type::ScrambledZipfian : Type::Latest);
+        max_fields = 2;
+        if (fields.size() > 1 && (!parseFraction(fields[1], theta) || theta <= 0 || theta >= 1))
+        {
+            error = "theta must be between 0 and 1 (exclusive): " + spec;
+            return nullptr;
+        }
+    }
+    else if (name == "hotspot")
+    {
+        type = Type::Hotspot;
+        max_fields = 3;
+        if ((fields.size() > 1 && (!parseFraction(fields[1], hot_ops) || hot_ops < 0 || hot_ops > 1)) ||
+            (fields.size() > 2 && (!parseFraction(fields[2], hot_keys) || hot_keys <= 0 || hot_keys > 1)))
+        {
+            error = "hotspot fractions must be between 0 and 1: " + spec;
+            return nullptr;
+        }
+    }
+    else if (name == "sequential")
+        type = Type::Sequential;
+    else
+    {
+        error = "unknown key distribution: " + name;
+        return nullptr;
+    }
+    if (fields.size() > max_fields)
+    {
+        error = "too many parameters: " + spec;
+        return nullptr;
+    }
+
+    return std::unique_ptr<KeyDistribution>(new KeyDistribution(type, key_count, theta, hot_ops, hot_keys));
+}
+
+KeyDistribution::KeyDistribution(Type type, uint64_t key_count, double theta, double hot_ops, double hot_keys)
+    : type(type), key_count(key_count), theta(theta), hot_ops(hot_ops), hot_keys(hot_keys)
+{
+    if (type == Type::Zipfian || type == Type::ScrambledZipfian || type == Type::Latest)
+    {
+        zeta_n = zeta(key_count, theta);
+        alpha = 1 / (1 - theta);
+        half_pow_theta = std::pow(0.5, theta);
+        // With two keys or fewer, nextZipfian() never gets to the formula eta is for.
+        if (key_count > 2)
+            eta = (1 - std::pow(2.0 / key_count, 1 - theta)) / (1 - (1 + half_pow_theta) / zeta_n);
+    }
+    if (type == Type::Hotspot)
+        hot_count = std::min(key_count, std::max<uint64_t>(1, static_cast<uint64_t>(key_count * hot_keys)));
+    if (type == Type::Latest)
+        position = key_count - 1; // As if the whole key space had just been written in order
+}
+
+uint64_t KeyDistribution::nextZipfian(std::mt19937 &gen) const
+{
+    double u = std::uniform_real_distribution<double>(0, 1)(gen);
+    double uz = u * zeta_n;
+    if (uz < 1)
+        return 0;
+    if (uz < 1 + half_pow_theta)
+        return 1;
+    uint64_t rank = static_cast<uint64_t>(key_count * std::pow(eta * u - eta + 1, alpha));
+    return std::min(rank, key_count - 1);
+}
+
+uint64_t KeyDistribution::next(std::mt19937 &gen)
+{
+    switch (type)
+    {
+    case Type::Uniform:
+        return std::uniform_int_distribution<uint64_t>(0, key_count - 1)(gen);
+    case Type::Zipfian:
+        return nextZipfian(gen);
+    case Type::ScrambledZipfian:
+        // Hashing the rank's bytes scatters the hot keys over the key space.
+        return fnv::hash(nextZipfian(gen)) % key_count;
+    case Type::Hotspot:
+    {
+        bool hot = hot_count == key_count || std::uniform_real_distribution<double>(0, 1)(gen) < hot_ops;
+        if (hot)
+            return std::uniform_int_distribution<uint64_t>(0, hot_count - 1)(gen);
+        return std::uniform_int_distribution<uint64_t>(hot_count, key_count - 1)(gen);
+    }
+    case Type::Latest:
+    {
+        // Ranks count back from the latest write, wrapping around the key space.
+        uint64_t latest = position.load(std::memory_order_relaxed) % key_count;
+        uint64_t rank = nextZipfian(gen);
+        return (latest + key_count - rank) % key_count;
+    }
+    case Type::Sequential:
+    default:
+        return position.fetch_add(1, std::memory_order_relaxed) % key_count;
+    }
+}
+
+uint64_t KeyDistribution::nextWrite(std::mt19937 &gen)
+{
+    if (type == Type::Latest)
+        return (position.fetch_add(1, std::memory_order_relaxed) + 1) % key_count;
+    return next(gen);
+}
+
+std::string KeyDistribution::describe() const
+{
+    std::ostringstream out;
+    switch (type)
+    {
+    case Type::Uniform:
+        out << "uniform";
+        break;
+    case Type::Zipfian:
+        out << "zipfian:" << theta;
+        break;
+    case Type::ScrambledZipfian:
+        out << "scrambled:" << theta;
+        break;
+    case Type::Hotspot:
+        out << "hotspot:" << hot_ops << ":" << hot_keys;
+        break;
+    case Type::Latest:
+        out << "latest:" << theta;
+        break;
+    case Type::Sequential:
+        out << "sequential";
+        break;
+    }
+    return out.str();
+}
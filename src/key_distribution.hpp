@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+
+/**
+ * @brief Chooses which key (0 to key_count - 1) a load-generator request uses.
+ *
+ * Distributions, as specified on the command line:
+ *  - uniform: every key equally likely.
+ *  - zipfian[:theta]: key i (from 0) has probability proportional to
+ *    1 / (i + 1)^theta, 0 < theta < 1 (default 0.99); low keys are hot.
+ *  - scrambled[:theta]: Zipfian popularity, but the hot keys are spread
+ *    over the key space by a hash instead of being the lowest ones.
+ *  - hotspot[:ops:keys]: a fraction 'ops' of requests (default 0.9) go to
+ *    the first 'keys' fraction of the key space (default 0.1), uniformly;
+ *    the rest go to the other keys.
+ *  - latest[:theta]: writes go to the key after the last one written, and
+ *    reads are Zipfian by recency: the latest key is the most likely.
+ *  - sequential: keys in order, wrapping around (a scan), shared by all threads.
+ *
+ * Zipfian sampling uses the rejection-free method of Gray et al. ("Quickly
+ * generating billion-record synthetic databases"): one random number and a
+ * pow() per key, and only the normalisation constant is computed up front
+ * (exactly for the first million keys, by an integral beyond), so nothing
+ * scales with the key space.
+ *
+ * One instance is shared by all threads; each passes its own random engine.
+ */
+class KeyDistribution
+{
+public:
+    /**
+     * @brief Builds a distribution from its specification (see above).
+     * @return nullptr, with 'error' set, if the specification is invalid.
+     */
+    static std::unique_ptr<KeyDistribution> parse(const std::string &spec, uint64_t key_count, std::string &error);
+
+    // Key for a read (or delete).
+    uint64_t next(std::mt19937 &gen);
+
+    // Key for a write; differs from next() only for "latest".
+    uint64_t nextWrite(std::mt19937 &gen);
+
+    // Specification with every parameter spelled out, for reports.
+    std::string describe() const;
+
+private:
+    enum class Type
+    {
+        Uniform,
+        Zipfian,
+        ScrambledZipfian,
+        Hotspot,
+        Latest,
+        Sequential
+    };
+
+    KeyDistribution(Type type, uint64_t key_count, double theta, double hot_ops, double hot_keys);
+
+    // Zipfian rank, 0 (most popular) to key_count - 1.
+    uint64_t nextZipfian(std::mt19937 &gen) const;
+
+    Type type;
+    uint64_t key_count;
+
+    // Zipfian parameters
+    double theta;
+    double zeta_n = 0; // Sum of 1 / i^theta for i = 1 .. key_count
+    double alpha = 0;
+    double eta = 0;
+    double half_pow_theta = 0;
+
+    // Hotspot parameters
+    double hot_ops;
+    double hot_keys;
+    uint64_t hot_count = 0;
+
+    // Last key written (latest) or next key (sequential), shared by all threads
+    std::atomic<uint64_t> position{0};
+};
@@ -0,0 +1,99 @@
+#include "large_value.hpp" // Declarations of the large-value helpers
+#include <atomic>            // For global statistics counters
+#include <cerrno>            // For EINTR
+#include <fcntl.h>           // For F_ADD_SEALS
+#include <sys/mman.h>        // For memfd_create
+#include <sys/sendfile.h>    // For sendfile
+#include <unistd.h>          // For write, pread, close
+
+namespace large_value
+{
+    namespace
+    {
+        std::atomic<uint64_t> g_files_created{0};
+        std::atomic<uint64_t> g_sendfile_bytes{0};
+        std::atomic<uint64_t> g_read_bytes{0};
+    }
+
+    int store(std::string_view value)
+    {
+        int fd = create();
+        if (fd < 0)
+            return -1;
+        if (!append(fd, value))
+        {
+            close(fd);
+            return -1;
+        }
+        seal(fd);
+        return fd;
+    }
+
+    int create()
+    {
+        int fd = memfd_create("kv-value", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (fd >= 0)
+            g_files_created.fetch_add(1, std::memory_order_relaxed);
+        return fd;
+    }
+
+    bool append(int fd, std::string_view data)
+    {
+        while (!data.empty())
+        {
+            ssize_t n = write(fd, data.data(), data.size());
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            data.remove_prefix(n);
+        }
+        return true;
+    }
+
+    void seal(int fd)
+    {
+        // Freeze size and contents so concurrent readers never see a change.
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+    }
+
+    bool read(int fd, char *out, size_t size)
+    {
+        // pread() keeps no file offset, so threads can share the descriptor.
+        size_t done = 0;
+        while (done < size)
+        {
+            ssize_t n = pread(fd, out + done, size - done, static_cast<off_t>(done));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            done += n;
+        }
+        g_read_bytes.fetch_add(size, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool send(int socket, int fd, size_t size)
+    {
+        // The explicit offset leaves the descriptor's own file position untouched.
+        off_t offset = 0;
+        while (static_cast<size_t>(offset) < size)
+        {
+            ssize_t n = sendfile(socket, fd, &offset, size - offset);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+        }
+        g_sendfile_bytes.fetch_add(size, std::memory_order_relaxed);
+        return true;
+    }
+
+    Stats stats()
+    {
+        return {g_files_created.load(std::memory_order_relaxed),
+                g_sendfile_bytes.load(std::memory_order_relaxed),
+                g_read_bytes.load(std::memory_order_relaxed)};
+    }
+}
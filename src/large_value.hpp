@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief File-backed storage for very large cache values.
+ *
+ * Values above a configurable size are kept out of the slab heap in a sealed
+ * anonymous memory file (memfd). The kernel owns those pages, so they are not
+ * part of the server's heap or RSS, and a response can hand them straight to
+ * the socket with sendfile() instead of copying multi-megabyte strings through
+ * user space.
+ *
+ * Files are sealed after they are written, so they are immutable: any number
+ * of threads may read or send one concurrently, each through its own dup()'d
+ * descriptor, while the cache is free to drop its own reference.
+ */
+namespace large_value
+{
+    /**
+     * @brief Snapshot of large-value activity, reported by /stats.
+     */
+    struct Stats
+    {
+        uint64_t files_created;  // Values stored in memfds since start
+        uint64_t sendfile_bytes; // Bytes sent to clients with sendfile()
+        uint64_t read_bytes;     // Bytes copied back out with pread()
+    };
+
+    /**
+     * @brief Copies 'value' into a new sealed memfd.
+     * @return The file descriptor, or -1 if memfds are unavailable.
+     */
+    int store(std::string_view value);
+
+    /**
+     * @brief Creates an empty, writable memfd for a value built piece by piece.
+     *
+     * Fill it with append() and call seal() before handing it to the cache.
+     * @return The file descriptor, or -1 if memfds are unavailable.
+     */
+    int create();
+
+    /**
+     * @brief Appends 'data' to a memfd from create().
+     * @return false on I/O error.
+     */
+    bool append(int fd, std::string_view data);
+
+    /**
+     * @brief Makes a memfd from create() immutable.
+     */
+    void seal(int fd);
+
+    /**
+     * @brief Reads the first 'size' bytes of 'fd' into 'out'.
+     * @return false on a short read or I/O error.
+     */
+    bool read(int fd, char *out, size_t size);
+
+    /**
+     * @brief Sends the first 'size' bytes of 'fd' to 'socket' with sendfile().
+     * @return false if the connection failed.
+     */
+    bool send(int socket, int fd, size_t size);
+
+    /**
+     * @brief Returns the accumulated statistics.
+     */
+    Stats stats();
+}
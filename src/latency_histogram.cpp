@@ -0,0 +1,109 @@
+#include "latency_histogram.hpp" // LatencyHistogram class definition
+#include <algorithm>             // For std::min, std::max
+#include <cmath>                 // For std::ceil, std::log2, std::pow
+
+LatencyHistogram::LatencyHistogram(uint64_t highest_value, int significant_digits)
+{
+    significant_digits = std::min(std::max(significant_digits, 1), 5);
+    highest_trackable = std::max<uint64_t>(highest_value, 2);
+
+    // Values below this are counted exactly; above it, buckets keep the
+    // same number of sub-buckets while doubling in width.
+    double single_unit_resolution = 2 * std::pow(10.0, significant_digits);
+    int sub_bucket_count_magnitude = static_cast<int>(std::ceil(std::log2(single_unit_resolution)));
+    sub_bucket_half_count_magnitude = std::max(sub_bucket_count_magnitude, 1) - 1;
+    uint64_t sub_bucket_count = uint64_t(1) << (sub_bucket_half_count_magnitude + 1);
+    sub_bucket_half_count = sub_bucket_count / 2;
+    sub_bucket_mask = sub_bucket_count - 1;
+
+    size_t bucket_count = 1;
+    uint64_t smallest_untrackable = sub_bucket_count;
+    while (smallest_untrackable <= highest_trackable)
+    {
+        if (smallest_untrackable > UINT64_MAX / 2)
+        {
+            bucket_count++;
+            break;
+        }
+        smallest_untrackable <<= 1;
+        bucket_count++;
+    }
+    counts_length = (bucket_count + 1) * sub_bucket_half_count;
+}
+
+size_t LatencyHistogram::countsIndex(uint64_t value) const
+{
+    // The bucket is given by the value's highest set bit (at least the first
+    // bucket's), the sub-bucket by the bits below it.
+    int pow2_ceiling = 64 - __builtin_clzll(value | sub_bucket_mask);
+    int bucket_index = pow2_ceiling - (sub_bucket_half_count_magnitude + 1);
+    uint64_t sub_bucket_index = value >> bucket_index;
+    return (static_cast<size_t>(bucket_index + 1) << sub_bucket_half_count_magnitude) +
+           (sub_bucket_index - sub_bucket_half_count);
+}
+
+uint64_t LatencyHistogram::valueAtIndex(size_t index) const
+{
+    int bucket_index = static_cast<int>(index >> sub_bucket_half_count_magnitude) - 1;
+    uint64_t sub_bucket_index = (index & (sub_bucket_half_count - 1)) + sub_bucket_half_count;
+    if (bucket_index < 0)
+    {
+        sub_bucket_index -= sub_bucket_half_count;
+        bucket_index = 0;
+    }
+    // Highest value counted at this index: its sub-bucket is 2^bucket_index wide.
+    return (sub_bucket_index << bucket_index) + ((uint64_t(1) << bucket_index) - 1);
+}
+
+void LatencyHistogram::record(uint64_t value)
+{
+    if (counts.empty())
+        counts.assign(counts_length, 0);
+    value = std::min(value, highest_trackable);
+    counts[countsIndex(value)]++;
+    total_count++;
+    sum += value;
+    min_value = std::min(min_value, value);
+    max_value = std::max(max_value, value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    if (other.empty())
+        return;
+    if (counts.empty())
+        counts.assign(counts_length, 0);
+    for (size_t i = 0; i < counts_length && i < other.counts.size(); i++)
+        counts[i] += other.counts[i];
+    total_count += other.total_count;
+    sum += other.sum;
+    min_value = std::min(min_value, other.min_value);
+    max_value = std::max(max_value, other.max_value);
+}
+
+void LatencyHistogram::reset()
+{
+    std::fill(counts.begin(), counts.end(), 0);
+    total_count = 0;
+    sum = 0;
+    min_value = UINT64_MAX;
+    max_value = 0;
+}
+
+uint64_t LatencyHistogram::valueAtPercentile(double percentile) const
+{
+    if (total_count == 0)
+        return 0;
+    percentile = std::min(std::max(percentile, 0.0), 100.0);
+    uint64_t target = static_cast<uint64_t>(percentile / 100.0 * total_count + 0.5);
+    target = std::max<uint64_t>(target, 1);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); i++)
+    {
+        seen += counts[i];
+        if (seen >= target)
+            return std::min(valueAtIndex(i), max_value);
+    }
+    return max_value;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief High dynamic range (HDR) histogram of latencies.
+ *
+ * Records values (nanoseconds) from 1 up to 'highest_value' with a fixed
+ * relative precision: with 3 significant digits, any recorded value is
+ * reported within 0.1% of itself, from 1 ns to minutes. Buckets double in
+ * width, and each is split into the same number of linear sub-buckets, so
+ * recording is a couple of shifts and an increment, and percentiles are
+ * exact up to that precision instead of averaged away.
+ *
+ * Counts are allocated on the first record() or merge(): a histogram that
+ * stays empty costs nothing. Not thread-safe; keep one per thread and
+ * merge() them at the end.
+ */
+class LatencyHistogram
+{
+public:
+    // One hour, in nanoseconds.
+    static constexpr uint64_t kDefaultHighestValue = 3600ULL * 1000 * 1000 * 1000;
+
+    /**
+     * @param highest_value Largest value tracked; larger ones are recorded as it.
+     * @param significant_digits Precision, 1 to 5.
+     */
+    explicit LatencyHistogram(uint64_t highest_value = kDefaultHighestValue, int significant_digits = 3);
+
+    void record(uint64_t value);
+
+    /**
+     * @brief Adds the counts of a histogram created with the same parameters.
+     */
+    void merge(const LatencyHistogram &other);
+
+    void reset();
+
+    bool empty() const { return total_count == 0; }
+    uint64_t count() const { return total_count; }
+    uint64_t min() const { return total_count ? min_value : 0; }
+    uint64_t max() const { return max_value; }
+    double mean() const { return total_count ? static_cast<double>(sum) / total_count : 0; }
+
+    /**
+     * @brief Smallest value that 'percentile' percent (0 to 100) of the recorded values don't exceed.
+     *
+     * Reported as the highest value equivalent to it at the histogram's
+     * precision (never above max()).
+     */
+    uint64_t valueAtPercentile(double percentile) const;
+
+private:
+    size_t countsIndex(uint64_t value) const;
+    uint64_t valueAtIndex(size_t index) const;
+
+    uint64_t highest_trackable;
+    int sub_bucket_half_count_magnitude;
+    uint64_t sub_bucket_half_count;
+    uint64_t sub_bucket_mask;
+    size_t counts_length;
+
+    std::vector<uint64_t> counts; // Empty until the first value
+    uint64_t total_count = 0;
+    uint64_t sum = 0;
+    uint64_t min_value = UINT64_MAX;
+    uint64_t max_value = 0;
+};
@@ -5,11 +5,23 @@
 #include <chrono>
 #include <random>
 #include <sstream>
-#include <cstring>
+#include <deque>
+#include <algorithm>
+#include <unordered_map>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
 #include <unistd.h>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/timerfd.h>
+#include "binary_client.hpp"
+#include "consistency_checker.hpp"
+#include "http_client.hpp"
+#include "key_distribution.hpp"
+#include "latency_histogram.hpp"
+#include "request_trace.hpp"
+#include "value_generator.hpp"
 
 /**
  * @brief Multi-threaded load generator for KV Server
@@ -21,7 +33,43 @@
  *  - PUT_ALL: All requests are POST (insert/update operations)
  *  - GET_ALL: All requests are GET (read operations)
  *  - GET_POPULAR: Repeated reads on a small set of keys (tests cache)
- *  - MIXED: Random mix of GET, PUT, and DELETE operations
+ *  - MIXED: Random mix of GET, PUT, and DELETE operations (--mix sets the ratio)
+ *  - REPLAY: The requests of a server trace (--trace), at their recorded times
+ *
+ * Keys are chosen from the key space by a KeyDistribution (--keys): uniform
+ * by default, or Zipfian, scrambled Zipfian, hotspot, latest or sequential
+ * to model production skew. GET_POPULAR always uses its ten popular keys.
+ * Values are short strings unless --value-size gives a size distribution;
+ * then they are slices of a pre-generated PayloadPool, sent over HTTP as
+ * raw bodies of the /api/kv/<key> routes.
+ *
+ * Every simulated client is one persistent connection, reconnecting when it
+ * fails or the server closes it, that may keep several requests in flight:
+ * pipelined HTTP/1.1 (via TCP or the server's Unix domain socket), or the
+ * binary protocol. An HTTP thread drives any number of them from one epoll
+ * loop (--connections, see httpClientThread()), so the number of simulated
+ * clients doesn't depend on the number of threads; a binary-protocol thread
+ * holds one.
+ *
+ * By default each connection sends its next request when a response
+ * arrives (closed loop). With a target rate, HTTP requests are sent on a
+ * schedule instead (open loop), which is what tail latencies should be
+ * measured with.
+ *
+ * Latencies are recorded in nanoseconds into HDR histograms, one per thread
+ * and kind of request (GET hit/miss, PUT, DELETE), and merged at the end
+ * into percentiles and a per-second time series; --results writes them as
+ * JSON and CSV.
+ *
+ * A scenario file (--scenario) runs several phases one after the other,
+ * each with its own workload, rate (or ramp), key distribution, mix and
+ * value sizes, and reports each one: a preload, an unmeasured warm-up, a
+ * ramp to peak, a spike and a cool-down in a single run.
+ *
+ * With --verify, every PUT writes a value tagged with its key and a
+ * version, and a ConsistencyChecker validates each GET against the history
+ * of writes: stale, lost, future or foreign values are reported as
+ * anomalies, and the exit status is 2 if there were any.
  */
 
 enum WorkloadType
@@ -29,16 +77,58 @@ enum WorkloadType
     PUT_ALL,     // Only PUT operations
     GET_ALL,     // Only GET operations
     GET_POPULAR, // Frequent reads on small key subset
-    MIXED        // Combination of GET, PUT, and DELETE
+    MIXED,       // Combination of GET, PUT, and DELETE
+    REPLAY       // Requests of a recorded trace
+};
+
+// Operation of a single request
+enum Operation
+{
+    OP_GET,
+    OP_PUT,
+    OP_DELETE
+};
+
+// What a request's latency is reported under: its operation and, for GETs
+// over HTTP, whether the server's cache answered (its X-Cache header)
+enum LatencyKind
+{
+    KIND_GET_HIT,
+    KIND_GET_MISS,
+    KIND_GET_OTHER, // GET without a cache status (binary protocol)
+    KIND_PUT,
+    KIND_DELETE,
+    KIND_COUNT
 };
 
+// Time series histograms cover up to a minute at 2 significant digits (1%).
+constexpr uint64_t kSeriesHighestValue = 60ULL * 1000 * 1000 * 1000;
+
 // Structure to hold per-thread (client) statistics
 struct ClientStats
 {
     uint64_t requests_sent = 0;      // Total number of requests sent
     uint64_t requests_succeeded = 0; // Requests that received HTTP 200 OK
     uint64_t requests_failed = 0;    // Requests that failed (non-200 response or timeout)
-    uint64_t total_latency_ms = 0;   // Cumulative latency in milliseconds
+    uint64_t total_latency_us = 0;   // Cumulative latency in microseconds
+    uint64_t max_latency_us = 0;     // Slowest successful request
+    uint64_t reconnects = 0;         // Connections opened after the first one
+    uint64_t max_send_lag_us = 0;    // Open loop: furthest a request was sent behind its schedule
+
+    LatencyHistogram latency[KIND_COUNT]; // Every answered request, in nanoseconds
+    uint64_t errors[KIND_COUNT] = {};     // Failed requests (error responses and no response)
+
+    // The second of the run being recorded, merged into g_timeseries once over
+    int64_t second = 0;
+    LatencyHistogram second_latency{kSeriesHighestValue, 2};
+    uint64_t second_errors = 0;
+};
+
+// One second of the run, all threads merged
+struct SecondStats
+{
+    LatencyHistogram latency{kSeriesHighestValue, 2};
+    uint64_t errors = 0;
 };
 
 // Global atomic flag to indicate if test is running
@@ -47,320 +137,1628 @@ std::atomic<bool> g_running(true);
 // Vector to store statistics for each client thread
 std::vector<ClientStats> g_client_stats;
 
+// Key choice, shared by all threads (set up in main)
+std::unique_ptr<KeyDistribution> g_keys;
+
+// MIXED: relative weights of GET, PUT and DELETE
+std::vector<double> g_operation_mix = {1, 1, 1};
+
+// Sized values (--value-size), or null for the short "value_<key>" strings
+std::unique_ptr<ValueSizeDistribution> g_value_sizes;
+std::unique_ptr<PayloadPool> g_payloads;
+
+// A traced request to replay
+struct ReplayRequest
+{
+    uint64_t offset_ns; // Since the first request of the trace
+    Operation op;
+    std::string key;
+    uint32_t value_size;
+};
+
+// REPLAY: each thread's share of the trace, and how much faster than recorded it is sent
+std::vector<std::vector<ReplayRequest>> g_replay;
+double g_replay_speed = 1;
+
+// --verify: the history of every write, shared by all phases; null otherwise
+std::unique_ptr<ConsistencyChecker> g_verifier;
+
+// Phases limited to a number of requests (a preload, say) share this budget;
+// see takeRequest()
+bool g_request_limited = false;
+std::atomic<int64_t> g_requests_left(0);
+
+// Per-second time series, indexed by seconds since g_test_start
+std::chrono::steady_clock::time_point g_test_start;
+std::mutex g_timeseries_mutex;
+std::vector<SecondStats> g_timeseries;
+
+LatencyKind latencyKind(Operation op, HttpClient::CacheStatus cache = HttpClient::CacheStatus::Unknown)
+{
+    switch (op)
+    {
+    case OP_GET:
+        if (cache == HttpClient::CacheStatus::Hit)
+            return KIND_GET_HIT;
+        if (cache == HttpClient::CacheStatus::Miss)
+            return KIND_GET_MISS;
+        return KIND_GET_OTHER;
+    case OP_PUT:
+        return KIND_PUT;
+    default:
+        return KIND_DELETE;
+    }
+}
+
 /**
- * @brief Sends a raw HTTP request to the target server and returns the response.
- *
- * This function creates a TCP socket, connects to the specified host and port,
- * sends the HTTP request string, and waits for a response.
+ * @brief Claims one request of a limited phase's budget.
+ * @return false once the budget is spent (always true for unlimited phases).
+ */
+bool takeRequest()
+{
+    return !g_request_limited || g_requests_left.fetch_sub(1, std::memory_order_relaxed) > 0;
+}
+
+/**
+ * @brief Merges the thread's current second into the global time series.
+ */
+void flushSecond(ClientStats &stats)
+{
+    if (stats.second_latency.empty() && stats.second_errors == 0)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(g_timeseries_mutex);
+        if (g_timeseries.size() <= static_cast<size_t>(stats.second))
+            g_timeseries.resize(stats.second + 1);
+        g_timeseries[stats.second].latency.merge(stats.second_latency);
+        g_timeseries[stats.second].errors += stats.second_errors;
+    }
+    stats.second_latency.reset();
+    stats.second_errors = 0;
+}
+
+// Moves the thread's time series on to the second 'now' falls in.
+void advanceSecond(ClientStats &stats, std::chrono::steady_clock::time_point now)
+{
+    int64_t second = std::chrono::duration_cast<std::chrono::seconds>(now - g_test_start).count();
+    if (second != stats.second)
+    {
+        flushSecond(stats);
+        stats.second = second;
+    }
+}
+
+/**
+ * @brief Records an answered request: its latency, and whether it succeeded.
+ */
+void recordResponse(ClientStats &stats, LatencyKind kind, bool ok, std::chrono::steady_clock::time_point sent,
+                    std::chrono::steady_clock::time_point received)
+{
+    uint64_t latency_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(received - sent).count();
+    stats.latency[kind].record(latency_ns);
+    if (ok)
+    {
+        stats.requests_succeeded++;
+        stats.total_latency_us += latency_ns / 1000;
+        stats.max_latency_us = std::max(stats.max_latency_us, latency_ns / 1000);
+    }
+    else
+    {
+        stats.requests_failed++;
+        stats.errors[kind]++;
+    }
+
+    advanceSecond(stats, received);
+    stats.second_latency.record(latency_ns);
+    if (!ok)
+        stats.second_errors++;
+}
+
+/**
+ * @brief Records requests that got no response (connection lost, or never sent).
+ */
+void recordFailures(ClientStats &stats, LatencyKind kind, uint64_t count)
+{
+    stats.requests_failed += count;
+    stats.errors[kind] += count;
+    advanceSecond(stats, std::chrono::steady_clock::now());
+    stats.second_errors += count;
+}
+
+/**
+ * @brief Builds a raw request to /api/kv/<key>; a PUT's body is the value itself.
  *
- * @param host Target server hostname or IP
- * @param port Target server port number
- * @param request Full HTTP request string
- * @return std::string Response received from the server
+ * @param key Already percent-encoded if it needs to be.
  */
-std::string sendHttpRequest(const std::string &host, int port, const std::string &request)
+std::string buildRawRequest(Operation op, std::string_view key, std::string_view value, const std::string &host)
 {
-    // Create a TCP socket
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0)
+    static const char *const methods[] = {"GET", "PUT", "DELETE"};
+    std::string request;
+    request.reserve(160 + key.size() + value.size());
+    request.append(methods[op]).append(" /api/kv/").append(key).append(" HTTP/1.1\r\n");
+    request.append("Host: ").append(host).append("\r\n");
+    if (op == OP_PUT)
     {
-        return "";
+        request.append("Content-Type: application/octet-stream\r\n");
+        request.append("Content-Length: ").append(std::to_string(value.size())).append("\r\n");
     }
+    request.append("\r\n").append(value);
+    return request;
+}
 
-    // Configure server address structure
-    struct sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr)); // Initialize to zeros
-    server_addr.sin_family = AF_INET;             // IPv4 address family
-    server_addr.sin_port = htons(port);           // Convert port to network byte order
+/**
+ * @brief Builds the request replaying a traced one, its value a slice of the payload pool.
+ */
+std::string makeReplayRequest(const ReplayRequest &traced, const std::string &host, std::mt19937 &gen)
+{
+    // Traced keys may hold any bytes (hashed ones start with '#'): percent-encode
+    // all but unreserved characters for the path.
+    static const char hex[] = "0123456789ABCDEF";
+    std::string path_key;
+    path_key.reserve(traced.key.size() * 3);
+    for (unsigned char c : traced.key)
+    {
+        if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~')
+            path_key += static_cast<char>(c);
+        else
+            path_key.append({'%', hex[c >> 4], hex[c & 15]});
+    }
 
-    // Converts the IP address from its human-readable string form (e.g., "127.0.0.1")
-    // into a binary representation suitable for use in the sockaddr_in structure.
-    //
-    // Parameters:
-    //   AF_INET → Specifies that the address family is IPv4.
-    //   host.c_str() → Provides the IP address as a C-style string (e.g., "192.168.1.10").
-    //   &server_addr.sin_addr → A pointer to where the converted binary address will be stored.
-    //
-    // This step is essential because socket APIs require the address to be in
-    // network byte order (binary form), not in string format. If the conversion
-    // succeeds, inet_pton() returns 1. If the input string is invalid, it returns 0.
-    // On error (e.g., unsupported address family), it returns -1.
-    inet_pton(AF_INET, host.c_str(), &server_addr.sin_addr); // Convert IP string to binary form
+    std::string_view value;
+    if (traced.op == OP_PUT)
+        value = g_payloads->slice(traced.value_size, gen);
+    return buildRawRequest(traced.op, path_key, value, host);
+}
 
-    // Attempt to connect to the server
-    if (connect(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
+/**
+ * @brief Picks the operation and the key (1-based) of a PUT_ALL, GET_ALL or
+ *        MIXED request.
+ */
+uint64_t nextOperation(WorkloadType workload, std::mt19937 &gen, Operation &op)
+{
+    if (workload == PUT_ALL)
+        op = OP_PUT;
+    else if (workload == GET_ALL)
+        op = OP_GET;
+    else
     {
-        close(sock);
-        return "";
+        // The mix is weighted in Operation order: GET, PUT, DELETE
+        std::discrete_distribution<> op_dist(g_operation_mix.begin(), g_operation_mix.end());
+        op = static_cast<Operation>(op_dist(gen));
     }
+    return (op == OP_PUT ? g_keys->nextWrite(gen) : g_keys->next(gen)) + 1;
+}
 
-    // Send the HTTP request string to the server
-    send(sock, request.c_str(), request.length(), 0);
+/**
+ * @brief Builds the next request of a workload with sized values: raw
+ *        requests to /api/kv/<key>, a PUT's body being the value itself.
+ *
+ * @param op Set to the request's operation.
+ */
+std::string makeRawRequest(WorkloadType workload, const std::string &host, std::mt19937 &gen, Operation &op)
+{
+    uint64_t key = nextOperation(workload, gen, op);
+    std::string_view value;
+    if (op == OP_PUT)
+        value = g_payloads->slice(g_value_sizes->next(gen), gen);
+    return buildRawRequest(op, "key_" + std::to_string(key), value, host);
+}
 
-    // Buffer for receiving response
-    char buffer[4096];
-    ssize_t bytes_read = recv(sock, buffer, sizeof(buffer) - 1, 0); // Receive response data
-    close(sock);                                                    // Close socket after receiving data
+/**
+ * @brief Whether --verify checks a workload: those choosing keys from
+ *        g_keys. GET_POPULAR and REPLAY run unchecked.
+ */
+bool verifies(WorkloadType workload)
+{
+    return g_verifier && (workload == PUT_ALL || workload == GET_ALL || workload == MIXED);
+}
 
-    // Null-terminate and return response if data received
-    if (bytes_read > 0)
+/**
+ * @brief Registers a write of 'key' with g_verifier and returns its version;
+ *        for a PUT, 'value' is set to its tagged value, padded with a slice
+ *        of the payload pool to a size of the distribution, if there is one.
+ */
+uint64_t beginVerifiedWrite(Operation op, const std::string &key, std::mt19937 &gen, std::string &value)
+{
+    uint64_t version = g_verifier->beginWrite(key, op == OP_DELETE);
+    if (op == OP_PUT)
     {
-        buffer[bytes_read] = '\0';
-        return std::string(buffer);
+        value = g_verifier->tag(key, version);
+        size_t size = g_value_sizes ? g_value_sizes->next(gen) : 0;
+        if (size > value.size() + 1)
+        {
+            value += '|';
+            value.append(g_payloads->slice(size - value.size(), gen));
+        }
     }
+    return version;
+}
+
+/**
+ * @brief Builds the next request of a verified workload: a raw request
+ *        like makeRawRequest()'s, whose write is registered with g_verifier.
+ *
+ * @param key Set to the request's key.
+ * @param version Set to the write's version (PUT and DELETE).
+ */
+std::string makeVerifiedRequest(WorkloadType workload, const std::string &host, std::mt19937 &gen, Operation &op,
+                                std::string &key, uint64_t &version)
+{
+    key = "key_" + std::to_string(nextOperation(workload, gen, op));
+    std::string value;
+    if (op != OP_GET)
+        version = beginVerifiedWrite(op, key, gen, value);
+    return buildRawRequest(op, key, value, host);
+}
 
-    // Return empty string if no data was received
-    return "";
+/**
+ * @brief Hands the response to a verified request, sent at 'start' and
+ *        received at 'end', to g_verifier.
+ *
+ * @param ok The server succeeded (HTTP 200, binary Ok).
+ * @param missing The key does not exist (HTTP 404, binary NotFound).
+ */
+void verifyResponse(Operation op, const std::string &key, uint64_t version, std::chrono::steady_clock::time_point start,
+                    std::chrono::steady_clock::time_point end, bool ok, bool missing, std::string_view value)
+{
+    if (op != OP_GET)
+        g_verifier->endWrite(key, version, ok || (op == OP_DELETE && missing), end); // Deleted either way
+    else if (ok || missing)
+        g_verifier->checkRead(key, start, end, ok, value); // Errors say nothing about the value
 }
 
 /**
- * @brief Function executed by each client thread.
+ * @brief Builds the next HTTP request of a workload.
  *
- * Generates requests according to the chosen workload type and measures
- * response latency and success rates.
+ * @param thread_id Part of PUT_ALL values, so threads write distinct values.
+ * @param gen The calling thread's random number generator.
+ * @param op Set to the request's operation.
  */
-void clientThread(int thread_id, const std::string &host, int port,
-                  WorkloadType workload, int duration_sec, int key_space_size)
+std::string makeHttpRequest(WorkloadType workload, const std::string &host, int thread_id, std::mt19937 &gen,
+                            Operation &op)
 {
-    // Initialize random number generators for key and operation selection
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> key_dist(1, key_space_size);
+    // Distributions for popular keys and operation selection (keys come from g_keys)
     std::uniform_int_distribution<> popular_key_dist(1, 10); // For GET_POPULAR (small key set)
-    std::uniform_int_distribution<> op_dist(0, 2);           // Random op selection (0=GET, 1=PUT, 2=DELETE)
+    std::discrete_distribution<> op_dist(g_operation_mix.begin(), g_operation_mix.end()); // 0=GET, 1=PUT, 2=DELETE
 
-    // Reference to current thread's statistics object
-    ClientStats &stats = g_client_stats[thread_id];
+    if (g_value_sizes && workload != GET_POPULAR)
+        return makeRawRequest(workload, host, gen, op);
 
-    // Calculate the time at which the thread should stop sending requests
-    auto start_time = std::chrono::steady_clock::now();
-    auto end_time = start_time + std::chrono::seconds(duration_sec);
+    std::string request;
+    std::ostringstream body;
 
-    // Loop until duration ends or global stop signal is set
-    while (g_running && std::chrono::steady_clock::now() < end_time)
+    uint64_t key;
+    std::string value;
+
+    // Select request type and format request body depending on workload type
+    switch (workload)
+    {
+    // -----------------------------
+    case PUT_ALL:
     {
-        std::string request;
-        std::ostringstream body;
-        auto req_start = std::chrono::steady_clock::now(); // Record start time
+        // Generate a random key and corresponding value
+        // Uses the random number generator 'gen' with the key distribution
+        // 'g_keys' to produce a random integer 'key'. Each thread generates a different key,
+        // simulating a unique entry to be inserted into the key-value store.
+        key = g_keys->nextWrite(gen) + 1;
+        op = OP_PUT;
 
-        int key;
-        std::string value;
+        // Creates a unique string value associated with the generated key.
+        // The format is "value_<key>_<thread_id>" so that each thread produces
+        // distinct values even if they accidentally generate the same key.
+        value = "value_" + std::to_string(key) + "_" + std::to_string(thread_id);
 
-        // Select request type and format request body depending on workload type
-        switch (workload)
-        {
-        // -----------------------------
-        case PUT_ALL:
-        {
-            // Generate a random key and corresponding value
-            // Uses the random number generator 'gen' with the distribution 'key_dist'
-            // to produce a random integer 'key'. Each thread generates a different key,
-            // simulating a unique entry to be inserted into the key-value store.
-            key = key_dist(gen);
+        // Constructs a JSON-formatted string for the HTTP POST body.
+        // The JSON object has two fields: "key" and "value".
+        // Example output: {"key":"key_42","value":"value_42_3"}
+        // The use of stringstream 'body' allows efficient concatenation of components.
+        body << "{\"key\":\"key_" << key << "\",\"value\":\"" << value << "\"}";
 
-            // Creates a unique string value associated with the generated key.
-            // The format is "value_<key>_<thread_id>" so that each thread produces
-            // distinct values even if they accidentally generate the same key.
-            value = "value_" + std::to_string(key) + "_" + std::to_string(thread_id);
+        // Initializes the HTTP request line specifying:
+        // - Method: POST (used for creating or updating resources)
+        // - Path: /api/kv (the API endpoint for the key-value store)
+        // - Protocol version: HTTP/1.1
+        // The '\r\n' marks the end of the HTTP request line per protocol rules.
+        request = "POST /api/kv HTTP/1.1\r\n";
 
-            // Constructs a JSON-formatted string for the HTTP POST body.
-            // The JSON object has two fields: "key" and "value".
-            // Example output: {"key":"key_42","value":"value_42_3"}
-            // The use of stringstream 'body' allows efficient concatenation of components.
-            body << "{\"key\":\"key_" << key << "\",\"value\":\"" << value << "\"}";
+        // Adds the "Host" header, which specifies the server’s hostname or IP address.
+        // Required in HTTP/1.1 requests to indicate the destination host.
+        request += "Host: " + host + "\r\n";
 
-            // Initializes the HTTP request line specifying:
-            // - Method: POST (used for creating or updating resources)
-            // - Path: /api/kv (the API endpoint for the key-value store)
-            // - Protocol version: HTTP/1.1
-            // The '\r\n' marks the end of the HTTP request line per protocol rules.
-            request = "POST /api/kv HTTP/1.1\r\n";
+        // Specifies the type of content being sent in the HTTP body.
+        // In this case, it tells the server that the request body is in JSON format.
+        request += "Content-Type: application/json\r\n";
 
-            // Adds the "Host" header, which specifies the server’s hostname or IP address.
-            // Required in HTTP/1.1 requests to indicate the destination host.
-            request += "Host: " + host + "\r\n";
+        // Adds the "Content-Length" header, which tells the server the exact size (in bytes)
+        // of the request body. This helps the server know how many bytes to read.
+        request += "Content-Length: " + std::to_string(body.str().length()) + "\r\n";
 
-            // Specifies the type of content being sent in the HTTP body.
-            // In this case, it tells the server that the request body is in JSON format.
-            request += "Content-Type: application/json\r\n";
+        // Adds a blank line ("\r\n") to indicate the end of the HTTP headers section.
+        // Then appends the actual JSON body (the payload) that contains the key-value data.
+        request += "\r\n" + body.str();
 
-            // Adds the "Content-Length" header, which tells the server the exact size (in bytes)
-            // of the request body. This helps the server know how many bytes to read.
-            request += "Content-Length: " + std::to_string(body.str().length()) + "\r\n";
+        // The final request string now forms a complete and valid HTTP POST message.
+        //
+        // Example full request:
+        // POST /api/kv HTTP/1.1
+        // Host: 127.0.0.1
+        // Content-Type: application/json
+        // Content-Length: 40
+        //
+        // {"key":"key_42","value":"value_42_3"}
+        break;
+    }
 
-            // Adds a blank line ("\r\n") to indicate the end of the HTTP headers section.
-            // Then appends the actual JSON body (the payload) that contains the key-value data.
-            request += "\r\n" + body.str();
+    // -----------------------------
+    case GET_ALL:
+    {
+        // Generate random GET request for a random key
+        key = g_keys->next(gen) + 1;
+        op = OP_GET;
+        request = "GET /api/kv?key=key_" + std::to_string(key) + " HTTP/1.1\r\n";
+        request += "Host: " + host + "\r\n\r\n";
+        break;
+    }
 
-            // The final request string now forms a complete and valid HTTP POST message.
-            //
-            // Example full request:
-            // POST /api/kv HTTP/1.1
-            // Host: 127.0.0.1
-            // Content-Type: application/json
-            // Content-Length: 40
-            //
-            // {"key":"key_42","value":"value_42_3"}
-            break;
-        }
+    // -----------------------------
+    case GET_POPULAR:
+    {
+        // Generate GET request for a popular key (small subset of keys)
+        key = popular_key_dist(gen);
+        op = OP_GET;
+        request = "GET /api/kv?key=popular_key_" + std::to_string(key) + " HTTP/1.1\r\n";
+        request += "Host: " + host + "\r\n\r\n";
+        break;
+    }
 
-        // -----------------------------
-        case GET_ALL:
-        {
-            // Generate random GET request for a random key
-            key = key_dist(gen);
+    // -----------------------------
+    case MIXED:
+    {
+        // Randomly choose an operation
+        int choice = op_dist(gen);
+        key = (choice == 1 ? g_keys->nextWrite(gen) : g_keys->next(gen)) + 1;
+
+        if (choice == 0)
+        { // GET request
+            op = OP_GET;
             request = "GET /api/kv?key=key_" + std::to_string(key) + " HTTP/1.1\r\n";
             request += "Host: " + host + "\r\n\r\n";
-            break;
         }
-
-        // -----------------------------
-        case GET_POPULAR:
-        {
-            // Generate GET request for a popular key (small subset of keys)
-            key = popular_key_dist(gen);
-            request = "GET /api/kv?key=popular_key_" + std::to_string(key) + " HTTP/1.1\r\n";
+        else if (choice == 1)
+        { // PUT request
+            op = OP_PUT;
+            value = "value_" + std::to_string(key);
+            body << "{\"key\":\"key_" << key << "\",\"value\":\"" << value << "\"}";
+            request = "POST /api/kv HTTP/1.1\r\n";
+            request += "Host: " + host + "\r\n";
+            request += "Content-Type: application/json\r\n";
+            request += "Content-Length: " + std::to_string(body.str().length()) + "\r\n";
+            request += "\r\n" + body.str();
+        }
+        else
+        { // DELETE request
+            op = OP_DELETE;
+            request = "DELETE /api/kv?key=key_" + std::to_string(key) + " HTTP/1.1\r\n";
             request += "Host: " + host + "\r\n\r\n";
-            break;
         }
+        break;
+    }
+
+    // -----------------------------
+    case REPLAY:
+        // Replayed requests come from the trace (makeReplayRequest())
+        op = OP_GET;
+        break;
+    }
+
+    return request;
+}
+
+/**
+ * @brief Function executed by each HTTP client thread: one epoll loop
+ *        driving 'connections' simulated clients, each a non-blocking
+ *        keep-alive connection (over TCP or the server's Unix domain socket).
+ *
+ * Closed loop (no rate): every connection keeps up to 'pipeline_depth'
+ * requests in flight and sends the next one when a response arrives; the
+ * server answers pipelined requests in order.
+ *
+ * Open loop: requests are issued on a fixed schedule of 'rate' per second
+ * (Poisson or evenly spaced arrivals) whether or not earlier ones have been
+ * answered, like independent users would. A closed-loop client stops sending
+ * while the server stalls, so the stall shows up in a single request's
+ * latency; here every request scheduled during the stall waits, and its
+ * latency is measured from its scheduled (intended) send time, not from
+ * when it was actually written. A timerfd fires at the next scheduled send,
+ * and each request goes to the next connection, in turn, with fewer than
+ * 'pipeline_depth' in flight; requests due while every connection is full
+ * or reconnecting wait in a backlog (their latency still counts from the
+ * schedule).
+ *
+ * When 'end_rate' differs from 'rate' (a ramp), the rate changes linearly
+ * from one to the other over the duration; each gap is drawn at the rate
+ * in force when it starts.
+ *
+ * REPLAY takes the schedule from the thread's share of the trace instead:
+ * each request is due at its recorded offset divided by the speed-up, and
+ * the thread stops scheduling when its share runs out.
+ *
+ * Connections open without blocking, all at the start. One that fails, or
+ * that the server closes, counts its requests in flight as failed and
+ * reconnects 10 ms later while the thread's other connections carry on, so
+ * a few threads can simulate thousands of clients.
+ */
+void httpClientThread(int thread_id, const std::string &host, int port, WorkloadType workload, int duration_sec,
+                      int connections, int pipeline_depth, double rate, double end_rate, bool poisson)
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr uint32_t kTimerTag = UINT32_MAX; // epoll data of the timerfd; connections use their index
+    constexpr auto kReconnectDelay = std::chrono::milliseconds(10);
+
+    std::random_device rd;
+    std::mt19937 gen(rd());
+
+    ClientStats &stats = g_client_stats[thread_id];
+    const std::vector<ReplayRequest> *replay = workload == REPLAY ? &g_replay[thread_id] : nullptr;
+    bool open_loop = rate > 0 || replay;
+    bool verifying = verifies(workload);
+    size_t depth = static_cast<size_t>(pipeline_depth);
+
+    // steady_clock is CLOCK_MONOTONIC, so the timerfd can be armed with its time points.
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    struct epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u32 = kTimerTag;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &event);
 
-        // -----------------------------
-        case MIXED:
+    // A request, from the time it is due until its response arrives
+    struct Scheduled
+    {
+        Clock::time_point time; // Scheduled send time (open loop) or send time (closed loop)
+        Operation op;
+        std::string request; // Empty once sent
+        std::string key;     // --verify only
+        uint64_t version = 0;
+    };
+
+    struct Connection
+    {
+        HttpClient client;
+        std::deque<Scheduled> outstanding; // Sent, in order; responses come back in order
+        uint32_t registered_events = 0;    // Events the socket is registered for (0: not registered)
+        bool connected_once = false;
+        bool available = false; // Open loop: listed in 'available'
+        bool written = false;   // Given requests in this dispatch()
+    };
+    std::vector<Connection> pool(connections);
+
+    std::deque<Scheduled> backlog;                           // Open loop: scheduled, not sent yet
+    std::deque<int> available;                               // Open loop: connections with room, in turn
+    std::deque<std::pair<Clock::time_point, int>> reconnect; // Connections to (re)open, and when
+    std::vector<int> written;
+    size_t in_flight = 0;
+
+    Clock::time_point start_time = Clock::now();
+    Clock::time_point end_time = start_time + std::chrono::seconds(duration_sec);
+    Clock::time_point drain_deadline = Clock::time_point::max(); // Set when sending stops
+    for (int index = 0; index < connections; index++)
+        reconnect.push_back({start_time, index});
+
+    // Gap to the request after one sent at 'from': Poisson arrivals have
+    // exponentially distributed gaps (mean 1 / rate), uniform ones 1 / rate.
+    std::exponential_distribution<double> poisson_gap(1);
+    auto nextGap = [&](Clock::time_point from) {
+        double current_rate = rate;
+        if (end_rate != rate && duration_sec > 0)
         {
-            // Randomly choose an operation
-            int op = op_dist(gen);
-            key = key_dist(gen);
+            double progress = std::chrono::duration<double>(from - start_time).count() / duration_sec;
+            current_rate += (end_rate - rate) * std::min(std::max(progress, 0.0), 1.0);
+        }
+        double seconds = (poisson ? poisson_gap(gen) : 1.0) / current_rate;
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    };
+    // Replay: the next request of this thread's share to schedule
+    size_t replay_position = 0;
+    auto replayTime = [&](size_t position) {
+        return start_time + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::nano>(
+                                (*replay)[position].offset_ns / g_replay_speed));
+    };
+    Clock::time_point next_send = end_time;
+    if (replay)
+        next_send = replay->empty() ? end_time : replayTime(0);
+    else if (open_loop)
+        next_send = start_time + nextGap(start_time);
+
+    bool sending = true;
+    bool budget_spent = false;
 
-            if (op == 0)
-            { // GET request
-                request = "GET /api/kv?key=key_" + std::to_string(key) + " HTTP/1.1\r\n";
-                request += "Host: " + host + "\r\n\r\n";
+    // Registers the connection's socket for the events it is waiting for.
+    auto watch = [&](int index) {
+        Connection &connection = pool[index];
+        uint32_t wanted = connection.client.isConnecting()
+                              ? EPOLLOUT
+                              : EPOLLIN | EPOLLRDHUP | (connection.client.hasOutput() ? EPOLLOUT : 0);
+        if (wanted == connection.registered_events)
+            return;
+        event.events = wanted;
+        event.data.u32 = index;
+        epoll_ctl(epoll_fd, connection.registered_events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD,
+                  connection.client.descriptor(), &event);
+        connection.registered_events = wanted;
+    };
+    // Builds the next request of the workload (not REPLAY) into 'request'.
+    auto makeRequest = [&](Scheduled &request) {
+        if (verifying)
+            request.request = makeVerifiedRequest(workload, host, gen, request.op, request.key, request.version);
+        else
+            request.request = makeHttpRequest(workload, host, thread_id, gen, request.op);
+    };
+    // Everything in flight on the connection failed; it reconnects shortly.
+    auto failConnection = [&](int index) {
+        Connection &connection = pool[index];
+        for (const Scheduled &request : connection.outstanding)
+            recordFailures(stats, latencyKind(request.op), 1);
+        in_flight -= connection.outstanding.size();
+        connection.outstanding.clear();
+        connection.client.close(); // Closing the socket also removes it from epoll
+        connection.registered_events = 0;
+        reconnect.push_back({Clock::now() + kReconnectDelay, index});
+    };
+    auto flush = [&](int index) {
+        if (pool[index].client.flushAvailable())
+            watch(index);
+        else
+            failConnection(index);
+    };
+    // Closed loop: fills the connection's pipeline with new requests.
+    auto topUp = [&](int index) {
+        Connection &connection = pool[index];
+        while (sending && connection.outstanding.size() < depth)
+        {
+            if (!takeRequest())
+            {
+                budget_spent = true;
+                sending = false;
+                break;
             }
-            else if (op == 1)
-            { // PUT request
-                value = "value_" + std::to_string(key);
-                body << "{\"key\":\"key_" << key << "\",\"value\":\"" << value << "\"}";
-                request = "POST /api/kv HTTP/1.1\r\n";
-                request += "Host: " + host + "\r\n";
-                request += "Content-Type: application/json\r\n";
-                request += "Content-Length: " + std::to_string(body.str().length()) + "\r\n";
-                request += "\r\n" + body.str();
+            Scheduled request{Clock::now(), OP_GET, {}};
+            makeRequest(request);
+            connection.client.queue(request.request);
+            request.request.clear();
+            connection.outstanding.push_back(std::move(request));
+            in_flight++;
+            stats.requests_sent++;
+        }
+    };
+    auto makeAvailable = [&](int index) {
+        if (!pool[index].available)
+        {
+            pool[index].available = true;
+            available.push_back(index);
+        }
+    };
+    auto onConnected = [&](int index) {
+        Connection &connection = pool[index];
+        if (connection.connected_once)
+            stats.reconnects++;
+        connection.connected_once = true;
+        if (open_loop)
+        {
+            makeAvailable(index);
+            watch(index);
+        }
+        else
+        {
+            topUp(index);
+            flush(index);
+        }
+    };
+    // Open loop: hands the backlog to the connections with room, in turn,
+    // then writes what each was given. (Requests count as sent once
+    // scheduled: the schedule, not the client, sets the load.)
+    auto dispatch = [&](Clock::time_point now) {
+        while (!backlog.empty() && !available.empty())
+        {
+            int index = available.front();
+            available.pop_front();
+            Connection &connection = pool[index];
+            if (!connection.client.isConnected() || connection.client.isConnecting() ||
+                connection.outstanding.size() >= depth)
+            {
+                connection.available = false; // Lost its connection or its room since it was listed
+                continue;
             }
+            Scheduled &request = backlog.front();
+            uint64_t lag = std::chrono::duration_cast<std::chrono::microseconds>(now - request.time).count();
+            stats.max_send_lag_us = std::max(stats.max_send_lag_us, lag);
+            connection.client.queue(request.request);
+            request.request.clear();
+            connection.outstanding.push_back(std::move(request));
+            backlog.pop_front();
+            in_flight++;
+            if (connection.outstanding.size() < depth)
+                available.push_back(index);
             else
-            { // DELETE request
-                request = "DELETE /api/kv?key=key_" + std::to_string(key) + " HTTP/1.1\r\n";
-                request += "Host: " + host + "\r\n\r\n";
+                connection.available = false;
+            if (!connection.written)
+            {
+                connection.written = true;
+                written.push_back(index);
             }
-            break;
         }
+        for (int index : written)
+        {
+            pool[index].written = false;
+            flush(index);
+        }
+        written.clear();
+    };
+
+    HttpClient::Response response;
+    struct epoll_event events[64];
+    while (true)
+    {
+        Clock::time_point now = Clock::now();
+        sending = sending && g_running && !budget_spent && now < end_time &&
+                  (!replay || replay_position < replay->size());
+        if (!sending && drain_deadline == Clock::time_point::max())
+            drain_deadline = now + std::chrono::seconds(5); // Responses still missing then count as failed
+
+        // 1. Open loop: everything due by now joins the backlog, even if the loop woke up late.
+        while (open_loop && sending && next_send <= now)
+        {
+            if (!takeRequest())
+            {
+                budget_spent = true;
+                sending = false;
+                break;
+            }
+            Scheduled request{next_send, OP_GET, {}};
+            if (replay)
+            {
+                const ReplayRequest &traced = (*replay)[replay_position++];
+                request.op = traced.op;
+                request.request = makeReplayRequest(traced, host, gen);
+                next_send = replay_position < replay->size() ? replayTime(replay_position) : end_time;
+            }
+            else
+            {
+                makeRequest(request);
+                next_send += nextGap(next_send);
+            }
+            backlog.push_back(std::move(request));
+            stats.requests_sent++;
         }
+        if (!sending && ((backlog.empty() && in_flight == 0) || now >= drain_deadline))
+            break;
 
-        // Send the request and capture the response
-        std::string response = sendHttpRequest(host, port, request);
+        // 2. Open the connections whose (re)connect time has come, while there is anything to send.
+        bool wants_connections = sending || !backlog.empty();
+        while (wants_connections && !reconnect.empty() && reconnect.front().first <= now)
+        {
+            int index = reconnect.front().second;
+            reconnect.pop_front();
+            if (!pool[index].client.connectNonBlocking(host, port))
+                reconnect.push_back({now + kReconnectDelay, index}); // Server down or refusing connections
+            else if (pool[index].client.isConnecting())
+                watch(index);
+            else
+                onConnected(index);
+        }
 
-        // Measure request latency
-        auto req_end = std::chrono::steady_clock::now();
-        auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(req_end - req_start).count();
+        // 3. Open loop: send the backlog, up to the in-flight limit of each connection.
+        if (open_loop)
+            dispatch(now);
 
-        // Update thread statistics
-        stats.requests_sent++;
-        if (!response.empty() && response.find("200 OK") != std::string::npos)
+        // 4. Sleep until the next scheduled send, a socket event, the next
+        //    reconnect or (while draining) a short timeout.
+        if (open_loop && sending)
         {
-            stats.requests_succeeded++;
-            stats.total_latency_ms += latency;
+            struct itimerspec deadline{};
+            auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(next_send.time_since_epoch());
+            deadline.it_value.tv_sec = since_epoch.count() / 1000000000;
+            deadline.it_value.tv_nsec = since_epoch.count() % 1000000000;
+            timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &deadline, nullptr);
         }
-        else
+        int timeout_ms = -1;
+        if (wants_connections && !reconnect.empty())
+            timeout_ms = static_cast<int>(std::max<int64_t>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(reconnect.front().first - now).count() + 1, 0));
+        if (!sending)
+            timeout_ms = timeout_ms < 0 ? 10 : std::min(timeout_ms, 10);
+
+        int ready = epoll_wait(epoll_fd, events, 64, timeout_ms);
+        for (int i = 0; i < ready; i++)
         {
-            stats.requests_failed++;
+            if (events[i].data.u32 == kTimerTag)
+            {
+                uint64_t expirations;
+                while (read(timer_fd, &expirations, sizeof(expirations)) > 0)
+                {
+                }
+                continue;
+            }
+            int index = static_cast<int>(events[i].data.u32);
+            Connection &connection = pool[index];
+            if (!connection.client.isConnected())
+                continue; // Failed earlier in this batch
+
+            if (connection.client.isConnecting())
+            {
+                if (connection.client.finishConnect())
+                    onConnected(index);
+                else
+                {
+                    connection.registered_events = 0;
+                    reconnect.push_back({Clock::now() + kReconnectDelay, index});
+                }
+                continue;
+            }
+
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            {
+                // Take every complete response, then handle a closed connection.
+                bool alive = connection.client.readAvailable();
+                Clock::time_point received = Clock::now();
+                HttpClient::ParseResult result = HttpClient::ParseResult::Incomplete;
+                while (!connection.outstanding.empty() &&
+                       (result = connection.client.nextResponse(response)) == HttpClient::ParseResult::Complete)
+                {
+                    const Scheduled &request = connection.outstanding.front();
+                    recordResponse(stats, latencyKind(request.op, response.cache), response.status == 200,
+                                   request.time, received);
+                    if (verifying)
+                        verifyResponse(request.op, request.key, request.version, request.time, received,
+                                       response.status == 200, response.status == 404, response.body);
+                    connection.outstanding.pop_front();
+                    in_flight--;
+                    if (response.close)
+                    {
+                        // The server won't answer the requests pipelined behind this one.
+                        alive = false;
+                        break;
+                    }
+                }
+                if (!alive || (!connection.outstanding.empty() && result == HttpClient::ParseResult::Malformed))
+                {
+                    failConnection(index);
+                    continue;
+                }
+                if (!open_loop)
+                    topUp(index);
+                else if (connection.outstanding.size() < depth)
+                    makeAvailable(index);
+            }
+            flush(index);
         }
     }
+
+    // Requests in flight when the drain deadline passed, and requests
+    // scheduled but never sent (server unreachable), failed too.
+    for (Connection &connection : pool)
+    {
+        for (const Scheduled &request : connection.outstanding)
+            recordFailures(stats, latencyKind(request.op), 1);
+        connection.client.close();
+    }
+    for (const Scheduled &request : backlog)
+        recordFailures(stats, latencyKind(request.op), 1);
+    flushSecond(stats);
+    close(timer_fd);
+    close(epoll_fd);
 }
 
 /**
- * @brief Prints command-line usage information.
+ * @brief Function executed by each client thread in binary-protocol mode.
+ *
+ * Same workloads as httpClientThread() in closed loop, over one blocking
+ * connection that reconnects when it fails; responses may arrive out of order,
+ * and each is matched to its request by ID to measure its
+ * latency.
  */
-void printUsage(const char *prog_name)
+void binaryClientThread(int thread_id, const std::string &host, int port, WorkloadType workload,
+                        int duration_sec, int pipeline_depth)
 {
-    std::cout << "Usage: " << prog_name << " <host> <port> <workload> <num_threads> <duration_sec> [key_space_size]" << std::endl;
-    std::cout << "Workload types: PUT_ALL, GET_ALL, GET_POPULAR, MIXED" << std::endl;
-    std::cout << "Example: " << prog_name << " localhost 8080 GET_POPULAR 10 60 10000" << std::endl;
-}
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<> popular_key_dist(1, 10);
+    std::discrete_distribution<> op_dist(g_operation_mix.begin(), g_operation_mix.end());
 
-int main(int argc, char *argv[])
-{
-    // Ensure minimum required arguments are provided
-    if (argc < 6)
-    {
-        printUsage(argv[0]);
-        return 1;
-    }
+    ClientStats &stats = g_client_stats[thread_id];
 
-    // Parse command-line arguments
-    std::string host = argv[1];
-    int port = std::stoi(argv[2]);
-    std::string workload_str = argv[3];
-    int num_threads = std::stoi(argv[4]);
-    int duration_sec = std::stoi(argv[5]);
-    int key_space_size = (argc > 6) ? std::stoi(argv[6]) : 10000;
-
-    // Map string to workload type enum
-    WorkloadType workload;
-    if (workload_str == "PUT_ALL")
-        workload = PUT_ALL;
-    else if (workload_str == "GET_ALL")
-        workload = GET_ALL;
-    else if (workload_str == "GET_POPULAR")
-        workload = GET_POPULAR;
-    else if (workload_str == "MIXED")
-        workload = MIXED;
-    else
-    {
-        std::cerr << "Invalid workload type: " << workload_str << std::endl;
-        printUsage(argv[0]);
-        return 1;
-    }
+    BinaryClient client;
+    bool connected_once = false;
 
-    // Display configuration summary
-    std::cout << "=== Load Generator Configuration ===" << std::endl;
-    std::cout << "Target: " << host << ":" << port << std::endl;
-    std::cout << "Workload: " << workload_str << std::endl;
-    std::cout << "Threads: " << num_threads << std::endl;
-    std::cout << "Duration: " << duration_sec << " seconds" << std::endl;
-    std::cout << "Key Space Size: " << key_space_size << std::endl;
-    std::cout << "====================================\n"
-              << std::endl;
+    // Send time and operation of every outstanding request, by request ID
+    struct Outstanding
+    {
+        std::chrono::steady_clock::time_point sent;
+        Operation op;
+        std::string key; // --verify only
+        uint64_t version = 0;
+    };
+    bool verifying = verifies(workload);
+    std::unordered_map<uint64_t, Outstanding> outstanding;
 
-    // Preload popular keys into server for GET_POPULAR workload
-    if (workload == GET_POPULAR)
+    auto end_time = std::chrono::steady_clock::now() + std::chrono::seconds(duration_sec);
+    bool budget_spent = false;
+    BinaryClient::Response response;
+    while (true)
     {
-        std::cout << "Pre-populating popular keys..." << std::endl;
-        for (int i = 1; i <= 10; i++)
+        bool sending = g_running && !budget_spent && std::chrono::steady_clock::now() < end_time;
+        if (!sending && outstanding.empty())
+            break;
+
+        if (!client.isConnected())
         {
-            std::ostringstream body;
-            body << "{\"key\":\"popular_key_" << i << "\",\"value\":\"popular_value_" << i << "\"}";
-            std::string request = "POST /api/kv HTTP/1.1\r\n";
-            request += "Host: " + host + "\r\n";
-            request += "Content-Type: application/json\r\n";
-            request += "Content-Length: " + std::to_string(body.str().length()) + "\r\n";
-            request += "\r\n" + body.str();
-            sendHttpRequest(host, port, request);
+            if (!sending)
+                break;
+            if (!client.connect(host, port))
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+            if (connected_once)
+                stats.reconnects++;
+            connected_once = true;
         }
-        std::cout << "Pre-population complete.\n"
-                  << std::endl;
-    }
-
-    // Prepare statistics and thread containers
-    g_client_stats.resize(num_threads);
-    std::vector<std::thread> threads;
 
-    std::cout << "Starting load test..." << std::endl;
-    auto test_start = std::chrono::steady_clock::now();
+        // Top the pipeline up, then wait for (any) one response.
+        while (sending && outstanding.size() < static_cast<size_t>(pipeline_depth))
+        {
+            if (!takeRequest())
+            {
+                budget_spent = true;
+                break;
+            }
+            uint64_t key = 0;
+            int op = 0; // 0 = GET, 1 = PUT, 2 = DELETE
+            std::string key_name;
+            switch (workload)
+            {
+            case PUT_ALL:
+                key = g_keys->nextWrite(gen) + 1;
+                op = 1;
+                key_name = "key_" + std::to_string(key);
+                break;
+            case GET_ALL:
+                key_name = "key_" + std::to_string(g_keys->next(gen) + 1);
+                break;
+            case GET_POPULAR:
+                key_name = "popular_key_" + std::to_string(popular_key_dist(gen));
+                break;
+            case MIXED:
+                op = op_dist(gen);
+                key = (op == 1 ? g_keys->nextWrite(gen) : g_keys->next(gen)) + 1;
+                key_name = "key_" + std::to_string(key);
+                break;
+            case REPLAY: // HTTP only
+                break;
+            }
 
-    // Launch multiple client threads
-    for (int i = 0; i < num_threads; i++)
-    {
-        threads.emplace_back(clientThread, i, host, port, workload, duration_sec, key_space_size);
-    }
+            Operation operation = op == 0 ? OP_GET : (op == 1 ? OP_PUT : OP_DELETE);
+            auto sent = std::chrono::steady_clock::now();
+            uint64_t id;
+            uint64_t version = 0;
+            if (verifying && op != 0)
+            {
+                std::string value;
+                version = beginVerifiedWrite(operation, key_name, gen, value);
+                id = op == 1 ? client.sendPut(key_name, value) : client.sendDelete(key_name);
+            }
+            else if (op == 0)
+            {
+                id = client.sendGet(key_name);
+            }
+            else if (op == 1)
+            {
+                if (g_value_sizes)
+                {
+                    id = client.sendPut(key_name, g_payloads->slice(g_value_sizes->next(gen), gen));
+                }
+                else
+                {
+                    std::string value = "value_" + std::to_string(key);
+                    if (workload == PUT_ALL)
+                        value += "_" + std::to_string(thread_id);
+                    id = client.sendPut(key_name, value);
+                }
+            }
+            else
+            {
+                id = client.sendDelete(key_name);
+            }
+            outstanding[id] = {sent, operation, verifying ? std::move(key_name) : std::string(), version};
+            stats.requests_sent++;
+        }
+
+        if (outstanding.empty())
+            continue;
+
+        if (!client.flush() || !client.receive(response))
+        {
+            // Connection lost: everything in flight failed.
+            for (const auto &entry : outstanding)
+                recordFailures(stats, latencyKind(entry.second.op), 1);
+            outstanding.clear();
+            client.close();
+            continue;
+        }
+
+        auto it = outstanding.find(response.id);
+        if (it == outstanding.end())
+            continue;
+
+        // Like HTTP: a GET of a missing key fails, a DELETE of one succeeds.
+        bool ok = response.status == binproto::Status::Ok ||
+                  (response.status == binproto::Status::NotFound && it->second.op == OP_DELETE);
+        auto received = std::chrono::steady_clock::now();
+        recordResponse(stats, latencyKind(it->second.op), ok, it->second.sent, received);
+        if (verifying)
+            verifyResponse(it->second.op, it->second.key, it->second.version, it->second.sent, received,
+                           response.status == binproto::Status::Ok,
+                           response.status == binproto::Status::NotFound, response.value);
+        outstanding.erase(it);
+    }
+    flushSecond(stats);
+}
+
+// Latencies of one reported operation, merged from every thread
+struct LatencySummary
+{
+    std::string name;
+    LatencyHistogram latency;
+    uint64_t errors = 0;
+};
+
+struct ReportedPercentile
+{
+    const char *name;
+    double value;
+};
+const ReportedPercentile kReportedPercentiles[] = {
+    {"p50", 50}, {"p90", 90}, {"p99", 99}, {"p99.9", 99.9}, {"p99.99", 99.99}};
+
+/**
+ * @brief Writes the results as <prefix>.json (everything), <prefix>_latency.csv
+ *        (percentiles per operation) and <prefix>_timeseries.csv. Latencies
+ *        are in microseconds.
+ *
+ * @param writeHeader Writes the JSON members before "latency" (config and summary).
+ * @return false if a file could not be written.
+ */
+template <typename HeaderWriter>
+bool writeResults(const std::string &prefix, const std::vector<LatencySummary> &latencies, HeaderWriter writeHeader)
+{
+    std::ofstream json(prefix + ".json");
+    std::ofstream latency_csv(prefix + "_latency.csv");
+    std::ofstream timeseries_csv(prefix + "_timeseries.csv");
+    if (!json || !latency_csv || !timeseries_csv)
+        return false;
+    json << std::fixed << std::setprecision(3);
+    latency_csv << std::fixed << std::setprecision(3);
+    timeseries_csv << std::fixed << std::setprecision(3);
+
+    json << "{\n";
+    writeHeader(json);
+
+    json << "  \"latency_us\": {";
+    latency_csv << "operation,count,errors,mean_us";
+    for (const auto &percentile : kReportedPercentiles)
+        latency_csv << "," << percentile.name << "_us";
+    latency_csv << ",max_us\n";
+    for (size_t i = 0; i < latencies.size(); i++)
+    {
+        const LatencySummary &summary = latencies[i];
+        json << (i ? "," : "") << "\n    \"" << summary.name << "\": {\"count\": " << summary.latency.count()
+             << ", \"errors\": " << summary.errors << ", \"mean\": " << summary.latency.mean() / 1000;
+        latency_csv << summary.name << "," << summary.latency.count() << "," << summary.errors << ","
+                    << summary.latency.mean() / 1000;
+        for (const auto &percentile : kReportedPercentiles)
+        {
+            double value = summary.latency.valueAtPercentile(percentile.value) / 1000.0;
+            json << ", \"" << percentile.name << "\": " << value;
+            latency_csv << "," << value;
+        }
+        json << ", \"max\": " << summary.latency.max() / 1000.0 << "}";
+        latency_csv << "," << summary.latency.max() / 1000.0 << "\n";
+    }
+    json << "\n  },\n";
+
+    json << "  \"timeseries\": [";
+    timeseries_csv << "second,requests,errors,mean_us,p50_us,p99_us,max_us\n";
+    for (size_t second = 0; second < g_timeseries.size(); second++)
+    {
+        const SecondStats &point = g_timeseries[second];
+        double mean = point.latency.mean() / 1000;
+        double p50 = point.latency.valueAtPercentile(50) / 1000.0;
+        double p99 = point.latency.valueAtPercentile(99) / 1000.0;
+        double max = point.latency.max() / 1000.0;
+        json << (second ? "," : "") << "\n    {\"second\": " << second << ", \"requests\": " << point.latency.count()
+             << ", \"errors\": " << point.errors << ", \"mean\": " << mean << ", \"p50\": " << p50
+             << ", \"p99\": " << p99 << ", \"max\": " << max << "}";
+        timeseries_csv << second << "," << point.latency.count() << "," << point.errors << "," << mean << "," << p50
+                       << "," << p99 << "," << max << "\n";
+    }
+    json << "\n  ]\n}\n";
+
+    return json.good() && latency_csv.good() && timeseries_csv.good();
+}
+
+/**
+ * @brief One phase of a run: what the threads send, at what rate, and for how long.
+ *
+ * A plain run is a single phase built from the command line; a scenario
+ * file (--scenario, see loadScenario()) lists several, run one after the other.
+ */
+struct Phase
+{
+    std::string name; // Scenario phases only; names their result files
+    std::string workload_name = "MIXED";
+    WorkloadType workload = MIXED;
+    int duration_sec = 0;
+    uint64_t requests = 0; // Stop once this many requests are sent, by all threads (0: no limit)
+    double rate = 0;       // Total requests/sec (0: closed loop)
+    double end_rate = 0;   // Rate reached at the end of the phase (a ramp); equal to 'rate' otherwise
+    std::string arrivals = "poisson";
+    bool measured = true; // Warm-ups run but are not reported
+    std::string keys = "uniform";
+    std::string mix;        // MIXED operation weights; empty for 1:1:1
+    std::string value_size; // Empty for short strings
+    double compressibility = 0;
+    std::string trace; // REPLAY
+    double speed = 1;
+
+    // Filled in by checkPhase() and applyPhase()
+    bool open_loop = false;
+    int pipeline_depth = 1;
+    uint64_t replay_count = 0;
+    uint64_t replay_span_ns = 0;
+    double replay_sample_rate = 1;
+};
+
+// Settings shared by every phase of a run
+struct RunConfig
+{
+    std::string host;
+    int port = 0;
+    int num_threads = 1;
+    int connections = 0; // Simulated clients, spread over the threads (0: one per thread)
+    int key_space_size = 10000;
+    std::string protocol = "http";
+    int pipeline_depth = 0; // 0: the default for each phase's protocol and loop
+    bool verify = false;    // Check every GET (see ConsistencyChecker)
+};
+
+// What a phase did, all threads merged
+struct PhaseResults
+{
+    double duration_sec = 0;
+    uint64_t sent = 0, succeeded = 0, failed = 0, reconnects = 0;
+    uint64_t total_latency_us = 0, max_latency_us = 0, max_send_lag_us = 0;
+    std::vector<LatencySummary> latencies; // Reported operations, see runPhase()
+    bool verified = false;                 // --verify checked this phase's workload
+    ConsistencyChecker::Report verification;
+};
+
+// Phases limited to a number of requests but not a duration end when the budget does.
+constexpr int kUnlimitedDurationSec = 365 * 24 * 3600;
+
+bool parseWorkload(const std::string &name, WorkloadType &workload)
+{
+    if (name == "PUT_ALL")
+        workload = PUT_ALL;
+    else if (name == "GET_ALL")
+        workload = GET_ALL;
+    else if (name == "GET_POPULAR")
+        workload = GET_POPULAR;
+    else if (name == "MIXED")
+        workload = MIXED;
+    else if (name == "REPLAY")
+        workload = REPLAY;
+    else
+        return false;
+    return true;
+}
+
+bool parseNumber(const std::string &field, double &value)
+{
+    std::istringstream in(field);
+    return (in >> value) && in.eof();
+}
+
+bool parseCount(const std::string &field, uint64_t &value)
+{
+    std::istringstream in(field);
+    return !field.empty() && field[0] != '-' && (in >> value) && in.eof();
+}
+
+/**
+ * @brief Parses MIXED weights: three non-negative numbers, "get:put:delete", not all zero.
+ */
+bool parseMix(const std::string &spec, std::vector<double> &weights)
+{
+    weights.clear();
+    std::istringstream fields(spec);
+    std::string field;
+    while (std::getline(fields, field, ':'))
+    {
+        double weight;
+        if (!parseNumber(field, weight) || weight < 0)
+            return false;
+        weights.push_back(weight);
+    }
+    return weights.size() == 3 && weights[0] + weights[1] + weights[2] > 0;
+}
+
+/**
+ * @brief Reads a scenario file: run-wide settings, then one section per phase.
+ *
+ * One setting per line, "name value", '#' starting a comment:
+ *
+ *     threads 8              # Run-wide: threads, connections, key_space, protocol, pipeline_depth
+ *     key_space 100000
+ *     keys zipfian           # Phase settings here are every phase's defaults
+ *
+ *     [preload]
+ *     workload PUT_ALL
+ *     keys sequential
+ *     requests 100000        # Stop after this many requests
+ *
+ *     [ramp]
+ *     workload MIXED
+ *     mix 90:8:2
+ *     rate 1000 20000        # Open loop, rising linearly from 1000 to 20000 req/sec
+ *     duration 60
+ *
+ * Phase settings: workload, duration, requests, rate (one value, or the
+ * start and end of a ramp; 0 runs closed loop), arrivals, keys, mix,
+ * value_size, compressibility, trace, speed, and measure (no for a warm-up,
+ * which runs but is left out of the results).
+ *
+ * @return false, with 'error' set, if the file is missing or invalid.
+ */
+bool loadScenario(const std::string &path, RunConfig &run, std::vector<Phase> &phases, std::string &error)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    Phase defaults;
+    bool threads_set = false;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line))
+    {
+        line_number++;
+        auto fail = [&](const std::string &message) {
+            error = path + ":" + std::to_string(line_number) + ": " + message;
+            return false;
+        };
+
+        line = line.substr(0, line.find('#'));
+        std::istringstream in(line);
+        std::string name;
+        if (!(in >> name))
+            continue; // Blank or comment
+        std::vector<std::string> values;
+        for (std::string value; in >> value;)
+            values.push_back(value);
+
+        if (name.front() == '[')
+        {
+            std::string phase_name = name.substr(1, name.size() - 2);
+            if (name.back() != ']' || !values.empty() || phase_name.empty() ||
+                phase_name.find_first_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-") !=
+                    std::string::npos)
+                return fail("expected [phase_name] (letters, digits, '_' and '-')");
+            for (const Phase &phase : phases)
+                if (phase.name == phase_name)
+                    return fail("phase " + phase_name + " appears twice");
+            phases.push_back(defaults);
+            phases.back().name = phase_name;
+            continue;
+        }
+
+        if (values.empty() || (values.size() > 1 && name != "rate"))
+            return fail("expected \"" + name + " <value>\"");
+        const std::string &value = values[0];
+        double number = 0;
+        uint64_t count = 0;
+
+        // Run-wide settings come before the first phase.
+        if (name == "threads" || name == "connections" || name == "key_space" || name == "protocol" ||
+            name == "pipeline_depth" || name == "verify")
+        {
+            if (!phases.empty())
+                return fail(name + " applies to the whole run: set it before the first phase");
+            if (name == "protocol")
+                run.protocol = value;
+            else if (name == "verify")
+            {
+                if (value != "yes" && value != "no")
+                    return fail("expected \"verify yes\" or \"verify no\"");
+                run.verify = value == "yes";
+            }
+            else if (!parseCount(value, count) || count > 100000000)
+                return fail("invalid " + name + ": " + value);
+            else if (name == "threads")
+            {
+                run.num_threads = static_cast<int>(count);
+                threads_set = true;
+            }
+            else if (name == "connections")
+                run.connections = static_cast<int>(count);
+            else if (name == "key_space")
+                run.key_space_size = static_cast<int>(count);
+            else
+                run.pipeline_depth = static_cast<int>(count);
+            continue;
+        }
+
+        Phase &phase = phases.empty() ? defaults : phases.back();
+        if (name == "workload")
+        {
+            if (!parseWorkload(value, phase.workload))
+                return fail("invalid workload: " + value);
+            phase.workload_name = value;
+        }
+        else if (name == "duration")
+        {
+            if (!parseCount(value, count) || count > static_cast<uint64_t>(kUnlimitedDurationSec))
+                return fail("invalid duration: " + value);
+            phase.duration_sec = static_cast<int>(count);
+        }
+        else if (name == "requests")
+        {
+            if (!parseCount(value, phase.requests))
+                return fail("invalid request count: " + value);
+        }
+        else if (name == "rate")
+        {
+            double end_rate = 0;
+            if (values.size() > 2 || !parseNumber(value, number) || number < 0 ||
+                (values.size() == 2 && !parseNumber(values[1], end_rate)))
+                return fail("expected \"rate <req/sec>\" or \"rate <start> <end>\"");
+            phase.rate = number;
+            phase.end_rate = values.size() == 2 ? end_rate : number;
+        }
+        else if (name == "arrivals")
+            phase.arrivals = value;
+        else if (name == "measure")
+        {
+            if (value != "yes" && value != "no")
+                return fail("expected \"measure yes\" or \"measure no\"");
+            phase.measured = value == "yes";
+        }
+        else if (name == "keys")
+            phase.keys = value;
+        else if (name == "mix")
+            phase.mix = value;
+        else if (name == "value_size")
+            phase.value_size = value;
+        else if (name == "compressibility")
+        {
+            if (!parseNumber(value, phase.compressibility))
+                return fail("invalid compressibility: " + value);
+        }
+        else if (name == "trace")
+            phase.trace = value;
+        else if (name == "speed")
+        {
+            if (!parseNumber(value, phase.speed))
+                return fail("invalid speed: " + value);
+        }
+        else
+            return fail("unknown setting: " + name);
+    }
+
+    // A default mix only concerns the MIXED phases.
+    for (Phase &phase : phases)
+        if (phase.workload != MIXED && phase.mix == defaults.mix)
+            phase.mix.clear();
+
+    if (!threads_set || run.num_threads < 1)
+        error = path + ": the number of threads is required (\"threads N\")";
+    else if (phases.empty())
+        error = path + " has no phases";
+    else
+        return true;
+    return false;
+}
+
+/**
+ * @brief Checks a phase's settings against the run's without applying
+ *        them, so that a scenario's mistakes show before its first phase.
+ *        Fills in the phase's loop and pipeline depth.
+ *
+ * @return false, with 'error' set, if the phase cannot run.
+ */
+bool checkPhase(Phase &phase, const RunConfig &run, std::string &error)
+{
+    bool binary = run.protocol == "binary";
+    phase.open_loop = phase.rate > 0 || phase.workload == REPLAY;
+    phase.pipeline_depth = run.pipeline_depth > 0 ? run.pipeline_depth : (binary ? 16 : (phase.open_loop ? 64 : 1));
+
+    if (phase.open_loop && binary)
+        error = "Open-loop mode supports http only";
+    else if (phase.arrivals != "poisson" && phase.arrivals != "uniform")
+        error = "Invalid arrivals: " + phase.arrivals;
+    else if (phase.end_rate != phase.rate && (phase.rate <= 0 || phase.end_rate <= 0))
+        error = "A ramp's start and end rates must both be above 0";
+    else if (phase.end_rate != phase.rate && phase.duration_sec <= 0)
+        error = "A ramp needs a duration";
+    else if (phase.duration_sec <= 0 && phase.requests == 0 && phase.workload != REPLAY)
+        error = "A phase needs a duration or a number of requests";
+    else if (!phase.mix.empty() && phase.workload != MIXED)
+        error = "--mix applies to the MIXED workload only";
+    else if (!phase.value_size.empty() && phase.workload == REPLAY)
+        error = "--value-size does not apply to REPLAY: the trace has the value sizes";
+    else if (phase.compressibility < 0 || phase.compressibility > 1)
+        error = "Compressibility must be between 0 and 1";
+    if (!error.empty())
+        return false;
+
+    std::string spec_error;
+    std::vector<double> weights;
+    if (!KeyDistribution::parse(phase.keys, std::max(run.key_space_size, 0), spec_error))
+    {
+        error = "Invalid key distribution: " + spec_error;
+        return false;
+    }
+    if (!phase.mix.empty() && !parseMix(phase.mix, weights))
+    {
+        error = "Invalid operation mix: " + phase.mix + " (expected get:put:delete, e.g. 90:8:2)";
+        return false;
+    }
+    if (!phase.value_size.empty())
+    {
+        auto sizes = ValueSizeDistribution::parse(phase.value_size, spec_error);
+        if (!sizes)
+        {
+            error = "Invalid value sizes: " + spec_error;
+            return false;
+        }
+        if (binary && sizes->maxSize() > binproto::kMaxValueLength)
+        {
+            error = "The binary protocol carries values up to " + std::to_string(binproto::kMaxValueLength) + " bytes";
+            return false;
+        }
+    }
+    if (phase.workload == REPLAY)
+    {
+        reqtrace::Reader reader;
+        if (phase.trace.empty())
+            error = "REPLAY needs a trace: --trace <file>";
+        else if (phase.rate > 0 || phase.speed <= 0)
+            error = "REPLAY sends at the trace's own rate; scale it with --speed (> 0)";
+        else if (!reader.open(phase.trace, spec_error))
+            error = "Invalid trace: " + spec_error;
+        return error.empty();
+    }
+    return true;
+}
+
+/**
+ * @brief Sets the globals the client threads read up for a checked phase:
+ *        key distribution, operation mix, value sizes and payloads, and
+ *        for REPLAY each thread's share of the trace.
+ *
+ * @return false, with 'error' set, if the trace has no requests.
+ */
+bool applyPhase(Phase &phase, const RunConfig &run, std::string &error)
+{
+    std::string spec_error;
+    g_keys = KeyDistribution::parse(phase.keys, std::max(run.key_space_size, 0), spec_error);
+    g_operation_mix = {1, 1, 1};
+    if (!phase.mix.empty())
+        parseMix(phase.mix, g_operation_mix);
+    g_value_sizes.reset();
+    g_payloads.reset();
+    g_replay.clear();
+    g_replay_speed = phase.speed;
+
+    if (!phase.value_size.empty())
+    {
+        g_value_sizes = ValueSizeDistribution::parse(phase.value_size, spec_error);
+        // Generated once, before the clock starts
+        g_payloads = std::make_unique<PayloadPool>(g_value_sizes->maxSize(), phase.compressibility);
+    }
+
+    // REPLAY: load the whole trace and deal it out to the threads round-robin
+    if (phase.workload == REPLAY)
+    {
+        reqtrace::Reader reader;
+        if (!reader.open(phase.trace, spec_error))
+        {
+            error = "Invalid trace: " + spec_error;
+            return false;
+        }
+        phase.replay_sample_rate = reader.header().sample_ppm / 1e6;
+
+        std::vector<ReplayRequest> requests;
+        uint32_t max_put_size = 0;
+        reqtrace::Record record;
+        while (reader.next(record))
+        {
+            Operation op;
+            if (record.op == reqtrace::Op::Get)
+                op = OP_GET;
+            else if (record.op == reqtrace::Op::Put)
+                op = OP_PUT;
+            else if (record.op == reqtrace::Op::Delete)
+                op = OP_DELETE;
+            else
+                continue;
+            if (op == OP_PUT)
+                max_put_size = std::max(max_put_size, record.value_size);
+            requests.push_back({record.timestamp_ns, op, std::move(record.key), record.value_size});
+        }
+        if (requests.empty())
+        {
+            error = "The trace " + phase.trace + " has no requests";
+            return false;
+        }
+
+        // Threads record concurrently, so the file is only nearly in time order.
+        std::stable_sort(requests.begin(), requests.end(),
+                         [](const ReplayRequest &a, const ReplayRequest &b) { return a.offset_ns < b.offset_ns; });
+        uint64_t first = requests.front().offset_ns;
+        g_replay.resize(run.num_threads);
+        for (size_t i = 0; i < requests.size(); i++)
+        {
+            requests[i].offset_ns -= first;
+            g_replay[i % run.num_threads].push_back(std::move(requests[i]));
+        }
+        phase.replay_count = requests.size();
+        phase.replay_span_ns = requests.back().offset_ns;
+
+        // Duration 0: the whole trace
+        if (phase.duration_sec <= 0)
+            phase.duration_sec = static_cast<int>(phase.replay_span_ns / phase.speed / 1e9) + 1;
+
+        // Values larger than this are sent cut short rather than holding the whole size in memory.
+        constexpr uint32_t kMaxReplayValue = 64 * 1024 * 1024;
+        g_payloads = std::make_unique<PayloadPool>(std::min(max_put_size, kMaxReplayValue), phase.compressibility);
+    }
+    return true;
+}
+
+/**
+ * @brief Prints a phase's configuration (the whole configuration of a plain run).
+ */
+void printConfiguration(const RunConfig &run, const Phase &phase)
+{
+    std::cout << "=== Load Generator Configuration ===" << std::endl;
+    if (!phase.name.empty())
+        std::cout << "Phase: " << phase.name << (phase.measured ? "" : " (warm-up, not measured)") << std::endl;
+    std::cout << "Target: " << run.host << ":" << run.port << std::endl;
+    std::cout << "Workload: " << phase.workload_name << std::endl;
+    std::cout << "Threads: " << run.num_threads << std::endl;
+    std::cout << "Connections: " << run.connections << std::endl;
+    if (phase.duration_sec > 0)
+        std::cout << "Duration: " << phase.duration_sec << " seconds" << std::endl;
+    if (phase.requests > 0)
+        std::cout << "Requests: " << phase.requests << std::endl;
+    std::cout << "Key Space Size: " << run.key_space_size << std::endl;
+    if (phase.workload == REPLAY)
+        std::cout << "Trace: " << phase.trace << " (" << phase.replay_count << " requests over "
+                  << phase.replay_span_ns / 1e9 << " s, " << phase.replay_sample_rate * 100 << "% sampled), speed "
+                  << phase.speed << "x" << std::endl;
+    else if (phase.workload == GET_POPULAR)
+        std::cout << "Key Distribution: 10 popular keys" << std::endl;
+    else
+        std::cout << "Key Distribution: " << g_keys->describe() << std::endl;
+    if (phase.workload == MIXED)
+        std::cout << "Operation Mix (GET:PUT:DELETE): " << (phase.mix.empty() ? "1:1:1" : phase.mix) << std::endl;
+    if (phase.workload == REPLAY)
+        std::cout << "Value Sizes: as traced (compressibility " << phase.compressibility << ")" << std::endl;
+    else if (g_value_sizes)
+        std::cout << "Value Sizes: " << g_value_sizes->describe() << " bytes (compressibility "
+                  << phase.compressibility << ")" << std::endl;
+    else
+        std::cout << "Value Sizes: short strings" << std::endl;
+    std::cout << "Protocol: " << run.protocol << std::endl;
+    std::cout << "Pipeline Depth: " << phase.pipeline_depth << std::endl;
+    if (run.verify)
+        std::cout << "Verification: " << (verifies(phase.workload) ? "every GET" : "none for this workload")
+                  << std::endl;
+    if (phase.workload == REPLAY)
+        std::cout << "Target Rate: as traced (open loop)" << std::endl;
+    else if (phase.end_rate != phase.rate)
+        std::cout << "Target Rate: " << phase.rate << " rising to " << phase.end_rate << " req/sec (open loop, "
+                  << phase.arrivals << " arrivals)" << std::endl;
+    else if (phase.open_loop)
+        std::cout << "Target Rate: " << phase.rate << " req/sec (open loop, " << phase.arrivals << " arrivals)"
+                  << std::endl;
+    else
+        std::cout << "Target Rate: none (closed loop)" << std::endl;
+    std::cout << "====================================\n"
+              << std::endl;
+}
+
+/**
+ * @brief Writes the ten keys GET_POPULAR reads, pipelined on one connection.
+ */
+void prepopulatePopularKeys(const RunConfig &run)
+{
+    std::cout << "Pre-populating popular keys..." << std::endl;
+    if (run.protocol == "binary")
+    {
+        // All ten PUTs in one write; wait until every one is acknowledged.
+        BinaryClient populate;
+        if (populate.connect(run.host, run.port))
+        {
+            for (int i = 1; i <= 10; i++)
+                populate.sendPut("popular_key_" + std::to_string(i), "popular_value_" + std::to_string(i));
+            BinaryClient::Response response;
+            bool ok = populate.flush();
+            for (int i = 1; i <= 10 && ok; i++)
+                ok = populate.receive(response);
+        }
+    }
+    else
+    {
+        // Likewise, pipelined on one keep-alive connection.
+        HttpClient populate;
+        if (populate.connect(run.host, run.port))
+        {
+            for (int i = 1; i <= 10; i++)
+            {
+                std::ostringstream body;
+                body << "{\"key\":\"popular_key_" << i << "\",\"value\":\"popular_value_" << i << "\"}";
+                std::string request = "POST /api/kv HTTP/1.1\r\n";
+                request += "Host: " + run.host + "\r\n";
+                request += "Content-Type: application/json\r\n";
+                request += "Content-Length: " + std::to_string(body.str().length()) + "\r\n";
+                request += "\r\n" + body.str();
+                populate.queue(request);
+            }
+            HttpClient::Response response;
+            bool ok = populate.flush();
+            for (int i = 1; i <= 10 && ok; i++)
+                ok = populate.receive(response);
+        }
+    }
+    std::cout << "Pre-population complete.\n"
+              << std::endl;
+}
+
+/**
+ * @brief Runs an applied phase on fresh statistics and merges what every thread recorded.
+ */
+PhaseResults runPhase(const RunConfig &run, const Phase &phase)
+{
+    g_client_stats.clear();
+    g_client_stats.resize(run.num_threads);
+    g_timeseries.clear();
+    g_request_limited = phase.requests > 0;
+    g_requests_left = static_cast<int64_t>(std::min<uint64_t>(phase.requests, INT64_MAX));
+    int duration_sec = phase.duration_sec > 0 ? phase.duration_sec : kUnlimitedDurationSec;
+    bool binary = run.protocol == "binary";
+
+    std::vector<std::thread> threads;
+    std::cout << "Starting load test..." << std::endl;
+    g_test_start = std::chrono::steady_clock::now();
+
+    // Launch multiple client threads
+    for (int i = 0; i < run.num_threads; i++)
+    {
+        // The connections, and an open loop's rate, are shared out evenly.
+        int connections = run.connections / run.num_threads + (i < run.connections % run.num_threads ? 1 : 0);
+        double share = static_cast<double>(connections) / run.connections;
+        if (binary)
+            threads.emplace_back(binaryClientThread, i, run.host, run.port, phase.workload, duration_sec,
+                                 phase.pipeline_depth);
+        else
+            threads.emplace_back(httpClientThread, i, run.host, run.port, phase.workload, duration_sec, connections,
+                                 phase.pipeline_depth, phase.rate * share, phase.end_rate * share,
+                                 phase.arrivals == "poisson");
+    }
 
     // Wait for all threads to complete
     for (auto &t : threads)
@@ -368,31 +1766,505 @@ int main(int argc, char *argv[])
         t.join();
     }
 
-    auto test_end = std::chrono::steady_clock::now();
-    auto actual_duration = std::chrono::duration_cast<std::chrono::seconds>(test_end - test_start).count();
+    PhaseResults results;
+    results.duration_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - g_test_start).count();
 
     // Aggregate statistics from all threads
-    uint64_t total_sent = 0, total_succeeded = 0, total_failed = 0, total_latency = 0;
     for (const auto &stats : g_client_stats)
     {
-        total_sent += stats.requests_sent;
-        total_succeeded += stats.requests_succeeded;
-        total_failed += stats.requests_failed;
-        total_latency += stats.total_latency_ms;
+        results.max_latency_us = std::max(results.max_latency_us, stats.max_latency_us);
+        results.max_send_lag_us = std::max(results.max_send_lag_us, stats.max_send_lag_us);
+        results.sent += stats.requests_sent;
+        results.succeeded += stats.requests_succeeded;
+        results.failed += stats.requests_failed;
+        results.total_latency_us += stats.total_latency_us;
+        results.reconnects += stats.reconnects;
     }
 
-    // Print performance summary
+    // Merge the latency histograms into the reported operations: GET hits and
+    // misses count as GETs too, and everything as ALL
+    enum { ROW_GET, ROW_GET_HIT, ROW_GET_MISS, ROW_PUT, ROW_DELETE, ROW_ALL, ROW_COUNT };
+    const char *row_names[ROW_COUNT] = {"GET", "GET_HIT", "GET_MISS", "PUT", "DELETE", "ALL"};
+    std::vector<LatencySummary> &latencies = results.latencies;
+    latencies.resize(ROW_COUNT);
+    for (int row = 0; row < ROW_COUNT; row++)
+        latencies[row].name = row_names[row];
+    for (const auto &stats : g_client_stats)
+    {
+        for (int kind = 0; kind < KIND_COUNT; kind++)
+        {
+            std::vector<int> rows = {ROW_ALL};
+            if (kind == KIND_GET_HIT || kind == KIND_GET_MISS || kind == KIND_GET_OTHER)
+                rows.push_back(ROW_GET);
+            if (kind == KIND_GET_HIT)
+                rows.push_back(ROW_GET_HIT);
+            else if (kind == KIND_GET_MISS)
+                rows.push_back(ROW_GET_MISS);
+            else if (kind == KIND_PUT)
+                rows.push_back(ROW_PUT);
+            else if (kind == KIND_DELETE)
+                rows.push_back(ROW_DELETE);
+            for (int row : rows)
+            {
+                latencies[row].latency.merge(stats.latency[kind]);
+                latencies[row].errors += stats.errors[kind];
+            }
+        }
+    }
+    // Only report what the workload did
+    latencies.erase(std::remove_if(latencies.begin(), latencies.end(),
+                                   [](const LatencySummary &summary) {
+                                       return summary.latency.empty() && summary.errors == 0;
+                                   }),
+                    latencies.end());
+
+    if (verifies(phase.workload))
+    {
+        results.verified = true;
+        results.verification = g_verifier->takeReport();
+    }
+    return results;
+}
+
+/**
+ * @brief Prints a phase's results: totals, percentiles and time series.
+ */
+void printResults(const Phase &phase, const PhaseResults &results)
+{
+    double throughput = results.duration_sec > 0 ? results.succeeded / results.duration_sec : 0;
+
     std::cout << "\n=== Load Test Results ===" << std::endl;
-    std::cout << "Actual Duration: " << actual_duration << " seconds" << std::endl;
-    std::cout << "Total Requests Sent: " << total_sent << std::endl;
-    std::cout << "Successful Requests: " << total_succeeded << std::endl;
-    std::cout << "Failed Requests: " << total_failed << std::endl;
-    std::cout << "Success Rate: " << (total_sent > 0 ? (double)total_succeeded / total_sent * 100.0 : 0) << "%" << std::endl;
+    if (!phase.name.empty())
+        std::cout << "Phase: " << phase.name << std::endl;
+    std::cout << "Actual Duration: " << static_cast<int64_t>(results.duration_sec) << " seconds" << std::endl;
+    std::cout << "Total Requests Sent: " << results.sent << std::endl;
+    std::cout << "Successful Requests: " << results.succeeded << std::endl;
+    std::cout << "Failed Requests: " << results.failed << std::endl;
+    std::cout << "Reconnects: " << results.reconnects << std::endl;
+    std::cout << "Success Rate: " << (results.sent > 0 ? (double)results.succeeded / results.sent * 100.0 : 0) << "%" << std::endl;
     std::cout << "\n--- Performance Metrics ---" << std::endl;
-    std::cout << "Average Throughput: " << (actual_duration > 0 ? (double)total_succeeded / actual_duration : 0) << " req/sec" << std::endl;
-    std::cout << "Average Response Time: " << (total_succeeded > 0 ? (double)total_latency / total_succeeded : 0) << " ms" << std::endl;
-    std::cout << "=========================\n"
-              << std::endl;
+    std::cout << "Average Throughput: " << throughput << " req/sec" << std::endl;
+    std::cout << "Average Response Time: " << (results.succeeded > 0 ? (double)results.total_latency_us / results.succeeded / 1000.0 : 0) << " ms" << std::endl;
+    std::cout << "Max Response Time: " << results.max_latency_us / 1000.0 << " ms" << std::endl;
+    if (phase.open_loop)
+    {
+        // Response times count from the scheduled send time. A large lag means
+        // the generator itself (or the in-flight limit) held requests back.
+        std::cout << "Max Send Lag: " << results.max_send_lag_us / 1000.0 << " ms" << std::endl;
+    }
+
+    // Percentiles per operation; GET_HIT and GET_MISS split GETs by the
+    // server's X-Cache header
+    std::cout << "\n--- Latency Percentiles (ms) ---" << std::endl;
+    std::cout << std::left << std::setw(10) << "Operation" << std::right << std::setw(10) << "Count"
+              << std::setw(8) << "Errors";
+    for (const auto &percentile : kReportedPercentiles)
+        std::cout << std::setw(10) << percentile.name;
+    std::cout << std::setw(10) << "max" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    for (const auto &summary : results.latencies)
+    {
+        std::cout << std::left << std::setw(10) << summary.name << std::right << std::setw(10)
+                  << summary.latency.count() << std::setw(8) << summary.errors;
+        for (const auto &percentile : kReportedPercentiles)
+            std::cout << std::setw(10) << summary.latency.valueAtPercentile(percentile.value) / 1e6;
+        std::cout << std::setw(10) << summary.latency.max() / 1e6 << std::endl;
+    }
+
+    std::cout << "\n--- Time Series (per second) ---" << std::endl;
+    std::cout << std::setw(6) << "Second" << std::setw(10) << "Requests" << std::setw(8) << "Errors"
+              << std::setw(10) << "mean" << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10)
+              << "max" << std::endl;
+    for (size_t second = 0; second < g_timeseries.size(); second++)
+    {
+        const SecondStats &point = g_timeseries[second];
+        std::cout << std::setw(6) << second << std::setw(10) << point.latency.count() << std::setw(8)
+                  << point.errors << std::setw(10) << point.latency.mean() / 1e6 << std::setw(10)
+                  << point.latency.valueAtPercentile(50) / 1e6 << std::setw(10)
+                  << point.latency.valueAtPercentile(99) / 1e6 << std::setw(10) << point.latency.max() / 1e6
+                  << std::endl;
+    }
+    std::cout << std::defaultfloat << std::setprecision(6);
 
+    if (results.verified)
+    {
+        const ConsistencyChecker::Report &report = results.verification;
+        std::cout << "\n--- Verification ---" << std::endl;
+        std::cout << "Reads Checked: " << report.reads_checked << " (" << report.reads_unresolved
+                  << " unresolved)" << std::endl;
+        std::cout << "Writes Acknowledged: " << report.writes_acknowledged << std::endl;
+        std::cout << "Anomalies: " << report.totalAnomalies() << std::endl;
+        for (int anomaly = 0; anomaly < static_cast<int>(ConsistencyChecker::Anomaly::Count); anomaly++)
+        {
+            if (report.anomalies[anomaly] > 0)
+                std::cout << "  " << ConsistencyChecker::anomalyName(static_cast<ConsistencyChecker::Anomaly>(anomaly))
+                          << ": " << report.anomalies[anomaly] << std::endl;
+        }
+        for (const std::string &example : report.examples)
+            std::cout << "  " << example << std::endl;
+    }
+}
+
+/**
+ * @brief Writes a phase's results files (see writeResults()).
+ */
+bool writePhaseResults(const std::string &prefix, const RunConfig &run, const Phase &phase,
+                       const PhaseResults &results)
+{
+    return writeResults(prefix, results.latencies, [&](std::ostream &json) {
+        json << "  \"config\": {\"host\": \"" << run.host << "\", \"port\": " << run.port << ", \"phase\": \""
+             << phase.name << "\", \"workload\": \"" << phase.workload_name << "\", \"threads\": " << run.num_threads
+             << ", \"connections\": " << run.connections
+             << ", \"duration_sec\": " << phase.duration_sec << ", \"requests\": " << phase.requests
+             << ", \"key_space_size\": " << run.key_space_size << ", \"keys\": \""
+             << (phase.workload == GET_POPULAR ? "popular" : g_keys->describe()) << "\", \"mix\": \""
+             << (phase.workload == MIXED ? (phase.mix.empty() ? "1:1:1" : phase.mix) : "")
+             << "\", \"value_size\": \"" << phase.value_size << "\", \"compressibility\": " << phase.compressibility
+             << ", \"trace\": \"" << phase.trace << "\", \"speed\": " << phase.speed << ", \"protocol\": \""
+             << run.protocol << "\", \"pipeline_depth\": " << phase.pipeline_depth
+             << ", \"target_rps\": " << phase.rate << ", \"end_rps\": " << phase.end_rate << ", \"arrivals\": \""
+             << (phase.open_loop ? phase.arrivals : "closed") << "\"},\n";
+        json << "  \"summary\": {\"duration_sec\": " << results.duration_sec
+             << ", \"requests_sent\": " << results.sent << ", \"succeeded\": " << results.succeeded
+             << ", \"failed\": " << results.failed << ", \"reconnects\": " << results.reconnects
+             << ", \"throughput_rps\": " << (results.duration_sec > 0 ? results.succeeded / results.duration_sec : 0)
+             << ", \"max_send_lag_us\": " << results.max_send_lag_us << "},\n";
+        if (results.verified)
+        {
+            const ConsistencyChecker::Report &report = results.verification;
+            json << "  \"verification\": {\"reads_checked\": " << report.reads_checked
+                 << ", \"reads_unresolved\": " << report.reads_unresolved
+                 << ", \"writes_acknowledged\": " << report.writes_acknowledged
+                 << ", \"anomalies\": " << report.totalAnomalies();
+            for (int anomaly = 0; anomaly < static_cast<int>(ConsistencyChecker::Anomaly::Count); anomaly++)
+            {
+                std::string name = ConsistencyChecker::anomalyName(static_cast<ConsistencyChecker::Anomaly>(anomaly));
+                std::replace(name.begin(), name.end(), ' ', '_');
+                json << ", \"" << name << "\": " << report.anomalies[anomaly];
+            }
+            json << "},\n";
+        }
+    });
+}
+
+/**
+ * @brief Prints command-line usage information.
+ */
+void printUsage(const char *prog_name)
+{
+    std::cout << "Usage: " << prog_name << " <host> <port> <workload> <num_threads> <duration_sec> [key_space_size] [protocol] [pipeline_depth] [target_rps] [arrivals] [options]" << std::endl;
+    std::cout << "       " << prog_name << " <host> <port> --scenario <file> [--connections <n>] [--verify] [--results <prefix>]" << std::endl;
+    std::cout << "Workload types: PUT_ALL, GET_ALL, GET_POPULAR, MIXED, REPLAY" << std::endl;
+    std::cout << "Protocols: http (default), binary" << std::endl;
+    std::cout << "Pipeline depth: requests in flight per thread and connection (default: 1 for http, 16 for binary, 64 in open loop)" << std::endl;
+    std::cout << "Target RPS: 0 (default) runs closed loop, each thread sending when a response arrives; otherwise" << std::endl;
+    std::cout << "            requests are sent on a fixed schedule at this total rate (open loop, http only)" << std::endl;
+    std::cout << "Arrivals (open loop): poisson (default) or uniform" << std::endl;
+    std::cout << "Host: an IPv4 address, or unix:<path> for the server's Unix domain socket (HTTP only; port is ignored)" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --keys <distribution>  uniform (default), zipfian[:theta], scrambled[:theta], hotspot[:ops:keys]," << std::endl;
+    std::cout << "                         latest[:theta] or sequential (theta defaults to 0.99, hotspot to 0.9:0.1)" << std::endl;
+    std::cout << "  --mix <get:put:delete> Relative weights of the MIXED operations (default 1:1:1)" << std::endl;
+    std::cout << "  --value-size <sizes>   Value sizes in bytes: N, uniform:MIN:MAX, pareto:MIN:ALPHA[:MAX] or" << std::endl;
+    std::cout << "                         file:PATH (lines of \"size weight\"); default: short strings" << std::endl;
+    std::cout << "  --compressibility <f>  Fraction (0-1) of each sized value deflate can remove (default 0)" << std::endl;
+    std::cout << "  --trace <file>         REPLAY: request trace recorded by the server (TRACE_FILE)" << std::endl;
+    std::cout << "  --speed <factor>       REPLAY: send this many times faster than recorded (default 1);" << std::endl;
+    std::cout << "                         a duration of 0 replays the whole trace" << std::endl;
+    std::cout << "  --connections <n>      Simulated clients (HTTP connections), spread over the threads; each" << std::endl;
+    std::cout << "                         thread drives its share from one epoll loop (default: one per thread)" << std::endl;
+    std::cout << "  --verify               Tag every PUT's value and check each GET against the writes before it;" << std::endl;
+    std::cout << "                         reports stale, lost and foreign values, and exits with 2 if there were any" << std::endl;
+    std::cout << "  --scenario <file>      Run the phases of a scenario file (threads, rates, workloads and" << std::endl;
+    std::cout << "                         distributions per phase) instead of one workload" << std::endl;
+    std::cout << "  --results <prefix>     Write <prefix>.json, <prefix>_latency.csv and <prefix>_timeseries.csv;" << std::endl;
+    std::cout << "                         for a scenario, <prefix>_<phase>.* per measured phase and <prefix>_phases.csv" << std::endl;
+    std::cout << "Example: " << prog_name << " localhost 8080 GET_POPULAR 10 60 10000" << std::endl;
+    std::cout << "Example: " << prog_name << " localhost 8080 GET_POPULAR 4 60 10000 http 64 20000 poisson" << std::endl;
+    std::cout << "Example: " << prog_name << " localhost 8080 REPLAY 4 0 --trace kv.trace --speed 2" << std::endl;
+    std::cout << "Example: " << prog_name << " localhost 8080 MIXED 4 60 100000 --connections 2000" << std::endl;
+    std::cout << "Example: " << prog_name << " localhost 8080 MIXED 4 60 1000 --keys zipfian --connections 200 --verify" << std::endl;
+    std::cout << "Example: " << prog_name << " localhost 8080 --scenario scenarios/peak_hour.scenario --results results/peak" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    // Options ("--name value") may appear anywhere; the rest are positional.
+    // A plain run is one phase, configured by the command line.
+    std::vector<std::string> args;
+    std::string results_prefix;
+    std::string scenario_path;
+    int connections = 0;
+    bool verify = false;
+    Phase single;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0)
+        {
+            args.push_back(arg);
+            continue;
+        }
+        if (arg == "--verify")
+        {
+            verify = true; // The only option without a value
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+        if (arg == "--results")
+            results_prefix = argv[++i];
+        else if (arg == "--keys")
+            single.keys = argv[++i];
+        else if (arg == "--mix")
+            single.mix = argv[++i];
+        else if (arg == "--value-size")
+            single.value_size = argv[++i];
+        else if (arg == "--compressibility")
+            single.compressibility = std::stod(argv[++i]);
+        else if (arg == "--trace")
+            single.trace = argv[++i];
+        else if (arg == "--speed")
+            single.speed = std::stod(argv[++i]);
+        else if (arg == "--scenario")
+            scenario_path = argv[++i];
+        else if (arg == "--connections")
+            connections = std::stoi(argv[++i]);
+        else
+        {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Ensure minimum required arguments are provided
+    if ((scenario_path.empty() && args.size() < 5) || (!scenario_path.empty() && args.size() != 2))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // Parse command-line arguments
+    RunConfig run;
+    run.host = args[0];
+    run.port = std::stoi(args[1]);
+    std::vector<Phase> phases;
+    if (!scenario_path.empty())
+    {
+        std::string scenario_error;
+        if (!loadScenario(scenario_path, run, phases, scenario_error))
+        {
+            std::cerr << "Invalid scenario: " << scenario_error << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        single.workload_name = args[2];
+        run.num_threads = std::stoi(args[3]);
+        single.duration_sec = std::stoi(args[4]);
+        run.key_space_size = (args.size() > 5) ? std::stoi(args[5]) : 10000;
+        run.protocol = (args.size() > 6) ? args[6] : "http";
+        run.pipeline_depth = (args.size() > 7) ? std::max(std::stoi(args[7]), 1) : 0;
+        single.rate = single.end_rate = (args.size() > 8) ? std::stod(args[8]) : 0;
+        single.arrivals = (args.size() > 9) ? args[9] : "poisson";
+
+        // Map string to workload type enum
+        if (!parseWorkload(single.workload_name, single.workload))
+        {
+            std::cerr << "Invalid workload type: " << single.workload_name << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+        // The positional duration is the whole run, so a replay of 0 seconds plays the whole trace.
+        if (single.duration_sec <= 0 && single.workload != REPLAY)
+        {
+            std::cerr << "The duration must be at least 1 second" << std::endl;
+            return 1;
+        }
+        phases.push_back(single);
+    }
+
+    bool binary = run.protocol == "binary";
+    if (!binary && run.protocol != "http")
+    {
+        std::cerr << "Invalid protocol: " << run.protocol << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (binary && run.host.compare(0, HttpClient::kUnixPrefix.size(), HttpClient::kUnixPrefix) == 0)
+    {
+        std::cerr << "The Unix domain socket serves HTTP only" << std::endl;
+        return 1;
+    }
+    if (run.num_threads < 1)
+    {
+        std::cerr << "At least one thread is needed" << std::endl;
+        return 1;
+    }
+    if (connections > 0)
+        run.connections = connections; // Overrides the scenario's
+    run.verify = run.verify || verify;
+    if (run.connections <= 0)
+        run.connections = run.num_threads;
+    if (run.connections < run.num_threads)
+    {
+        std::cerr << "Every thread needs a connection: use at most " << run.connections << " threads" << std::endl;
+        return 1;
+    }
+    if (binary && run.connections != run.num_threads)
+    {
+        std::cerr << "The binary protocol uses one connection per thread" << std::endl;
+        return 1;
+    }
+
+    // Every connection is a descriptor: allow as many as the hard limit does.
+    struct rlimit files;
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur < files.rlim_max)
+    {
+        files.rlim_cur = files.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &files);
+    }
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur != RLIM_INFINITY &&
+        static_cast<rlim_t>(run.connections) + 2 * run.num_threads + 16 > files.rlim_cur)
+    {
+        std::cerr << run.connections << " connections need more file descriptors than the limit of "
+                  << files.rlim_cur << " (ulimit -n)" << std::endl;
+        return 1;
+    }
+
+    // Check every phase before running the first.
+    for (Phase &phase : phases)
+    {
+        std::string phase_error;
+        if (!checkPhase(phase, run, phase_error))
+        {
+            if (!phase.name.empty())
+                std::cerr << "Phase " << phase.name << ": ";
+            std::cerr << phase_error << std::endl;
+            return 1;
+        }
+    }
+    if (!scenario_path.empty())
+        std::cout << "=== Scenario: " << scenario_path << " (" << phases.size() << " phases) ===\n"
+                  << std::endl;
+
+    // Scenario: what each measured phase did, for the summary
+    std::vector<std::pair<const Phase *, PhaseResults>> measured;
+    uint64_t anomalies = 0; // Every phase's, measured or not
+    if (run.verify)
+        g_verifier = std::make_unique<ConsistencyChecker>(std::chrono::steady_clock::now());
+    for (Phase &phase : phases)
+    {
+        std::string phase_error;
+        if (!applyPhase(phase, run, phase_error))
+        {
+            std::cerr << phase_error << std::endl;
+            return 1;
+        }
+        printConfiguration(run, phase);
+
+        // Preload popular keys into server for GET_POPULAR workload
+        if (phase.workload == GET_POPULAR)
+            prepopulatePopularKeys(run);
+
+        PhaseResults results = runPhase(run, phase);
+        anomalies += results.verification.totalAnomalies();
+        if (!phase.measured)
+        {
+            std::cout << "Warm-up " << phase.name << " finished: " << results.sent << " requests in "
+                      << static_cast<int64_t>(results.duration_sec) << " seconds (not measured)";
+            if (results.verified)
+                std::cout << ", " << results.verification.totalAnomalies() << " anomalies";
+            std::cout << "\n"
+                      << std::endl;
+            continue;
+        }
+        printResults(phase, results);
+
+        if (!results_prefix.empty())
+        {
+            std::string prefix = phase.name.empty() ? results_prefix : results_prefix + "_" + phase.name;
+            if (!writePhaseResults(prefix, run, phase, results))
+            {
+                std::cerr << "Cannot write results to " << prefix << "*" << std::endl;
+                return 1;
+            }
+            std::cout << "\nResults written to " << prefix << ".json, " << prefix << "_latency.csv and " << prefix
+                      << "_timeseries.csv" << std::endl;
+        }
+        std::cout << "=========================\n"
+                  << std::endl;
+        if (!scenario_path.empty())
+            measured.emplace_back(&phase, std::move(results));
+    }
+
+    if (!scenario_path.empty())
+    {
+        // One line per measured phase: totals, and percentiles of all its requests
+        std::ofstream csv;
+        if (!results_prefix.empty())
+        {
+            csv.open(results_prefix + "_phases.csv");
+            csv << std::fixed << std::setprecision(3)
+                << "phase,workload,duration_sec,requests_sent,succeeded,failed,throughput_rps,p50_us,p99_us,"
+                   "p99.9_us,max_us\n";
+        }
+        std::cout << "=== Scenario Summary (latencies in ms) ===" << std::endl;
+        std::cout << std::left << std::setw(16) << "Phase" << std::right << std::setw(10) << "Seconds"
+                  << std::setw(12) << "Requests" << std::setw(8) << "Errors" << std::setw(12) << "req/sec"
+                  << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(10)
+                  << "max" << std::endl;
+        std::cout << std::fixed << std::setprecision(3);
+        for (const auto &entry : measured)
+        {
+            const Phase &phase = *entry.first;
+            const PhaseResults &results = entry.second;
+            LatencyHistogram all;
+            for (const auto &summary : results.latencies)
+                if (summary.name == "ALL")
+                    all.merge(summary.latency);
+            double throughput = results.duration_sec > 0 ? results.succeeded / results.duration_sec : 0;
+            double percentiles[] = {all.valueAtPercentile(50) / 1000.0, all.valueAtPercentile(99) / 1000.0,
+                                    all.valueAtPercentile(99.9) / 1000.0, all.max() / 1000.0};
+
+            std::cout << std::left << std::setw(16) << phase.name << std::right << std::setw(10)
+                      << results.duration_sec << std::setw(12) << results.sent << std::setw(8) << results.failed
+                      << std::setw(12) << throughput;
+            for (double value : percentiles)
+                std::cout << std::setw(10) << value / 1000;
+            std::cout << std::endl;
+
+            if (csv.is_open())
+            {
+                csv << phase.name << "," << phase.workload_name << "," << results.duration_sec << "," << results.sent
+                    << "," << results.succeeded << "," << results.failed << "," << throughput;
+                for (double value : percentiles)
+                    csv << "," << value;
+                csv << "\n";
+            }
+        }
+        std::cout << std::defaultfloat << std::setprecision(6);
+
+        if (!results_prefix.empty())
+        {
+            if (!csv.good())
+            {
+                std::cerr << "Cannot write results to " << results_prefix << "_phases.csv" << std::endl;
+                return 1;
+            }
+            std::cout << "\nPhase summary written to " << results_prefix << "_phases.csv" << std::endl;
+        }
+    }
+
+    if (anomalies > 0)
+    {
+        std::cerr << "Verification failed: " << anomalies << " anomalies" << std::endl;
+        return 2;
+    }
     return 0;
 }
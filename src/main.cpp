@@ -65,6 +65,18 @@ int main(int argc, char* argv[]) {
     int server_port = std::stoi(getEnv("SERVER_PORT", "8080"));           // Port on which the KV server will listen
     size_t cache_size = std::stoul(getEnv("CACHE_SIZE", "1000"));         // Cache capacity for in-memory key-value storage
     size_t thread_pool_size = std::stoul(getEnv("THREAD_POOL_SIZE", "8"));// Number of worker threads for handling requests
+    size_t compression_threshold = std::stoul(getEnv("COMPRESSION_THRESHOLD", "0")); // Min value size to compress (0 = off)
+    size_t large_value_threshold = std::stoul(getEnv("LARGE_VALUE_THRESHOLD", "1048576")); // Min value size kept in a memfd and sent with sendfile (0 = off)
+    int memcache_port = std::stoi(getEnv("MEMCACHE_PORT", "11211"));      // Port of the memcached text protocol (0 = off)
+    int resp_port = std::stoi(getEnv("RESP_PORT", "6379"));               // Port of the Redis protocol (0 = off)
+    int binary_port = std::stoi(getEnv("BINARY_PORT", "9090"));           // Port of the binary protocol (0 = off)
+    std::string unix_socket_path = getEnv("UNIX_SOCKET_PATH", "");        // Unix domain socket serving HTTP (empty = off)
+    mode_t unix_socket_mode = std::stoul(getEnv("UNIX_SOCKET_MODE", "660"), nullptr, 8); // Permissions of the socket file (octal)
+    std::string hot_table_name = getEnv("HOT_TABLE_NAME", "");            // Shared memory exporting hot entries, e.g. /kv_hot (empty = off)
+    size_t hot_table_slots = std::stoul(getEnv("HOT_TABLE_SLOTS", "4096")); // Entries (1 KiB slots) in the shared table
+    std::string trace_file = getEnv("TRACE_FILE", "");                    // Sampled request trace for load_generator replay (empty = off)
+    double trace_sample_rate = std::stod(getEnv("TRACE_SAMPLE_RATE", "0.01")); // Fraction of operations traced
+    bool trace_hash_keys = getEnv("TRACE_KEYS", "hash") != "full";        // Trace key hashes (hash) or the keys themselves (full)
     
     // ------------------------------
     // Display the loaded configuration
@@ -76,6 +88,14 @@ int main(int argc, char* argv[]) {
     std::cout << "Server Port: " << server_port << std::endl;
     std::cout << "Cache Size: " << cache_size << std::endl;
     std::cout << "Thread Pool Size: " << thread_pool_size << std::endl;
+    std::cout << "Compression Threshold: " << compression_threshold << std::endl;
+    std::cout << "Large Value Threshold: " << large_value_threshold << std::endl;
+    std::cout << "Memcached Port: " << memcache_port << std::endl;
+    std::cout << "RESP Port: " << resp_port << std::endl;
+    std::cout << "Binary Port: " << binary_port << std::endl;
+    std::cout << "Unix Socket: " << (unix_socket_path.empty() ? "off" : unix_socket_path) << std::endl;
+    std::cout << "Hot Table: " << (hot_table_name.empty() ? "off" : hot_table_name + " (" + std::to_string(hot_table_slots) + " slots)") << std::endl;
+    std::cout << "Request Trace: " << (trace_file.empty() ? "off" : trace_file + " (" + std::to_string(trace_sample_rate) + " sampled, " + (trace_hash_keys ? "hashed" : "full") + " keys)") << std::endl;
     std::cout << "================================\n" << std::endl;
     
     // ------------------------------
@@ -106,7 +126,14 @@ int main(int argc, char* argv[]) {
     // The server uses the given database connection for persistence.
     // g_server = new KVServer(server_port, cache_size, thread_pool_size, db);
     g_server = new KVServer(server_port, cache_size, thread_pool_size,
-                            db_host, db_port, db_name, db_user, db_password);
+                            db_host, db_port, db_name, db_user, db_password,
+                            compression_threshold, large_value_threshold);
+    g_server->setMemcachePort(memcache_port);
+    g_server->setRespPort(resp_port);
+    g_server->setBinaryPort(binary_port);
+    g_server->setUnixSocket(unix_socket_path, unix_socket_mode);
+    g_server->setHotTable(hot_table_name, hot_table_slots);
+    g_server->setTrace(trace_file, trace_sample_rate, trace_hash_keys);
     
     // Attempt to start the server.
     if (!g_server->start()) {
@@ -0,0 +1,197 @@
+#include "memcache_protocol.hpp" // Declarations of the memcached parser
+#include <charconv>              // For std::from_chars
+
+namespace memcache
+{
+    namespace
+    {
+        constexpr std::string_view kBadFormat = "CLIENT_ERROR bad command line format";
+
+        // Splits the next space-separated token off the front of 'line'.
+        std::string_view nextToken(std::string_view &line)
+        {
+            size_t start = line.find_first_not_of(' ');
+            if (start == std::string_view::npos)
+            {
+                line = {};
+                return {};
+            }
+            size_t end = line.find(' ', start);
+            std::string_view token = line.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+            line = end == std::string_view::npos ? std::string_view() : line.substr(end);
+            return token;
+        }
+
+        template <typename T>
+        bool parseNumber(std::string_view token, T &out)
+        {
+            if (token.empty())
+                return false;
+            auto result = std::from_chars(token.data(), token.data() + token.size(), out);
+            return result.ec == std::errc() && result.ptr == token.data() + token.size();
+        }
+
+        // Keys are at most 250 bytes and contain no whitespace or control characters.
+        bool validKey(std::string_view key)
+        {
+            if (key.empty() || key.size() > kMaxKeyLength)
+                return false;
+            for (char c : key)
+            {
+                if (static_cast<unsigned char>(c) <= ' ' || c == 0x7f)
+                    return false;
+            }
+            return true;
+        }
+
+        // Consumes an optional trailing "noreply"; false if anything else is left.
+        bool parseNoreply(std::string_view rest, bool &noreply)
+        {
+            std::string_view token = nextToken(rest);
+            noreply = token == "noreply";
+            return (token.empty() || noreply) && nextToken(rest).empty();
+        }
+    }
+
+    ParseStatus parse(std::string_view input, Request &request, size_t &consumed, std::string_view &error)
+    {
+        // Find the end of the command line; a bare "\n" is accepted like memcached does.
+        size_t newline = input.find('\n');
+        if (newline == std::string_view::npos || newline > kMaxLineLength)
+        {
+            if (newline == std::string_view::npos && input.size() <= kMaxLineLength)
+                return ParseStatus::Incomplete;
+            error = "CLIENT_ERROR line too long";
+            return ParseStatus::Fatal;
+        }
+
+        std::string_view line = input.substr(0, newline);
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        const size_t line_length = newline + 1;
+
+        // Unless a data block follows, the request is exactly the command line.
+        consumed = line_length;
+        request = Request{};
+
+        std::string_view command = nextToken(line);
+
+        if (command == "get" || command == "gets")
+        {
+            request.command = command == "get" ? Command::Get : Command::Gets;
+            std::string_view keys = line;
+            std::string_view scan = keys;
+            bool any = false;
+            for (std::string_view key = nextKey(scan); !key.empty(); key = nextKey(scan))
+            {
+                if (!validKey(key))
+                {
+                    error = kBadFormat;
+                    return ParseStatus::Error;
+                }
+                any = true;
+            }
+            if (!any)
+            {
+                error = "ERROR";
+                return ParseStatus::Error;
+            }
+            request.keys = keys;
+            return ParseStatus::Ok;
+        }
+
+        if (command == "set" || command == "add" || command == "cas")
+        {
+            request.command = command == "set" ? Command::Set : command == "add" ? Command::Add : Command::Cas;
+            request.keys = nextToken(line);
+            size_t bytes = 0;
+            bool ok = validKey(request.keys) &&
+                      parseNumber(nextToken(line), request.flags) &&
+                      parseNumber(nextToken(line), request.exptime) &&
+                      parseNumber(nextToken(line), bytes) &&
+                      (request.command != Command::Cas || parseNumber(nextToken(line), request.cas_unique)) &&
+                      parseNoreply(line, request.noreply);
+            if (!ok)
+            {
+                error = kBadFormat;
+                return ParseStatus::Error;
+            }
+            if (bytes > kMaxValueLength)
+            {
+                // The data block can't be skipped without buffering it; give up on the connection.
+                error = "SERVER_ERROR object too large for cache";
+                return ParseStatus::Fatal;
+            }
+
+            // The data block and its "\r\n" terminator must be complete.
+            if (input.size() < line_length + bytes + 2)
+                return ParseStatus::Incomplete;
+            consumed = line_length + bytes + 2;
+            if (input[line_length + bytes] != '\r' || input[line_length + bytes + 1] != '\n')
+            {
+                error = "CLIENT_ERROR bad data chunk";
+                return ParseStatus::Error;
+            }
+            request.data = input.substr(line_length, bytes);
+            return ParseStatus::Ok;
+        }
+
+        if (command == "delete")
+        {
+            request.command = Command::Delete;
+            request.keys = nextToken(line);
+            // Old clients may send a (meaningless) "0" hold time before noreply.
+            std::string_view rest = line;
+            if (nextToken(rest) == "0")
+                line = rest;
+            if (!validKey(request.keys) || !parseNoreply(line, request.noreply))
+            {
+                error = kBadFormat;
+                return ParseStatus::Error;
+            }
+            return ParseStatus::Ok;
+        }
+
+        if (command == "incr" || command == "decr")
+        {
+            request.command = command == "incr" ? Command::Incr : Command::Decr;
+            request.keys = nextToken(line);
+            if (!validKey(request.keys))
+            {
+                error = kBadFormat;
+                return ParseStatus::Error;
+            }
+            if (!parseNumber(nextToken(line), request.delta))
+            {
+                error = "CLIENT_ERROR invalid numeric delta argument";
+                return ParseStatus::Error;
+            }
+            if (!parseNoreply(line, request.noreply))
+            {
+                error = kBadFormat;
+                return ParseStatus::Error;
+            }
+            return ParseStatus::Ok;
+        }
+
+        if (command == "version" && nextToken(line).empty())
+        {
+            request.command = Command::Version;
+            return ParseStatus::Ok;
+        }
+
+        if (command == "quit" && nextToken(line).empty())
+        {
+            request.command = Command::Quit;
+            return ParseStatus::Ok;
+        }
+
+        error = "ERROR";
+        return ParseStatus::Error;
+    }
+
+    std::string_view nextKey(std::string_view &keys)
+    {
+        return nextToken(keys);
+    }
+}
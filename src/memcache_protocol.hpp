@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief Parser for the memcached text protocol.
+ *
+ * Supports the retrieval commands get/gets (any number of keys), the storage
+ * commands set/add/cas, delete, incr/decr, version and quit. Parsing is
+ * zero-copy: every field of a Request is a view into the connection's input
+ * buffer, and a request is only reported once it is complete (command line
+ * plus data block), so a connection can simply parse requests one after
+ * another from its buffer to support pipelining.
+ *
+ * Executing requests is up to the server (see KVServer::executeMemcache()).
+ */
+namespace memcache
+{
+    enum class Command
+    {
+        Get,
+        Gets,
+        Set,
+        Add,
+        Cas,
+        Delete,
+        Incr,
+        Decr,
+        Version,
+        Quit
+    };
+
+    struct Request
+    {
+        Command command = Command::Get;
+        std::string_view keys;    // get/gets: space-separated key list; otherwise the single key
+        uint32_t flags = 0;       // Storage commands: client flags
+        int64_t exptime = 0;      // Storage commands: expiration time
+        uint64_t cas_unique = 0;  // cas: the token returned by gets
+        uint64_t delta = 0;       // incr/decr: amount
+        std::string_view data;    // Storage commands: the data block, without its "\r\n"
+        bool noreply = false;     // Client asked for no response
+    };
+
+    enum class ParseStatus
+    {
+        Ok,         // 'request' is complete; 'consumed' bytes belong to it
+        Incomplete, // Wait for more input
+        Error,      // Bad request; reply 'error' and skip 'consumed' bytes
+        Fatal       // Unrecoverable (line or value too long); reply 'error' and close
+    };
+
+    // Limits (the key limit is memcached's own).
+    constexpr size_t kMaxKeyLength = 250;
+    constexpr size_t kMaxLineLength = 64 * 1024;
+    constexpr size_t kMaxValueLength = 16 * 1024 * 1024;
+
+    /**
+     * @brief Parses one request from the start of 'input'.
+     * @param input Unconsumed bytes received on the connection.
+     * @param request Receives the parsed request (views into 'input').
+     * @param consumed Receives the number of bytes the request occupies.
+     * @param error On Error/Fatal, the response line to send (without "\r\n").
+     */
+    ParseStatus parse(std::string_view input, Request &request, size_t &consumed, std::string_view &error);
+
+    /**
+     * @brief Returns the next key of a get/gets key list and removes it from 'keys'.
+     * @return An empty view once the list is exhausted.
+     */
+    std::string_view nextKey(std::string_view &keys);
+}
@@ -0,0 +1,157 @@
+#include "request_trace.hpp" // Trace format, Writer and Reader class definitions
+#include <algorithm>         // For std::min, std::max
+#include <cstdio>            // For snprintf
+#include <cstring>           // For memcpy
+#include <functional>        // For std::hash
+#include <thread>            // For std::this_thread::get_id
+
+namespace reqtrace
+{
+    namespace
+    {
+        // Records are written out in batches of about this many bytes.
+        constexpr size_t kBatchBytes = 64 * 1024;
+    }
+
+    Writer::~Writer()
+    {
+        std::lock_guard<std::mutex> buffer_lock(buffer_mutex);
+        std::lock_guard<std::mutex> file_lock(file_mutex);
+        if (file.is_open())
+        {
+            writeOut(buffer);
+            file.close();
+        }
+    }
+
+    bool Writer::open(const std::string &path, double sample_rate, bool hash)
+    {
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+
+        hash_keys = hash;
+        sample_all = sample_rate >= 1;
+        sample_threshold = sample_rate <= 0 ? 0 : static_cast<uint64_t>(sample_rate * 18446744073709551616.0);
+        start = std::chrono::steady_clock::now();
+
+        FileHeader header{};
+        header.magic = kMagic;
+        header.version = kVersion;
+        header.sample_ppm = static_cast<uint32_t>(std::min(std::max(sample_rate, 0.0), 1.0) * 1000000 + 0.5);
+        header.start_unix_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::system_clock::now().time_since_epoch())
+                                   .count();
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        buffer.reserve(kBatchBytes + 1024);
+        return static_cast<bool>(file);
+    }
+
+    bool Writer::sampled() const
+    {
+        if (sample_all)
+            return true;
+        // xorshift64*, seeded per thread
+        thread_local uint64_t state =
+            std::hash<std::thread::id>()(std::this_thread::get_id()) ^ 0x9e3779b97f4a7c15ULL;
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545f4914f6cdd1dULL < sample_threshold;
+    }
+
+    void Writer::record(Op op, std::string_view key, size_t value_size, bool hit)
+    {
+        if (!sampled())
+            return;
+
+        RecordHeader header{};
+        header.timestamp_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        header.value_size = static_cast<uint32_t>(std::min<size_t>(value_size, UINT32_MAX));
+        header.op = static_cast<uint8_t>(op);
+        header.flags = hit ? kHit : 0;
+
+        // Keys too long for the length field are hashed as well.
+        char hashed[sizeof(uint64_t)];
+        if (hash_keys || key.size() > UINT16_MAX)
+        {
+            uint64_t hash = hashKey(key);
+            memcpy(hashed, &hash, sizeof(hash));
+            key = std::string_view(hashed, sizeof(hashed));
+            header.flags |= kKeyHashed;
+        }
+        header.key_length = static_cast<uint16_t>(key.size());
+
+        std::unique_lock<std::mutex> lock(buffer_mutex);
+        buffer.append(reinterpret_cast<const char *>(&header), sizeof(header));
+        buffer.append(key);
+        record_count.fetch_add(1, std::memory_order_relaxed);
+        if (buffer.size() < kBatchBytes)
+            return;
+
+        // Hand the batch over and write it without holding up other threads'
+        // records; taking the file lock first keeps batches in order.
+        std::string batch;
+        batch.swap(buffer);
+        buffer.reserve(kBatchBytes + 1024);
+        std::lock_guard<std::mutex> file_lock(file_mutex);
+        lock.unlock();
+        writeOut(batch);
+    }
+
+    void Writer::writeOut(std::string &batch)
+    {
+        file.write(batch.data(), batch.size());
+        batch.clear();
+    }
+
+    bool Reader::open(const std::string &path, std::string &error)
+    {
+        file.open(path, std::ios::binary);
+        if (!file)
+        {
+            error = "cannot open " + path;
+            return false;
+        }
+        if (!file.read(reinterpret_cast<char *>(&file_header), sizeof(file_header)) || file_header.magic != kMagic)
+        {
+            error = path + " is not a request trace";
+            return false;
+        }
+        if (file_header.version != kVersion)
+        {
+            error = path + ": unsupported trace version " + std::to_string(file_header.version);
+            return false;
+        }
+        return true;
+    }
+
+    bool Reader::next(Record &record)
+    {
+        RecordHeader header;
+        if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)))
+            return false;
+        std::string key(header.key_length, '\0');
+        if (!file.read(&key[0], key.size()))
+            return false;
+
+        record.timestamp_ns = header.timestamp_ns;
+        record.op = static_cast<Op>(header.op);
+        record.flags = header.flags;
+        record.value_size = header.value_size;
+        if ((header.flags & kKeyHashed) && key.size() == sizeof(uint64_t))
+        {
+            uint64_t hash;
+            memcpy(&hash, key.data(), sizeof(hash));
+            char text[18];
+            snprintf(text, sizeof(text), "#%016llx", static_cast<unsigned long long>(hash));
+            record.key = text;
+        }
+        else
+        {
+            record.key = std::move(key);
+        }
+        return true;
+    }
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include "fnv_hash.hpp"
+
+/**
+ * @brief Compact binary traces of the server's requests, for replay.
+ *
+ * The server records a sample of the reads, writes and deletes it performs
+ * (from every protocol) with their time, key and value size; the load
+ * generator replays a trace with its original inter-arrival times.
+ *
+ * File layout (little-endian): a FileHeader, then one record per traced
+ * operation: a RecordHeader followed by 'key_length' key bytes. When the
+ * server hashes keys (the default, so traces carry no key names), the key
+ * is its 8-byte hash instead.
+ */
+namespace reqtrace
+{
+    constexpr uint64_t kMagic = 0x314543415254564b; // "KVTRACE1"
+    constexpr uint32_t kVersion = 1;
+
+    enum class Op : uint8_t
+    {
+        Get = 1,
+        Put = 2,
+        Delete = 3
+    };
+
+    // Record flags
+    constexpr uint8_t kHit = 1;       // A GET answered from the cache
+    constexpr uint8_t kKeyHashed = 2; // The key is its 8-byte hash
+
+    struct FileHeader
+    {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t sample_ppm;    // Fraction of operations recorded, in parts per million
+        uint64_t start_unix_ns; // Wall-clock time of timestamp 0
+    };
+
+    struct RecordHeader
+    {
+        uint64_t timestamp_ns; // Since the trace started
+        uint32_t value_size;   // Bytes written (PUT) or read (GET; 0 on a miss)
+        uint16_t key_length;
+        uint8_t op;
+        uint8_t flags;
+    };
+
+    static_assert(sizeof(FileHeader) == 24 && sizeof(RecordHeader) == 16, "part of the file format");
+
+    /**
+     * @brief Hash of a key stored in place of it (64-bit FNV-1a).
+     */
+    inline uint64_t hashKey(std::string_view key)
+    {
+        return fnv::hash(key);
+    }
+
+    /**
+     * @brief The server's side: samples and appends records to a file.
+     *
+     * Thread-safe. Whether an operation is recorded is decided by a
+     * thread-local random number, so unsampled operations cost one xorshift;
+     * sampled ones are appended to a shared buffer that is written out in
+     * 64 KiB batches (outside the buffer's lock, in order).
+     */
+    class Writer
+    {
+    public:
+        Writer() = default;
+        Writer(const Writer &) = delete;
+        Writer &operator=(const Writer &) = delete;
+
+        /**
+         * @brief Writes out the buffered records and closes the file.
+         */
+        ~Writer();
+
+        /**
+         * @brief Creates (or truncates) the trace file and writes its header.
+         * @param sample_rate Fraction of operations recorded, 0 to 1.
+         * @param hash_keys Store key hashes instead of keys.
+         * @return false if the file could not be created.
+         */
+        bool open(const std::string &path, double sample_rate, bool hash_keys);
+
+        /**
+         * @brief Records an operation, if it is sampled.
+         * @param hit For GETs: answered from the cache.
+         */
+        void record(Op op, std::string_view key, size_t value_size, bool hit = false);
+
+        // Operations recorded so far.
+        uint64_t recorded() const { return record_count.load(std::memory_order_relaxed); }
+
+    private:
+        bool sampled() const;
+        void writeOut(std::string &batch);
+
+        std::ofstream file;
+        bool hash_keys = true;
+        uint64_t sample_threshold = 0; // Sampled if a 64-bit random number is below it
+        bool sample_all = false;
+        std::chrono::steady_clock::time_point start;
+
+        std::mutex buffer_mutex; // Guards 'buffer'
+        std::string buffer;
+        std::mutex file_mutex; // Orders and guards writes to 'file'
+        std::atomic<uint64_t> record_count{0};
+    };
+
+    /**
+     * @brief A record as read back.
+     */
+    struct Record
+    {
+        uint64_t timestamp_ns;
+        Op op;
+        uint8_t flags;
+        uint32_t value_size;
+        std::string key; // The key, or "#" and 16 hex digits of its hash
+    };
+
+    /**
+     * @brief Reads a trace file record by record.
+     */
+    class Reader
+    {
+    public:
+        /**
+         * @return false, with 'error' set, if the file is missing or not a trace.
+         */
+        bool open(const std::string &path, std::string &error);
+
+        /**
+         * @return false at the end of the trace (a truncated last record is dropped).
+         */
+        bool next(Record &record);
+
+        const FileHeader &header() const { return file_header; }
+
+    private:
+        std::ifstream file;
+        FileHeader file_header{};
+    };
+}
@@ -0,0 +1,186 @@
+#include "resp_protocol.hpp" // Declarations of the RESP parser and encoders
+#include <charconv>          // For std::from_chars / std::to_chars
+
+namespace resp
+{
+    namespace
+    {
+        // Reads "<prefix><decimal>\r\n" at 'pos'. Returns false if the line is
+        // incomplete; sets 'bad' if it is malformed.
+        bool readLength(std::string_view input, size_t &pos, char prefix, int64_t &value, bool &bad)
+        {
+            size_t eol = input.find("\r\n", pos);
+            if (eol == std::string_view::npos)
+            {
+                // A length line is short; a long unterminated one is garbage.
+                bad = input.size() - pos > 32;
+                return false;
+            }
+            std::string_view line = input.substr(pos, eol - pos);
+            if (line.size() < 2 || line[0] != prefix)
+            {
+                bad = true;
+                return false;
+            }
+            auto result = std::from_chars(line.data() + 1, line.data() + line.size(), value);
+            if (result.ec != std::errc() || result.ptr != line.data() + line.size())
+            {
+                bad = true;
+                return false;
+            }
+            pos = eol + 2;
+            return true;
+        }
+
+        void appendNumber(std::pmr::string &out, int64_t value)
+        {
+            char digits[24];
+            out.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr - digits);
+        }
+
+        // Inline commands: arguments separated by spaces (no quoting).
+        ParseStatus parseInline(std::string_view input, Arguments &args, size_t &consumed, std::string_view &error)
+        {
+            size_t newline = input.find('\n');
+            if (newline == std::string_view::npos)
+            {
+                if (input.size() <= kMaxInlineLength)
+                    return ParseStatus::Incomplete;
+                error = "ERR Protocol error: too big inline request";
+                return ParseStatus::Error;
+            }
+            consumed = newline + 1;
+
+            std::string_view line = input.substr(0, newline);
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            while (!line.empty())
+            {
+                size_t start = line.find_first_not_of(" \t");
+                if (start == std::string_view::npos)
+                    break;
+                size_t end = line.find_first_of(" \t", start);
+                args.push_back(line.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start));
+                line = end == std::string_view::npos ? std::string_view() : line.substr(end);
+            }
+            return ParseStatus::Ok;
+        }
+    }
+
+    ParseStatus parse(std::string_view input, Arguments &args, size_t &consumed, std::string_view &error)
+    {
+        args.clear();
+        if (input.empty())
+            return ParseStatus::Incomplete;
+        if (input[0] != '*')
+            return parseInline(input, args, consumed, error);
+
+        // *<count>\r\n followed by <count> times $<len>\r\n<bytes>\r\n
+        size_t pos = 0;
+        int64_t count = 0;
+        bool bad = false;
+        if (!readLength(input, pos, '*', count, bad))
+        {
+            error = "ERR Protocol error: invalid multibulk length";
+            return bad ? ParseStatus::Error : ParseStatus::Incomplete;
+        }
+        if (count < 0 || static_cast<uint64_t>(count) > kMaxArguments)
+        {
+            error = "ERR Protocol error: invalid multibulk length";
+            return ParseStatus::Error;
+        }
+
+        for (int64_t i = 0; i < count; ++i)
+        {
+            int64_t length = 0;
+            if (!readLength(input, pos, '$', length, bad))
+            {
+                error = "ERR Protocol error: invalid bulk length";
+                return bad ? ParseStatus::Error : ParseStatus::Incomplete;
+            }
+            if (length < 0 || static_cast<uint64_t>(length) > kMaxBulkLength)
+            {
+                error = "ERR Protocol error: invalid bulk length";
+                return ParseStatus::Error;
+            }
+            if (input.size() - pos < static_cast<size_t>(length) + 2)
+                return ParseStatus::Incomplete;
+            if (input[pos + length] != '\r' || input[pos + length + 1] != '\n')
+            {
+                error = "ERR Protocol error: expected '\\r\\n' after bulk string";
+                return ParseStatus::Error;
+            }
+            args.push_back(input.substr(pos, length));
+            pos += length + 2;
+        }
+
+        consumed = pos;
+        return ParseStatus::Ok;
+    }
+
+    void appendSimple(std::pmr::string &out, std::string_view text)
+    {
+        out.append("+").append(text).append("\r\n");
+    }
+
+    void appendError(std::pmr::string &out, std::string_view message)
+    {
+        out.append("-").append(message).append("\r\n");
+    }
+
+    void appendInteger(std::pmr::string &out, int64_t value)
+    {
+        out.push_back(':');
+        appendNumber(out, value);
+        out.append("\r\n");
+    }
+
+    void appendBulk(std::pmr::string &out, std::string_view value)
+    {
+        out.push_back('$');
+        appendNumber(out, static_cast<int64_t>(value.size()));
+        out.append("\r\n").append(value).append("\r\n");
+    }
+
+    void appendNull(std::pmr::string &out, int version)
+    {
+        out.append(version >= 3 ? "_\r\n" : "$-1\r\n");
+    }
+
+    void appendArrayHeader(std::pmr::string &out, size_t count)
+    {
+        out.push_back('*');
+        appendNumber(out, static_cast<int64_t>(count));
+        out.append("\r\n");
+    }
+
+    void appendMapHeader(std::pmr::string &out, size_t count, int version)
+    {
+        // RESP2 has no map type: a map is a flat array of keys and values.
+        if (version >= 3)
+        {
+            out.push_back('%');
+            appendNumber(out, static_cast<int64_t>(count));
+            out.append("\r\n");
+        }
+        else
+        {
+            appendArrayHeader(out, count * 2);
+        }
+    }
+
+    bool equalsIgnoreCase(std::string_view token, std::string_view upper)
+    {
+        if (token.size() != upper.size())
+            return false;
+        for (size_t i = 0; i < token.size(); ++i)
+        {
+            char c = token[i];
+            if (c >= 'a' && c <= 'z')
+                c = static_cast<char>(c - 'a' + 'A');
+            if (c != upper[i])
+                return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Parser and reply encoders for RESP, the Redis protocol.
+ *
+ * Commands arrive either as a RESP array of bulk strings
+ * ("*2\r\n$3\r\nGET\r\n$1\r\nk\r\n") or as an inline command line
+ * ("GET k\r\n", used by redis-benchmark's *_INLINE tests and telnet).
+ * Parsing is zero-copy: the arguments are views into the connection's input
+ * buffer, and a command is only reported once it is complete, so pipelined
+ * commands are parsed one after another from the buffer.
+ *
+ * Replies are appended to an output buffer in RESP2 or RESP3 form; the two
+ * only differ here in how a null is written. Executing commands is up to the
+ * server (see KVServer::executeResp()).
+ */
+namespace resp
+{
+    using Arguments = std::pmr::vector<std::string_view>;
+
+    enum class ParseStatus
+    {
+        Ok,         // 'args' holds a complete command; 'consumed' bytes belong to it
+        Incomplete, // Wait for more input
+        Error       // Protocol error: reply 'error' and close the connection
+    };
+
+    // Limits (Redis allows larger bulk strings, but values here are capped
+    // like the other protocols').
+    constexpr size_t kMaxInlineLength = 64 * 1024;
+    constexpr size_t kMaxBulkLength = 16 * 1024 * 1024;
+    constexpr size_t kMaxArguments = 1024 * 1024;
+
+    /**
+     * @brief Parses one command from the start of 'input'.
+     * @param input Unconsumed bytes received on the connection.
+     * @param args Receives the command name and arguments (views into 'input').
+     *        An empty inline line yields Ok with no arguments.
+     * @param consumed Receives the number of bytes the command occupies.
+     * @param error On Error, the error reply to send (without "-" and "\r\n").
+     */
+    ParseStatus parse(std::string_view input, Arguments &args, size_t &consumed, std::string_view &error);
+
+    // ===== Reply encoders =====
+
+    void appendSimple(std::pmr::string &out, std::string_view text);             // +text
+    void appendError(std::pmr::string &out, std::string_view message);           // -message
+    void appendInteger(std::pmr::string &out, int64_t value);                    // :value
+    void appendBulk(std::pmr::string &out, std::string_view value);              // $len value
+    void appendNull(std::pmr::string &out, int version);                         // $-1 (RESP2) or _ (RESP3)
+    void appendArrayHeader(std::pmr::string &out, size_t count);                 // *count
+    void appendMapHeader(std::pmr::string &out, size_t count, int version);      // %count (RESP3) or *2count
+
+    /**
+     * @brief Case-insensitive comparison of a command name or option.
+     * @param upper The expected spelling, in upper case.
+     */
+    bool equalsIgnoreCase(std::string_view token, std::string_view upper);
+}
@@ -1,9 +1,28 @@
 #include "server.hpp"
+#include "slab_allocator.hpp"
+#include "compression.hpp"
+#include "large_value.hpp"
+#include "chunked_decoder.hpp"
+#include "resp_protocol.hpp"
+#include "binary_protocol.hpp"
+#include "http1.hpp"
+#include "http2.hpp"
 #include <iostream>
 #include <sstream>
 #include <cstring>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <utility>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <netinet/tcp.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
@@ -13,19 +32,29 @@
 KVServer::KVServer(int port, size_t cache_size, size_t thread_pool_size,
                    const std::string &db_host, const std::string &db_port,
                    const std::string &db_name, const std::string &db_user,
-                   const std::string &db_password)
-    : port(port), thread_pool_size(thread_pool_size),
+                   const std::string &db_password, size_t compression_threshold,
+                   size_t large_value_threshold)
+    : port(port), thread_pool_size(thread_pool_size), compression_threshold(compression_threshold),
+      large_value_threshold(large_value_threshold),
       db_host(db_host), db_port(db_port), db_name(db_name),
       db_user(db_user), db_password(db_password), running(false),
-      cache_hits(0), cache_misses(0), total_requests(0)
+      cache_hits(0), cache_misses(0), total_requests(0), streamed_uploads(0), streamed_upload_bytes(0),
+      memcache_commands(0), resp_commands(0), binary_requests(0), binary_deferred(0), expired_keys(0),
+      http2_streams(0), http2_deferred(0)
 {
-    // Initialize cache with given size
-    cache = std::make_unique<LRUCache>(cache_size);
+    // Initialize cache with given size (large values stored compressed if enabled,
+    // very large ones in memfds)
+    cache = std::make_unique<LRUCache>(cache_size, compression_threshold, large_value_threshold);
     // Take ownership of the provided database pointer
     // database = std::unique_ptr<Database>(db);
 
-    // Initialize server socket to an invalid state
+    // Initialize server sockets to an invalid state
     server_socket = -1;
+    memcache_socket = -1;
+    resp_socket = -1;
+    binary_socket = -1;
+    unix_socket = -1;
+    epoll_fd = -1;
 }
 
 // =======================
@@ -38,16 +67,69 @@ KVServer::~KVServer()
 }
 
 // =======================
-// Start the server
+// Enable the memcached listener
 // =======================
-bool KVServer::start()
+void KVServer::setMemcachePort(int memcache_port)
+{
+    this->memcache_port = memcache_port;
+}
+
+// =======================
+// Enable the RESP listener
+// =======================
+void KVServer::setRespPort(int resp_port)
+{
+    this->resp_port = resp_port;
+}
+
+// =======================
+// Enable the binary protocol listener
+// =======================
+void KVServer::setBinaryPort(int binary_port)
+{
+    this->binary_port = binary_port;
+}
+
+// =======================
+// Enable the Unix domain socket listener
+// =======================
+void KVServer::setUnixSocket(const std::string &path, mode_t mode)
+{
+    unix_socket_path = path;
+    unix_socket_mode = mode;
+}
+
+// =======================
+// Enable the shared-memory hot table
+// =======================
+void KVServer::setHotTable(const std::string &name, size_t slots, mode_t mode)
+{
+    hot_table_name = name;
+    hot_table_slots = slots;
+    hot_table_mode = mode;
+}
+
+// =======================
+// Enable the request trace
+// =======================
+void KVServer::setTrace(const std::string &path, double sample_rate, bool hash_keys)
+{
+    trace_path = path;
+    trace_sample_rate = sample_rate;
+    trace_hash_keys = hash_keys;
+}
+
+// =======================
+// Create a listening TCP socket
+// =======================
+int KVServer::createListenSocket(int listen_port)
 {
     // Create a TCP socket (IPv4, Stream type)
-    server_socket = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_socket < 0)
+    int listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_socket < 0)
     {
         std::cerr << "Failed to create socket" << std::endl;
-        return false;
+        return -1;
     }
 
     // Allow socket address reuse (helps during quick restarts)
@@ -58,39 +140,199 @@ bool KVServer::start()
     // to bind() to the same port soon after restarting the server may cause the error
     // "Address already in use". Setting opt = 1 enables this behavior.
     // Parameters:
-    //   server_socket - the socket file descriptor on which the option is being set
+    //   listen_socket - the socket file descriptor on which the option is being set
     //   SOL_SOCKET    - specifies that the option is at the socket level
     //   SO_REUSEADDR  - the option that allows reusing the local address
     //   &opt          - pointer to the integer value (1 to enable the option)
     //   sizeof(opt)   - size of the option value being passed
     int opt = 1;
-    setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
 
     // Prepare server address structure
     struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr)); // Zero-initialize
     server_addr.sin_family = AF_INET;             // IPv4
     server_addr.sin_addr.s_addr = INADDR_ANY;     // Bind to all network interfaces
-    server_addr.sin_port = htons(port);           // Set port in network byte order
+    server_addr.sin_port = htons(listen_port);    // Set port in network byte order
 
     // Bind the socket to the specified IP and port
-    if (bind(server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
+    if (bind(listen_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
     {
-        std::cerr << "Failed to bind socket to port " << port << std::endl;
-        close(server_socket);
-        return false;
+        std::cerr << "Failed to bind socket to port " << listen_port << std::endl;
+        close(listen_socket);
+        return -1;
     }
 
     // Start listening for incoming connections (max 128 in queue)
-    if (listen(server_socket, 128) < 0)
+    if (listen(listen_socket, 128) < 0)
     {
         std::cerr << "Failed to listen on socket" << std::endl;
-        close(server_socket);
+        close(listen_socket);
+        return -1;
+    }
+
+    // Non-blocking, so a worker woken for a connection another worker already
+    // accepted gets EAGAIN instead of blocking in accept().
+    fcntl(listen_socket, F_SETFL, fcntl(listen_socket, F_GETFL) | O_NONBLOCK);
+    return listen_socket;
+}
+
+// =======================
+// Create a listening Unix domain socket
+// =======================
+int KVServer::createUnixListenSocket(const std::string &path, mode_t mode)
+{
+    struct sockaddr_un server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(server_addr.sun_path))
+    {
+        std::cerr << "Unix socket path too long: " << path << std::endl;
+        return -1;
+    }
+    memcpy(server_addr.sun_path, path.c_str(), path.size() + 1);
+
+    int listen_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_socket < 0)
+    {
+        std::cerr << "Failed to create unix socket" << std::endl;
+        return -1;
+    }
+
+    // A socket file survives the process that bound it, so a previous run
+    // (or a crash) leaves one behind; bind() would fail with EADDRINUSE.
+    // Only a socket is removed, never a regular file at a mistyped path.
+    struct stat existing;
+    if (lstat(path.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode))
+        unlink(path.c_str());
+
+    if (bind(listen_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
+    {
+        std::cerr << "Failed to bind unix socket " << path << ": " << strerror(errno) << std::endl;
+        close(listen_socket);
+        return -1;
+    }
+
+    // Connecting requires write permission on the socket file; bind() applied
+    // the umask, so set the requested mode explicitly.
+    if (chmod(path.c_str(), mode) < 0 || listen(listen_socket, 128) < 0)
+    {
+        std::cerr << "Failed to listen on unix socket " << path << std::endl;
+        close(listen_socket);
+        unlink(path.c_str());
+        return -1;
+    }
+
+    fcntl(listen_socket, F_SETFL, fcntl(listen_socket, F_GETFL) | O_NONBLOCK);
+    return listen_socket;
+}
+
+// =======================
+// Start the server
+// =======================
+bool KVServer::start()
+{
+    server_socket = createListenSocket(port);
+    if (server_socket < 0)
         return false;
+    if (port == 0)
+    {
+        // Ephemeral port: find out which one the kernel chose
+        struct sockaddr_in bound_addr;
+        socklen_t bound_len = sizeof(bound_addr);
+        getsockname(server_socket, (struct sockaddr *)&bound_addr, &bound_len);
+        port = ntohs(bound_addr.sin_port);
+    }
+
+    // Optional protocol listeners; if one can't be opened, undo the others.
+    struct
+    {
+        int listen_port;
+        int &listen_socket;
+    } optional_listeners[] = {{memcache_port, memcache_socket},
+                              {resp_port, resp_socket},
+                              {binary_port, binary_socket}};
+    auto close_listeners = [this]()
+    {
+        for (int *fd : {&server_socket, &memcache_socket, &resp_socket, &binary_socket, &unix_socket})
+        {
+            if (*fd >= 0)
+                close(*fd);
+            *fd = -1;
+        }
+    };
+    for (auto &listener : optional_listeners)
+    {
+        if (listener.listen_port <= 0)
+            continue;
+        listener.listen_socket = createListenSocket(listener.listen_port);
+        if (listener.listen_socket < 0)
+        {
+            close_listeners();
+            return false;
+        }
+    }
+    if (!unix_socket_path.empty())
+    {
+        unix_socket = createUnixListenSocket(unix_socket_path, unix_socket_mode);
+        if (unix_socket < 0)
+        {
+            close_listeners();
+            return false;
+        }
+    }
+    if (!hot_table_name.empty())
+    {
+        hot_table = std::make_unique<hottable::Publisher>();
+        if (!hot_table->create(hot_table_name, hot_table_slots, hot_table_mode))
+        {
+            std::cerr << "Failed to create shared memory table " << hot_table_name << ": " << strerror(errno)
+                      << std::endl;
+            hot_table.reset();
+            close_listeners();
+            return false;
+        }
+    }
+    if (!trace_path.empty())
+    {
+        trace_writer = std::make_unique<reqtrace::Writer>();
+        if (!trace_writer->open(trace_path, trace_sample_rate, trace_hash_keys))
+        {
+            std::cerr << "Failed to create request trace " << trace_path << ": " << strerror(errno) << std::endl;
+            trace_writer.reset();
+            hot_table.reset();
+            close_listeners();
+            return false;
+        }
     }
 
+    // All listening sockets and all persistent connections are watched by one
+    // epoll instance that every worker waits on.
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    addListener(server_socket, Protocol::Http);
+    if (unix_socket >= 0)
+        addListener(unix_socket, Protocol::Http);
+    if (memcache_socket >= 0)
+        addListener(memcache_socket, Protocol::Memcache);
+    if (resp_socket >= 0)
+        addListener(resp_socket, Protocol::Resp);
+    if (binary_socket >= 0)
+        addListener(binary_socket, Protocol::Binary);
+
     running = true;
     std::cout << "KV Server listening on port " << port << std::endl;
+    if (unix_socket >= 0)
+        std::cout << "KV Server listening on unix socket " << unix_socket_path << std::endl;
+    if (memcache_socket >= 0)
+        std::cout << "Memcached protocol listening on port " << memcache_port << std::endl;
+    if (resp_socket >= 0)
+        std::cout << "RESP (Redis) protocol listening on port " << resp_port << std::endl;
+    if (binary_socket >= 0)
+        std::cout << "Binary protocol listening on port " << binary_port << std::endl;
+    if (trace_writer)
+        std::cout << "Tracing " << trace_sample_rate * 100 << "% of requests to " << trace_path << std::endl;
+    if (hot_table)
+        std::cout << "Hot entries exported in shared memory " << hot_table_name << std::endl;
 
     // Spawn worker threads to handle client connections concurrently
     // Create and launch multiple worker threads for the server's thread pool.
@@ -117,6 +359,12 @@ bool KVServer::start()
         worker_threads.emplace_back(&KVServer::workerThread, this);
     }
 
+    // Streaming uploads block on their client; they get threads of their own.
+    for (size_t i = 0; i < kUploadThreads; ++i)
+    {
+        upload_threads.emplace_back(&KVServer::uploadThread, this);
+    }
+
     return true;
 }
 
@@ -130,454 +378,2183 @@ void KVServer::workerThread()
         db_host.c_str(), db_port.c_str(), db_name.c_str(), 
         db_user.c_str(), db_password.c_str());
 
-   
+    // Per-thread request arena. Every temporary of a request (request buffer,
+    // parsed fields, JSON and response) is bump-allocated from this buffer and
+    // released in one step once the response has been sent. Only requests that
+    // outgrow it fall back to the general-purpose heap.
+    std::unique_ptr<char[]> arena_buffer(new char[kArenaSize]);
+    std::pmr::monotonic_buffer_resource arena(arena_buffer.get(), kArenaSize);
 
     while (running)
     {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-
-        // Accept an incoming client connection request on the server socket.
-        // This function blocks (waits) until a client attempts to connect to the server.
-        // When a connection request arrives, the `accept()` call creates a new socket
-        // dedicated to communicating with that specific client and returns its file
-        // descriptor (`client_socket`).
-        //
-        // Explanation of parameters:
-        //   - server_socket: The listening socket that was previously created, bound to
-        //     an address, and set to listen for incoming connections using listen().
-        //   - (struct sockaddr *)&client_addr: A pointer to a sockaddr structure where
-        //     the details (IP address and port number) of the connecting client will be stored.
-        //   - &client_len: A pointer to a variable that initially contains the size of
-        //     the client_addr structure. On return, it holds the actual size of the
-        //     address information stored.
-        //
-        // Return value:
-        //   - On success: Returns a new socket descriptor (`client_socket`) that represents
-        //     the connection to the newly accepted client. The server uses this socket
-        //     to send and receive data with that specific client.
-        //   - On failure: Returns -1, and `errno` is set to indicate the specific error.
-        //
-        // In summary, this line accepts a new client connection from the listening socket
-        // and establishes a separate communication channel with that client.
-        int client_socket = accept(server_socket, (struct sockaddr *)&client_addr, &client_len);
-
-        if (client_socket < 0)
-        {
-            if (running)
-            {
-                std::cerr << "Failed to accept connection" << std::endl;
-            }
+        // Wait for one ready socket: a listener with a pending connection, or a
+        // persistent connection with new input. One event per call, so that
+        // ready sockets are spread over all idle workers. The timeout lets the
+        // worker notice shutdown.
+        struct epoll_event event;
+        int ready = epoll_wait(epoll_fd, &event, 1, kPollTimeoutMs);
+        if (ready == 0)
+        {
+            // Idle: remove keys whose TTL ran out but that nobody has read.
+            expireDueKeys(database.get());
             continue;
         }
+        if (ready < 0)
+            continue;
 
-        // Handle client request synchronously in the same thread
-        handleClient(client_socket, database.get());
-
-        // Close client connection after serving
-        close(client_socket);
+        // The event carries an id: the connection may have been closed by
+        // another worker (one answering its deferred requests) since. The
+        // reference keeps it alive until the event has been served.
+        uint64_t id = event.data.u64;
+        auto listener = std::find_if(listeners.begin(), listeners.end(),
+                                     [id](const std::unique_ptr<Endpoint> &l) { return l->id == id; });
+        if (listener != listeners.end())
+            acceptConnection(**listener, database.get(), &arena);
+        else if (std::shared_ptr<Endpoint> connection = findConnection(id))
+            serviceConnection(*connection, database.get(), &arena);
+
+        // Reset the arena for the next request
+        arena.release();
     }
 }
 
 // =======================
-// Handle HTTP Request
+// Accept a new connection
 // =======================
-void KVServer::handleClient(int client_socket, Database* database)
+void KVServer::acceptConnection(Endpoint &listener, Database *database, std::pmr::memory_resource *arena)
 {
-    char buffer[4096];
+    // Large enough for the peer address of both TCP and Unix domain listeners.
+    struct sockaddr_storage client_addr;
+    socklen_t client_len = sizeof(client_addr);
 
-    // Receive data from the connected client socket and store it in the buffer.
-    // Parameters:
-    //  - client_socket: The socket descriptor representing the client's connection.
-    //  - buffer: The character array where received data will be stored.
-    //  - sizeof(buffer) - 1: The maximum number of bytes to read. We subtract 1 to leave
-    //    room for a null terminator ('\0') in case we later treat the buffer as a C string.
-    //  - 0: Flags argument; 0 means default behavior (blocking receive).
+    // Accept an incoming client connection request on the listening socket.
+    // The call creates a new socket dedicated to communicating with that
+    // specific client and returns its file descriptor (`client_socket`).
+    //
+    // Explanation of parameters:
+    //   - listener.fd: The listening socket that was previously created, bound to
+    //     an address, and set to listen for incoming connections using listen().
+    //   - (struct sockaddr *)&client_addr: A pointer to a sockaddr structure where
+    //     the details (IP address and port number) of the connecting client will be stored.
+    //   - &client_len: A pointer to a variable that initially contains the size of
+    //     the client_addr structure. On return, it holds the actual size of the
+    //     address information stored.
     //
-    // Return value:
-    //  - recv() returns the number of bytes actually received and stored in 'buffer'.
-    //  - A return value of 0 means the peer has performed an orderly shutdown
-    //    (connection closed).
-    //  - A return value of -1 indicates an error (errno will be set accordingly).
-    ssize_t bytes_read = recv(client_socket, buffer, sizeof(buffer) - 1, 0);
-    if (bytes_read <= 0)
+    // The listening socket is non-blocking: if another worker was woken for
+    // the same connection and got it first, this fails with EAGAIN.
+    int client_socket = accept4(listener.fd, (struct sockaddr *)&client_addr, &client_len, SOCK_CLOEXEC);
+    if (client_socket < 0)
     {
-        return; // Client disconnected or read failed
+        if (running && errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            std::cerr << "Failed to accept connection" << std::endl;
+        }
+        return;
     }
-    // received data is not null-terminated by default so we do it manually
-    buffer[bytes_read] = '\0'; // Null-terminate received data
-    // Convert buffer to std::string for easier manipulation
-    std::string request(buffer);
-
-    total_requests++; // Increment total request count
-
-    // Parse the first line of an HTTP request to extract the method, path, and HTTP version.
-    //
-    // Example of a typical HTTP request line:
-    //     "GET /index.html HTTP/1.1"
-    //
-    // 1. std::istringstream iss(request);
-    //    - Creates an input string stream (iss) from the string variable 'request'.
-    //    - This allows us to use stream extraction operators (>>) to parse the string
-    //      in a convenient, token-by-token manner, similar to how std::cin works.
-    //    - The input stream treats whitespace (spaces, tabs, newlines) as delimiters.
-
-    std::istringstream iss(request);
-    //    - Declares three string variables to hold the components of the request line:
-    //        method  → HTTP method (e.g., "GET", "POST", "PUT")
-    //        path    → Requested resource path (e.g., "/index.html")
-    //        version → HTTP version (e.g., "HTTP/1.1")
-    std::string method, path, version;
-    //    - Extracts tokens sequentially from the request string stream and assigns them
-    //      to 'method', 'path', and 'version' respectively.
-    //    - After this operation:
-    //         method  contains the HTTP method,
-    //         path    contains the requested URL/path,
-    //         version contains the HTTP protocol version.
-    //    - Any extra parts of the request (e.g., headers or body) remain unprocessed
-    //      in the stream and can be handled later if needed.
-    iss >> method >> path >> version;
-
-    std::string response;
-
-    // Extract the query string (if any) from the URL path in an HTTP request.
-    //
-    // Example:
-    //     If path = "/search?query=ai&sort=desc"
-    //     Then after this block executes:
-    //         path  = "/search"
-    //         query = "query=ai&sort=desc"
 
-    std::string query;
+    // Every connection, HTTP included, is registered with epoll and served
+    // whenever input arrives; no worker waits for a request to come in.
+    // (TCP_NODELAY simply fails on a Unix domain socket.)
+    int nodelay = 1;
+    setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
 
-    //    - Searches for the position of the first '?' character in 'path'.
-    //    - If found, 'query_pos' will hold its index within the string.
-    //    - If not found, std::string::npos is returned (a special value meaning “not found”).
-    size_t query_pos = path.find('?');
+    // Responses are sent blocking; a client that doesn't read them is dropped
+    // after a while rather than holding the worker.
+    struct timeval send_timeout{kSendTimeoutMs / 1000, (kSendTimeoutMs % 1000) * 1000};
+    setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
 
-    //    - Checks whether a '?' was actually found in the path.
-    //    - Only if it exists do we proceed to extract the query string.
-    if (query_pos != std::string::npos)
+    if (listener.protocol == Protocol::Http)
     {
-        //    - Extracts the substring starting just after '?' till the end of 'path'.
-        //    - This gives the query string (e.g., "query=ai&sort=desc").
-        query = path.substr(query_pos + 1);
-        //    - Truncates the 'path' string to exclude the query part.
-        //    - Keeps only the portion before '?' (e.g., "/search").
-        path = path.substr(0, query_pos);
+        // Only a streamed upload reads the socket blocking; don't let a
+        // stalled client hold its upload thread forever.
+        struct timeval timeout{kUploadReceiveTimeoutMs / 1000, (kUploadReceiveTimeoutMs % 1000) * 1000};
+        setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
     }
 
-    // Extract the HTTP request body (if any) from the complete request string.
-    //
-    // In an HTTP request, headers and the body are separated by a blank line,
-    // represented by the sequence "\r\n\r\n".
-    //
-    // Example of a raw HTTP request:
-    //     POST /submit HTTP/1.1\r\n
-    //     Host: example.com\r\n
-    //     Content-Length: 13\r\n
-    //     \r\n
-    //     name=Manish
-    //
-    // After this block executes on the above example:
-    //     body = "name=Manish"
-
-    std::string body;
-
-    //    - Searches for the position of the sequence "\r\n\r\n" in the request string.
-    //    - This sequence marks the end of the HTTP headers and the start of the body.
-    //    - If found, 'body_pos' will hold the index of the *first* '\r' in that sequence.
-    //    - If not found, std::string::npos is returned, meaning the request likely has no body.
-    size_t body_pos = request.find("\r\n\r\n");
+    auto connection = std::make_shared<Endpoint>(&input_pool);
+    connection->fd = client_socket;
+    connection->protocol = listener.protocol;
+    connection->listening = false;
 
-    //    - Checks whether the header-body separator was found.
-    //    - If yes, proceed to extract the body.
-    if (body_pos != std::string::npos)
     {
-        //    - Extracts the substring starting 4 characters after "\r\n\r\n" (to skip the separator).
-        //    - The remainder of the string is the request body.
-        body = request.substr(body_pos + 4);
+        std::lock_guard<std::mutex> lock(connections_mtx);
+        connection->id = ++next_endpoint_id;
+        connections.emplace(connection->id, connection);
     }
 
-    // Handle different HTTP API endpoints and methods based on the parsed 'path' and 'method'.
-    //
-    // This block routes incoming HTTP requests to the appropriate handler functions
-    // depending on the request URL (path) and HTTP method.
-    //
-    // Supported endpoints:
-    //   1. /api/kv   → Key-Value store operations (CRUD)
-    //   2. /stats    → Server statistics
-    //   Otherwise → 404 Not Found
-    if (path == "/api/kv")
-    {
+    struct epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    event.data.u64 = connection->id;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client_socket, &event) < 0)
+        closeConnection(*connection);
+}
 
-        if (method == "POST")
-        {
-            // Calls handlePutRequest(body)
-            // Used for creating or updating a key-value pair.
-            // Expects data in the request body, e.g., {"key": "name", "value": "Manish"}.
-            response = handlePutRequest(body, database); // Create/Update
-        }
+// =======================
+// Look up a persistent connection
+// =======================
+std::shared_ptr<KVServer::Endpoint> KVServer::findConnection(uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(connections_mtx);
+    auto it = connections.find(id);
+    return it == connections.end() ? nullptr : it->second;
+}
 
-        else if (method == "GET")
+// =======================
+// Serve input on a persistent connection
+// =======================
+void KVServer::serviceConnection(Endpoint &connection, Database *database, std::pmr::memory_resource *arena)
+{
+    // The connection is armed with EPOLLONESHOT, so only this worker touches it
+    // until it is re-armed below.
+    //
+    // 1. Drain what the socket has (without blocking), up to a per-event budget
+    //    so one busy client can't monopolize the worker.
+    char buffer[16 * 1024];
+    bool peer_closed = false;
+    size_t received = 0;
+    while (received < kMaxReadPerEvent)
+    {
+        ssize_t bytes_read = recv(connection.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (bytes_read > 0)
         {
-            // Calls handleGetRequest(query)
-            //  Retrieves the value associated with a given key.
-            //  Expects a query string in the URL, e.g., /api/kv?key=name.
-            response = handleGetRequest(query, database); // Read
+            connection.input.append(buffer, bytes_read);
+            received += bytes_read;
+            continue;
         }
+        if (bytes_read < 0 && errno == EINTR)
+            continue;
+        if (bytes_read == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+            peer_closed = true;
+        break;
+    }
 
-        else if (method == "DELETE")
-        {
-            // Calls handleDeleteRequest(query)
-            // Deletes a key-value pair identified by the key in the query string.
-            response = handleDeleteRequest(query, database); // Delete
-        }
-        else
+    // 2. Execute every complete request in the buffer, in order, collecting the
+    //    responses so a pipelined batch is answered with one send. Binary
+    //    requests that need the database are queued instead.
+    std::pmr::string output(arena);
+    bool keep_open;
+    if (connection.protocol == Protocol::Binary)
+        keep_open = handleBinaryInput(connection, output, database);
+    else if (connection.protocol == Protocol::Resp)
+        keep_open = handleRespInput(connection, database, arena, output);
+    else if (connection.protocol == Protocol::Http2)
+    {
+        // The session is shared with the worker executing deferred streams:
+        // the frames it produces are sent before it is released.
+        std::lock_guard<std::mutex> lock(connection.send_mtx);
+        keep_open = handleHttp2Input(connection, database, arena, output);
+        if (!output.empty() && !sendBuffers(connection.fd, output, {}, 0))
+            keep_open = false;
+        output.clear();
+    }
+    else if (connection.protocol == Protocol::Http)
+    {
+        // HTTP/1.1: answered (and sent) one request at a time, as soon as it
+        // is complete in the input. A connection that switched to HTTP/2
+        // stays open as one; one starting a streaming upload goes to an
+        // upload thread, which closes it when done.
+        HttpOutcome outcome = serveHttp(connection, database, arena);
+        if (outcome == HttpOutcome::Upload)
         {
-            // If any other HTTP method is used (e.g., PUT, PATCH, OPTIONS),
-            // respond with HTTP 405 "Method Not Allowed".
-            // The response body is a JSON error message: {"error": "Method not allowed"}.
-            response = buildHttpResponse(405, "{\"error\":\"Method not allowed\"}");
+            queueUpload(connection, arena);
+            return;
         }
+        keep_open = outcome != HttpOutcome::Close;
     }
-    // Handles a special endpoint that reports server performance statistics.
-    // Useful for monitoring purposes.
-    else if (path == "/stats")
-    {
+    else
+        keep_open = handleMemcacheInput(connection, database, arena, output);
 
-        std::ostringstream stats; // Create a std::ostringstream object 'stats' to build a JSON response dynamically.
-        stats << "{\"total_requests\":" << total_requests
-              << ",\"cache_hits\":" << cache_hits
-              << ",\"cache_misses\":" << cache_misses
-              << ",\"hit_rate\":" << (total_requests > 0 ? (double)cache_hits / total_requests : 0)
-              << "}";
-        // The constructed JSON string might look like:
-        //           {"total_requests":120,"cache_hits":85,"cache_misses":35,"hit_rate":0.7083}
+    // 3. Reply, then either close or wait for more input.
+    if (!output.empty())
+    {
+        std::lock_guard<std::mutex> lock(connection.send_mtx);
+        if (!sendBuffers(connection.fd, output, {}, 0))
+            keep_open = false;
+    }
 
-        // Send back a 200 OK response with the JSON statistics.
-        response = buildHttpResponse(200, stats.str());
+    // Binary requests or HTTP/2 streams still queued, or being executed by
+    // another worker
+    bool queued = false;
+    if (connection.protocol == Protocol::Binary || connection.protocol == Protocol::Http2)
+    {
+        std::lock_guard<std::mutex> lock(connection.deferred_mtx);
+        queued = connection.deferred_running || !connection.deferred.empty() || !connection.deferred_streams.empty();
     }
-    // Invalid endpoint
-    else
+
+    if (!keep_open || connection.input.size() > kMaxPendingInput || (peer_closed && !queued))
     {
+        closeConnection(connection);
+        return;
+    }
 
-        //    - This branch handles invalid or unknown endpoints (not matching /api/kv or /stats).
-        //    - Responds with HTTP 404 "Not Found" and a JSON error message:
-        response = buildHttpResponse(404, "{\"error\":\"Not found\"}");
+    // Queued requests run after re-arming, so the connection's next requests
+    // (possibly cache hits) are served by other workers meanwhile; the
+    // caller's reference keeps the connection alive should one of them close
+    // it. A connection with a full queue isn't read again until
+    // executeDeferred() empties it; nor is one that half-closed after
+    // sending, which then still gets its answers and is closed on the next
+    // event.
+    bool rearm = true;
+    if (queued)
+    {
+        std::lock_guard<std::mutex> lock(connection.deferred_mtx);
+        if (peer_closed || connection.deferred.size() >= kMaxDeferredRequests)
+        {
+            connection.deferred_paused = true;
+            rearm = false;
+        }
     }
 
-    // Send back the HTTP response
-    // 0 means default behavior (blocking send)
-    send(client_socket, response.c_str(), response.length(), 0);
+    if (rearm && !rearmConnection(connection))
+        return;
+
+    if (queued)
+        executeDeferred(connection, database, arena);
 }
 
 // =======================
-// Handle POST/PUT Request
+// Wait for a persistent connection's next input
 // =======================
-std::string KVServer::handlePutRequest(const std::string &body, Database* database)
+bool KVServer::rearmConnection(Endpoint &connection)
 {
-    std::string key, value;
-    parseKeyValue(body, key, value); // Extract key and value from JSON
-
-    if (key.empty())
+    struct epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    event.data.u64 = connection.id;
+    // More input may already be buffered in the socket (budget exhausted);
+    // level-triggered re-arming reports it again immediately.
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection.fd, &event) < 0)
     {
-        return buildHttpResponse(400, "{\"error\":\"Invalid request body\"}");
+        closeConnection(connection);
+        return false;
     }
+    return true;
+}
 
-    // Write key-value pair to database
-    // If database write fails, return 500 error
-    if (!database->put(key, value))
-    {
-        std::cerr << "[ERROR] PUT failed for key: " << key << std::endl;
-        return buildHttpResponse(500, "{\"error\":\"Database write failed\"}");
-    }
+// =======================
+// Close a persistent connection
+// =======================
+void KVServer::closeConnection(Endpoint &connection)
+{
+    // Stop events and wake any worker blocked sending to it; the descriptor
+    // itself is closed with the last reference (see ~Endpoint).
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection.fd, nullptr);
+    shutdown(connection.fd, SHUT_RDWR);
+    std::lock_guard<std::mutex> lock(connections_mtx);
+    connections.erase(connection.id);
+}
 
-    // Update in-memory cache as well  
-    cache->put(key, value);
+KVServer::Endpoint::~Endpoint()
+{
+    // Listening sockets are closed by stop().
+    if (!listening && fd >= 0)
+        close(fd);
+}
 
-    return buildHttpResponse(200, "{\"status\":\"success\"}");
+// =======================
+// Number of open persistent connections
+// =======================
+size_t KVServer::connectionCount()
+{
+    std::lock_guard<std::mutex> lock(connections_mtx);
+    return connections.size();
 }
 
 // =======================
-// Handle GET Request
+// Register a listening socket
 // =======================
-std::string KVServer::handleGetRequest(const std::string &query, Database *database)
+void KVServer::addListener(int listen_socket, Protocol protocol)
 {
-    // It searches the query string for a parameter named "key=".
-    // Returns the substring after "key=" up to the next '&' (if any) or the end.
-    // e.g., for "key=user123&value=abc", it would return "user123".
-    // If "key=" is not found, it should return an empty string.
-    std::string key = parseKeyFromQuery(query);
+    auto listener = std::make_unique<Endpoint>();
+    listener->fd = listen_socket;
+    listener->protocol = protocol;
+    listener->listening = true;
+    listener->id = ++next_endpoint_id; // Before any worker runs: no lock needed
+
+    // EPOLLEXCLUSIVE: a new connection wakes one waiting worker, not all of them.
+    struct epoll_event event{};
+    event.events = EPOLLIN | EPOLLEXCLUSIVE;
+    event.data.u64 = listener->id;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_socket, &event);
+    listeners.push_back(std::move(listener));
+}
 
-    if (key.empty())
+// =======================
+// Handle HTTP Request
+// =======================
+KVServer::HttpOutcome KVServer::handleClient(Endpoint &connection, Database *database, std::pmr::memory_resource *arena)
+{
+    // The request is parsed in place from the connection's input, which
+    // serviceConnection() fills without blocking. Until the header block
+    // ("\r\n\r\n") and then Content-Length bytes of body have arrived, the
+    // connection just waits in epoll for more, holding no worker. Large or
+    // chunked raw uploads are the exception: as soon as the headers are
+    // complete, the connection goes to an upload thread, which streams the
+    // body to storage.
+    int client_socket = connection.fd;
+    std::string_view input = connection.input;
+    http1::Request request;
+    bool headers_complete = http1::parseRequest(input, request);
+    if (!headers_complete && input.size() <= kMaxHeaderBytes)
+        return HttpOutcome::Incomplete;
+
+    bool stream_body = false;
+    if (headers_complete)
     {
-        return buildHttpResponse(400, "{\"error\":\"Missing key parameter\"}");
+        stream_body = isStreamingUpload(request);
+        if (!stream_body && !request.chunked && request.content_length <= kMaxBodyBytes &&
+            request.body.size() < request.content_length)
+        {
+            // Tell clients waiting for permission (curl does for large bodies)
+            // to send the body; only before any of it has arrived, and once:
+            // the request is parsed again whenever more input arrives.
+            if (request.body.empty() && !connection.continue_sent && http1::expectsContinue(request))
+            {
+                sendBuffers(client_socket, "HTTP/1.1 100 Continue\r\n\r\n", {}, 0);
+                connection.continue_sent = true;
+            }
+            return HttpOutcome::Incomplete;
+        }
     }
 
-    // Try to get value from cache first
-    std::string value = cache->get(key);
-    
+    // A client with prior knowledge of HTTP/2 starts with the connection
+    // preface, whose first line looks like a request ("PRI * HTTP/2.0").
+    if (connection.first_request && headers_complete && input.substr(0, 16) == http2::kPreface.substr(0, 16))
+        return adoptHttp2Connection(connection, input, {}, nullptr, database, arena) ? HttpOutcome::Adopted
+                                                                                    : HttpOutcome::Close;
 
-    if (!value.empty())
+    if (stream_body)
+        return HttpOutcome::Upload;
+
+    total_requests++; // Increment total request count
+
+    HttpResponse response(arena);
+
+    if (!headers_complete || request.content_length > kMaxBodyBytes)
     {
-        cache_hits++;
-        std::ostringstream json;
-        json << "{\"key\":\"" << key << "\",\"value\":\"" << value << "\"}";
-        return buildHttpResponse(200, json.str());
+        response = buildHttpResponse(413, "{\"error\":\"Request too large\"}", arena);
+        sendResponse(client_socket, response);
+        return HttpOutcome::Close;
     }
 
-    cache_misses++;
-
-    // If cache miss, retrieve from database
-    
-    if (database->get(key, value))
+    if (request.chunked)
     {
-        
-        cache->put(key, value); // Store result in cache for next time
+        // Chunked bodies are only decoded on the streaming upload path.
+        response = buildHttpResponse(411, "{\"error\":\"Content-Length required\"}", arena);
+        sendResponse(client_socket, response);
+        return HttpOutcome::Close;
+    }
+
+    response = routeRequest(request.method, request.target, request.headers.accept_encoding, request.body, database,
+                            arena);
 
-        std::ostringstream json;
-        json << "{\"key\":\"" << key << "\",\"value\":\"" << value << "\"}";
-        return buildHttpResponse(200, json.str());
+    // "Upgrade: h2c" (RFC 7540, section 3.2): the request is answered as
+    // stream 1 of an HTTP/2 connection instead, after a 101 response.
+    if (connection.first_request && http1::upgradesToHttp2(request))
+    {
+        std::string_view pipelined = input.substr(request.size());
+        return adoptHttp2Connection(connection, pipelined, request.headers.http2_settings,
+                                    &response, database, arena)
+                   ? HttpOutcome::Adopted
+                   : HttpOutcome::Close;
     }
 
-    // Key not found in database
-    return buildHttpResponse(404, "{\"error\":\"Key not found\"}");
+    // Send back the HTTP response.
+    bool keep_alive = http1::keepsAlive(request);
+    if (!sendResponse(client_socket, response, keep_alive) || !keep_alive)
+        return HttpOutcome::Close;
+    connection.input.erase(0, request.size());
+    connection.continue_sent = false;
+    return HttpOutcome::KeepAlive;
 }
 
 // =======================
-// Handle DELETE Request
+// Upload Thread Function
 // =======================
-std::string KVServer::handleDeleteRequest(const std::string &query, Database *database)
+void KVServer::uploadThread()
 {
-    std::string key = parseKeyFromQuery(query);
+    // Like a worker, an upload thread has its own database connection and arena.
+    auto database = std::make_unique<Database>(
+        db_host.c_str(), db_port.c_str(), db_name.c_str(),
+        db_user.c_str(), db_password.c_str());
+    std::unique_ptr<char[]> arena_buffer(new char[kArenaSize]);
+    std::pmr::monotonic_buffer_resource arena(arena_buffer.get(), kArenaSize);
 
-    if (key.empty())
+    while (running)
     {
-        return buildHttpResponse(400, "{\"error\":\"Missing key parameter\"}");
-    }
-
-    // Remove from database and cache
-    if (!database->del(key)) {
-        std::cerr << "[ERROR] DELETE failed for key: " << key << std::endl;
-        return buildHttpResponse(500, "{\"error\":\"Database delete failed\"}");
+        std::shared_ptr<Endpoint> connection;
+        {
+            // The timeout lets the thread notice shutdown.
+            std::unique_lock<std::mutex> lock(uploads_mtx);
+            if (!uploads_cv.wait_for(lock, std::chrono::milliseconds(kPollTimeoutMs),
+                                     [this] { return !uploads.empty(); }))
+                continue;
+            connection = std::move(uploads.front());
+            uploads.pop_front();
+        }
+        serveUpload(*connection, database.get(), &arena);
+        closeConnection(*connection);
+        arena.release();
     }
-    cache->del(key);
-
-    return buildHttpResponse(200, "{\"status\":\"success\"}");
 }
 
 // =======================
-// Parse key from query string
+// Hand a streaming upload to the upload threads
 // =======================
-std::string KVServer::parseKeyFromQuery(const std::string &query)
+void KVServer::queueUpload(Endpoint &connection, std::pmr::memory_resource *arena)
 {
-    size_t key_pos = query.find("key=");
-    if (key_pos == std::string::npos)
     {
-        return "";
+        std::lock_guard<std::mutex> lock(uploads_mtx);
+        if (uploads.size() < kMaxQueuedUploads)
+        {
+            // The caller holds a reference, so the connection is still registered.
+            uploads.push_back(findConnection(connection.id));
+            uploads_cv.notify_one();
+            return;
+        }
     }
+    total_requests++;
+    HttpResponse response = buildHttpResponse(503, "{\"error\":\"Too many uploads\"}", arena);
+    sendResponse(connection.fd, response);
+    closeConnection(connection);
+}
 
-    size_t start = key_pos + 4;
-    // Find the end of the key parameter (next '&' or end of string)
-    size_t end = query.find('&', start);
+// =======================
+// Answer a streaming upload
+// =======================
+void KVServer::serveUpload(Endpoint &connection, Database *database, std::pmr::memory_resource *arena)
+{
+    // handleClient() found the headers complete and the request to be a
+    // streaming upload. isStreamingUpload() only accepts /api/kv/{key}; the
+    // key is the rest of the path, and whatever body bytes arrived with the
+    // headers are handed over first.
+    std::string_view input = connection.input;
+    http1::Request request;
+    http1::parseRequest(input, request);
+    total_requests++;
+
+    std::string_view path = request.target.substr(0, request.target.find('?'));
+    std::pmr::string key = http1::percentDecode(path.substr(kRawPathPrefix.size()), arena);
+    std::string_view received = input.substr(request.body_offset);
+    bool send_continue = !connection.continue_sent && received.empty() && http1::expectsContinue(request);
+    HttpResponse response = handleStreamingPut(connection.fd, key, request, send_continue, received, database, arena);
+
+    // The upload may have left part of its body unread, so the connection
+    // is not reused.
+    sendResponse(connection.fd, response, false);
+}
 
-    if (end == std::string::npos)
+// =======================
+// Serve the buffered HTTP/1.1 requests of a connection
+// =======================
+KVServer::HttpOutcome KVServer::serveHttp(Endpoint &connection, Database *database, std::pmr::memory_resource *arena)
+{
+    while (true)
     {
-        // If no '&' found, return substring from start to end of string
-        return query.substr(start);
+        HttpOutcome outcome = handleClient(connection, database, arena);
+        if (outcome != HttpOutcome::KeepAlive)
+            return outcome;
+        connection.first_request = false;
     }
-    // Return substring from start to the position of '&'
-    return query.substr(start, end - start);
 }
 
 // =======================
-// Parse key-value from JSON body
+// Route a request to its handler
 // =======================
-void KVServer::parseKeyValue(const std::string &body, std::string &key, std::string &value)
+KVServer::HttpResponse KVServer::routeRequest(std::string_view method, std::string_view path, std::string_view accept_encoding,
+                                              std::string_view body, Database *database,
+                                              std::pmr::memory_resource *arena)
 {
-    // Simplified JSON parsing for {"key":"...", "value":"..."}
-    // Find positions of "key" and "value" in the body string
-    size_t key_start = body.find("\"key\"");
-    size_t value_start = body.find("\"value\"");
+    HttpResponse response(arena);
 
-    // If either "key" or "value" is not found, return without modifying key/value
-    if (key_start == std::string::npos || value_start == std::string::npos)
-    {
-        return;
-    }
+    // Split the query string (if any) off the URL path.
+    //     "/api/kv?key=a" → path "/api/kv", query "key=a"
+    std::string_view query;
+    http1::splitTarget(path, path, query);
 
-    // Extract the value of the "key" field from a JSON-formatted HTTP request body.
-    //
-    // Example input body (from a POST request):
-    //     {"key":"username","value":"Manish"}
-    //
-    // After this block executes:
-    //     key = "username"
+    // gzip responses are only offered when compression is enabled and the client asks for it.
+    bool accept_gzip = compression_threshold > 0 &&
+                       compression::acceptsGzip(accept_encoding);
 
-    //    - Finds the position of the colon ':' that follows the "key" field name.
-    //    - 'key_start' is assumed to be the position where the substring "key" was found earlier.
-    //    - Adding +1 moves the index to just after the colon.
-    //    - Example: For '{"key":"username"}', this points right before the first '"' in the value.
-    size_t key_value_start = body.find(':', key_start) + 1;
+    // Handle different HTTP API endpoints and methods based on the parsed 'path' and 'method'.
+    //
+    // Supported endpoints:
+    //   1. /api/kv         → Key-Value store operations (CRUD) with JSON bodies
+    //   2. /api/kv/{key}   → Same, with raw application/octet-stream values
+    //   3. /stats          → Server statistics
+    //   Otherwise → 404 Not Found
+    if (path.size() > kRawPathPrefix.size() && path.compare(0, kRawPathPrefix.size(), kRawPathPrefix) == 0)
+    {
+        // The key is the rest of the path, percent-decoded so it may contain any byte.
+        std::pmr::string key = http1::percentDecode(path.substr(kRawPathPrefix.size()), arena);
+        response = handleRawRequest(method, key, body, database, arena, accept_gzip);
+    }
+    else if (path == "/api/kv")
+    {
+
+        if (method == "POST")
+        {
+            // Used for creating or updating a key-value pair.
+            // Expects data in the request body, e.g., {"key": "name", "value": "Manish"}.
+            response = handlePutRequest(body, database, arena); // Create/Update
+        }
+
+        else if (method == "GET")
+        {
+            //  Retrieves the value associated with a given key.
+            //  Expects a query string in the URL, e.g., /api/kv?key=name.
+            response = handleGetRequest(query, database, arena, accept_gzip); // Read
+        }
+
+        else if (method == "DELETE")
+        {
+            // Deletes a key-value pair identified by the key in the query string.
+            response = handleDeleteRequest(query, database, arena); // Delete
+        }
+        else
+        {
+            // If any other HTTP method is used (e.g., PUT, PATCH, OPTIONS),
+            // respond with HTTP 405 "Method Not Allowed".
+            response = buildHttpResponse(405, "{\"error\":\"Method not allowed\"}", arena);
+        }
+    }
+    // Handles a special endpoint that reports server performance statistics.
+    // Useful for monitoring purposes.
+    else if (path == "/stats")
+    {
+        LRUCache::Stats cache_stats = cache->stats();
+        SlabAllocator::Stats slab_stats = SlabAllocator::instance().stats();
+        compression::Stats comp = compression::stats();
+        large_value::Stats large = large_value::stats();
+        hottable::Publisher::Stats hot_stats = hot_table ? hot_table->stats() : hottable::Publisher::Stats();
+
+        std::ostringstream stats; // Create a std::ostringstream object 'stats' to build a JSON response dynamically.
+        stats << "{\"total_requests\":" << total_requests
+              << ",\"cache_hits\":" << cache_hits
+              << ",\"cache_misses\":" << cache_misses
+              << ",\"hit_rate\":" << (total_requests > 0 ? (double)cache_hits / total_requests : 0)
+              << ",\"cache_entries\":" << cache_stats.entries
+              << ",\"cache_entry_bytes\":" << cache_stats.entry_bytes
+              << ",\"slab_bytes_reserved\":" << slab_stats.bytes_reserved
+              << ",\"slab_bytes_in_use\":" << slab_stats.bytes_in_use
+              << ",\"slab_large_bytes\":" << slab_stats.large_bytes
+              << ",\"slab_idle_pages\":" << slab_stats.idle_pages
+              << ",\"compressed_values\":" << comp.values_compressed
+              << ",\"compression_ratio\":" << (comp.compressed_bytes > 0 ? (double)comp.raw_bytes / comp.compressed_bytes : 0)
+              << ",\"compress_cpu_ms\":" << comp.compress_ns / 1e6
+              << ",\"decompress_cpu_ms\":" << comp.decompress_ns / 1e6
+              << ",\"gzip_passthrough_responses\":" << comp.gzip_passthrough
+              << ",\"gzip_compressed_responses\":" << comp.gzip_compressed
+              << ",\"large_values\":" << cache_stats.file_entries
+              << ",\"large_value_bytes\":" << cache_stats.file_bytes
+              << ",\"large_value_files_created\":" << large.files_created
+              << ",\"sendfile_bytes\":" << large.sendfile_bytes
+              << ",\"streamed_uploads\":" << streamed_uploads
+              << ",\"streamed_upload_bytes\":" << streamed_upload_bytes
+              << ",\"persistent_connections\":" << connectionCount()
+              << ",\"memcache_commands\":" << memcache_commands
+              << ",\"resp_commands\":" << resp_commands
+              << ",\"binary_requests\":" << binary_requests
+              << ",\"binary_deferred\":" << binary_deferred
+              << ",\"expiring_keys\":" << expiring_keys
+              << ",\"expired_keys\":" << expired_keys
+              << ",\"http2_streams\":" << http2_streams
+              << ",\"http2_deferred\":" << http2_deferred
+              << ",\"hot_table_published\":" << hot_stats.published
+              << ",\"hot_table_updated\":" << hot_stats.updated
+              << ",\"hot_table_invalidated\":" << hot_stats.invalidated
+              << ",\"slab_classes\":[";
+        // One object per size class that currently owns pages
+        for (size_t i = 0; i < slab_stats.classes.size(); ++i)
+        {
+            const auto &c = slab_stats.classes[i];
+            stats << (i ? "," : "") << "{\"chunk_size\":" << c.chunk_size
+                  << ",\"pages\":" << c.pages
+                  << ",\"chunks_used\":" << c.chunks_used
+                  << ",\"chunks_per_page\":" << c.chunks_per_page << "}";
+        }
+        stats << "]}";
+        // The constructed JSON string might look like:
+        //           {"total_requests":120,"cache_hits":85,"cache_misses":35,"hit_rate":0.7083,
+        //            "cache_entries":35,...,"slab_classes":[{"chunk_size":96,"pages":1,...}]}
+
+        // Send back a 200 OK response with the JSON statistics.
+        response = buildHttpResponse(200, stats.str(), arena);
+    }
+    // Invalid endpoint
+    else
+    {
+        //    - This branch handles invalid or unknown endpoints (not matching /api/kv or /stats).
+        //    - Responds with HTTP 404 "Not Found" and a JSON error message:
+        response = buildHttpResponse(404, "{\"error\":\"Not found\"}", arena);
+    }
+
+    return response;
+}
+
+// =======================
+// Take over an HTTP/2 connection
+// =======================
+bool KVServer::adoptHttp2Connection(Endpoint &connection, std::string_view received,
+                                    std::string_view http2_settings, HttpResponse *upgrade_response,
+                                    Database *database, std::pmr::memory_resource *arena)
+{
+    auto session = std::make_unique<http2::Session>(kMaxBodyBytes);
+
+    std::pmr::string output(arena);
+    if (upgrade_response)
+    {
+        // Malformed settings: decline the upgrade and answer over HTTP/1.1.
+        if (!session->upgrade(http2_settings))
+        {
+            sendResponse(connection.fd, *upgrade_response);
+            return false;
+        }
+        output += "HTTP/1.1 101 Switching Protocols\r\nConnection: Upgrade\r\nUpgrade: h2c\r\n\r\n";
+    }
+
+    // 'received' is a view of the end of the input: drop what comes before.
+    connection.input.erase(0, received.data() - connection.input.data());
+    connection.protocol = Protocol::Http2;
+    connection.http2_session = std::move(session);
+
+    // Server preface, the upgraded request's response, then whatever frames
+    // the client sent along with its first request. From now on the
+    // connection is served as HTTP/2 by serviceConnection().
+    std::lock_guard<std::mutex> lock(connection.send_mtx);
+    connection.http2_session->start(output);
+    if (upgrade_response)
+        respondHttp2(*connection.http2_session, 1, *upgrade_response, output);
+    bool keep_open = handleHttp2Input(connection, database, arena, output);
+    return sendBuffers(connection.fd, output, {}, 0) && keep_open;
+}
+
+// =======================
+// Handle HTTP/2 input
+// =======================
+bool KVServer::handleHttp2Input(Endpoint &connection, Database *database, std::pmr::memory_resource *arena,
+                                std::pmr::string &output)
+{
+    std::vector<http2::Request> requests;
+    size_t consumed = 0;
+    bool keep_open = connection.http2_session->receive(connection.input, consumed, requests, output);
+    connection.input.erase(0, consumed);
+
+    // Each stream is routed exactly like an HTTP/1.1 request; the session
+    // interleaves the response bodies under flow control. Streams that need
+    // the database are executed after the connection is re-armed, in order,
+    // so cache hits behind them are answered now; a GET waits behind any
+    // queued write, which it could otherwise overtake.
+    for (http2::Request &request : requests)
+    {
+        total_requests++;
+        http2_streams++;
+        if (!request.too_large)
+        {
+            bool read = request.method == "GET";
+            std::lock_guard<std::mutex> lock(connection.deferred_mtx);
+            if ((read && connection.deferred_stream_writes > 0) || needsDatabase(request.method, request.target))
+            {
+                if (!read)
+                    connection.deferred_stream_writes++;
+                connection.deferred_streams.push_back(std::move(request));
+                continue;
+            }
+        }
+
+        HttpResponse response(arena);
+        if (request.too_large)
+            response = buildHttpResponse(413, "{\"error\":\"Request too large\"}", arena);
+        else
+            response = routeRequest(request.method, request.target, http1::findHeader(request.headers, "accept-encoding"),
+                                    request.body, database, arena);
+        respondHttp2(*connection.http2_session, request.stream_id, response, output);
+    }
+    return keep_open && !connection.http2_session->finished();
+}
+
+bool KVServer::needsDatabase(std::string_view method, std::string_view target)
+{
+    std::string_view path, query;
+    http1::splitTarget(target, path, query);
+    if (path.size() > kRawPathPrefix.size() && path.compare(0, kRawPathPrefix.size(), kRawPathPrefix) == 0)
+    {
+        // Decoded on the stack; a longer key spills to the heap.
+        char buffer[256];
+        std::pmr::monotonic_buffer_resource decode_arena(buffer, sizeof(buffer));
+        return method != "GET" || !cache->contains(http1::percentDecode(path.substr(kRawPathPrefix.size()), &decode_arena));
+    }
+    if (path == "/api/kv")
+    {
+        if (method == "GET")
+            return !cache->contains(http1::parseKeyFromQuery(query));
+        return method == "POST" || method == "DELETE";
+    }
+    return false; // Statistics, or an error answered without storage
+}
+
+bool KVServer::executeStream(Endpoint &connection, http2::Request &stream, Database *database)
+{
+    // Routed on an arena of its own: the queue may be executed for as long
+    // as the client keeps sending, so the worker's arena would only grow.
+    std::pmr::monotonic_buffer_resource arena;
+    HttpResponse response = routeRequest(stream.method, stream.target, http1::findHeader(stream.headers, "accept-encoding"),
+                                         stream.body, database, &arena);
+    http2_deferred++;
+
+    if (stream.method != "GET")
+    {
+        std::lock_guard<std::mutex> lock(connection.deferred_mtx);
+        connection.deferred_stream_writes--;
+    }
+
+    std::pmr::string output(&arena);
+    std::lock_guard<std::mutex> lock(connection.send_mtx);
+    respondHttp2(*connection.http2_session, stream.stream_id, response, output);
+    return sendBuffers(connection.fd, output, {}, 0);
+}
+
+// =======================
+// Send an HttpResponse on an HTTP/2 stream
+// =======================
+void KVServer::respondHttp2(http2::Session &session, uint32_t stream_id, const HttpResponse &response,
+                            std::pmr::string &output)
+{
+    // The head is "HTTP/1.1 200 OK\r\n" followed by the header lines, which
+    // the session converts (dropping Connection and the blank line).
+    std::string_view head = response.head;
+    int status = 500;
+    if (head.size() >= 12)
+        std::from_chars(head.data() + 9, head.data() + 12, status);
+    size_t line_end = head.find("\r\n");
+    std::string_view headers = line_end == std::string_view::npos ? std::string_view() : head.substr(line_end + 2);
+
+    // DATA frames are built in memory, so a file body is read rather than
+    // sent with sendfile().
+    std::string body;
+    body.reserve(response.body.size() + response.file_size + response.tail.size());
+    body.append(response.body);
+    if (response.file_fd >= 0)
+    {
+        size_t offset = body.size();
+        body.resize(offset + response.file_size);
+        if (!large_value::read(response.file_fd, &body[offset], response.file_size))
+            body.resize(offset);
+    }
+    body.append(response.tail);
+    session.respond(stream_id, status, headers, std::move(body), output);
+}
+
+// =======================
+// Handle POST/PUT Request
+// =======================
+KVServer::HttpResponse KVServer::handlePutRequest(std::string_view body, Database *database, std::pmr::memory_resource *arena)
+{
+    std::string_view key, value;
+    http1::parseKeyValue(body, key, value); // Extract key and value from JSON
+
+    if (key.empty())
+    {
+        return buildHttpResponse(400, "{\"error\":\"Invalid request body\"}", arena);
+    }
+
+    return storeValue(key, value, database, arena);
+}
+
+// =======================
+// Store a value (DB, then cache)
+// =======================
+KVServer::HttpResponse KVServer::storeValue(std::string_view key, std::string_view value, Database *database, std::pmr::memory_resource *arena)
+{
+    // If database write fails, return 500 error
+    std::lock_guard<std::mutex> lock(keyLock(key));
+    if (!writeValueWithExpiry(key, value, std::nullopt, database))
+        return buildHttpResponse(500, "{\"error\":\"Database write failed\"}", arena);
+
+    return buildHttpResponse(200, "{\"status\":\"success\"}", arena);
+}
+
+// =======================
+// Handle GET Request
+// =======================
+KVServer::HttpResponse KVServer::handleGetRequest(std::string_view query, Database *database, std::pmr::memory_resource *arena, bool accept_gzip)
+{
+    // It searches the query string for a parameter named "key=".
+    // Returns the substring after "key=" up to the next '&' (if any) or the end.
+    // e.g., for "key=user123&value=abc", it would return "user123".
+    // If "key=" is not found, it should return an empty string.
+    std::string_view key = http1::parseKeyFromQuery(query);
+
+    if (key.empty())
+    {
+        return buildHttpResponse(400, "{\"error\":\"Missing key parameter\"}", arena);
+    }
+
+    expireIfDue(key, database);
+
+    // Try to get value from cache first, copying the stored bytes straight into the arena.
+    std::pmr::string stored(arena);
+    LRUCache::StoredValue meta;
+    bool hit = cache->getStored(key, stored, meta);
+    if (hit && meta.compressed && !accept_gzip)
+        hit = inflateStored(stored, meta);
+    if (hit)
+    {
+        cache_hits++;
+        exportHotEntry(key, meta.raw_size);
+        traceOperation(reqtrace::Op::Get, key, meta.raw_size, true);
+        if (meta.fd >= 0)
+        {
+            // Very large value: send the JSON around the file without copying it.
+            std::pmr::string prefix(arena);
+            prefix.append("{\"key\":\"").append(key).append("\",\"value\":\"");
+            return withCacheStatus(
+                buildFileResponse(meta.fd, meta.raw_size, prefix, "\"}", "application/json", arena), true);
+        }
+        if (!meta.compressed)
+            return withCacheStatus(buildHttpResponse(200, http1::buildKeyValueJson(key, stored, arena)), true);
+
+        // Compressed, and the client takes gzip (it was inflated above otherwise):
+        // serve the cached deflate bytes as-is, wrapped into a gzip body.
+        std::pmr::string prefix(arena);
+        prefix.append("{\"key\":\"").append(key).append("\",\"value\":\"");
+        std::pmr::string gz(arena);
+        gz.reserve(prefix.size() + stored.size() + 64);
+        compression::appendGzipSpliced(gz, prefix, stored, meta.crc32, meta.raw_size, "\"}");
+        return withCacheStatus(buildHttpResponse(200, std::move(gz), kGzipHeaders), true);
+    }
+
+    cache_misses++;
+
+    // If cache miss, retrieve from database
+    std::string db_value;
+    bool found = database->get(key, db_value);
+    traceOperation(reqtrace::Op::Get, key, db_value.size());
+    if (found)
+    {
+
+        cache->put(key, db_value); // Store result in cache for next time
+
+        std::pmr::string json = http1::buildKeyValueJson(key, db_value, arena);
+        if (accept_gzip && db_value.size() >= compression_threshold)
+        {
+            std::pmr::string gz(arena);
+            compression::appendGzip(gz, json);
+            return withCacheStatus(buildHttpResponse(200, std::move(gz), kGzipHeaders), false);
+        }
+        return withCacheStatus(buildHttpResponse(200, std::move(json)), false);
+    }
+
+    // Key not found in database
+    return withCacheStatus(buildHttpResponse(404, "{\"error\":\"Key not found\"}", arena), false);
+}
+
+// =======================
+// Handle DELETE Request
+// =======================
+KVServer::HttpResponse KVServer::handleDeleteRequest(std::string_view query, Database *database, std::pmr::memory_resource *arena)
+{
+    std::string_view key = http1::parseKeyFromQuery(query);
+
+    if (key.empty())
+    {
+        return buildHttpResponse(400, "{\"error\":\"Missing key parameter\"}", arena);
+    }
+
+    return deleteValue(key, database, arena);
+}
+
+// =======================
+// Delete a value (DB, then cache)
+// =======================
+KVServer::HttpResponse KVServer::deleteValue(std::string_view key, Database *database, std::pmr::memory_resource *arena)
+{
+    std::lock_guard<std::mutex> lock(keyLock(key));
+    if (!removeValue(key, database))
+        return buildHttpResponse(500, "{\"error\":\"Database delete failed\"}", arena);
+
+    return buildHttpResponse(200, "{\"status\":\"success\"}", arena);
+}
+
+// =======================
+// Storage path shared by all protocols
+// =======================
+bool KVServer::fetchValue(std::string_view key, Database *database, std::pmr::string &value)
+{
+    // Cache first (lock-free), then the database, filling the cache on a miss.
+    if (expireIfDue(key, database))
+        return false;
+    if (fetchCachedValue(key, value))
+        return true;
+
+    cache_misses++;
+    std::string db_value;
+    bool found = database->get(key, db_value);
+    traceOperation(reqtrace::Op::Get, key, db_value.size());
+    if (!found)
+        return false;
+
+    cache->put(key, db_value);
+    value.assign(db_value);
+    return true;
+}
+
+bool KVServer::fetchCachedValue(std::string_view key, std::pmr::string &value)
+{
+    if (!cache->get(key, value))
+        return false;
+    cache_hits++;
+    exportHotEntry(key, value.size());
+    traceOperation(reqtrace::Op::Get, key, value.size(), true);
+    return true;
+}
+
+bool KVServer::writeValue(std::string_view key, std::string_view value, Database *database)
+{
+    traceOperation(reqtrace::Op::Put, key, value.size());
+
+    // Write key-value pair to database first; the cache only ever holds
+    // values that are durable.
+    if (!database->put(key, value))
+    {
+        std::cerr << "[ERROR] PUT failed for key: " << key << std::endl;
+        return false;
+    }
+
+    // Update in-memory cache as well, then the shared table, before the
+    // write is acknowledged
+    cache->put(key, value);
+    if (hot_table)
+        hot_table->update(key, value);
+    return true;
+}
+
+bool KVServer::writeValueWithExpiry(std::string_view key, std::string_view value,
+                                    std::optional<std::chrono::steady_clock::time_point> deadline, Database *database)
+{
+    // The old TTL is dropped before the write, so that an expiry sweep can't
+    // delete the new value; it is put back if the write fails.
+    std::optional<std::chrono::steady_clock::time_point> previous = clearExpiry(key);
+    if (!writeValue(key, value, database))
+    {
+        if (previous)
+            setExpiry(key, *previous);
+        return false;
+    }
+    if (deadline)
+        setExpiry(key, *deadline);
+    return true;
+}
+
+bool KVServer::removeValue(std::string_view key, Database *database, bool *existed)
+{
+    // Remove from database and cache
+    traceOperation(reqtrace::Op::Delete, key, 0);
+    clearExpiry(key);
+    if (!database->del(key, existed))
+    {
+        std::cerr << "[ERROR] DELETE failed for key: " << key << std::endl;
+        return false;
+    }
+    cache->del(key);
+    if (hot_table)
+        hot_table->invalidate(key);
+    return true;
+}
+
+void KVServer::exportHotEntry(std::string_view key, size_t value_size)
+{
+    if (!hot_table || !hottable::Publisher::fits(key.size(), value_size) || hot_table->holds(key))
+        return;
+
+    // Re-read the value after taking the ticket: a write landing in between
+    // bumps the ticket and the possibly stale value is not published.
+    uint64_t ticket = hot_table->ticket(key);
+    std::string value;
+    if (cache->get(key, value))
+        hot_table->publish(key, value, ticket);
+}
+
+std::mutex &KVServer::keyLock(std::string_view key)
+{
+    return key_locks[std::hash<std::string_view>()(key) % kKeyLockStripes];
+}
+
+// =======================
+// Key expiration (TTL)
+// =======================
+KVServer::ExpiryStripe &KVServer::expiryStripe(std::string_view key)
+{
+    return expiry_stripes[std::hash<std::string_view>()(key) % kKeyLockStripes];
+}
+
+void KVServer::setExpiry(std::string_view key, std::chrono::steady_clock::time_point deadline)
+{
+    ExpiryStripe &stripe = expiryStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mtx);
+    if (stripe.deadlines.insert_or_assign(std::string(key), deadline).second)
+        expiring_keys++;
+}
+
+std::optional<std::chrono::steady_clock::time_point> KVServer::clearExpiry(std::string_view key)
+{
+    // Most stores never use TTLs: skip the lock (and the key copy) then.
+    if (expiring_keys.load(std::memory_order_relaxed) == 0)
+        return std::nullopt;
+    ExpiryStripe &stripe = expiryStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mtx);
+    auto it = stripe.deadlines.find(std::string(key));
+    if (it == stripe.deadlines.end())
+        return std::nullopt;
+    auto deadline = it->second;
+    stripe.deadlines.erase(it);
+    expiring_keys--;
+    return deadline;
+}
+
+bool KVServer::expireIfDue(std::string_view key, Database *database)
+{
+    if (expiring_keys.load(std::memory_order_relaxed) == 0)
+        return false;
+
+    ExpiryStripe &stripe = expiryStripe(key);
+    std::lock_guard<std::mutex> lock(stripe.mtx);
+    auto it = stripe.deadlines.find(std::string(key));
+    if (it == stripe.deadlines.end() || it->second > std::chrono::steady_clock::now())
+        return false;
+
+    // The stripe stays locked while the key is deleted: a writer replacing the
+    // value clears its TTL first, so it waits here instead of being deleted.
+    stripe.deadlines.erase(it);
+    expiring_keys--;
+    database->del(key);
+    cache->del(key);
+    if (hot_table)
+        hot_table->invalidate(key);
+    expired_keys++;
+    return true;
+}
+
+void KVServer::expireDueKeys(Database *database)
+{
+    if (expiring_keys.load(std::memory_order_relaxed) == 0)
+        return;
+
+    // One stripe per idle round, so the sweep never holds a worker for long.
+    ExpiryStripe &stripe = expiry_stripes[next_expiry_stripe++ % kKeyLockStripes];
+    std::lock_guard<std::mutex> lock(stripe.mtx);
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = stripe.deadlines.begin(); it != stripe.deadlines.end();)
+    {
+        if (it->second > now)
+        {
+            ++it;
+            continue;
+        }
+        database->del(it->first);
+        cache->del(it->first);
+        if (hot_table)
+            hot_table->invalidate(it->first);
+        it = stripe.deadlines.erase(it);
+        expiring_keys--;
+        expired_keys++;
+    }
+}
+
+// =======================
+// Handle /api/kv/{key} (raw octet-stream values)
+// =======================
+KVServer::HttpResponse KVServer::handleRawRequest(std::string_view method, std::string_view key, std::string_view body,
+                                                  Database *database, std::pmr::memory_resource *arena, bool accept_gzip)
+{
+    if (key.empty())
+    {
+        return buildHttpResponse(400, "{\"error\":\"Missing key\"}", arena);
+    }
+
+    if (method == "PUT" || method == "POST")
+    {
+        // The body is the value itself: no JSON parsing, no escaping, any bytes.
+        return storeValue(key, body, database, arena);
+    }
+
+    if (method == "DELETE")
+    {
+        return deleteValue(key, database, arena);
+    }
+
+    if (method != "GET")
+    {
+        return buildHttpResponse(405, "{\"error\":\"Method not allowed\"}", arena);
+    }
+
+    expireIfDue(key, database);
+
+    // Cache hit: the stored bytes are copied once, from the cache entry into the
+    // arena, and that buffer becomes the response body sent with writev().
+    std::pmr::string stored(arena);
+    LRUCache::StoredValue meta;
+    bool hit = cache->getStored(key, stored, meta);
+    if (hit && meta.compressed && !accept_gzip)
+        hit = inflateStored(stored, meta);
+    if (hit)
+    {
+        cache_hits++;
+        exportHotEntry(key, meta.raw_size);
+        traceOperation(reqtrace::Op::Get, key, meta.raw_size, true);
+        if (meta.fd >= 0)
+            return withCacheStatus(buildFileResponse(meta.fd, meta.raw_size, {}, {}, kOctetStream, arena), true);
+        if (!meta.compressed)
+            return withCacheStatus(buildHttpResponse(200, std::move(stored), {}, kOctetStream), true);
+
+        std::pmr::string gz(arena);
+        gz.reserve(stored.size() + 64);
+        compression::appendGzipSpliced(gz, {}, stored, meta.crc32, meta.raw_size, {});
+        return withCacheStatus(buildHttpResponse(200, std::move(gz), kGzipHeaders, kOctetStream), true);
+    }
+
+    cache_misses++;
+
+    std::string db_value;
+    bool found = database->get(key, db_value);
+    traceOperation(reqtrace::Op::Get, key, db_value.size());
+    if (found)
+    {
+        cache->put(key, db_value); // Store result in cache for next time
+        return withCacheStatus(buildHttpResponse(200, std::pmr::string(db_value, arena), {}, kOctetStream), false);
+    }
+
+    return withCacheStatus(buildHttpResponse(404, "{\"error\":\"Key not found\"}", arena), false);
+}
+
+// =======================
+// Stream a large PUT /api/kv/{key} body to storage
+// =======================
+KVServer::HttpResponse KVServer::handleStreamingPut(int client_socket, std::string_view key,
+                                                    const http1::Request &request, bool send_continue,
+                                                    std::string_view received, Database *database,
+                                                    std::pmr::memory_resource *arena)
+{
+    bool chunked = request.chunked;
+    size_t content_length = request.content_length;
+
+    if (key.empty())
+    {
+        return buildHttpResponse(400, "{\"error\":\"Missing key\"}", arena);
+    }
+    if (!chunked && content_length > kMaxUploadBytes)
+    {
+        return buildHttpResponse(413, "{\"error\":\"Request too large\"}", arena);
+    }
+
+    // A plain write: the new value does not inherit a TTL.
+    clearExpiry(key);
+    if (!database->beginPutStream(key))
+    {
+        std::cerr << "[ERROR] Streaming PUT failed for key: " << key << std::endl;
+        return buildHttpResponse(500, "{\"error\":\"Database write failed\"}", arena);
+    }
+
+    // Values that may reach the large-value threshold are also written to a
+    // memfd as they stream by, so the cache can serve them afterwards without
+    // the value ever being held in memory. Smaller ones are just invalidated.
+    int fd = -1;
+    if (large_value_threshold > 0 && (chunked || content_length >= large_value_threshold))
+        fd = large_value::create();
+
+    // Receive buffer: the only per-upload memory, whatever the value's size.
+    // The bytes already received are decoded where they are; only what is
+    // read from the socket goes through the buffer.
+    char buffer[kUploadChunkSize];
+    static_assert(ChunkedDecoder::kMaxLineLength + 1 < kUploadChunkSize, "a kept line must leave room to read");
+    std::string_view input = received; // Bytes not decoded yet
+
+    // Storage is ready: tell a client waiting for permission to send the body.
+    if (send_continue)
+        sendBuffers(client_socket, "HTTP/1.1 100 Continue\r\n\r\n", {}, 0);
+
+    ChunkedDecoder decoder;
+    size_t total = 0;
+    int status = 200;
+    while (status == 200)
+    {
+        // 1. Pick the next piece of payload out of the buffer, if there is one.
+        std::string_view data;
+        bool finished = false;
+        if (chunked)
+        {
+            size_t consumed = 0;
+            ChunkedDecoder::Status st = decoder.next(input, consumed, data);
+            input.remove_prefix(consumed);
+            if (st == ChunkedDecoder::Status::Error)
+                status = 400;
+            finished = st == ChunkedDecoder::Status::Done;
+        }
+        else
+        {
+            data = input.substr(0, content_length - total);
+            input.remove_prefix(data.size());
+            finished = total + data.size() == content_length;
+        }
+
+        // 2. Forward it to the database (and the memfd).
+        if (!data.empty())
+        {
+            total += data.size();
+            if (total > kMaxUploadBytes)
+                status = 413;
+            else if (!database->writePutStream(data) || (fd >= 0 && !large_value::append(fd, data)))
+                status = 500;
+        }
+        if (finished || status != 200)
+            break;
+
+        // 3. Refill: keep any partial chunk-size line, then read more.
+        if (data.empty())
+        {
+            // Only an incomplete chunk-size or trailer line is ever kept; the
+            // decoder rejects one longer than kMaxLineLength (plus the '\r'
+            // of its CRLF), so it fits.
+            size_t kept = input.size();
+            if (kept > ChunkedDecoder::kMaxLineLength + 1)
+            {
+                status = 400;
+                break;
+            }
+            std::memmove(buffer, input.data(), kept);
+            size_t want = sizeof(buffer) - kept;
+            if (!chunked)
+                want = std::min(want, content_length - total);
+            ssize_t bytes_read = recv(client_socket, buffer + kept, want, 0);
+            if (bytes_read <= 0)
+            {
+                status = 0; // Client went away mid-upload
+                break;
+            }
+            input = std::string_view(buffer, kept + bytes_read);
+        }
+    }
+
+    // Commit and bring the cache in line under the key's lock, as every
+    // other write does, so a concurrent write to the key can't land between
+    // the two and leave the cache holding the older value. The body itself
+    // is received without the lock: a slow client must not stall the stripe.
+    std::unique_lock<std::mutex> lock(keyLock(key), std::defer_lock);
+    if (status == 200)
+        lock.lock();
+    if (status != 200 || !database->endPutStream(true))
+    {
+        if (status != 200)
+            database->endPutStream(false);
+        if (fd >= 0)
+            close(fd);
+        if (status == 400)
+            return buildHttpResponse(400, "{\"error\":\"Malformed chunked body\"}", arena);
+        if (status == 413)
+            return buildHttpResponse(413, "{\"error\":\"Request too large\"}", arena);
+        std::cerr << "[ERROR] Streaming PUT failed for key: " << key << std::endl;
+        return buildHttpResponse(500, "{\"error\":\"Database write failed\"}", arena);
+    }
+
+    streamed_uploads++;
+    streamed_upload_bytes += total;
+    traceOperation(reqtrace::Op::Put, key, total);
+
+    // The database now has the new value; bring the cache in line.
+    if (fd >= 0 && total >= large_value_threshold)
+    {
+        large_value::seal(fd);
+        cache->putFile(key, fd, total);
+    }
+    else
+    {
+        if (fd >= 0)
+            close(fd);
+        cache->del(key);
+    }
+    if (hot_table)
+        hot_table->invalidate(key); // Streamed values never fit a slot
+
+    return buildHttpResponse(200, "{\"status\":\"success\"}", arena);
+}
+
+// =======================
+// Memcached text protocol
+// =======================
+bool KVServer::handleMemcacheInput(Endpoint &connection, Database *database, std::pmr::memory_resource *arena,
+                                   std::pmr::string &output)
+{
+    // Execute requests in order until the buffer holds only an incomplete one.
+    // The parsed requests are views into connection.input, which is compacted
+    // only after the loop.
+    std::string_view input = connection.input;
+    size_t offset = 0;
+    bool keep_open = true;
+    while (keep_open && offset < input.size())
+    {
+        memcache::Request request;
+        size_t consumed = 0;
+        std::string_view error;
+        memcache::ParseStatus status = memcache::parse(input.substr(offset), request, consumed, error);
+        if (status == memcache::ParseStatus::Incomplete)
+            break;
+
+        total_requests++;
+        memcache_commands++;
+        if (status == memcache::ParseStatus::Ok)
+        {
+            keep_open = executeMemcache(request, database, arena, output);
+        }
+        else
+        {
+            output.append(error).append("\r\n");
+            if (status == memcache::ParseStatus::Fatal)
+                return false;
+        }
+        offset += consumed;
+    }
+
+    connection.input.erase(0, offset);
+    return keep_open;
+}
+
+namespace
+{
+    // Appends a decimal number without going through a stream.
+    void appendNumber(std::pmr::string &out, uint64_t value)
+    {
+        char digits[24];
+        out.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr - digits);
+    }
+
+    // The "cas unique" of a value. Values carry no version number, so the token
+    // is a hash of the current contents: cas succeeds iff the value is unchanged.
+    uint64_t casToken(std::string_view value)
+    {
+        uint64_t token = std::hash<std::string_view>()(value);
+        return token ? token : 1;
+    }
+}
+
+std::string_view KVServer::storeMemcacheValue(const memcache::Request &request, Database *database)
+{
+    // exptime: 0 = never expires; negative = already expired; up to 30 days,
+    // seconds from now; beyond that, an absolute Unix time.
+    constexpr int64_t kMaxRelativeExptime = 30 * 24 * 3600;
+    std::string_view key = request.keys;
+    int64_t ttl = request.exptime;
+    if (ttl > kMaxRelativeExptime)
+        ttl -= std::chrono::duration_cast<std::chrono::seconds>(
+                   std::chrono::system_clock::now().time_since_epoch()).count();
+
+    if (request.exptime != 0 && ttl <= 0)
+    {
+        // Stored and immediately expired: the key simply goes away.
+        return removeValue(key, database) ? "STORED" : "SERVER_ERROR storage failure";
+    }
+
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    if (request.exptime != 0)
+        deadline = std::chrono::steady_clock::now() + std::chrono::seconds(ttl);
+    return writeValueWithExpiry(key, request.data, deadline, database) ? "STORED" : "SERVER_ERROR storage failure";
+}
+
+bool KVServer::executeMemcache(const memcache::Request &request, Database *database, std::pmr::memory_resource *arena,
+                               std::pmr::string &output)
+{
+    using memcache::Command;
+    std::string_view key = request.keys;
+    std::string_view reply;
+    std::pmr::string value(arena);
+
+    switch (request.command)
+    {
+    case Command::Get:
+    case Command::Gets:
+    {
+        // VALUE <key> <flags> <bytes> [<cas unique>]\r\n<data>\r\n ... END\r\n
+        // Flags are not stored, so they always read back as 0.
+        std::string_view keys = request.keys;
+        for (std::string_view k = memcache::nextKey(keys); !k.empty(); k = memcache::nextKey(keys))
+        {
+            if (!fetchValue(k, database, value))
+                continue;
+            output.append("VALUE ").append(k).append(" 0 ");
+            appendNumber(output, value.size());
+            if (request.command == Command::Gets)
+            {
+                output.push_back(' ');
+                appendNumber(output, casToken(value));
+            }
+            output.append("\r\n").append(value).append("\r\n");
+        }
+        output.append("END\r\n");
+        return true;
+    }
+
+    case Command::Set:
+    {
+        std::lock_guard<std::mutex> lock(keyLock(key));
+        reply = storeMemcacheValue(request, database);
+        break;
+    }
+
+    case Command::Add:
+    {
+        // Check-then-write is atomic against other writers of this key.
+        std::lock_guard<std::mutex> lock(keyLock(key));
+        if (fetchValue(key, database, value))
+            reply = "NOT_STORED";
+        else
+            reply = storeMemcacheValue(request, database);
+        break;
+    }
+
+    case Command::Cas:
+    {
+        std::lock_guard<std::mutex> lock(keyLock(key));
+        if (!fetchValue(key, database, value))
+            reply = "NOT_FOUND";
+        else if (casToken(value) != request.cas_unique)
+            reply = "EXISTS";
+        else
+            reply = storeMemcacheValue(request, database);
+        break;
+    }
+
+    case Command::Delete:
+    {
+        std::lock_guard<std::mutex> lock(keyLock(key));
+        bool existed = false;
+        if (expireIfDue(key, database))
+            reply = "NOT_FOUND";
+        else if (!removeValue(key, database, &existed))
+            reply = "SERVER_ERROR storage failure";
+        else
+            reply = existed ? "DELETED" : "NOT_FOUND";
+        break;
+    }
+
+    case Command::Incr:
+    case Command::Decr:
+    {
+        // The value must be a decimal 64-bit unsigned integer. incr wraps
+        // around like memcached's; decr stops at 0.
+        std::lock_guard<std::mutex> lock(keyLock(key));
+        if (!fetchValue(key, database, value))
+        {
+            reply = "NOT_FOUND";
+            break;
+        }
+        uint64_t number = 0;
+        auto parsed = std::from_chars(value.data(), value.data() + value.size(), number);
+        if (value.empty() || parsed.ec != std::errc() || parsed.ptr != value.data() + value.size())
+        {
+            reply = "CLIENT_ERROR cannot increment or decrement non-numeric value";
+            break;
+        }
+        if (request.command == Command::Incr)
+            number += request.delta;
+        else
+            number = number > request.delta ? number - request.delta : 0;
+
+        char digits[24];
+        std::string_view updated(digits, std::to_chars(digits, digits + sizeof(digits), number).ptr - digits);
+        if (!writeValue(key, updated, database))
+        {
+            reply = "SERVER_ERROR storage failure";
+            break;
+        }
+        if (!request.noreply)
+            output.append(updated).append("\r\n");
+        return true;
+    }
+
+    case Command::Version:
+        reply = "VERSION kv-server 1.0";
+        break;
+
+    case Command::Quit:
+        return false;
+    }
+
+    if (!request.noreply)
+        output.append(reply).append("\r\n");
+    return true;
+}
+
+// =======================
+// RESP (Redis protocol)
+// =======================
+bool KVServer::handleRespInput(Endpoint &connection, Database *database, std::pmr::memory_resource *arena,
+                               std::pmr::string &output)
+{
+    // Same scheme as handleMemcacheInput(): execute every complete command in
+    // the buffer, in order, then drop the consumed bytes.
+    std::string_view input = connection.input;
+    resp::Arguments args(arena);
+    size_t offset = 0;
+    bool keep_open = true;
+    while (keep_open && offset < input.size())
+    {
+        size_t consumed = 0;
+        std::string_view error;
+        resp::ParseStatus status = resp::parse(input.substr(offset), args, consumed, error);
+        if (status == resp::ParseStatus::Incomplete)
+            break;
+        if (status == resp::ParseStatus::Error)
+        {
+            // Like Redis: report the protocol error and drop the connection,
+            // since the rest of the stream can't be framed.
+            resp::appendError(output, error);
+            return false;
+        }
+
+        offset += consumed;
+        if (args.empty())
+            continue; // Blank inline line
+
+        total_requests++;
+        resp_commands++;
+        keep_open = executeResp(args, connection, database, arena, output);
+    }
+
+    connection.input.erase(0, offset);
+    return keep_open;
+}
+
+namespace
+{
+    // Parses a whole argument as a signed 64-bit integer.
+    bool parseInt64(std::string_view text, int64_t &value)
+    {
+        if (text.empty())
+            return false;
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        return result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+
+    void appendWrongArity(std::pmr::string &out, std::string_view command)
+    {
+        out.append("-ERR wrong number of arguments for '").append(command).append("' command\r\n");
+    }
+}
+
+bool KVServer::executeResp(const resp::Arguments &args, Endpoint &connection, Database *database,
+                           std::pmr::memory_resource *arena, std::pmr::string &output)
+{
+    using resp::equalsIgnoreCase;
+    std::string_view command = args[0];
+    const size_t argc = args.size();
+    const int version = connection.resp_version;
+    std::pmr::string value(arena);
+
+    if (equalsIgnoreCase(command, "GET"))
+    {
+        if (argc != 2)
+            appendWrongArity(output, command);
+        else if (fetchValue(args[1], database, value))
+            resp::appendBulk(output, value);
+        else
+            resp::appendNull(output, version);
+        return true;
+    }
+
+    if (equalsIgnoreCase(command, "SET"))
+    {
+        // SET key value [NX | XX] [EX seconds | PX milliseconds | KEEPTTL]
+        if (argc < 3)
+        {
+            appendWrongArity(output, command);
+            return true;
+        }
+        std::string_view key = args[1];
+        bool nx = false, xx = false, keep_ttl = false;
+        int64_t ttl_ms = 0;
+        for (size_t i = 3; i < argc; ++i)
+        {
+            std::string_view option = args[i];
+            int64_t amount = 0;
+            if (equalsIgnoreCase(option, "NX") && !xx)
+                nx = true;
+            else if (equalsIgnoreCase(option, "XX") && !nx)
+                xx = true;
+            else if (equalsIgnoreCase(option, "KEEPTTL") && ttl_ms == 0)
+                keep_ttl = true;
+            else if ((equalsIgnoreCase(option, "EX") || equalsIgnoreCase(option, "PX")) && !keep_ttl && ttl_ms == 0 &&
+                     i + 1 < argc)
+            {
+                if (!parseInt64(args[++i], amount))
+                {
+                    resp::appendError(output, "ERR value is not an integer or out of range");
+                    return true;
+                }
+                if (amount <= 0 || amount > (int64_t(1) << 40))
+                {
+                    resp::appendError(output, "ERR invalid expire time in 'set' command");
+                    return true;
+                }
+                ttl_ms = equalsIgnoreCase(option, "EX") ? amount * 1000 : amount;
+            }
+            else
+            {
+                resp::appendError(output, "ERR syntax error");
+                return true;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(keyLock(key));
+        if ((nx || xx) && fetchValue(key, database, value) == nx)
+        {
+            // NX and the key exists, or XX and it doesn't: not set.
+            resp::appendNull(output, version);
+            return true;
+        }
+        // KEEPTTL leaves the TTL alone; otherwise it is replaced (or removed).
+        bool stored;
+        if (keep_ttl)
+            stored = writeValue(key, args[2], database);
+        else if (ttl_ms > 0)
+            stored = writeValueWithExpiry(key, args[2],
+                                          std::chrono::steady_clock::now() + std::chrono::milliseconds(ttl_ms), database);
+        else
+            stored = writeValueWithExpiry(key, args[2], std::nullopt, database);
+        if (stored)
+            resp::appendSimple(output, "OK");
+        else
+            resp::appendError(output, "ERR storage failure");
+        return true;
+    }
+
+    if (equalsIgnoreCase(command, "MGET"))
+    {
+        if (argc < 2)
+        {
+            appendWrongArity(output, command);
+            return true;
+        }
+        resp::appendArrayHeader(output, argc - 1);
+        for (size_t i = 1; i < argc; ++i)
+        {
+            if (fetchValue(args[i], database, value))
+                resp::appendBulk(output, value);
+            else
+                resp::appendNull(output, version);
+        }
+        return true;
+    }
+
+    if (equalsIgnoreCase(command, "MSET"))
+    {
+        // Each key is written like SET; the batch as a whole is not atomic.
+        if (argc < 3 || argc % 2 == 0)
+        {
+            appendWrongArity(output, command);
+            return true;
+        }
+        bool ok = true;
+        for (size_t i = 1; i + 1 < argc && ok; i += 2)
+        {
+            std::lock_guard<std::mutex> lock(keyLock(args[i]));
+            ok = writeValueWithExpiry(args[i], args[i + 1], std::nullopt, database);
+        }
+        if (ok)
+            resp::appendSimple(output, "OK");
+        else
+            resp::appendError(output, "ERR storage failure");
+        return true;
+    }
+
+    if (equalsIgnoreCase(command, "DEL"))
+    {
+        if (argc < 2)
+        {
+            appendWrongArity(output, command);
+            return true;
+        }
+        int64_t removed = 0;
+        for (size_t i = 1; i < argc; ++i)
+        {
+            std::lock_guard<std::mutex> lock(keyLock(args[i]));
+            bool existed = false;
+            // An expired key that was not swept yet doesn't count as deleted.
+            if (!expireIfDue(args[i], database) && removeValue(args[i], database, &existed) && existed)
+                removed++;
+        }
+        resp::appendInteger(output, removed);
+        return true;
+    }
+
+    if (equalsIgnoreCase(command, "EXISTS"))
+    {
+        if (argc < 2)
+        {
+            appendWrongArity(output, command);
+            return true;
+        }
+        int64_t found = 0;
+        for (size_t i = 1; i < argc; ++i)
+        {
+            if (fetchValue(args[i], database, value))
+                found++;
+        }
+        resp::appendInteger(output, found);
+        return true;
+    }
+
+    if (equalsIgnoreCase(command, "INCR"))
+    {
+        // A missing key counts as 0; the key keeps its TTL.
+        if (argc != 2)
+        {
+            appendWrongArity(output, command);
+            return true;
+        }
+        std::string_view key = args[1];
+        std::lock_guard<std::mutex> lock(keyLock(key));
+        int64_t number = 0;
+        if (fetchValue(key, database, value) && !parseInt64(value, number))
+        {
+            resp::appendError(output, "ERR value is not an integer or out of range");
+            return true;
+        }
+        if (number == INT64_MAX)
+        {
+            resp::appendError(output, "ERR increment or decrement would overflow");
+            return true;
+        }
+        number++;
+
+        char digits[24];
+        std::string_view updated(digits, std::to_chars(digits, digits + sizeof(digits), number).ptr - digits);
+        if (writeValue(key, updated, database))
+            resp::appendInteger(output, number);
+        else
+            resp::appendError(output, "ERR storage failure");
+        return true;
+    }
+
+    if (equalsIgnoreCase(command, "PING"))
+    {
+        if (argc == 1)
+            resp::appendSimple(output, "PONG");
+        else if (argc == 2)
+            resp::appendBulk(output, args[1]);
+        else
+            appendWrongArity(output, command);
+        return true;
+    }
+
+    if (equalsIgnoreCase(command, "ECHO"))
+    {
+        if (argc == 2)
+            resp::appendBulk(output, args[1]);
+        else
+            appendWrongArity(output, command);
+        return true;
+    }
+
+    if (equalsIgnoreCase(command, "HELLO"))
+    {
+        // HELLO [protover [AUTH user pass] [SETNAME name]]: switches the
+        // connection to RESP2 or RESP3. Authentication is not supported and
+        // the other options are ignored.
+        if (argc >= 2)
+        {
+            int64_t requested = 0;
+            if (!parseInt64(args[1], requested) || requested < 2 || requested > 3)
+            {
+                resp::appendError(output, "NOPROTO unsupported protocol version");
+                return true;
+            }
+            connection.resp_version = static_cast<int>(requested);
+        }
+        const int proto = connection.resp_version;
+        resp::appendMapHeader(output, 6, proto);
+        resp::appendBulk(output, "server");
+        resp::appendBulk(output, "kv-server");
+        resp::appendBulk(output, "version");
+        resp::appendBulk(output, "1.0");
+        resp::appendBulk(output, "proto");
+        resp::appendInteger(output, proto);
+        resp::appendBulk(output, "mode");
+        resp::appendBulk(output, "standalone");
+        resp::appendBulk(output, "role");
+        resp::appendBulk(output, "master");
+        resp::appendBulk(output, "modules");
+        resp::appendArrayHeader(output, 0);
+        return true;
+    }
+
+    if (equalsIgnoreCase(command, "SELECT"))
+    {
+        // There is a single database.
+        if (argc != 2)
+            appendWrongArity(output, command);
+        else if (args[1] == "0")
+            resp::appendSimple(output, "OK");
+        else
+            resp::appendError(output, "ERR DB index is out of range");
+        return true;
+    }
+
+    if (equalsIgnoreCase(command, "CONFIG") || equalsIgnoreCase(command, "COMMAND"))
+    {
+        // Clients probe these on connect (redis-benchmark reads CONFIG GET
+        // save/appendonly, redis-cli COMMAND DOCS); there is nothing to report.
+        if (equalsIgnoreCase(command, "CONFIG"))
+            resp::appendMapHeader(output, 0, version);
+        else
+            resp::appendArrayHeader(output, 0);
+        return true;
+    }
+
+    if (equalsIgnoreCase(command, "CLIENT") && argc >= 2 &&
+        (equalsIgnoreCase(args[1], "SETNAME") || equalsIgnoreCase(args[1], "SETINFO")))
+    {
+        // Client libraries announce themselves; accepted and ignored.
+        resp::appendSimple(output, "OK");
+        return true;
+    }
+
+    if (equalsIgnoreCase(command, "QUIT"))
+    {
+        resp::appendSimple(output, "OK");
+        return false;
+    }
+
+    output.append("-ERR unknown command '").append(command).append("'\r\n");
+    return true;
+}
+
+// =======================
+// Binary protocol
+// =======================
+bool KVServer::handleBinaryInput(Endpoint &connection, std::pmr::string &output, Database *database)
+{
+    std::string_view input = connection.input;
+    std::pmr::string value(output.get_allocator().resource());
+    size_t offset = 0;
+    while (offset < input.size())
+    {
+        binproto::Request request;
+        size_t consumed = 0;
+        binproto::ParseStatus status = binproto::parseRequest(input.substr(offset), request, consumed);
+        if (status == binproto::ParseStatus::Incomplete)
+            break;
+        if (status == binproto::ParseStatus::Error)
+            return false; // Can't find the next frame: drop the connection
+        offset += consumed;
+
+        total_requests++;
+        binary_requests++;
+        switch (request.opcode)
+        {
+        case binproto::Opcode::Ping:
+            binproto::appendResponse(output, binproto::Status::Ok, request.id);
+            continue;
+
+        case binproto::Opcode::Get:
+            if (request.key.empty())
+                break;
+            // Cache hits are answered now, ahead of any earlier database misses,
+            // unless a write to the key is still queued: the hit would be stale.
+            if (!hasDeferredWrite(connection, request.key) && !expireIfDue(request.key, database) &&
+                fetchCachedValue(request.key, value))
+            {
+                binproto::appendResponse(output, binproto::Status::Ok, request.id, value);
+                continue;
+            }
+            [[fallthrough]];
+
+        case binproto::Opcode::Put:
+        case binproto::Opcode::Delete:
+            if (request.key.empty())
+                break;
+        {
+            std::lock_guard<std::mutex> lock(connection.deferred_mtx);
+            connection.deferred.push_back(DeferredRequest{request.opcode, request.id, std::string(request.key),
+                                                          std::string(request.value)});
+            if (request.opcode != binproto::Opcode::Get)
+                connection.deferred_writes[connection.deferred.back().key]++;
+            continue;
+        }
+        }
+
+        // Unknown opcode or missing key
+        binproto::appendResponse(output, binproto::Status::BadRequest, request.id);
+    }
+
+    connection.input.erase(0, offset);
+    return true;
+}
+
+bool KVServer::hasDeferredWrite(Endpoint &connection, std::string_view key)
+{
+    std::lock_guard<std::mutex> lock(connection.deferred_mtx);
+    return !connection.deferred_writes.empty() && connection.deferred_writes.count(std::string(key));
+}
+
+void KVServer::executeDeferred(Endpoint &connection, Database *database, std::pmr::memory_resource *arena)
+{
+    {
+        std::lock_guard<std::mutex> lock(connection.deferred_mtx);
+        if (connection.deferred_running)
+            return; // That worker executes what was just queued, in order
+        connection.deferred_running = true;
+    }
+
+    std::pmr::string value(arena);
+    std::pmr::string response(arena);
+    while (true)
+    {
+        // A connection only ever queues one kind: binary requests, or HTTP/2
+        // streams (whose IDs are never 0).
+        DeferredRequest request;
+        http2::Request stream;
+        {
+            std::unique_lock<std::mutex> lock(connection.deferred_mtx);
+            if (connection.deferred.empty() && connection.deferred_streams.empty())
+            {
+                connection.deferred_running = false;
+                bool paused = std::exchange(connection.deferred_paused, false);
+                lock.unlock();
+                if (paused)
+                    rearmConnection(connection);
+                return;
+            }
+            if (!connection.deferred_streams.empty())
+            {
+                stream = std::move(connection.deferred_streams.front());
+                connection.deferred_streams.pop_front();
+            }
+            else
+            {
+                request = std::move(connection.deferred.front());
+                connection.deferred.pop_front();
+            }
+        }
+
+        if (stream.stream_id != 0)
+        {
+            if (!executeStream(connection, stream, database))
+                break;
+            continue;
+        }
 
-    //    - Finds the first double quote '"' after the colon (the start of the actual value).
-    //    - Adds +1 to move past the opening quote.
-    //    - After this line, key_value_start points to the beginning of the value text
-    //      (e.g., the 'u' in "username").
-    key_value_start = body.find('"', key_value_start) + 1;
+        binproto::Status status = binproto::Status::Ok;
+        value.clear();
+        if (request.opcode == binproto::Opcode::Get)
+        {
+            // fetchValue() re-checks the cache: another request may have filled it.
+            if (!fetchValue(request.key, database, value))
+                status = binproto::Status::NotFound;
+        }
+        else if (request.opcode == binproto::Opcode::Put)
+        {
+            std::lock_guard<std::mutex> lock(keyLock(request.key));
+            if (!writeValueWithExpiry(request.key, request.value, std::nullopt, database))
+                status = binproto::Status::ServerError;
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(keyLock(request.key));
+            bool existed = false;
+            if (expireIfDue(request.key, database))
+                status = binproto::Status::NotFound;
+            else if (!removeValue(request.key, database, &existed))
+                status = binproto::Status::ServerError;
+            else if (!existed)
+                status = binproto::Status::NotFound;
+        }
+        binary_deferred++;
 
-    //    - Finds the next double quote '"' that marks the *end* of the key's value.
-    //    - For example, in {"key":"username"}, this finds the quote after "username".
-    size_t key_value_end = body.find('"', key_value_start);
+        // The write is in the cache now: later GETs of the key may hit again.
+        if (request.opcode != binproto::Opcode::Get)
+        {
+            std::lock_guard<std::mutex> lock(connection.deferred_mtx);
+            auto it = connection.deferred_writes.find(request.key);
+            if (--it->second == 0)
+                connection.deferred_writes.erase(it);
+        }
 
-    //    - Extracts the substring between the starting and ending quotes.
-    //    - Effectively retrieves just the value part — e.g., "username".
-    //    - Stores it into the variable 'key'.
-    key = body.substr(key_value_start, key_value_end - key_value_start);
+        response.clear();
+        binproto::appendResponse(response, status, request.id, value);
+        std::lock_guard<std::mutex> lock(connection.send_mtx);
+        if (!sendBuffers(connection.fd, response, {}, 0))
+            break;
+    }
 
-    // Extract value substring
-    size_t value_value_start = body.find(':', value_start) + 1;
-    value_value_start = body.find('"', value_value_start) + 1;
-    size_t value_value_end = body.find('"', value_value_start);
-    value = body.substr(value_value_start, value_value_end - value_value_start);
+    // Connection is gone; nobody is waiting for the rest. It may be paused,
+    // with no event left to close it.
+    {
+        std::lock_guard<std::mutex> lock(connection.deferred_mtx);
+        connection.deferred.clear();
+        connection.deferred_writes.clear();
+        connection.deferred_streams.clear();
+        connection.deferred_stream_writes = 0;
+        connection.deferred_running = false;
+    }
+    closeConnection(connection);
 }
 
 // =======================
 // Build HTTP Response
 // =======================
-std::string KVServer::buildHttpResponse(int status_code, const std::string &body)
+KVServer::HttpResponse KVServer::buildHttpResponse(int status_code, std::string_view body, std::pmr::memory_resource *arena)
+{
+    return buildHttpResponse(status_code, std::pmr::string(body, arena));
+}
+
+KVServer::HttpResponse KVServer::buildHttpResponse(int status_code, std::pmr::string body,
+                                                   std::string_view extra_headers, std::string_view content_type)
+{
+    HttpResponse response(body.get_allocator().resource());
+
+    // The body buffer is moved in as-is and sent after the headers with a
+    // single writev(); only the status line and headers are formatted.
+    response.body = std::move(body);
+    writeResponseHead(response, status_code, extra_headers, content_type);
+    return response;
+}
+
+KVServer::HttpResponse KVServer::buildFileResponse(int fd, size_t size, std::string_view prefix, std::string_view suffix,
+                                                   std::string_view content_type, std::pmr::memory_resource *arena)
+{
+    HttpResponse response(arena);
+    response.file_fd = fd;
+    response.file_size = size;
+    response.body.assign(prefix);
+    response.tail.assign(suffix);
+    writeResponseHead(response, 200, {}, content_type);
+    return response;
+}
+
+void KVServer::writeResponseHead(HttpResponse &response, int status_code, std::string_view extra_headers,
+                                 std::string_view content_type)
+{
+    size_t content_length = response.body.size() + response.file_size + response.tail.size();
+    http1::writeResponseHead(response.head, status_code, content_length, extra_headers, content_type);
+}
+
+bool KVServer::inflateStored(std::pmr::string &stored, LRUCache::StoredValue &meta)
+{
+    std::pmr::string value(stored.get_allocator());
+    value.resize(meta.raw_size);
+    if (!compression::inflateValue(stored, &value[0], meta.raw_size))
+        return false;
+    stored = std::move(value);
+    meta.compressed = false;
+    return true;
+}
+
+KVServer::HttpResponse KVServer::withCacheStatus(HttpResponse response, bool hit)
+{
+    http1::addCacheStatus(response.head, hit);
+    return response;
+}
+
+// =======================
+// HttpResponse ownership of the file descriptor
+// =======================
+KVServer::HttpResponse::HttpResponse(HttpResponse &&other) noexcept
+    : head(std::move(other.head)), body(std::move(other.body)), tail(std::move(other.tail)),
+      file_fd(std::exchange(other.file_fd, -1)), file_size(std::exchange(other.file_size, 0))
+{
+}
+
+KVServer::HttpResponse &KVServer::HttpResponse::operator=(HttpResponse &&other) noexcept
+{
+    if (this != &other)
+    {
+        if (file_fd >= 0)
+            close(file_fd);
+        head = std::move(other.head);
+        body = std::move(other.body);
+        tail = std::move(other.tail);
+        file_fd = std::exchange(other.file_fd, -1);
+        file_size = std::exchange(other.file_size, 0);
+    }
+    return *this;
+}
+
+KVServer::HttpResponse::~HttpResponse()
+{
+    if (file_fd >= 0)
+        close(file_fd);
+}
+
+// =======================
+// Decide whether a request body is streamed
+// =======================
+bool KVServer::isStreamingUpload(const http1::Request &request)
+{
+    if (!request.chunked && request.content_length < kStreamingUploadThreshold)
+        return false;
+
+    // Only raw-value uploads ("PUT /api/kv/<key> ..." or POST) are streamed.
+    if (request.method != "PUT" && request.method != "POST")
+        return false;
+    std::string_view target = request.target;
+    return target.size() > kRawPathPrefix.size() && target.compare(0, kRawPathPrefix.size(), kRawPathPrefix) == 0;
+}
+
+// =======================
+// Send an HTTP response
+// =======================
+bool KVServer::sendResponse(int client_socket, HttpResponse &response, bool keep_alive)
 {
-    std::ostringstream response;
-    response << "HTTP/1.1 " << status_code << " " << getStatusText(status_code) << "\r\n";
-    response << "Content-Type: application/json\r\n";
-    response << "Content-Length: " << body.length() << "\r\n";
-    response << "Connection: close\r\n";
-    response << "\r\n";
-    response << body;
-    return response.str();
+    // HTTP/1.1 connections persist by default; say so when this one won't.
+    if (!keep_alive)
+        response.head.insert(response.head.size() - 2, "Connection: close\r\n");
+
+    if (response.file_fd < 0)
+        return sendBuffers(client_socket, response.head, response.body, 0);
+
+    // Headers (and any prefix) first, corked with MSG_MORE so they go out in
+    // the same segment as the start of the file, then the file straight from
+    // the page cache, then the suffix.
+    return sendBuffers(client_socket, response.head, response.body, MSG_MORE) &&
+           large_value::send(client_socket, response.file_fd, response.file_size) &&
+           sendBuffers(client_socket, response.tail, {}, 0);
 }
 
 // =======================
-// Return Text for HTTP Status Code
+// Send two buffers with one system call
 // =======================
-std::string KVServer::getStatusText(int status_code)
+bool KVServer::sendBuffers(int client_socket, std::string_view first, std::string_view second, int flags)
 {
-    switch (status_code)
+    // Gather both buffers into one system call; loop over partial writes,
+    // which are common for large bodies.
+    struct iovec iov[2] = {
+        {const_cast<char *>(first.data()), first.size()},
+        {const_cast<char *>(second.data()), second.size()}};
+    struct msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+
+    size_t remaining = first.size() + second.size();
+    while (remaining > 0)
     {
-    case 200:
-        return "OK";
-    case 400:
-        return "Bad Request";
-    case 404:
-        return "Not Found";
-    case 405:
-        return "Method Not Allowed";
-    case 500:
-        return "Internal Server Error";
-    default:
-        return "Unknown";
+        ssize_t n = sendmsg(client_socket, &msg, MSG_NOSIGNAL | flags);
+        if (n <= 0)
+            return false;
+        remaining -= n;
+
+        // Skip the iovecs (or the part of one) that have been fully sent.
+        size_t sent = n;
+        while (msg.msg_iovlen > 0 && sent >= msg.msg_iov->iov_len)
+        {
+            sent -= msg.msg_iov->iov_len;
+            ++msg.msg_iov;
+            --msg.msg_iovlen;
+        }
+        if (msg.msg_iovlen > 0)
+        {
+            msg.msg_iov->iov_base = static_cast<char *>(msg.msg_iov->iov_base) + sent;
+            msg.msg_iov->iov_len -= sent;
+        }
     }
+    return true;
 }
 
 // =======================
@@ -590,12 +2567,33 @@ void KVServer::stop()
 
     running = false; // Signal worker threads to stop
 
-    // Close server socket to stop accepting new connections
+    // Close listening sockets to stop accepting new connections
     if (server_socket >= 0)
     {
         close(server_socket);
         server_socket = -1;
     }
+    if (memcache_socket >= 0)
+    {
+        close(memcache_socket);
+        memcache_socket = -1;
+    }
+    if (resp_socket >= 0)
+    {
+        close(resp_socket);
+        resp_socket = -1;
+    }
+    if (binary_socket >= 0)
+    {
+        close(binary_socket);
+        binary_socket = -1;
+    }
+    if (unix_socket >= 0)
+    {
+        close(unix_socket);
+        unix_socket = -1;
+        unlink(unix_socket_path.c_str());
+    }
 
     // Join all worker threads before exiting
     for (auto &thread : worker_threads)
@@ -610,6 +2608,43 @@ void KVServer::stop()
     // Clear thread vector
     worker_threads.clear();
 
+    // Upload threads may be blocked receiving a body: wake them, then join
+    {
+        std::lock_guard<std::mutex> lock(connections_mtx);
+        for (auto &entry : connections)
+            shutdown(entry.second->fd, SHUT_RDWR);
+    }
+    for (auto &thread : upload_threads)
+    {
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+    upload_threads.clear();
+    uploads.clear();
+
+    // No worker is left to serve them: drop persistent connections (closing
+    // their sockets) and the epoll set
+    connections.clear();
+    listeners.clear();
+
+    // Mark the shared table inactive so local readers stop using it
+    hot_table.reset();
+
+    // Write out the rest of the trace
+    if (trace_writer)
+    {
+        std::cout << "Request trace: " << trace_writer->recorded() << " operations recorded in " << trace_path
+                  << std::endl;
+        trace_writer.reset();
+    }
+    if (epoll_fd >= 0)
+    {
+        close(epoll_fd);
+        epoll_fd = -1;
+    }
+
     // Print server statistics before shutting down
     printStats();
 }
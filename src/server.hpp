@@ -1,13 +1,30 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <functional>
 #include <memory>
+#include <memory_resource>
 #include <thread>
 #include <vector>
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <sys/types.h>
 #include "cache.hpp"
 #include "database.hpp"
+#include "memcache_protocol.hpp"
+#include "resp_protocol.hpp"
+#include "binary_protocol.hpp"
+#include "http1.hpp"
+#include "http2.hpp"
+#include "hot_table.hpp"
+#include "request_trace.hpp"
 
 /**
  * @brief HTTP-based KV Server with caching and database backend
@@ -22,9 +39,151 @@
  *  - POST /api/kv            → Create or update a key-value pair
  *  - GET /api/kv?key=<key>   → Retrieve the value of a given key
  *  - DELETE /api/kv?key=<key>→ Delete a key-value pair
+ *
+ * The same store is also served over the memcached text protocol, the
+ * Redis protocol (RESP) and a compact binary protocol on ports of their own
+ * (see setMemcachePort(), setRespPort() and setBinaryPort()). All listening
+ * sockets and persistent connections share one epoll instance that every
+ * worker waits on.
+ *
+ * The HTTP port also speaks cleartext HTTP/2, with prior knowledge or via
+ * "Upgrade: h2c"; such connections stay open and their streams are routed
+ * to the same handlers as HTTP/1.1 requests.
  */
 class KVServer {
 private:
+    // Size of the per-worker request arena (see workerThread()).
+    static constexpr size_t kArenaSize = 64 * 1024;
+
+    // Limits on an incoming request; larger requests get 413 Payload Too Large.
+    static constexpr size_t kMaxHeaderBytes = 16 * 1024;
+    static constexpr size_t kMaxBodyBytes = 16 * 1024 * 1024;
+
+    // Raw uploads (PUT /api/kv/<key>) with a body at least this large, or sent
+    // chunked, are streamed to the database instead of being buffered.
+    static constexpr size_t kStreamingUploadThreshold = 256 * 1024;
+
+    // Receive buffer of a streaming upload, and the largest value it may carry
+    // (PostgreSQL's BYTEA limit).
+    static constexpr size_t kUploadChunkSize = 64 * 1024;
+    static constexpr size_t kMaxUploadBytes = size_t(1) << 30;
+
+    // Longest a streaming upload waits for more of its body before the
+    // client is dropped (the only blocking read of an HTTP connection).
+    static constexpr int kUploadReceiveTimeoutMs = 10000;
+
+    // Threads that receive streaming uploads (see uploadThread()), and the
+    // uploads that may wait for one; more get 503 Service Unavailable.
+    static constexpr size_t kUploadThreads = 4;
+    static constexpr size_t kMaxQueuedUploads = 64;
+
+    // Longest a send to any connection may block. Sockets are blocking, so a
+    // client that stops reading would otherwise hold the sending worker (and
+    // the connection's send_mtx) forever; it is dropped instead.
+    static constexpr int kSendTimeoutMs = 10000;
+
+    // Timeout of a worker's epoll_wait(), so it notices shutdown.
+    static constexpr int kPollTimeoutMs = 200;
+
+    // Bytes read from one persistent connection per readiness event before
+    // its buffered requests are executed.
+    static constexpr size_t kMaxReadPerEvent = 256 * 1024;
+
+    // Input buffers up to this size are recycled by input_pool; larger ones
+    // (big uploads, long pipelines) come from and go back to the heap.
+    static constexpr size_t kInputPoolLargestBlock = 64 * 1024;
+
+    // Unparsed input a persistent connection may hold: one largest request.
+    static constexpr size_t kMaxPendingInput =
+        std::max({memcache::kMaxValueLength + memcache::kMaxLineLength + 2,
+                  resp::kMaxBulkLength + resp::kMaxInlineLength + 2,
+                  binproto::kHeaderSize + binproto::kMaxKeyLength + binproto::kMaxValueLength});
+
+    // Binary requests a connection may have waiting for the database before
+    // it stops being read (until they are done).
+    static constexpr size_t kMaxDeferredRequests = 1024;
+
+    // Number of mutexes serializing read-modify-write commands per key.
+    static constexpr size_t kKeyLockStripes = 64;
+
+    // Wire protocol spoken on a socket.
+    enum class Protocol
+    {
+        Http,
+        Memcache,
+        Resp,
+        Binary,
+        Http2 // An HTTP connection that switched to HTTP/2
+    };
+
+    // What became of an HTTP/1.1 connection after handleClient().
+    enum class HttpOutcome
+    {
+        Incomplete, // The request isn't all in the input yet: wait for more
+        Close,      // Answered; the caller closes the connection
+        KeepAlive,  // Answered; persistent: wait for the client's next request
+        Adopted,    // Switched to HTTP/2 (see adoptHttp2Connection())
+        Upload      // A streaming upload: hand the connection to an upload thread
+    };
+
+    // A binary-protocol request that needs the database, copied out of the
+    // connection's input so it can complete after the connection is re-armed.
+    struct DeferredRequest
+    {
+        binproto::Opcode opcode;
+        uint64_t id;
+        std::string key;
+        std::string value;
+    };
+
+    /**
+     * @brief A socket registered with the epoll instance.
+     *
+     * Either a listening socket or a connection (HTTP/1.1, memcached, RESP,
+     * binary or HTTP/2) with the input received but not yet executed. epoll
+     * events carry the Endpoint's id, never its address: an event may be
+     * delivered for a connection another worker has just closed, and the id
+     * of a closed connection is never reused.
+     *
+     * A connection's socket is closed when its Endpoint is destroyed: the
+     * worker serving an event holds a reference for the whole event, so the
+     * connection outlives a close by another worker (e.g. one answering
+     * deferred requests).
+     */
+    struct Endpoint
+    {
+        uint64_t id = 0; // Key in 'connections' and the epoll event data
+        int fd = -1;
+        Protocol protocol = Protocol::Http;
+        bool listening = false;
+        std::pmr::string input; // Received bytes not yet consumed by the parser (from input_pool)
+        int resp_version = 2; // RESP connections: protocol version chosen with HELLO
+        std::mutex send_mtx;  // Serializes responses written by different workers (and HTTP/2 session use)
+        std::unique_ptr<http2::Session> http2_session; // HTTP/2 connections: framing and stream state
+        bool first_request = true; // HTTP: nothing answered yet, so HTTP/2 may still be negotiated
+        bool continue_sent = false; // HTTP: "100 Continue" was sent for the request being received
+
+        // Binary and HTTP/2 connections: requests waiting for the database,
+        // executed in arrival order by one worker at a time (see executeDeferred()).
+        std::mutex deferred_mtx;
+        std::deque<DeferredRequest> deferred;
+        std::unordered_map<std::string, size_t> deferred_writes; // Queued PUTs and DELETEs per key
+        std::deque<http2::Request> deferred_streams;
+        size_t deferred_stream_writes = 0; // Queued streams other than GETs
+        bool deferred_running = false; // A worker is executing the queue
+        bool deferred_paused = false;  // Not re-armed: the queue is full
+
+        explicit Endpoint(std::pmr::memory_resource *pool = std::pmr::get_default_resource()) : input(pool) {}
+        ~Endpoint();
+    };
+
+    // TTL deadlines of the keys in one lock stripe.
+    struct ExpiryStripe
+    {
+        std::mutex mtx;
+        std::unordered_map<std::string, std::chrono::steady_clock::time_point> deadlines;
+    };
+
     // Pointer to LRU cache for storing recently accessed key-value pairs in memory
     std::unique_ptr<LRUCache> cache;
 
@@ -37,9 +196,107 @@ private:
     // Port number on which the server listens for HTTP requests
     int port;
 
+    // Listening socket and port of the memcached text protocol (port 0 disables it)
+    int memcache_socket;
+    int memcache_port = 0;
+
+    // Listening socket and port of the Redis protocol (port 0 disables it)
+    int resp_socket;
+    int resp_port = 0;
+
+    // Listening socket and port of the binary protocol (port 0 disables it)
+    int binary_socket;
+    int binary_port = 0;
+
+    // Unix domain socket serving HTTP to local clients (empty path disables it)
+    int unix_socket;
+    std::string unix_socket_path;
+    mode_t unix_socket_mode = 0660;
+
+    // Shared-memory table of hot entries for local readers (empty name disables it)
+    std::unique_ptr<hottable::Publisher> hot_table;
+    std::string hot_table_name;
+    size_t hot_table_slots = 0;
+    mode_t hot_table_mode = 0644;
+
+    // Sampled trace of the reads, writes and deletes served (empty path disables it)
+    std::unique_ptr<reqtrace::Writer> trace_writer;
+    std::string trace_path;
+    double trace_sample_rate = 1;
+    bool trace_hash_keys = true;
+
+    // epoll instance shared by all workers
+    int epoll_fd;
+
+    // Input buffers of persistent connections. A buffer keeps its capacity
+    // between requests, and a closed connection's returns here for the next
+    // one, so serving requests takes no general-purpose heap allocation once
+    // warm. Declared before 'connections', which must be destroyed first.
+    std::pmr::synchronized_pool_resource input_pool{
+        std::pmr::pool_options{0, kInputPoolLargestBlock}};
+
+    // Listening sockets registered with epoll
+    std::vector<std::unique_ptr<Endpoint>> listeners;
+
+    // Open persistent connections, looked up by id. Shared so the worker
+    // serving an event keeps the connection alive while another closes it.
+    std::mutex connections_mtx;
+    std::unordered_map<uint64_t, std::shared_ptr<Endpoint>> connections;
+    uint64_t next_endpoint_id = 0; // Guarded by connections_mtx
+
+    // Striped per-key locks: writes and memcached add/cas/incr/decr hold the
+    // key's lock so a read-modify-write is atomic against other writers.
+    std::mutex key_locks[kKeyLockStripes];
+
+    // Deadlines of keys with a TTL (SET EX/PX, memcached exptime), striped
+    // like key_locks. Expired keys are deleted when next accessed, and by
+    // idle workers sweeping one stripe per poll timeout.
+    ExpiryStripe expiry_stripes[kKeyLockStripes];
+    std::atomic<size_t> expiring_keys{0};
+    std::atomic<size_t> next_expiry_stripe{0};
+
     // Number of worker threads to handle client requests concurrently
     size_t thread_pool_size;
 
+    // Values of at least this many bytes are cached compressed and may be sent
+    // gzip-encoded to clients that accept it (0 disables compression)
+    size_t compression_threshold;
+
+    // Values of at least this many bytes are cached in memfds and sent with
+    // sendfile() instead of being copied into the response (0 disables it)
+    size_t large_value_threshold;
+
+    // Extra response headers for gzip-encoded bodies
+    static constexpr std::string_view kGzipHeaders = "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n";
+
+    // Raw-value endpoint: /api/kv/{key} carries the value itself as the body
+    static constexpr std::string_view kRawPathPrefix = "/api/kv/";
+    static constexpr std::string_view kOctetStream = "application/octet-stream";
+
+    /**
+     * @brief An HTTP response as separate buffers, sent together with writev().
+     *
+     * Keeping the body separate from the status line and headers lets a value
+     * copied out of the cache (or a gzip member) become the response body
+     * without being copied again behind the headers.
+     *
+     * A memfd-backed value is not copied at all: the response owns a descriptor
+     * of the file, which is sent with sendfile() between 'body' and 'tail'.
+     */
+    struct HttpResponse
+    {
+        std::pmr::string head; // Status line, headers and the blank line
+        std::pmr::string body;
+        std::pmr::string tail; // Sent after the file (only used with file_fd)
+        int file_fd = -1;      // Owned descriptor of a file body, or -1
+        size_t file_size = 0;
+
+        explicit HttpResponse(std::pmr::memory_resource *arena) : head(arena), body(arena), tail(arena) {}
+        HttpResponse(HttpResponse &&other) noexcept;
+        HttpResponse &operator=(HttpResponse &&other) noexcept;
+        ~HttpResponse();
+    };
+
     // Database connection parameters
     std::string db_host;
     std::string db_port;
@@ -50,6 +307,12 @@ private:
     // Pool of worker threads that process incoming HTTP requests
     std::vector<std::thread> worker_threads;
 
+    // Threads receiving streaming uploads, and the connections waiting for one
+    std::vector<std::thread> upload_threads;
+    std::deque<std::shared_ptr<Endpoint>> uploads;
+    std::mutex uploads_mtx;
+    std::condition_variable uploads_cv;
+
     // Atomic flag indicating whether the server is currently running
     std::atomic<bool> running;
     
@@ -61,26 +324,296 @@ private:
     // Counts the number of times a requested key was not found in the cache
     std::atomic<uint64_t> cache_misses;
 
-    // Tracks total number of HTTP requests received by the server
+    // Tracks total number of requests received by the server (all protocols)
     std::atomic<uint64_t> total_requests;
+
+    // Uploads that were streamed to the database, and their total size
+    std::atomic<uint64_t> streamed_uploads;
+    std::atomic<uint64_t> streamed_upload_bytes;
+
+    // Memcached and RESP commands executed
+    std::atomic<uint64_t> memcache_commands;
+    std::atomic<uint64_t> resp_commands;
+    std::atomic<uint64_t> binary_requests;
+
+    // Binary requests answered after the connection's later requests
+    // (database misses and writes)
+    std::atomic<uint64_t> binary_deferred;
+
+    // Keys deleted because their TTL ran out
+    std::atomic<uint64_t> expired_keys;
+
+    // Requests received as HTTP/2 streams
+    std::atomic<uint64_t> http2_streams;
+
+    // HTTP/2 streams answered after the connection's later streams
+    // (database misses and writes)
+    std::atomic<uint64_t> http2_deferred;
     
     /**
-     * @brief Handles an individual client connection.
+     * @brief Answers the HTTP request at the start of a connection's input.
      * 
-     * Reads the HTTP request, determines its type (GET, POST, DELETE),
+     * Parses the request, determines its type (GET, POST, DELETE),
      * processes it accordingly, and sends back an appropriate HTTP response.
+     * Never waits for input: a request that isn't complete yet is left in
+     * the input (Incomplete) until serviceConnection() has read more. All
+     * request temporaries are allocated from 'arena', which the caller
+     * releases after the response has been sent.
+     * 
+     * HTTP/1.1 connections are persistent unless the client sends
+     * "Connection: close"; HTTP/1.0 clients get a "Connection: close"
+     * response. On its first request, a connection that starts with the
+     * HTTP/2 preface, or asks to upgrade to h2c, is handed to
+     * adoptHttp2Connection() instead. A streaming upload is left in the input
+     * as soon as its headers are complete (Upload), for queueUpload().
      * 
-     * @param client_socket Socket file descriptor for the connected client.
+     * @param connection The connection; the answered request is removed
+     *        from its input, leaving the start of pipelined requests.
+     * @param arena Per-request bump allocator.
+     */
+    HttpOutcome handleClient(Endpoint &connection, Database *db, std::pmr::memory_resource *arena);
+
+    /**
+     * @brief Answers requests with handleClient() until one is incomplete in the input.
+     *
+     * Pipelined requests already read from the socket must be answered now:
+     * epoll won't report them again.
      */
-    void handleClient(int client_socket,Database *db);
+    HttpOutcome serveHttp(Endpoint &connection, Database *db, std::pmr::memory_resource *arena);
+
+    /**
+     * @brief Dispatches a request to its handler by path and method.
+     *
+     * Shared by HTTP/1.1 and HTTP/2; streamed uploads are handed to the
+     * upload threads before this point.
+     *
+     * @param path The request target, including any query string.
+     * @param accept_encoding The request's Accept-Encoding value (empty if absent).
+     * @param body The complete request body.
+     * @return A formatted HTTP response.
+     */
+    HttpResponse routeRequest(std::string_view method, std::string_view path, std::string_view accept_encoding,
+                              std::string_view body, Database *db, std::pmr::memory_resource *arena);
+
+    /**
+     * @brief Turns an HTTP connection into a persistent HTTP/2 connection.
+     *
+     * Sends the server preface (after a 101 response when upgrading) and
+     * serves the frames already received; serviceConnection() serves the
+     * connection as HTTP/2 from then on.
+     *
+     * @param received Bytes read after the HTTP/1.1 request (upgrade), or
+     *        everything read so far (prior knowledge).
+     * @param http2_settings The HTTP2-Settings header of an upgrade request.
+     * @param upgrade_response Response to the upgrading request, sent on
+     *        stream 1; nullptr for prior knowledge.
+     * @return true if the connection stays open as HTTP/2; false if it is to
+     *         be closed, e.g. because the upgrade was declined and the
+     *         response sent over HTTP/1.1.
+     */
+    bool adoptHttp2Connection(Endpoint &connection, std::string_view received, std::string_view http2_settings,
+                              HttpResponse *upgrade_response, Database *db, std::pmr::memory_resource *arena);
+
+    /**
+     * @brief Processes the frames buffered on an HTTP/2 connection, routing
+     *        each completed stream and queueing its response into 'output'.
+     *
+     * Streams that need the database are queued on the connection for
+     * executeDeferred() instead, so a miss doesn't hold back the streams
+     * behind it; while a write is queued, GETs queue behind it too. The
+     * caller holds the connection's send_mtx, which guards the session.
+     *
+     * @return false if the connection should be closed.
+     */
+    bool handleHttp2Input(Endpoint &connection, Database *db, std::pmr::memory_resource *arena,
+                          std::pmr::string &output);
+
+    /**
+     * @brief Returns true if routing the request may access the database:
+     *        a write, or a read of a key that isn't cached.
+     */
+    bool needsDatabase(std::string_view method, std::string_view target);
+
+    /**
+     * @brief Routes a deferred HTTP/2 stream and sends its response.
+     * @return false if the response could not be sent.
+     */
+    bool executeStream(Endpoint &connection, http2::Request &stream, Database *db);
+
+    /**
+     * @brief Sends an HttpResponse as the response of an HTTP/2 stream.
+     */
+    void respondHttp2(http2::Session &session, uint32_t stream_id, const HttpResponse &response,
+                      std::pmr::string &output);
 
     /**
      * @brief Function executed by each worker thread.
      * 
-     * Continuously listens for new client connections, retrieves requests from
-     * the socket, and delegates them to the `handleClient()` function.
+     * Waits on the shared epoll instance and handles one ready socket at a
+     * time: new connections go to acceptConnection(), input on a persistent
+     * connection to serviceConnection().
      */
     void workerThread();
+
+    /**
+     * @brief Function executed by each upload thread.
+     *
+     * Serves the connections queued by queueUpload() with serveUpload(),
+     * one at a time, then closes them. Receiving a streamed body blocks, so
+     * it is kept off the workers that serve everyone else.
+     */
+    void uploadThread();
+
+    /**
+     * @brief Hands a connection whose input starts with a streaming upload
+     *        to the upload threads.
+     *
+     * The connection is not re-armed: it belongs to the upload thread until
+     * closed. If kMaxQueuedUploads are already waiting, it is answered with
+     * 503 and closed instead.
+     */
+    void queueUpload(Endpoint &connection, std::pmr::memory_resource *arena);
+
+    /**
+     * @brief Answers the streaming upload at the start of a connection's input
+     *        with handleStreamingPut(), with "Connection: close".
+     */
+    void serveUpload(Endpoint &connection, Database *db, std::pmr::memory_resource *arena);
+
+    /**
+     * @brief Creates a non-blocking TCP socket listening on the given port.
+     * @return The socket, or -1 on failure.
+     */
+    int createListenSocket(int listen_port);
+
+    /**
+     * @brief Creates a non-blocking Unix domain stream socket listening at 'path'.
+     *
+     * A stale socket file left at the path is replaced; any other file there
+     * makes this fail.
+     * @param mode Permissions of the socket file, e.g. 0660.
+     * @return The socket, or -1 on failure.
+     */
+    int createUnixListenSocket(const std::string &path, mode_t mode);
+
+    /**
+     * @brief Registers a listening socket with the epoll instance.
+     */
+    void addListener(int listen_socket, Protocol protocol);
+
+    /**
+     * @brief Accepts a connection on a ready listener.
+     *
+     * Every connection is registered with epoll, and served by
+     * serviceConnection() whenever it has input.
+     */
+    void acceptConnection(Endpoint &listener, Database *db, std::pmr::memory_resource *arena);
+
+    /**
+     * @brief Looks up an open persistent connection by id.
+     * @return The connection, or null if it has been closed.
+     */
+    std::shared_ptr<Endpoint> findConnection(uint64_t id);
+
+    /**
+     * @brief Reads the available input of a persistent connection, executes
+     *        the complete requests and sends their responses in one write.
+     *
+     * The caller holds a reference to 'connection' for the whole call.
+     */
+    void serviceConnection(Endpoint &connection, Database *db, std::pmr::memory_resource *arena);
+
+    /**
+     * @brief Re-arms a persistent connection for its next readiness event; closes it on failure.
+     * @return false if the connection was closed.
+     */
+    bool rearmConnection(Endpoint &connection);
+
+    /**
+     * @brief Removes a persistent connection from epoll and shuts its socket
+     *        down; the Endpoint is freed once no worker uses it.
+     */
+    void closeConnection(Endpoint &connection);
+
+    /**
+     * @brief Number of open persistent connections.
+     */
+    size_t connectionCount();
+
+    /**
+     * @brief Executes the complete memcached requests buffered on a connection.
+     *
+     * Requests are executed in order and their responses appended to 'output';
+     * the consumed input is removed from the connection.
+     *
+     * @return false if the connection should be closed (quit or a fatal error).
+     */
+    bool handleMemcacheInput(Endpoint &connection, Database *db, std::pmr::memory_resource *arena,
+                             std::pmr::string &output);
+
+    /**
+     * @brief Executes one memcached request, appending its response to 'output'.
+     * @return false if the connection should be closed.
+     */
+    bool executeMemcache(const memcache::Request &request, Database *db, std::pmr::memory_resource *arena,
+                         std::pmr::string &output);
+
+    /**
+     * @brief Stores the value of a memcached set/add/cas, applying its exptime.
+     * @return The response line.
+     */
+    std::string_view storeMemcacheValue(const memcache::Request &request, Database *db);
+
+    /**
+     * @brief Executes the complete RESP commands buffered on a connection.
+     *
+     * Works like handleMemcacheInput(); a protocol error closes the connection.
+     *
+     * @return false if the connection should be closed.
+     */
+    bool handleRespInput(Endpoint &connection, Database *db, std::pmr::memory_resource *arena,
+                         std::pmr::string &output);
+
+    /**
+     * @brief Executes one RESP command, appending its reply to 'output'.
+     *
+     * Supports GET, SET (NX/XX, EX/PX, KEEPTTL), MGET, MSET, DEL, EXISTS,
+     * INCR, PING, ECHO, HELLO, SELECT 0 and QUIT, plus the CONFIG, COMMAND
+     * and CLIENT probes clients send on connect.
+     *
+     * @param args Command name and arguments.
+     * @return false if the connection should be closed.
+     */
+    bool executeResp(const resp::Arguments &args, Endpoint &connection, Database *db,
+                     std::pmr::memory_resource *arena, std::pmr::string &output);
+
+    /**
+     * @brief Handles the complete binary requests buffered on a connection.
+     *
+     * Requests that can be answered from memory (cache hits, pings, bad
+     * requests) are answered into 'output' right away; those needing the
+     * database are queued on the connection for executeDeferred(). A GET of
+     * a key with a queued PUT or DELETE is queued behind it, even on a hit,
+     * so it never sees the value from before the write.
+     *
+     * @return false if the connection should be closed (framing error).
+     */
+    bool handleBinaryInput(Endpoint &connection, std::pmr::string &output, Database *db);
+
+    /**
+     * @brief Returns true if a PUT or DELETE of 'key' is queued on the connection.
+     */
+    bool hasDeferredWrite(Endpoint &connection, std::string_view key);
+
+    /**
+     * @brief Executes a binary or HTTP/2 connection's queued requests in
+     *        order, sending each response as soon as it is ready.
+     *
+     * Only one worker executes a connection's queue at a time; others
+     * return at once, leaving what they queued to it. The worker that
+     * empties the queue re-arms the connection if it was paused.
+     */
+    void executeDeferred(Endpoint &connection, Database *db, std::pmr::memory_resource *arena);
     
     /**
      * @brief Handles HTTP PUT/POST requests (Create or Update operation).
@@ -91,7 +624,7 @@ private:
      * @param body The HTTP request body containing the key-value data.
      * @return A formatted HTTP response string.
      */
-    std::string handlePutRequest(const std::string& body,Database *db);
+    HttpResponse handlePutRequest(std::string_view body, Database *db, std::pmr::memory_resource *arena);
 
     /**
      * @brief Handles HTTP GET requests (Read operation).
@@ -100,10 +633,14 @@ private:
      * If not found, retrieves it from the database, updates the cache, and
      * returns the value in the HTTP response.
      * 
+     * Compressed cache entries are sent gzip-encoded without recompression when
+     * the client accepts gzip, and inflated otherwise.
+     * 
      * @param query The URL query string containing the key parameter.
+     * @param accept_gzip Whether the response may be gzip-encoded.
      * @return A formatted HTTP response with the key’s value or an error message.
      */
-    std::string handleGetRequest(const std::string& query,Database *db);
+    HttpResponse handleGetRequest(std::string_view query, Database *db, std::pmr::memory_resource *arena, bool accept_gzip);
 
     /**
      * @brief Handles HTTP DELETE requests (Delete operation).
@@ -114,33 +651,148 @@ private:
      * @param query The URL query string containing the key parameter.
      * @return A formatted HTTP response indicating success or failure.
      */
-    std::string handleDeleteRequest(const std::string& query,Database *db);
-    
+    HttpResponse handleDeleteRequest(std::string_view query, Database *db, std::pmr::memory_resource *arena);
+
     /**
-     * @brief Extracts the "key" parameter from an HTTP query string.
-     * 
-     * Example:
-     *   Input:  "key=example"
-     *   Output: "example"
-     * 
-     * @param query The HTTP query string.
-     * @return Extracted key as a string.
+     * @brief Handles /api/kv/{key}, where the body is the raw value.
+     *
+     * GET returns the value as application/octet-stream, PUT/POST store the
+     * request body byte-for-byte (including NUL bytes and empty values) and
+     * DELETE removes the key. No JSON parsing or escaping is involved.
+     *
+     * @param method The HTTP method.
+     * @param key The percent-decoded key taken from the path.
+     * @param body The request body (the value for PUT/POST).
+     * @param accept_gzip Whether the response may be gzip-encoded.
+     * @return A formatted HTTP response.
      */
-    std::string parseKeyFromQuery(const std::string& query);
+    HttpResponse handleRawRequest(std::string_view method, std::string_view key, std::string_view body,
+                                  Database *db, std::pmr::memory_resource *arena, bool accept_gzip);
 
     /**
-     * @brief Parses the key and value from a request body (used in POST/PUT).
-     * 
-     * The body typically contains data in the format:
-     *   key=<key>&value=<value>
-     * 
-     * This function extracts both components for further processing.
-     * 
-     * @param body The HTTP request body.
-     * @param key Reference to store the extracted key.
-     * @param value Reference to store the extracted value.
+     * @brief Streams a large or chunked PUT /api/kv/{key} body into the database.
+     *
+     * The body is read from the socket in kUploadChunkSize pieces, de-chunked
+     * if needed, and piped into a COPY (see Database::beginPutStream), so the
+     * memory used is O(chunk) however large the value is. Values reaching the
+     * large-value threshold are teed into a memfd and cached from it. The
+     * commit and the cache update are made under keyLock(key); receiving
+     * the body is not.
+     *
+     * @param client_socket The connection to read the rest of the body from.
+     * @param key The percent-decoded key taken from the path.
+     * @param request The parsed request (framing).
+     * @param send_continue Whether to send "100 Continue" once storage is ready.
+     * @param received Body bytes that were already read along with the headers,
+     *        of any size (on a keep-alive connection, up to kMaxReadPerEvent).
+     *        They are decoded in place: only bytes read from the socket, and
+     *        an incomplete chunk-size line (at most ChunkedDecoder::kMaxLineLength),
+     *        are held in the kUploadChunkSize receive buffer.
+     * @return A formatted HTTP response.
+     */
+    HttpResponse handleStreamingPut(int client_socket, std::string_view key, const http1::Request &request,
+                                    bool send_continue, std::string_view received, Database *db,
+                                    std::pmr::memory_resource *arena);
+
+    /**
+     * @brief Writes a key-value pair to the database, then the cache.
+     */
+    HttpResponse storeValue(std::string_view key, std::string_view value, Database *db, std::pmr::memory_resource *arena);
+
+    /**
+     * @brief Removes a key from the database, then the cache.
+     */
+    HttpResponse deleteValue(std::string_view key, Database *db, std::pmr::memory_resource *arena);
+
+    /**
+     * @brief Looks a key up in the cache, then the database (filling the cache).
+     * @return false if the key does not exist.
+     */
+    bool fetchValue(std::string_view key, Database *db, std::pmr::string &value);
+
+    /**
+     * @brief The cache half of fetchValue(): a hit is counted, traced and
+     *        offered to the hot table. Used directly by paths that must not
+     *        wait for the database on a miss.
+     * @return false on a miss.
+     */
+    bool fetchCachedValue(std::string_view key, std::pmr::string &value);
+
+    /**
+     * @brief Writes a key-value pair to the database, then the cache.
+     * @return false if the database write failed.
+     */
+    bool writeValue(std::string_view key, std::string_view value, Database *db);
+
+    /**
+     * @brief writeValue(), replacing the key's TTL with 'deadline' (none if empty).
+     *
+     * The new TTL is only recorded once the write has succeeded; if it
+     * fails, the old value keeps its old TTL.
+     * @return false if the database write failed.
+     */
+    bool writeValueWithExpiry(std::string_view key, std::string_view value,
+                              std::optional<std::chrono::steady_clock::time_point> deadline, Database *db);
+
+    /**
+     * @brief Removes a key from the database, then the cache.
+     * @param existed If non-null, receives whether the key was present.
+     * @return false if the database delete failed.
+     */
+    bool removeValue(std::string_view key, Database *db, bool *existed = nullptr);
+
+    /**
+     * @brief Publishes a key that was just read from the cache to the hot table.
+     *
+     * Called on cache hits. Keys already in the table, and values too large
+     * for a slot, cost only a lookup in the table.
+     */
+    void exportHotEntry(std::string_view key, size_t value_size);
+
+    /**
+     * @brief Adds an operation to the request trace, if tracing is on.
+     *
+     * Called where every protocol's reads, writes and deletes reach the
+     * storage path, so commands that read and then write (INCR, APPEND, SET
+     * NX) are traced as both.
+     */
+    void traceOperation(reqtrace::Op op, std::string_view key, size_t value_size, bool hit = false)
+    {
+        if (trace_writer)
+            trace_writer->record(op, key, value_size, hit);
+    }
+
+    /**
+     * @brief Returns the lock stripe guarding writes to a key.
+     */
+    std::mutex &keyLock(std::string_view key);
+
+    /**
+     * @brief Returns the expiry stripe holding a key's TTL.
      */
-    void parseKeyValue(const std::string& body, std::string& key, std::string& value);
+    ExpiryStripe &expiryStripe(std::string_view key);
+
+    /**
+     * @brief Gives a key a TTL; it is deleted once 'deadline' has passed.
+     */
+    void setExpiry(std::string_view key, std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * @brief Removes a key's TTL, if any (the key then persists).
+     * @return The deadline that was removed, if there was one.
+     */
+    std::optional<std::chrono::steady_clock::time_point> clearExpiry(std::string_view key);
+
+    /**
+     * @brief Deletes the key if its TTL has run out.
+     * @return true if the key was expired (and is now gone).
+     */
+    bool expireIfDue(std::string_view key, Database *db);
+
+    /**
+     * @brief Deletes the expired keys of the next expiry stripe.
+     */
+    void expireDueKeys(Database *db);
     
     /**
      * @brief Builds a complete HTTP response string.
@@ -151,42 +803,166 @@ private:
      *  - Body (e.g., the response message or data)
      * 
      * @param status_code The HTTP status code (e.g., 200, 404).
-     * @param body The response body text.
-     * @return A complete HTTP response string.
+     * @param body The response body text (copied into the arena).
+     * @param arena Allocator for the response strings.
+     * @return A complete HTTP response.
      */
-    std::string buildHttpResponse(int status_code, const std::string& body);
+    HttpResponse buildHttpResponse(int status_code, std::string_view body, std::pmr::memory_resource *arena);
 
     /**
-     * @brief Returns a human-readable status message for a given HTTP code.
-     * 
-     * Example:
-     *  - 200 → "OK"
-     *  - 404 → "Not Found"
-     *  - 500 → "Internal Server Error"
-     * 
-     * @param status_code HTTP status code.
-     * @return Corresponding status text string.
+     * @brief Builds an HTTP response around an already-built body, without copying it.
+     *
+     * @param status_code The HTTP status code (e.g., 200, 404).
+     * @param body The response body; moved into the response. Its allocator is used for the headers.
+     * @param extra_headers Additional "Name: value\r\n" lines (e.g. Content-Encoding).
+     * @param content_type The Content-Type header value.
+     * @return A complete HTTP response.
      */
-    std::string getStatusText(int status_code);
+    HttpResponse buildHttpResponse(int status_code, std::pmr::string body, std::string_view extra_headers = {},
+                                   std::string_view content_type = "application/json");
+
+    /**
+     * @brief Builds a 200 response whose body is prefix + file contents + suffix.
+     *
+     * @param fd Descriptor of the file holding the value; owned by the response.
+     * @param size Number of bytes of the file to send.
+     * @param prefix Bytes sent before the file (e.g. the start of a JSON object).
+     * @param suffix Bytes sent after the file.
+     * @param content_type The Content-Type header value.
+     * @param arena Allocator for the response strings.
+     * @return A complete HTTP response.
+     */
+    HttpResponse buildFileResponse(int fd, size_t size, std::string_view prefix, std::string_view suffix,
+                                   std::string_view content_type, std::pmr::memory_resource *arena);
+
+    /**
+     * @brief Replaces compressed cached bytes from LRUCache::getStored() with
+     *        the original value, for a client that can't take gzip.
+     *
+     * @param stored The deflate data; receives the value, from the same allocator.
+     * @param meta Describes 'stored'; marked uncompressed on success.
+     * @return false if the data is corrupt: the caller treats the GET as a
+     *         miss, and the database's value then replaces the entry.
+     */
+    static bool inflateStored(std::pmr::string &stored, LRUCache::StoredValue &meta);
+
+    /**
+     * @brief Adds "X-Cache: HIT" or "X-Cache: MISS" to the response to a GET,
+     *        so clients (e.g. the load generator) can tell cache hits apart.
+     */
+    HttpResponse withCacheStatus(HttpResponse response, bool hit);
+
+    /**
+     * @brief Formats the status line and headers into response.head.
+     *
+     * Content-Length covers body, file and tail.
+     */
+    void writeResponseHead(HttpResponse &response, int status_code, std::string_view extra_headers,
+                           std::string_view content_type);
+
+    /**
+     * @brief Decides from the parsed request whether the body is streamed by handleStreamingPut().
+     */
+    bool isStreamingUpload(const http1::Request &request);
+
+    /**
+     * @brief Sends the headers and body with sendmsg(), looping over partial writes.
+     *
+     * A file body follows with sendfile(); the headers are sent with MSG_MORE
+     * so they share a TCP segment with the start of the file.
+     * @param keep_alive Unless set, "Connection: close" is added to the headers.
+     * @return false if the connection failed.
+     */
+    bool sendResponse(int client_socket, HttpResponse &response, bool keep_alive = false);
+
+    /**
+     * @brief Sends two buffers with sendmsg(), looping over partial writes.
+     * @param flags Extra send flags, e.g. MSG_MORE when more data follows.
+     * @return false if the connection failed.
+     */
+    bool sendBuffers(int client_socket, std::string_view first, std::string_view second, int flags);
 
 public:
     /**
      * @brief Constructs the KVServer with specified configuration.
      * 
-     * @param port Port number for the server to listen on.
+     * @param port Port number for the server to listen on; 0 picks a free
+     *        one when the server starts (see getPort()).
      * @param cache_size Maximum number of entries to hold in the cache.
      * @param thread_pool_size Number of worker threads to spawn.
      * @param db Pointer to an already initialized Database object.
+     * @param compression_threshold Minimum value size for compressed caching
+     *        and gzip responses (0 disables compression).
+     * @param large_value_threshold Minimum value size kept in a memfd and sent
+     *        with sendfile() (0 disables it).
      */
     KVServer(int port, size_t cache_size, size_t thread_pool_size,
              const std::string &db_host, const std::string &db_port,
              const std::string &db_name, const std::string &db_user,
-             const std::string &db_password);
+             const std::string &db_password, size_t compression_threshold = 0,
+             size_t large_value_threshold = 0);
 
     /**
      * @brief Destructor that ensures resources (threads, sockets) are cleaned up.
      */
     ~KVServer();
+
+    /**
+     * @brief Enables the memcached text protocol on the given port.
+     *
+     * Must be called before start(). 0 (the default) disables it.
+     */
+    void setMemcachePort(int memcache_port);
+
+    /**
+     * @brief Enables the Redis protocol (RESP2/RESP3) on the given port.
+     *
+     * Must be called before start(). 0 (the default) disables it.
+     */
+    void setRespPort(int resp_port);
+
+    /**
+     * @brief Enables the binary protocol (see binary_protocol.hpp) on the given port.
+     *
+     * Must be called before start(). 0 (the default) disables it.
+     */
+    void setBinaryPort(int binary_port);
+
+    /**
+     * @brief Also serves the HTTP API on a Unix domain socket at 'path'.
+     *
+     * For co-located clients, which skip the TCP/IP loopback stack. The
+     * socket file is created with the given permissions and removed by
+     * stop(). Must be called before start(); an empty path (the default)
+     * disables it.
+     */
+    void setUnixSocket(const std::string &path, mode_t mode = 0660);
+
+    /**
+     * @brief Exports hot entries in a shared-memory table (see hot_table.hpp).
+     *
+     * Small values are published when read from the cache and kept up to
+     * date by writes, so local processes can read them with HotTableClient
+     * without a request. Must be called before start(); an empty name (the
+     * default) disables it.
+     *
+     * @param name POSIX shared memory name, e.g. "/kv_hot".
+     * @param slots Number of 1 KiB slots.
+     * @param mode Permissions of the segment; readers need read access.
+     */
+    void setHotTable(const std::string &name, size_t slots, mode_t mode = 0644);
+
+    /**
+     * @brief Records a sampled trace of the requests served (see request_trace.hpp).
+     *
+     * Each traced read, write or delete stores its time, key (or key hash)
+     * and value size; load_generator can replay the file. Must be called
+     * before start(); an empty path (the default) disables it.
+     *
+     * @param sample_rate Fraction of operations recorded, 0 to 1.
+     * @param hash_keys Store 8-byte key hashes instead of the keys.
+     */
+    void setTrace(const std::string &path, double sample_rate, bool hash_keys = true);
     
     /**
      * @brief Starts the server and begins accepting HTTP connections.
@@ -197,6 +973,11 @@ public:
      */
     bool start();
 
+    /**
+     * @brief Returns the HTTP port; after start(), the one actually bound.
+     */
+    int getPort() const { return port; }
+
     /**
      * @brief Gracefully stops the server.
      * 
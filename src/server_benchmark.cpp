@@ -0,0 +1,408 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "database.hpp"
+#include "fake_database.hpp"
+#include "http_client.hpp"
+#include "key_distribution.hpp"
+#include "latency_histogram.hpp"
+#include "server.hpp"
+
+/**
+ * @brief In-process benchmark of the server, with no database or other process.
+ *
+ * Starts a KVServer on an ephemeral port, linked with the fake storage
+ * backend (fake_database.hpp) instead of PostgreSQL, and preloads every key
+ * of the key space into it. Client threads in the same process then send
+ * GET, PUT and DELETE requests to the raw /api/kv/<key> routes for a fixed
+ * time, each over one keep-alive connection with a number of requests in
+ * flight (closed loop), and record every response time in HDR histograms.
+ *
+ * The backend's latency and failure rate are set on the command line, so
+ * a run can leave storage out entirely (the default: no delay), or model a
+ * slow or failing one. The results give throughput, latency percentiles
+ * per operation (GETs split by the server's X-Cache header) and the backend
+ * operations the requests caused; --results writes them as JSON.
+ */
+
+namespace
+{
+    struct Options
+    {
+        int server_threads = 4;
+        int clients = 4;
+        int pipeline_depth = 1;
+        int duration_sec = 5;
+        uint64_t key_space = 10000;
+        size_t cache_size = 1000;
+        std::string keys = "uniform";
+        std::string mix_spec = "80:15:5";
+        std::vector<double> mix = {80, 15, 5}; // GET, PUT, DELETE
+        size_t value_size = 64;
+        fake_database::Config storage;
+        std::string results_path;
+    };
+
+    enum Kind
+    {
+        KIND_GET_HIT,
+        KIND_GET_MISS,
+        KIND_PUT,
+        KIND_DELETE,
+        KIND_COUNT
+    };
+    const char *const kKindNames[KIND_COUNT] = {"GET_HIT", "GET_MISS", "PUT", "DELETE"};
+
+    // Kind a request's failure is counted under (0 = GET, 1 = PUT, 2 = DELETE)
+    Kind failedKind(int op)
+    {
+        return op == 1 ? KIND_PUT : (op == 2 ? KIND_DELETE : KIND_GET_MISS);
+    }
+
+    // What one client thread recorded
+    struct ClientResult
+    {
+        LatencyHistogram latency[KIND_COUNT];
+        uint64_t errors[KIND_COUNT] = {};
+        uint64_t not_found = 0; // GETs answered 404
+        uint64_t reconnects = 0;
+    };
+
+    bool parseMix(const std::string &spec, std::vector<double> &weights)
+    {
+        std::vector<double> parsed;
+        std::istringstream in(spec);
+        std::string field;
+        while (std::getline(in, field, ':'))
+        {
+            std::istringstream number_in(field);
+            double weight;
+            if (!(number_in >> weight) || !number_in.eof() || weight < 0)
+                return false;
+            parsed.push_back(weight);
+        }
+        if (parsed.size() != 3 || parsed[0] + parsed[1] + parsed[2] <= 0)
+            return false;
+        weights = parsed;
+        return true;
+    }
+
+    /**
+     * @brief Sends requests on one connection until 'end', then waits for
+     *        the ones still in flight.
+     */
+    void clientThread(int id, int port, const Options &options, KeyDistribution &keys, ClientResult &result)
+    {
+        static const char *const methods[] = {"GET ", "PUT ", "DELETE "};
+        std::mt19937 gen(id + 1);
+        std::discrete_distribution<> op_dist(options.mix.begin(), options.mix.end());
+        const std::string value(options.value_size, 'v');
+        const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(options.duration_sec);
+
+        struct Outstanding
+        {
+            int op; // 0 = GET, 1 = PUT, 2 = DELETE
+            std::chrono::steady_clock::time_point sent;
+        };
+        std::deque<Outstanding> outstanding;
+        HttpClient client;
+        bool connected_once = false;
+        HttpClient::Response response;
+        std::string request;
+        while (true)
+        {
+            bool sending = std::chrono::steady_clock::now() < end;
+            if (!sending && outstanding.empty())
+                break;
+            if (!client.isConnected())
+            {
+                if (!sending || !client.connect("127.0.0.1", port))
+                    break;
+                result.reconnects += connected_once;
+                connected_once = true;
+            }
+
+            while (sending && outstanding.size() < static_cast<size_t>(options.pipeline_depth))
+            {
+                int op = op_dist(gen);
+                uint64_t key = op == 1 ? keys.nextWrite(gen) : keys.next(gen);
+                request.assign(methods[op]).append("/api/kv/key_").append(std::to_string(key));
+                request.append(" HTTP/1.1\r\nHost: localhost\r\n");
+                if (op == 1)
+                    request.append("Content-Length: ").append(std::to_string(value.size())).append("\r\n\r\n").append(value);
+                else
+                    request.append("\r\n");
+                client.queue(request);
+                outstanding.push_back({op, std::chrono::steady_clock::now()});
+            }
+
+            if (!client.flush() || !client.receive(response))
+            {
+                // Connection lost: everything in flight failed.
+                for (const Outstanding &request_sent : outstanding)
+                    result.errors[failedKind(request_sent.op)]++;
+                outstanding.clear();
+                client.close();
+                continue;
+            }
+            auto received = std::chrono::steady_clock::now();
+            const Outstanding &answered = outstanding.front();
+            Kind kind = failedKind(answered.op);
+            if (answered.op == 0 && response.cache == HttpClient::CacheStatus::Hit)
+                kind = KIND_GET_HIT;
+            if (response.status == 200 || (answered.op == 0 && response.status == 404))
+            {
+                result.latency[kind].record(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(received - answered.sent).count());
+                result.not_found += response.status == 404;
+            }
+            else
+                result.errors[kind]++;
+            outstanding.pop_front();
+            if (response.close)
+            {
+                for (const Outstanding &request_sent : outstanding)
+                    result.errors[failedKind(request_sent.op)]++;
+                outstanding.clear();
+                client.close();
+            }
+        }
+    }
+
+    void printUsage(const char *prog_name)
+    {
+        std::cout << "Usage: " << prog_name << " [options]" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "  --server-threads <n>   Server worker threads (default 4)" << std::endl;
+        std::cout << "  --clients <n>          Client threads, one connection each (default 4)" << std::endl;
+        std::cout << "  --pipeline <n>         Requests in flight per connection (default 1)" << std::endl;
+        std::cout << "  --duration <sec>       Length of the run (default 5)" << std::endl;
+        std::cout << "  --key-space <n>        Keys, all preloaded into the backend (default 10000)" << std::endl;
+        std::cout << "  --cache-size <n>       Server cache capacity in entries (default 1000)" << std::endl;
+        std::cout << "  --keys <distribution>  Key choice, as for load_generator (default uniform)" << std::endl;
+        std::cout << "  --mix <get:put:delete> Operation weights (default 80:15:5)" << std::endl;
+        std::cout << "  --value-size <bytes>   Size of preloaded and written values (default 64)" << std::endl;
+        std::cout << "  --read-latency <us>    Backend get latency: N, fixed:N, uniform:MIN:MAX or exponential:MEAN" << std::endl;
+        std::cout << "  --write-latency <us>   Backend put and delete latency, likewise (default 0 for both)" << std::endl;
+        std::cout << "  --failure-rate <f>     Fraction (0-1) of backend operations that fail (default 0)" << std::endl;
+        std::cout << "  --results <file>       Write the results as JSON" << std::endl;
+        std::cout << "Example: " << prog_name << " --clients 8 --pipeline 4 --read-latency exponential:500" << std::endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--help")
+        {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+        try
+        {
+            if (arg == "--server-threads")
+                options.server_threads = std::stoi(value);
+            else if (arg == "--clients")
+                options.clients = std::stoi(value);
+            else if (arg == "--pipeline")
+                options.pipeline_depth = std::stoi(value);
+            else if (arg == "--duration")
+                options.duration_sec = std::stoi(value);
+            else if (arg == "--key-space")
+                options.key_space = std::stoull(value);
+            else if (arg == "--cache-size")
+                options.cache_size = std::stoul(value);
+            else if (arg == "--keys")
+                options.keys = value;
+            else if (arg == "--mix")
+            {
+                if (!parseMix(value, options.mix))
+                {
+                    std::cerr << "Invalid operation mix: " << value << " (expected get:put:delete, e.g. 90:8:2)"
+                              << std::endl;
+                    return 1;
+                }
+                options.mix_spec = value;
+            }
+            else if (arg == "--value-size")
+                options.value_size = std::stoul(value);
+            else if (arg == "--read-latency")
+                options.storage.read_latency = value;
+            else if (arg == "--write-latency")
+                options.storage.write_latency = value;
+            else if (arg == "--failure-rate")
+                options.storage.failure_rate = std::stod(value);
+            else if (arg == "--results")
+                options.results_path = value;
+            else
+            {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        catch (const std::exception &)
+        {
+            std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+            return 1;
+        }
+    }
+    if (options.server_threads < 1 || options.clients < 1 || options.pipeline_depth < 1 ||
+        options.duration_sec < 1 || options.key_space < 1)
+    {
+        std::cerr << "Threads, clients, pipeline depth, duration and key space must be positive" << std::endl;
+        return 1;
+    }
+
+    std::string error;
+    auto keys = KeyDistribution::parse(options.keys, options.key_space, error);
+    if (!keys)
+    {
+        std::cerr << "Invalid key distribution: " << error << std::endl;
+        return 1;
+    }
+
+    // Preload the backend before its latency applies.
+    {
+        Database preload("", "", "", "", "");
+        const std::string value(options.value_size, 'v');
+        for (uint64_t key = 0; key < options.key_space; key++)
+            preload.put("key_" + std::to_string(key), value);
+    }
+    if (!fake_database::configure(options.storage, error))
+    {
+        std::cerr << "Invalid backend configuration: " << error << std::endl;
+        return 1;
+    }
+
+    KVServer server(0, options.cache_size, options.server_threads, "", "", "", "", "");
+    if (!server.start())
+    {
+        std::cerr << "Failed to start the server" << std::endl;
+        return 1;
+    }
+    int port = server.getPort();
+
+    std::cout << "=== Server Benchmark ===" << std::endl;
+    std::cout << "Server: port " << port << ", " << options.server_threads << " threads, cache of "
+              << options.cache_size << " entries" << std::endl;
+    std::cout << "Backend: read latency " << options.storage.read_latency << " us, write latency "
+              << options.storage.write_latency << " us, failure rate " << options.storage.failure_rate << std::endl;
+    std::cout << "Clients: " << options.clients << " x pipeline " << options.pipeline_depth << ", "
+              << options.duration_sec << " seconds" << std::endl;
+    std::cout << "Keys: " << options.key_space << " (" << keys->describe() << "), mix " << options.mix_spec
+              << ", values of " << options.value_size << " bytes"
+              << std::endl;
+
+    std::vector<ClientResult> results(options.clients);
+    std::vector<std::thread> clients;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < options.clients; i++)
+        clients.emplace_back(clientThread, i, port, std::cref(options), std::ref(*keys), std::ref(results[i]));
+    for (auto &client : clients)
+        client.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    server.stop();
+
+    // Merge the threads' results; ALL covers every operation
+    LatencyHistogram latency[KIND_COUNT + 1];
+    uint64_t errors[KIND_COUNT + 1] = {};
+    uint64_t not_found = 0, reconnects = 0;
+    for (const ClientResult &result : results)
+    {
+        for (int kind = 0; kind < KIND_COUNT; kind++)
+        {
+            latency[kind].merge(result.latency[kind]);
+            latency[KIND_COUNT].merge(result.latency[kind]);
+            errors[kind] += result.errors[kind];
+            errors[KIND_COUNT] += result.errors[kind];
+        }
+        not_found += result.not_found;
+        reconnects += result.reconnects;
+    }
+    uint64_t succeeded = latency[KIND_COUNT].count();
+    double throughput = succeeded / elapsed;
+    fake_database::Stats storage = fake_database::stats();
+
+    const double percentiles[] = {50, 90, 99, 99.9};
+    const char *const percentile_names[] = {"p50", "p90", "p99", "p99.9"};
+    std::cout << "\n--- Results ---" << std::endl;
+    std::cout << "Throughput: " << std::fixed << std::setprecision(0) << throughput << " req/sec (" << succeeded
+              << " succeeded, " << errors[KIND_COUNT] << " failed, " << not_found << " not found, " << reconnects
+              << " reconnects)" << std::endl;
+    std::cout << "Backend operations: " << storage.reads << " reads, " << storage.writes << " writes, "
+              << storage.deletes << " deletes, " << storage.failures << " injected failures" << std::endl;
+    std::cout << "\n--- Latency (us) ---" << std::endl;
+    std::cout << std::left << std::setw(10) << "Operation" << std::right << std::setw(10) << "Count" << std::setw(8)
+              << "Errors" << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99"
+              << std::setw(10) << "p99.9" << std::setw(10) << "max" << std::endl;
+    std::cout << std::setprecision(1);
+    for (int kind = 0; kind <= KIND_COUNT; kind++)
+    {
+        if (latency[kind].empty() && errors[kind] == 0)
+            continue;
+        std::cout << std::left << std::setw(10) << (kind == KIND_COUNT ? "ALL" : kKindNames[kind]) << std::right
+                  << std::setw(10) << latency[kind].count() << std::setw(8) << errors[kind];
+        for (double percentile : percentiles)
+            std::cout << std::setw(10) << latency[kind].valueAtPercentile(percentile) / 1e3;
+        std::cout << std::setw(10) << latency[kind].max() / 1e3 << std::endl;
+    }
+
+    if (!options.results_path.empty())
+    {
+        std::ofstream json(options.results_path);
+        json << std::fixed << std::setprecision(3);
+        json << "{\n  \"config\": {\"server_threads\": " << options.server_threads
+             << ", \"clients\": " << options.clients << ", \"pipeline_depth\": " << options.pipeline_depth
+             << ", \"duration_sec\": " << options.duration_sec << ", \"key_space\": " << options.key_space
+             << ", \"cache_size\": " << options.cache_size << ", \"keys\": \"" << keys->describe()
+             << "\", \"mix\": \"" << options.mix_spec << "\", \"value_size\": " << options.value_size << ", \"read_latency\": \""
+             << options.storage.read_latency << "\", \"write_latency\": \"" << options.storage.write_latency
+             << "\", \"failure_rate\": " << options.storage.failure_rate << "},\n";
+        json << "  \"summary\": {\"duration_sec\": " << elapsed << ", \"succeeded\": " << succeeded
+             << ", \"failed\": " << errors[KIND_COUNT] << ", \"not_found\": " << not_found
+             << ", \"reconnects\": " << reconnects << ", \"throughput_rps\": " << throughput
+             << ", \"backend_reads\": " << storage.reads << ", \"backend_writes\": " << storage.writes
+             << ", \"backend_deletes\": " << storage.deletes << ", \"backend_failures\": " << storage.failures
+             << "},\n";
+        json << "  \"latency_us\": [";
+        bool first = true;
+        for (int kind = 0; kind <= KIND_COUNT; kind++)
+        {
+            if (latency[kind].empty() && errors[kind] == 0)
+                continue;
+            json << (first ? "\n" : ",\n") << "    {\"operation\": \""
+                 << (kind == KIND_COUNT ? "ALL" : kKindNames[kind]) << "\", \"count\": " << latency[kind].count()
+                 << ", \"errors\": " << errors[kind] << ", \"mean\": " << latency[kind].mean() / 1e3;
+            for (int i = 0; i < 4; i++)
+                json << ", \"" << percentile_names[i] << "\": " << latency[kind].valueAtPercentile(percentiles[i]) / 1e3;
+            json << ", \"max\": " << latency[kind].max() / 1e3 << "}";
+            first = false;
+        }
+        json << "\n  ]\n}\n";
+        if (!json.good())
+        {
+            std::cerr << "Cannot write results to " << options.results_path << std::endl;
+            return 1;
+        }
+        std::cout << "\nResults written to " << options.results_path << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,213 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "fake_database.hpp"
+#include "hpack.hpp"
+#include "http2.hpp"
+#include "server.hpp"
+
+/**
+ * @brief Tests of KVServer over real sockets, with the in-memory database.
+ *
+ * Covers connections that go away while another worker is still answering
+ * their deferred requests: HTTP/2 clients reset the connection while a
+ * stream that needs the (slowed-down) database is in flight, and send more
+ * frames just before, so the connection's next event and the failing
+ * deferred send race. The server must survive, keep serving, and drop every
+ * such connection. Run by ctest; exits non-zero if any check fails.
+ */
+
+namespace
+{
+    int failures = 0;
+
+#define CHECK(condition)                                                        \
+    do                                                                          \
+    {                                                                           \
+        if (!(condition))                                                       \
+        {                                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                         \
+        }                                                                       \
+    } while (0)
+
+    constexpr uint8_t kHeaders = 0x1;
+    constexpr uint8_t kSettings = 0x4;
+    constexpr uint8_t kPing = 0x6;
+    constexpr uint8_t kEndStream = 0x1;
+    constexpr uint8_t kEndHeaders = 0x4;
+
+    // Every database read takes this long, so misses are deferred and stay
+    // in flight while the client disconnects.
+    constexpr const char *kReadLatencyUs = "20000";
+
+    std::string frame(uint8_t type, uint8_t flags, uint32_t stream_id, std::string_view payload)
+    {
+        std::string bytes;
+        bytes.push_back(static_cast<char>(payload.size() >> 16));
+        bytes.push_back(static_cast<char>(payload.size() >> 8));
+        bytes.push_back(static_cast<char>(payload.size()));
+        bytes.push_back(static_cast<char>(type));
+        bytes.push_back(static_cast<char>(flags));
+        for (int shift = 24; shift >= 0; shift -= 8)
+            bytes.push_back(static_cast<char>(stream_id >> shift));
+        bytes.append(payload);
+        return bytes;
+    }
+
+    std::string getStream(uint32_t stream_id, std::string_view key)
+    {
+        std::pmr::string block;
+        hpack::appendHeader(block, ":method", "GET");
+        hpack::appendHeader(block, ":scheme", "http");
+        hpack::appendHeader(block, ":path", "/api/kv?key=" + std::string(key));
+        return frame(kHeaders, kEndStream | kEndHeaders, stream_id, block);
+    }
+
+    int connectTo(int port)
+    {
+        int sock = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (connect(sock, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+        {
+            close(sock);
+            return -1;
+        }
+        return sock;
+    }
+
+    bool sendAll(int sock, std::string_view bytes)
+    {
+        while (!bytes.empty())
+        {
+            ssize_t n = send(sock, bytes.data(), bytes.size(), MSG_NOSIGNAL);
+            if (n <= 0)
+                return false;
+            bytes.remove_prefix(n);
+        }
+        return true;
+    }
+
+    // Closes with a reset (SO_LINGER 0), so the server's next send fails.
+    void reset(int sock)
+    {
+        linger option{1, 0};
+        setsockopt(sock, SOL_SOCKET, SO_LINGER, &option, sizeof(option));
+        close(sock);
+    }
+
+    // Sends an HTTP/1.1 request on a new connection and returns the response.
+    std::string httpGet(int port, std::string_view target)
+    {
+        int sock = connectTo(port);
+        if (sock < 0)
+            return {};
+        sendAll(sock, "GET " + std::string(target) + " HTTP/1.1\r\nHost: test\r\nConnection: close\r\n\r\n");
+        std::string response;
+        char buffer[4096];
+        ssize_t n;
+        while ((n = recv(sock, buffer, sizeof(buffer), 0)) > 0)
+            response.append(buffer, n);
+        close(sock);
+        return response;
+    }
+
+    // A counter from /stats, or -1
+    long stat(int port, std::string_view name)
+    {
+        std::string stats = httpGet(port, "/stats");
+        std::string field = "\"" + std::string(name) + "\":";
+        size_t pos = stats.find(field);
+        return pos == std::string::npos ? -1 : std::stol(stats.substr(pos + field.size()));
+    }
+
+    // HTTP/2 clients reset their connection while the server is still
+    // executing a deferred stream, right after sending more frames.
+    void testResetWithDeferredStream(int port)
+    {
+        constexpr int kClients = 8;
+        constexpr int kConnections = 40;
+        std::atomic<int> connected{0};
+        std::vector<std::thread> clients;
+        for (int client = 0; client < kClients; client++)
+        {
+            clients.emplace_back([&, client] {
+                for (int i = 0; i < kConnections; i++)
+                {
+                    int sock = connectTo(port);
+                    if (sock < 0)
+                        continue;
+                    connected++;
+                    std::string key = "missing-" + std::to_string(client) + "-" + std::to_string(i);
+                    sendAll(sock, std::string(http2::kPreface) + frame(kSettings, 0, 0, "") + getStream(1, key));
+
+                    // The first stream is deferred by now (or soon); wake the
+                    // connection again while it waits on the database.
+                    std::this_thread::sleep_for(std::chrono::microseconds(500 + 250 * (i % 8)));
+                    sendAll(sock, getStream(3, key) + frame(kPing, 0, 0, std::string(8, '\0')));
+                    reset(sock);
+                }
+            });
+        }
+        for (std::thread &client : clients)
+            client.join();
+        CHECK(connected == kClients * kConnections);
+
+        // Still serving, and every reset connection is dropped once its
+        // deferred streams are done ("persistent_connections" counts the
+        // connection asking for the stats).
+        std::string response = httpGet(port, "/api/kv?key=missing-0-0");
+        CHECK(response.compare(0, 12, "HTTP/1.1 404") == 0);
+        CHECK(stat(port, "http2_deferred") > 0);
+        long open = -1;
+        for (int attempt = 0; attempt < 100 && open != 1; attempt++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            open = stat(port, "persistent_connections");
+        }
+        CHECK(open == 1);
+    }
+}
+
+int main()
+{
+    fake_database::Config config;
+    config.read_latency = kReadLatencyUs;
+    std::string error;
+    if (!fake_database::configure(config, error))
+    {
+        std::fprintf(stderr, "fake database: %s\n", error.c_str());
+        return 1;
+    }
+
+    KVServer server(0, 1000, 4, "", "", "", "", "");
+    if (!server.start())
+    {
+        std::fprintf(stderr, "failed to start the server\n");
+        return 1;
+    }
+
+    testResetWithDeferredStream(server.getPort());
+    server.stop();
+
+    if (failures > 0)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("server_test: all checks passed\n");
+    return 0;
+}
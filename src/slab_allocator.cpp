@@ -0,0 +1,379 @@
+#include "slab_allocator.hpp" // Corresponding header with the SlabAllocator class definition
+#include <algorithm>           // For std::lower_bound
+#include <atomic>              // For the large-allocation byte counter
+#include <cstring>             // For std::memmove
+#include <memory>              // For std::unique_ptr
+#include <mutex>               // For per-class and page-pool locks
+#include <new>                 // For std::bad_alloc
+#include <sys/mman.h>          // For mmap/munmap of slab pages
+
+// =======================
+// Tunables
+// =======================
+namespace
+{
+    // Smallest chunk size; every class is a multiple of 16 bytes.
+    constexpr size_t kMinChunk = 64;
+
+    // Each size class is ~25% larger than the previous one.
+    constexpr double kGrowthFactor = 1.25;
+
+    // Largest chunk served from slabs; bigger requests use the system allocator.
+    constexpr size_t kMaxChunk = SlabAllocator::kPageSize / 2;
+
+    // Chunks held per thread per size class. Refills and flushes move half of it.
+    constexpr size_t kMagazineSize = 32;
+
+    // Byte budget of one magazine, so threads don't hoard many large chunks.
+    constexpr size_t kMagazineBytes = 64 * 1024;
+
+    // Upper bound on the number of size classes (kMinChunk..kMaxChunk at 1.25x is ~40).
+    constexpr size_t kMaxClasses = 64;
+
+    // Empty pages kept around for reuse before they are unmapped.
+    constexpr size_t kMaxIdlePages = 4;
+
+    // Maps one page-aligned slab page straight from the OS so that releasing it
+    // really returns the memory (RSS) instead of leaving it in the malloc heap.
+    void *mapPage()
+    {
+        const size_t page = SlabAllocator::kPageSize;
+        // Over-map by one page and trim, to obtain page-size alignment.
+        void *raw = mmap(nullptr, page * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED)
+            throw std::bad_alloc();
+
+        uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+        uintptr_t aligned = (start + page - 1) & ~(uintptr_t)(page - 1);
+        if (aligned > start)
+            munmap(raw, aligned - start);
+        uintptr_t tail = aligned + page;
+        uintptr_t end = start + page * 2;
+        if (end > tail)
+            munmap(reinterpret_cast<void *>(tail), end - tail);
+        return reinterpret_cast<void *>(aligned);
+    }
+
+    void unmapPage(void *page)
+    {
+        munmap(page, SlabAllocator::kPageSize);
+    }
+}
+
+// --- PIMPL Implementation Struct Definition ---
+
+struct SlabAllocator::Impl
+{
+    // Header at the start of every slab page.
+    struct Page
+    {
+        Page *prev;        // Links in the owning class's partial-page list
+        Page *next;
+        void *free_list;   // Chunks freed back to this page
+        size_t carved;     // Chunks handed out from the never-used tail so far
+        size_t used;       // Chunks currently out of the page (incl. magazines)
+        uint32_t class_id;
+        bool in_partial;
+    };
+
+    // Chunks start after the header, on a cache-line boundary.
+    static constexpr size_t kHeaderSize = (sizeof(Page) + 63) & ~size_t(63);
+
+    struct SizeClass
+    {
+        size_t chunk_size = 0;
+        size_t chunks_per_page = 0;
+        size_t magazine_limit = 0; // Chunks a thread magazine may hold for this class
+        std::mutex mtx;
+        Page *partial = nullptr; // Pages with at least one free chunk
+        size_t pages = 0;
+        size_t chunks_used = 0;
+    };
+
+    // Per-thread stack of free chunks for one size class.
+    struct Magazine
+    {
+        void *items[kMagazineSize];
+        size_t count = 0;
+    };
+
+    // All magazines of one thread; returned to the shared state on thread exit.
+    struct ThreadCache
+    {
+        Impl *owner;
+        Magazine mags[kMaxClasses];
+
+        explicit ThreadCache(Impl *owner) : owner(owner) {}
+
+        ~ThreadCache()
+        {
+            for (size_t cls = 0; cls < owner->num_classes; ++cls)
+            {
+                if (mags[cls].count > 0)
+                    owner->flush(cls, mags[cls].items, mags[cls].count);
+            }
+        }
+    };
+
+    std::vector<size_t> class_sizes;
+    std::unique_ptr<SizeClass[]> classes;
+    size_t num_classes;
+
+    // Shared pool of empty pages that any size class can take.
+    std::mutex pool_mtx;
+    std::vector<Page *> idle_pages;
+
+    std::atomic<size_t> large_bytes{0};
+
+    Impl()
+    {
+        // Build the geometric series of chunk sizes, rounded to 16 bytes.
+        size_t size = kMinChunk;
+        while (size < kMaxChunk && class_sizes.size() < kMaxClasses - 1)
+        {
+            class_sizes.push_back(size);
+            size_t next = static_cast<size_t>(size * kGrowthFactor);
+            size = (next + 15) & ~size_t(15);
+        }
+        class_sizes.push_back(kMaxChunk);
+
+        num_classes = class_sizes.size();
+        classes.reset(new SizeClass[num_classes]);
+        for (size_t i = 0; i < num_classes; ++i)
+        {
+            classes[i].chunk_size = class_sizes[i];
+            classes[i].chunks_per_page = (kPageSize - kHeaderSize) / class_sizes[i];
+            classes[i].magazine_limit = std::max<size_t>(2, std::min(kMagazineSize, kMagazineBytes / class_sizes[i]));
+        }
+    }
+
+    // Index of the smallest class that fits 'size', or num_classes if none does.
+    size_t classFor(size_t size) const
+    {
+        return std::lower_bound(class_sizes.begin(), class_sizes.end(), size) - class_sizes.begin();
+    }
+
+    static Page *pageOf(void *chunk)
+    {
+        return reinterpret_cast<Page *>(reinterpret_cast<uintptr_t>(chunk) & ~(uintptr_t)(kPageSize - 1));
+    }
+
+    // --- Page pool (lock order: class mutex, then pool mutex) ---
+
+    Page *takePage(uint32_t class_id)
+    {
+        Page *page = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(pool_mtx);
+            if (!idle_pages.empty())
+            {
+                page = idle_pages.back();
+                idle_pages.pop_back();
+            }
+        }
+        if (!page)
+            page = static_cast<Page *>(mapPage());
+
+        page->prev = page->next = nullptr;
+        page->free_list = nullptr;
+        page->carved = 0;
+        page->used = 0;
+        page->class_id = class_id;
+        page->in_partial = false;
+        return page;
+    }
+
+    void releasePage(Page *page)
+    {
+        {
+            std::lock_guard<std::mutex> lock(pool_mtx);
+            if (idle_pages.size() < kMaxIdlePages)
+            {
+                idle_pages.push_back(page);
+                return;
+            }
+        }
+        unmapPage(page);
+    }
+
+    // --- Partial list maintenance (class mutex held) ---
+
+    static void pushPartial(SizeClass &c, Page *page)
+    {
+        page->prev = nullptr;
+        page->next = c.partial;
+        if (c.partial)
+            c.partial->prev = page;
+        c.partial = page;
+        page->in_partial = true;
+    }
+
+    static void removePartial(SizeClass &c, Page *page)
+    {
+        if (page->prev)
+            page->prev->next = page->next;
+        else
+            c.partial = page->next;
+        if (page->next)
+            page->next->prev = page->prev;
+        page->prev = page->next = nullptr;
+        page->in_partial = false;
+    }
+
+    // Moves up to 'n' chunks of class 'cls' from the shared state into 'out'.
+    size_t refill(size_t cls, void **out, size_t n)
+    {
+        SizeClass &c = classes[cls];
+        std::lock_guard<std::mutex> lock(c.mtx);
+        for (size_t i = 0; i < n; ++i)
+        {
+            Page *page = c.partial;
+            if (!page)
+            {
+                page = takePage(static_cast<uint32_t>(cls));
+                ++c.pages;
+                pushPartial(c, page);
+            }
+
+            void *chunk;
+            if (page->free_list)
+            {
+                chunk = page->free_list;
+                page->free_list = *static_cast<void **>(chunk);
+            }
+            else
+            {
+                chunk = reinterpret_cast<char *>(page) + kHeaderSize + page->carved * c.chunk_size;
+                ++page->carved;
+            }
+
+            ++page->used;
+            ++c.chunks_used;
+            if (page->used == c.chunks_per_page)
+                removePartial(c, page);
+            out[i] = chunk;
+        }
+        return n;
+    }
+
+    // Returns 'n' chunks of class 'cls' to their pages; empty pages go back to the pool.
+    void flush(size_t cls, void **items, size_t n)
+    {
+        SizeClass &c = classes[cls];
+        std::lock_guard<std::mutex> lock(c.mtx);
+        for (size_t i = 0; i < n; ++i)
+        {
+            Page *page = pageOf(items[i]);
+            *static_cast<void **>(items[i]) = page->free_list;
+            page->free_list = items[i];
+            --page->used;
+            --c.chunks_used;
+
+            if (page->used == 0)
+            {
+                // Fully free: give the page back so any class can reuse it.
+                if (page->in_partial)
+                    removePartial(c, page);
+                --c.pages;
+                releasePage(page);
+            }
+            else if (!page->in_partial)
+            {
+                pushPartial(c, page);
+            }
+        }
+    }
+
+    ThreadCache &threadCache()
+    {
+        thread_local ThreadCache cache(this);
+        return cache;
+    }
+};
+
+// --- SlabAllocator Public Methods Implementation ---
+
+SlabAllocator &SlabAllocator::instance()
+{
+    // Intentionally never destroyed: thread magazines may flush into it during exit.
+    static SlabAllocator *allocator = new SlabAllocator();
+    return *allocator;
+}
+
+SlabAllocator::SlabAllocator()
+{
+    slab_impl = new Impl();
+}
+
+SlabAllocator::~SlabAllocator()
+{
+    delete slab_impl;
+}
+
+void *SlabAllocator::allocate(size_t size)
+{
+    size_t cls = slab_impl->classFor(size);
+    if (cls >= slab_impl->num_classes)
+    {
+        // Too large for any size class
+        slab_impl->large_bytes.fetch_add(size, std::memory_order_relaxed);
+        return ::operator new(size);
+    }
+
+    // Fast path: pop from this thread's magazine, refilling half of it if empty.
+    Impl::Magazine &mag = slab_impl->threadCache().mags[cls];
+    if (mag.count == 0)
+        mag.count = slab_impl->refill(cls, mag.items, slab_impl->classes[cls].magazine_limit / 2);
+    return mag.items[--mag.count];
+}
+
+void SlabAllocator::deallocate(void *ptr, size_t size)
+{
+    size_t cls = slab_impl->classFor(size);
+    if (cls >= slab_impl->num_classes)
+    {
+        slab_impl->large_bytes.fetch_sub(size, std::memory_order_relaxed);
+        ::operator delete(ptr);
+        return;
+    }
+
+    // Fast path: push onto this thread's magazine; when it is full, flush the
+    // older half to the shared state and keep the most recently freed chunks.
+    Impl::Magazine &mag = slab_impl->threadCache().mags[cls];
+    const size_t limit = slab_impl->classes[cls].magazine_limit;
+    if (mag.count == limit)
+    {
+        const size_t half = limit / 2;
+        slab_impl->flush(cls, mag.items, half);
+        std::memmove(mag.items, mag.items + half, (limit - half) * sizeof(void *));
+        mag.count = limit - half;
+    }
+    mag.items[mag.count++] = ptr;
+}
+
+SlabAllocator::Stats SlabAllocator::stats()
+{
+    Stats s{};
+    s.large_bytes = slab_impl->large_bytes.load(std::memory_order_relaxed);
+
+    size_t pages = 0;
+    for (size_t cls = 0; cls < slab_impl->num_classes; ++cls)
+    {
+        Impl::SizeClass &c = slab_impl->classes[cls];
+        std::lock_guard<std::mutex> lock(c.mtx);
+        if (c.pages == 0)
+            continue;
+        s.classes.push_back({c.chunk_size, c.pages, c.chunks_used, c.chunks_per_page});
+        pages += c.pages;
+        s.bytes_in_use += c.chunks_used * c.chunk_size;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(slab_impl->pool_mtx);
+        s.idle_pages = slab_impl->idle_pages.size();
+    }
+
+    s.bytes_reserved = (pages + s.idle_pages) * kPageSize + s.large_bytes;
+    s.bytes_in_use += s.large_bytes;
+    return s;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Size-class slab allocator for cache entries.
+ *
+ * Memory is reserved in 1 MiB pages (slabs). Each page is dedicated to one
+ * size class and carved into equal chunks; size classes grow geometrically
+ * (factor 1.25) so internal fragmentation stays bounded. Requests larger than
+ * the biggest class go straight to the system allocator.
+ *
+ * Allocation cost is kept low with per-thread magazines: every thread keeps a
+ * small stack of free chunks per size class and only touches the shared,
+ * mutex-protected class state to refill or flush a batch.
+ *
+ * Pages whose chunks are all free are returned to a shared pool of empty pages,
+ * from which any size class can take them. This rebalances memory between size
+ * classes as the value size mix changes, and keeps RSS stable under churn. Only
+ * a few idle pages are kept; the rest are released to the OS.
+ */
+class SlabAllocator
+{
+public:
+    // Size of one slab page; pages are also aligned to this size.
+    static constexpr size_t kPageSize = 1 << 20;
+
+    // Per-size-class usage, as seen by the shared state (chunks cached in
+    // thread magazines count as in use).
+    struct ClassStats
+    {
+        size_t chunk_size;
+        size_t pages;
+        size_t chunks_used;
+        size_t chunks_per_page;
+    };
+
+    // Snapshot of allocator memory usage.
+    struct Stats
+    {
+        size_t bytes_reserved; // Slab pages owned by size classes + idle pages + large allocations
+        size_t bytes_in_use;   // Chunks handed out (chunk size granularity) + large allocations
+        size_t large_bytes;    // Allocations too big for any size class
+        size_t idle_pages;     // Empty pages waiting to be reused by any class
+        std::vector<ClassStats> classes;
+    };
+
+    /**
+     * @brief Returns the process-wide allocator instance.
+     */
+    static SlabAllocator &instance();
+
+    /**
+     * @brief Allocates at least 'size' bytes, aligned to 16 bytes.
+     */
+    void *allocate(size_t size);
+
+    /**
+     * @brief Returns memory obtained from allocate(). 'size' must match the request.
+     */
+    void deallocate(void *ptr, size_t size);
+
+    /**
+     * @brief Collects memory usage statistics.
+     */
+    Stats stats();
+
+    SlabAllocator(const SlabAllocator &) = delete;
+    SlabAllocator &operator=(const SlabAllocator &) = delete;
+
+private:
+    struct Impl;
+    Impl *slab_impl;
+
+    SlabAllocator();
+    ~SlabAllocator();
+};
@@ -0,0 +1,180 @@
+#include "value_generator.hpp" // ValueSizeDistribution, PayloadPool
+#include <algorithm>           // For std::min, std::upper_bound
+#include <cmath>               // For std::pow, std::lround
+#include <fstream>             // For std::ifstream
+#include <sstream>             // For std::istringstream
+
+namespace
+{
+    // Largest value a distribution may produce (the server streams bodies this large).
+    constexpr size_t kMaxValueSize = size_t(1) << 30;
+
+    // Pareto values are capped here unless the specification says otherwise.
+    constexpr size_t kDefaultParetoMax = 1024 * 1024;
+
+    // Extra pool content beyond the largest value, so slices start at varied offsets.
+    constexpr size_t kPoolSlack = 1024 * 1024;
+
+    // Compressibility is applied per block of this many bytes.
+    constexpr size_t kBlockSize = 64;
+
+    bool parseSize(const std::string &field, size_t &value)
+    {
+        std::istringstream in(field);
+        unsigned long long parsed;
+        if (field.empty() || field[0] == '-' || !(in >> parsed) || !in.eof() || parsed > kMaxValueSize)
+            return false;
+        value = static_cast<size_t>(parsed);
+        return true;
+    }
+
+    bool parseNumber(const std::string &field, double &value)
+    {
+        std::istringstream in(field);
+        return (in >> value) && in.eof();
+    }
+}
+
+std::unique_ptr<ValueSizeDistribution> ValueSizeDistribution::parse(const std::string &spec, std::string &error)
+{
+    std::unique_ptr<ValueSizeDistribution> distribution(new ValueSizeDistribution());
+    distribution->spec = spec;
+
+    // file:PATH keeps any ':' in the path.
+    if (spec.compare(0, 5, "file:") == 0)
+    {
+        std::string path = spec.substr(5);
+        std::ifstream file(path);
+        if (!file)
+        {
+            error = "cannot open " + path;
+            return nullptr;
+        }
+        distribution->type = Type::Histogram;
+        double total = 0;
+        std::string line;
+        int line_number = 0;
+        while (std::getline(file, line))
+        {
+            line_number++;
+            line = line.substr(0, line.find('#'));
+            std::istringstream in(line);
+            std::string size_field, weight_field, extra;
+            if (!(in >> size_field))
+                continue; // Blank or comment
+            size_t size;
+            double weight;
+            if (!(in >> weight_field) || (in >> extra) || !parseSize(size_field, size) ||
+                !parseNumber(weight_field, weight) || weight < 0)
+            {
+                error = path + ":" + std::to_string(line_number) + ": expected \"size weight\"";
+                return nullptr;
+            }
+            if (weight == 0)
+                continue;
+            total += weight;
+            distribution->sizes.push_back(size);
+            distribution->cumulative_weights.push_back(total);
+            distribution->max_size = std::max(distribution->max_size, size);
+        }
+        if (distribution->sizes.empty())
+        {
+            error = path + " has no sizes";
+            return nullptr;
+        }
+        return distribution;
+    }
+
+    std::vector<std::string> fields;
+    std::istringstream in(spec);
+    std::string field;
+    while (std::getline(in, field, ':'))
+        fields.push_back(field);
+    if (fields.size() == 1)
+        fields.insert(fields.begin(), "fixed"); // A bare size
+
+    const std::string &name = fields.empty() ? spec : fields[0];
+    bool valid = false;
+    if (name == "fixed" && fields.size() == 2)
+    {
+        distribution->type = Type::Fixed;
+        valid = parseSize(fields[1], distribution->min_size);
+        distribution->max_size = distribution->min_size;
+    }
+    else if (name == "uniform" && fields.size() == 3)
+    {
+        distribution->type = Type::Uniform;
+        valid = parseSize(fields[1], distribution->min_size) && parseSize(fields[2], distribution->max_size) &&
+                distribution->min_size <= distribution->max_size;
+    }
+    else if (name == "pareto" && (fields.size() == 3 || fields.size() == 4))
+    {
+        distribution->type = Type::Pareto;
+        distribution->max_size = kDefaultParetoMax;
+        valid = parseSize(fields[1], distribution->min_size) && distribution->min_size > 0 &&
+                parseNumber(fields[2], distribution->alpha) && distribution->alpha > 0 &&
+                (fields.size() == 3 || parseSize(fields[3], distribution->max_size)) &&
+                distribution->min_size <= distribution->max_size;
+    }
+    if (!valid)
+    {
+        error = "invalid value size distribution: " + spec +
+                " (expected N, fixed:N, uniform:MIN:MAX, pareto:MIN:ALPHA[:MAX] or file:PATH)";
+        return nullptr;
+    }
+    return distribution;
+}
+
+size_t ValueSizeDistribution::next(std::mt19937 &gen) const
+{
+    switch (type)
+    {
+    case Type::Fixed:
+        return min_size;
+    case Type::Uniform:
+        return std::uniform_int_distribution<size_t>(min_size, max_size)(gen);
+    case Type::Pareto:
+    {
+        // Inverse transform: u in (0, 1] gives min * u^(-1/alpha) >= min.
+        double u = 1.0 - std::uniform_real_distribution<double>(0, 1)(gen);
+        double size = min_size * std::pow(u, -1.0 / alpha);
+        return size >= max_size ? max_size : static_cast<size_t>(size);
+    }
+    case Type::Histogram:
+    default:
+    {
+        double point = std::uniform_real_distribution<double>(0, cumulative_weights.back())(gen);
+        size_t index = std::upper_bound(cumulative_weights.begin(), cumulative_weights.end(), point) -
+                       cumulative_weights.begin();
+        return sizes[std::min(index, sizes.size() - 1)];
+    }
+    }
+}
+
+PayloadPool::PayloadPool(size_t max_value_size, double compressibility)
+{
+    compressibility = std::min(std::max(compressibility, 0.0), 1.0);
+    size_t random_bytes = kBlockSize - static_cast<size_t>(std::lround(compressibility * kBlockSize));
+
+    // A fixed seed: every run writes the same content.
+    std::mt19937_64 gen(42);
+    data.resize(max_value_size + kPoolSlack);
+    for (size_t block = 0; block < data.size(); block += kBlockSize)
+    {
+        size_t end = std::min(block + random_bytes, data.size());
+        for (size_t i = block; i < end; i += 8)
+        {
+            uint64_t bits = gen();
+            for (size_t j = i; j < std::min(i + 8, end); j++, bits >>= 8)
+                data[j] = static_cast<char>(bits & 0xff);
+        }
+        // The rest of the block stays zero.
+    }
+}
+
+std::string_view PayloadPool::slice(size_t size, std::mt19937 &gen) const
+{
+    size = std::min(size, data.size());
+    size_t offset = std::uniform_int_distribution<size_t>(0, data.size() - size)(gen);
+    return std::string_view(data).substr(offset, size);
+}
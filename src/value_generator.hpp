@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Chooses the size of each value a load-generator request writes.
+ *
+ * Distributions, as specified on the command line (sizes in bytes):
+ *  - fixed:N, or just N: every value N bytes.
+ *  - uniform:MIN:MAX: uniformly between MIN and MAX.
+ *  - pareto:MIN:ALPHA[:MAX]: heavy-tailed, most values near MIN and a few
+ *    very large (the smaller ALPHA, the heavier the tail); capped at MAX,
+ *    1 MiB by default.
+ *  - file:PATH: a histogram of real value sizes, one "size weight" pair per
+ *    line ('#' starts a comment); sizes are drawn with those weights.
+ *
+ * Immutable once built: one instance is shared by all threads, each passing
+ * its own random engine.
+ */
+class ValueSizeDistribution
+{
+public:
+    /**
+     * @brief Builds a distribution from its specification (see above).
+     * @return nullptr, with 'error' set, if the specification (or file) is invalid.
+     */
+    static std::unique_ptr<ValueSizeDistribution> parse(const std::string &spec, std::string &error);
+
+    size_t next(std::mt19937 &gen) const;
+
+    // Largest size next() can return.
+    size_t maxSize() const { return max_size; }
+
+    // Specification as given, for reports.
+    const std::string &describe() const { return spec; }
+
+private:
+    enum class Type
+    {
+        Fixed,
+        Uniform,
+        Pareto,
+        Histogram
+    };
+
+    ValueSizeDistribution() = default;
+
+    Type type = Type::Fixed;
+    std::string spec;
+    size_t min_size = 0;
+    size_t max_size = 0;
+    double alpha = 0; // Pareto shape
+
+    // Histogram: sizes and the running total of their weights
+    std::vector<size_t> sizes;
+    std::vector<double> cumulative_weights;
+};
+
+/**
+ * @brief Value bytes, generated once and handed out as slices.
+ *
+ * The pool is filled up front with 'max_value_size' plus 1 MiB of content,
+ * and slice() returns a view of it at a random offset, so requests write
+ * values of any size without generating or allocating anything, and
+ * consecutive values of one size still differ.
+ *
+ * 'compressibility' (0 to 1) is roughly the fraction of a value deflate
+ * can remove: each 64-byte block starts with random bytes and ends with
+ * that fraction of zeros. 0 makes values incompressible, like encrypted or
+ * already-compressed data.
+ */
+class PayloadPool
+{
+public:
+    PayloadPool(size_t max_value_size, double compressibility);
+
+    std::string_view slice(size_t size, std::mt19937 &gen) const;
+
+private:
+    std::string data;
+};